@@ -0,0 +1,203 @@
+/*
+ * adaptive_timeout.cpp
+ * 
+ * Implementation of the per-command timeout estimator
+ */
+
+#include "adaptive_timeout.h"
+#include "logger.h"
+#include <Preferences.h>
+
+#define RTO_NVS_NAMESPACE  "lte_rto"
+#define RTO_NVS_KEY        "table"
+
+AdaptiveTimeout::AdaptiveTimeout() {
+  clear();
+}
+
+void AdaptiveTimeout::clear() {
+  memset(entries, 0, sizeof(entries));
+  unsavedSamples = 0;
+}
+
+// ============================================
+// ESTIMATE
+// ============================================
+uint32_t AdaptiveTimeout::get(const char* cmd, uint32_t fixedMs) {
+#if ADAPTIVE_TIMEOUTS
+  Entry* entry = find(cmd, false);
+  if (entry == nullptr || entry->samples < RTO_MIN_SAMPLES) {
+    return fixedMs;
+  }
+  
+  uint32_t margin = entry->rttvarMs * 4;
+  if (margin < RTO_GRANULARITY_MS) {
+    margin = RTO_GRANULARITY_MS;
+  }
+  uint32_t timeout = entry->srttMs + margin;
+  uint32_t peak = entry->peakMs + entry->peakMs * RTO_PEAK_HEADROOM_PERCENT / 100;
+  if (timeout < peak) {
+    timeout = peak;
+  }
+  timeout <<= entry->backoff;
+  uint32_t cap = fixedMs * RTO_MAX_FACTOR;
+  if (timeout < RTO_MIN_MS) {
+    timeout = RTO_MIN_MS;
+  }
+  if (timeout < fixedMs && isFlooredAtFixed(entry->key)) {
+    timeout = fixedMs;
+  }
+  return (timeout > cap) ? cap : timeout;
+#else
+  return fixedMs;
+#endif
+}
+
+void AdaptiveTimeout::onResponse(const char* cmd, uint32_t rttMs) {
+  Entry* entry = find(cmd, true);
+  if (entry->samples == 0) {
+    entry->srttMs = rttMs;
+    entry->rttvarMs = rttMs / 2;
+  } else {
+    uint32_t error = (rttMs > entry->srttMs) ? rttMs - entry->srttMs : entry->srttMs - rttMs;
+    entry->rttvarMs = (entry->rttvarMs * 3 + error) / 4;
+    entry->srttMs = (entry->srttMs * 7 + rttMs) / 8;
+  }
+  entry->peakMs -= entry->peakMs / RTO_PEAK_DECAY;
+  if (rttMs > entry->peakMs) {
+    entry->peakMs = rttMs;
+  }
+  if (entry->samples < 0xFFFF) {
+    entry->samples++;
+  }
+  entry->backoff = 0;
+  unsavedSamples++;
+}
+
+void AdaptiveTimeout::onTimeout(const char* cmd) {
+  Entry* entry = find(cmd, false);
+  if (entry != nullptr && entry->backoff < 4) {
+    entry->backoff++;
+  }
+}
+
+// ============================================
+// TABLE
+// ============================================
+// Commands whose first parameter picks the operation, not just its target
+// (HTTPACTION=0 is a GET, =1 a POST); the key keeps that parameter.
+static const char* const kModeCommands[] = {
+  "AT+HTTPACTION=",
+  "AT+CFUN=",
+  "AT+CGACT="
+};
+
+// Commands whose learned timeout never drops below the fixed one: a false
+// timeout there (a PDP context half written) costs a bring-up retry, more
+// than a slower failure detection saves. CGDCONT's answer time also grows
+// more on a slow network than its recent answers predict.
+static const char* const kFixedFloorCommands[] = {
+  "AT+CGDCONT="
+};
+
+bool AdaptiveTimeout::isFlooredAtFixed(const char* key) {
+  for (size_t i = 0; i < sizeof(kFixedFloorCommands) / sizeof(kFixedFloorCommands[0]); i++) {
+    if (strcmp(key, kFixedFloorCommands[i]) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void AdaptiveTimeout::makeKey(const char* cmd, char* key) {
+  size_t n = 0;
+  while (cmd[n] != '\0' && n < RTO_KEY_LEN - 1) {
+    key[n] = cmd[n];
+    n++;
+    if (cmd[n - 1] == '=' || cmd[n - 1] == '?') {
+      break;
+    }
+  }
+  key[n] = '\0';
+  
+  if (n == 0 || key[n - 1] != '=') {
+    return;
+  }
+  for (size_t i = 0; i < sizeof(kModeCommands) / sizeof(kModeCommands[0]); i++) {
+    if (strcmp(key, kModeCommands[i]) != 0) {
+      continue;
+    }
+    while (cmd[n] != '\0' && cmd[n] != ',' && n < RTO_KEY_LEN - 1) {
+      key[n] = cmd[n];
+      n++;
+    }
+    key[n] = '\0';
+    return;
+  }
+}
+
+AdaptiveTimeout::Entry* AdaptiveTimeout::find(const char* cmd, bool create) {
+  char key[RTO_KEY_LEN];
+  makeKey(cmd, key);
+  
+  Entry* fewest = &entries[0];
+  for (uint8_t i = 0; i < RTO_TABLE_SIZE; i++) {
+    if (entries[i].key[0] != '\0' && strcmp(entries[i].key, key) == 0) {
+      return &entries[i];
+    }
+    if (entries[i].samples < fewest->samples) {
+      fewest = &entries[i];
+    }
+  }
+  if (!create) {
+    return nullptr;
+  }
+  
+  // Free slot, or the command with the least history
+  memset(fewest, 0, sizeof(Entry));
+  strcpy(fewest->key, key);
+  return fewest;
+}
+
+// ============================================
+// NVS PERSISTENCE
+// ============================================
+bool AdaptiveTimeout::load() {
+  Preferences prefs;
+  if (!prefs.begin(RTO_NVS_NAMESPACE, true)) {
+    return false;
+  }
+  bool ok = prefs.getBytesLength(RTO_NVS_KEY) == sizeof(entries) &&
+            prefs.getBytes(RTO_NVS_KEY, entries, sizeof(entries)) == sizeof(entries);
+  prefs.end();
+  if (!ok) {
+    clear();  // Missing, or saved by a build with another table layout
+    return false;
+  }
+  
+  uint8_t used = 0;
+  for (uint8_t i = 0; i < RTO_TABLE_SIZE; i++) {
+    entries[i].key[RTO_KEY_LEN - 1] = '\0';
+    entries[i].backoff = 0;
+    used += (entries[i].key[0] != '\0') ? 1 : 0;
+  }
+  Logger::printf(LOG_INFO, "RTO", "Loaded timeouts for %u commands", used);
+  return true;
+}
+
+bool AdaptiveTimeout::save(bool force) {
+  if (unsavedSamples == 0 || (!force && unsavedSamples < RTO_SAVE_EVERY)) {
+    return true;
+  }
+  Preferences prefs;
+  if (!prefs.begin(RTO_NVS_NAMESPACE, false)) {
+    LOG_W("RTO", "NVS open failed");
+    return false;
+  }
+  bool ok = prefs.putBytes(RTO_NVS_KEY, entries, sizeof(entries)) == sizeof(entries);
+  prefs.end();
+  if (ok) {
+    unsavedSamples = 0;
+  }
+  return ok;
+}
@@ -0,0 +1,75 @@
+/*
+ * adaptive_timeout.h
+ * 
+ * Per-command AT timeouts learned from observed response times
+ * 
+ * Each command (keyed by its text up to the first '=' or '?', so AT+CNACT?
+ * and AT+CNACT=0,1 are tracked apart; for commands whose first parameter
+ * is the operation, such as AT+HTTPACTION=0 (GET) and =1 (POST), that
+ * parameter is part of the key) keeps a smoothed response time and
+ * its mean deviation, as TCP does for its retransmission timeout (RFC 6298):
+ *   srtt   = 7/8 srtt + 1/8 rtt
+ *   rttvar = 3/4 rttvar + 1/4 |srtt - rtt|
+ *   timeout = srtt + max(RTO_GRANULARITY_MS, 4 * rttvar)
+ * Modem response times are heavy-tailed, so the timeout is also kept above
+ * the slowest recent answer plus RTO_PEAK_HEADROOM_PERCENT (that peak decays
+ * by 1/RTO_PEAK_DECAY per answer). The result is clamped to
+ * [RTO_MIN_MS, RTO_MAX_FACTOR x the command's fixed timeout]; for AT+CGDCONT
+ * the fixed timeout is also the floor (only backoff lengthens it).
+ * Until a command has RTO_MIN_SAMPLES answers its fixed timeout is used.
+ * A timeout doubles the next wait for that command (up to the cap) until it
+ * answers again, so a slower network does not cause repeated false timeouts.
+ * 
+ * The table is kept in NVS (Preferences) and reloaded at boot; save() only
+ * writes after RTO_SAVE_EVERY new samples to spare the flash.
+ */
+
+#ifndef ADAPTIVE_TIMEOUT_H
+#define ADAPTIVE_TIMEOUT_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define RTO_KEY_LEN  16
+
+// ============================================
+// ADAPTIVE TIMEOUT CLASS
+// ============================================
+class AdaptiveTimeout {
+public:
+  AdaptiveTimeout();
+  
+  // Timeout for cmd; fixedMs is the timeout it replaces
+  uint32_t get(const char* cmd, uint32_t fixedMs);
+  
+  // Command answered (OK, ERROR or its result) after rttMs
+  void onResponse(const char* cmd, uint32_t rttMs);
+  
+  // Command got no answer in time
+  void onTimeout(const char* cmd);
+  
+  // NVS persistence; save() is a no-op until enough new samples
+  bool load();
+  bool save(bool force);
+  
+  void clear();
+
+private:
+  struct Entry {
+    char key[RTO_KEY_LEN];
+    uint32_t srttMs;
+    uint32_t rttvarMs;
+    uint32_t peakMs;           // Slowly decaying maximum
+    uint16_t samples;
+    uint8_t backoff;           // Timeouts since the last answer
+  };
+  
+  Entry entries[RTO_TABLE_SIZE];
+  uint16_t unsavedSamples;
+  
+  Entry* find(const char* cmd, bool create);
+  static void makeKey(const char* cmd, char* key);
+  static bool isFlooredAtFixed(const char* key);
+};
+
+#endif // ADAPTIVE_TIMEOUT_H
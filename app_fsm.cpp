@@ -0,0 +1,219 @@
+/*
+ * app_fsm.cpp
+ * 
+ * Implementation of the table-driven state machine engine
+ */
+
+#include "app_fsm.h"
+#include "logger.h"
+
+// ============================================
+// BEGIN
+// ============================================
+void AppFsm::begin(const FsmState* stateTable, uint8_t numStates,
+                   const FsmTransition* transitionTable, uint8_t numTransitions,
+                   uint8_t initialState, const char* const* names) {
+  states = stateTable;
+  stateCount = numStates;
+  transitions = transitionTable;
+  transitionCount = numTransitions;
+  eventNames = names;
+  
+  queueHead = 0;
+  queueCount = 0;
+  droppedEvents = 0;
+  traceHead = 0;
+  traceCount = 0;
+  memset(dwell, 0, sizeof(dwell));
+  for (uint8_t i = 0; i < FSM_MAX_STATES; i++) {
+    dwellHist[i].reset();
+  }
+  
+  current = initialState;
+  previous = initialState;
+  enteredMs = millis();
+  
+  const FsmState* s = findState(current);
+  if (s != nullptr && s->onEntry != nullptr) {
+    s->onEntry();
+  }
+}
+
+// ============================================
+// POST EVENT
+// ============================================
+bool AppFsm::post(uint8_t event) {
+  if (queueCount >= FSM_EVENT_QUEUE) {
+    droppedEvents++;
+    Logger::printf(LOG_ERROR, "FSM", "Event queue full - dropped %s",
+                   eventNames ? eventNames[event] : "?");
+    return false;
+  }
+  queue[(queueHead + queueCount) % FSM_EVENT_QUEUE] = event;
+  queueCount++;
+  return true;
+}
+
+// ============================================
+// RUN (one loop pass)
+// ============================================
+void AppFsm::run() {
+  // Events posted by actions during dispatch are handled in this same pass
+  while (queueCount > 0) {
+    uint8_t event = queue[queueHead];
+    queueHead = (queueHead + 1) % FSM_EVENT_QUEUE;
+    queueCount--;
+    dispatch(event);
+  }
+  
+  const FsmState* s = findState(current);
+  if (s != nullptr && s->onUpdate != nullptr) {
+    s->onUpdate();
+  }
+}
+
+// ============================================
+// DISPATCH ONE EVENT
+// ============================================
+void AppFsm::dispatch(uint8_t event) {
+  for (uint8_t i = 0; i < transitionCount; i++) {
+    const FsmTransition& t = transitions[i];
+    if ((t.from != current && t.from != FSM_ANY_STATE) || t.event != event) {
+      continue;
+    }
+    if (t.guard != nullptr && !t.guard()) {
+      continue;
+    }
+    
+    const FsmState* from = findState(current);
+    const FsmState* to = findState(t.to);
+    
+    if (from != nullptr && from->onExit != nullptr) {
+      from->onExit();
+    }
+    if (t.action != nullptr) {
+      t.action();
+    }
+    
+    uint32_t stamp = millis();
+    recordTransition(current, t.to, event);
+    
+    // Dwell of the state being left
+    if (current < FSM_MAX_STATES) {
+      FsmDwellStats& d = dwell[current];
+      uint32_t dwellMs = stamp - enteredMs;
+      d.entries++;
+      d.totalMs += dwellMs;
+      d.lastMs = dwellMs;
+      if (dwellMs > d.maxMs) {
+        d.maxMs = dwellMs;
+      }
+      dwellHist[current].record(dwellMs);
+    }
+    
+    Logger::printf(LOG_INFO, "Main", "State: %s -> %s (%s)",
+                   getStateName(current), getStateName(t.to),
+                   eventNames ? eventNames[event] : "?");
+    
+    previous = current;
+    current = t.to;
+    enteredMs = stamp;
+    
+    // Self-transitions re-run the entry action (used for retries)
+    if (to != nullptr && to->onEntry != nullptr) {
+      to->onEntry();
+    }
+    return;
+  }
+  
+  Logger::printf(LOG_DEBUG, "FSM", "Event %s ignored in %s",
+                 eventNames ? eventNames[event] : "?", getStateName(current));
+}
+
+// ============================================
+// TRACE / METRICS
+// ============================================
+void AppFsm::recordTransition(uint8_t from, uint8_t to, uint8_t event) {
+  FsmTraceEntry& e = trace[traceHead];
+  e.timeMs = millis();
+  e.from = from;
+  e.to = to;
+  e.event = event;
+  traceHead = (traceHead + 1) % FSM_TRACE_SIZE;
+  if (traceCount < FSM_TRACE_SIZE) {
+    traceCount++;
+  }
+}
+
+uint8_t AppFsm::getTraceCount() {
+  return traceCount;
+}
+
+FsmTraceEntry AppFsm::getTrace(uint8_t index) {
+  uint8_t oldest = (traceHead + FSM_TRACE_SIZE - traceCount) % FSM_TRACE_SIZE;
+  return trace[(oldest + index) % FSM_TRACE_SIZE];
+}
+
+FsmDwellStats AppFsm::getDwellStats(uint8_t state) {
+  FsmDwellStats empty = { 0, 0, 0, 0 };
+  return (state < FSM_MAX_STATES) ? dwell[state] : empty;
+}
+
+LatencyHistogram* AppFsm::getDwellHistogram(uint8_t state) {
+  return (state < FSM_MAX_STATES) ? &dwellHist[state] : nullptr;
+}
+
+void AppFsm::logDwellStats() {
+  for (uint8_t i = 0; i < stateCount; i++) {
+    uint8_t id = states[i].id;
+    FsmDwellStats d = getDwellStats(id);
+    if (d.entries == 0) {
+      continue;
+    }
+    Logger::printf(LOG_INFO, "FSM", "%-12s n=%lu avg=%lu ms max=%lu ms last=%lu ms",
+                   states[i].name, (unsigned long)d.entries, (unsigned long)(d.totalMs / d.entries),
+                   (unsigned long)d.maxMs, (unsigned long)d.lastMs);
+  }
+  if (droppedEvents > 0) {
+    Logger::printf(LOG_WARN, "FSM", "%lu events dropped", (unsigned long)droppedEvents);
+  }
+}
+
+void AppFsm::logTrace(uint8_t maxEntries) {
+  uint8_t count = (maxEntries < traceCount) ? maxEntries : traceCount;
+  for (uint8_t i = traceCount - count; i < traceCount; i++) {
+    FsmTraceEntry e = getTrace(i);
+    Logger::printf(LOG_INFO, "FSM", "[%lu] %s -> %s (%s)", (unsigned long)e.timeMs,
+                   getStateName(e.from), getStateName(e.to),
+                   eventNames ? eventNames[e.event] : "?");
+  }
+}
+
+// ============================================
+// ACCESSORS
+// ============================================
+uint8_t AppFsm::getState() {
+  return current;
+}
+
+uint8_t AppFsm::getPreviousState() {
+  return previous;
+}
+
+uint32_t AppFsm::getStateEnteredMs() {
+  return enteredMs;
+}
+
+const char* AppFsm::getStateName(uint8_t state) {
+  const FsmState* s = findState(state);
+  return s ? s->name : "UNKNOWN";
+}
+
+const FsmState* AppFsm::findState(uint8_t id) {
+  for (uint8_t i = 0; i < stateCount; i++) {
+    if (states[i].id == id) {
+      return &states[i];
+    }
+  }
+  return nullptr;
+}
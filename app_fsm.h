@@ -0,0 +1,123 @@
+/*
+ * app_fsm.h
+ * 
+ * Table-driven state machine engine with transition tracing
+ * 
+ * The application supplies compile-time tables of states (entry/update/exit
+ * actions) and transitions (from, event, guard, to, action). Events are
+ * queued with post() and dispatched by run(), so an action may post the next
+ * event without re-entering the dispatcher. Every transition is stamped into
+ * a trace ring and folded into per-state dwell-time metrics.
+ */
+
+#ifndef APP_FSM_H
+#define APP_FSM_H
+
+#include <Arduino.h>
+#include "latency_histogram.h"
+
+#define FSM_MAX_STATES     12
+#define FSM_EVENT_QUEUE    8
+#define FSM_TRACE_SIZE     32
+#define FSM_ANY_STATE      0xFF   // Transition row matches every state
+
+typedef void (*FsmAction)();
+typedef bool (*FsmGuard)();
+
+// State definition (actions may be nullptr)
+struct FsmState {
+  uint8_t id;
+  const char* name;
+  FsmAction onEntry;
+  FsmAction onUpdate;    // Called on every run() while in the state
+  FsmAction onExit;
+};
+
+// Transition row; first matching row whose guard passes wins
+struct FsmTransition {
+  uint8_t from;          // State id or FSM_ANY_STATE
+  uint8_t event;
+  FsmGuard guard;        // nullptr = always
+  uint8_t to;
+  FsmAction action;      // Runs between exit and entry (nullptr = none)
+};
+
+struct FsmTraceEntry {
+  uint32_t timeMs;
+  uint8_t from;
+  uint8_t to;
+  uint8_t event;
+};
+
+struct FsmDwellStats {
+  uint32_t entries;
+  uint32_t totalMs;
+  uint32_t maxMs;
+  uint32_t lastMs;
+};
+
+// ============================================
+// APP FSM CLASS
+// ============================================
+class AppFsm {
+public:
+  // Bind tables and enter the initial state (runs its entry action)
+  void begin(const FsmState* states, uint8_t stateCount,
+             const FsmTransition* transitions, uint8_t transitionCount,
+             uint8_t initialState, const char* const* eventNames);
+  
+  // Queue an event (safe from actions; not from ISRs)
+  bool post(uint8_t event);
+  
+  // Dispatch queued events, then run the current state's update action
+  void run();
+  
+  uint8_t getState();
+  uint8_t getPreviousState();
+  uint32_t getStateEnteredMs();
+  const char* getStateName(uint8_t state);
+  
+  // Dwell time per state (completed visits)
+  FsmDwellStats getDwellStats(uint8_t state);
+  
+  // Dwell-time histogram per state (nullptr if out of range); callers may
+  // snapshot, reset and merge it back for telemetry
+  LatencyHistogram* getDwellHistogram(uint8_t state);
+  
+  // Trace entries, oldest first (index < getTraceCount())
+  uint8_t getTraceCount();
+  FsmTraceEntry getTrace(uint8_t index);
+  
+  // Log dwell table and the most recent transitions
+  void logDwellStats();
+  void logTrace(uint8_t maxEntries);
+
+private:
+  const FsmState* states;
+  uint8_t stateCount;
+  const FsmTransition* transitions;
+  uint8_t transitionCount;
+  const char* const* eventNames;
+  
+  uint8_t current;
+  uint8_t previous;
+  uint32_t enteredMs;
+  
+  uint8_t queue[FSM_EVENT_QUEUE];
+  uint8_t queueHead;
+  uint8_t queueCount;
+  uint32_t droppedEvents;
+  
+  FsmTraceEntry trace[FSM_TRACE_SIZE];
+  uint8_t traceHead;
+  uint8_t traceCount;
+  
+  FsmDwellStats dwell[FSM_MAX_STATES];
+  LatencyHistogram dwellHist[FSM_MAX_STATES];
+  
+  const FsmState* findState(uint8_t id);
+  void dispatch(uint8_t event);
+  void recordTransition(uint8_t from, uint8_t to, uint8_t event);
+};
+
+#endif // APP_FSM_H
@@ -21,6 +21,24 @@ enum AppState {
   STATE_ERROR          // Error state (recoverable)
 };
 
+// ============================================
+// STATE MACHINE EVENTS (see transition table in the sketch)
+// ============================================
+enum AppEvent {
+  EVENT_INIT_DONE,       // setup() finished
+  EVENT_FATAL,           // Unrecoverable init failure
+  EVENT_PLAY_REQUEST,    // Tap / short press
+  EVENT_RECORD_REQUEST,  // Hold / long press
+  EVENT_REPLAY_REQUEST,  // Double tap - replay last tag
+  EVENT_UID_READ,        // NFC UID available
+  EVENT_TIMEOUT,         // State timed out
+  EVENT_AUDIO_READY,     // Audio buffered for playback
+  EVENT_NO_AUDIO,        // Server had nothing for the tag
+  EVENT_DONE,            // State finished its work
+  EVENT_FAILED,          // State's operation failed
+  EVENT_COUNT
+};
+
 // ============================================
 // ACTION TYPES (determined by button press)
 // ============================================
@@ -7,6 +7,7 @@
 #include "audio_manager.h"
 #include "logger.h"
 #include "config.h"
+#include "profiler.h"
 #include "soc/i2s_reg.h"   // For I2S register definitions
 #include "soc/i2s_struct.h" // For I2S register structure
 #include "soc/dport_access.h" // For DPORT register access macros
@@ -30,6 +31,19 @@ bool AudioManager::init(uint8_t micBclkPin, uint8_t micLrclkPin, uint8_t micData
   currentMode = AUDIO_MODE_NONE;
   initialized = true;
   currentSampleRate = SAMPLE_RATE;
+  resetCaptureStats();
+  
+  // Health monitor state (see MicWatchdog)
+  if (i2sLock == NULL) {
+    i2sLock = xSemaphoreCreateMutex();
+  }
+  recovering = false;
+  stuckBlockRun = 0;
+  lastGoodBlockMs = millis();
+  captureGeneration = 0;
+  backfillStartMs = 0;
+  backfillEndMs = 0;
+  backfillSamples = 0;
   
   Logger::printf(LOG_INFO, "Audio", "Audio manager initialized");
   Logger::printf(LOG_INFO, "Audio", "Mic pins: BCLK=GPIO%d, LRCLK=GPIO%d, DATA=GPIO%d", 
@@ -63,6 +77,7 @@ bool AudioManager::startPlayback(uint32_t sampleRate) {
 // WRITE PLAYBACK DATA
 // ============================================
 size_t AudioManager::writePlaybackData(const uint8_t* data, size_t length) {
+  PROFILE_ZONE(PROF_SPK_WRITE);
   if (currentMode != AUDIO_MODE_PLAYBACK) {
     LOG_E("Audio", "Not in playback mode");
     return 0;
@@ -104,6 +119,12 @@ bool AudioManager::startRecording(uint32_t sampleRate) {
   
   LOG_I("Audio", "Starting recording mode...");
   
+  // No backfill carried over from a recovery in the previous clip
+  recovering = false;
+  backfillStartMs = 0;
+  backfillEndMs = 0;
+  backfillSamples = 0;
+  
   if (!reconfigureI2S(AUDIO_MODE_RECORDING, sampleRate)) {
     LOG_E("Audio", "Failed to configure I2S for recording");
     return false;
@@ -112,6 +133,12 @@ bool AudioManager::startRecording(uint32_t sampleRate) {
   // Clear DMA buffer to avoid reading stale data
   i2s_zero_dma_buffer(I2S_PORT_RECORDING);
   
+  // New clip - start fresh quality statistics and health counters
+  resetCaptureStats();
+  stuckBlockRun = 0;
+  lastGoodBlockMs = millis();
+  captureGeneration++;
+  
   // ESP32 I2S RX mode: Sometimes LRCLK doesn't start until we start reading
   // Trigger a blocking read to start the clocks properly and ensure DMA is ready
   uint8_t dummyBuffer[64];
@@ -133,9 +160,33 @@ bool AudioManager::startRecording(uint32_t sampleRate) {
 // ============================================
 // READ RECORDED DATA
 // ============================================
+// While the mic watchdog is restarting I2S (or right after), the caller gets
+// silence at the real-time sample rate so downstream timing stays consistent.
+size_t AudioManager::readRecordedData(uint8_t* buffer, size_t maxLength) {
+  PROFILE_ZONE(PROF_MIC_READ);
+  if (recovering || isBackfillPending()) {
+    return readSilenceBackfill(buffer, maxLength);
+  }
+  
+  // Non-blocking: if the watchdog holds the lock, it is mid-restart
+  if (i2sLock != NULL && xSemaphoreTake(i2sLock, 0) != pdTRUE) {
+    return readSilenceBackfill(buffer, maxLength);
+  }
+  
+  size_t result = readRecordedDataLocked(buffer, maxLength);
+  
+  if (i2sLock != NULL) {
+    xSemaphoreGive(i2sLock);
+  }
+  return result;
+}
+
+// ============================================
+// READ RECORDED DATA (I2S lock held)
+// ============================================
 // SPH0645LM4H outputs 32-bit samples with 18-bit audio data (left-aligned)
 // We need to extract the 18-bit data and convert to 16-bit
-size_t AudioManager::readRecordedData(uint8_t* buffer, size_t maxLength) {
+size_t AudioManager::readRecordedDataLocked(uint8_t* buffer, size_t maxLength) {
   if (currentMode != AUDIO_MODE_RECORDING) {
     LOG_E("Audio", "Not in recording mode");
     return 0;
@@ -164,6 +215,7 @@ size_t AudioManager::readRecordedData(uint8_t* buffer, size_t maxLength) {
   }
   
   if (result != ESP_OK) {
+    captureStats.droppedBlocks++;
     static unsigned long lastError = 0;
     if (millis() - lastError > 2000) {  // Log errors every 2 seconds
       lastError = millis();
@@ -235,64 +287,22 @@ size_t AudioManager::readRecordedData(uint8_t* buffer, size_t maxLength) {
     }
   }
   
-  // SPH0645LM4H: 24-bit signed audio left-justified in 32-bit word
-  // Data is in bits [31:8], bits [7:0] are padding
-  // I2S configured for stereo (RIGHT_LEFT) - mono mode causes all-zero samples on ESP32
-  // Extract only LEFT channel samples (even indices: 0, 2, 4, ...)
-  // Properly sign-extend 24-bit sample before converting to 16-bit PCM
-  
-  // DC Offset Removal Filter
-  // Uses a running average (IIR high-pass) to track and remove DC bias
-  // Algorithm: dc_estimate slowly tracks DC component, then subtract it from signal
-  // Filter coefficient N=7: time constant ≈ 128 samples (8ms at 16kHz)
-  // Integer-only math for embedded real-time processing
-  static int32_t dc_estimate = 0;  // Running estimate of DC offset
-  const int N = 7;  // Filter coefficient: 1/128 per sample (slow DC tracking)
-  
-  size_t monoSampleCount = 0;
-  for (size_t i = 0; i < samplesRead; i += 2) {  // Step by 2 to get LEFT channel only (even indices)
-    if (i >= samplesRead) break;  // Safety check
-    
-    uint32_t raw = i2sBuffer[i];  // LEFT channel (even index)
-    
-    // Extract 24-bit signed PCM from bits [31:8]
-    // Cast to int32_t first, then shift: this preserves sign bit (bit 31)
-    // Right-shift by 8 moves 24-bit data to bits [23:0], with automatic sign extension
-    int32_t sample24bit = ((int32_t)raw) >> 8;  // Sign-extends correctly from bit 31
-    
-    // Convert to 16-bit PCM: shift right by 8 more bits (truncate lower 8 bits of 24-bit sample)
-    int16_t pcm = (int16_t)(sample24bit >> 8);
-    
-    // DC Offset Removal: IIR high-pass filter
-    // Update DC estimate using slow low-pass filter: dc_estimate = dc_estimate * (1 - 1/2^N) + pcm
-    // This tracks the slowly-varying DC component (bias around -3500)
-    dc_estimate = dc_estimate - (dc_estimate >> N) + (int32_t)pcm;
-    
-    // Remove DC offset: subtract the filtered DC estimate from the signal
-    // This centers the audio around zero while preserving audio content
-    int32_t pcm_dc_removed = (int32_t)pcm - (dc_estimate >> N);
-    
-    // High-Pass Filter: Remove low-frequency noise and rumble (< 80Hz)
-    // First-order IIR high-pass filter: y[n] = a*y[n-1] + a*(x[n] - x[n-1])
-    // Cutoff ~80Hz at 22kHz: a ≈ 0.997 (calculated: a = exp(-2*π*fc/fs))
-    // Integer implementation: a = 1023/1024 (close approximation)
-    static int32_t hp_last_input = 0;
-    static int32_t hp_last_output = 0;
-    const int32_t hp_alpha = 1023;  // a * 1024 for integer math
-    int32_t hp_input = pcm_dc_removed;
-    int32_t hp_output = (hp_alpha * hp_last_output) / 1024 + (hp_alpha * (hp_input - hp_last_input)) / 1024;
-    hp_last_input = hp_input;
-    hp_last_output = hp_output;
-    int32_t pcm_filtered = hp_output;
-    
-    // Clamp to 16-bit range to prevent overflow
-    if (pcm_filtered > 32767) pcm_filtered = 32767;
-    if (pcm_filtered < -32768) pcm_filtered = -32768;
-    
-    outputBuffer[monoSampleCount++] = (int16_t)pcm_filtered;
+  // Convert, filter and update capture statistics in one pass
+  bool allZerosThisRead = true;
+  bool allOnesThisRead = true;
+  size_t monoSampleCount = processCaptureBlock(i2sBuffer, samplesRead, outputBuffer,
+                                               &allZerosThisRead, &allOnesThisRead);
+  
+  // Track stuck mic output for the health monitor (MicWatchdog)
+  // Stuck = every LEFT sample in the block is 0x00000000 or every one is 0x00000001
+  if (allZerosThisRead || allOnesThisRead) {
+    stuckBlockRun++;
+  } else {
+    stuckBlockRun = 0;
+    lastGoodBlockMs = millis();
   }
   
-  // Track intermittent zero-data periods for automatic recovery
+  // Track intermittent zero-data periods (recovery is done off this path by MicWatchdog)
   static int consecutiveZeroReads = 0;
   static int totalReads = 0;
   static int zeroReads = 0;
@@ -300,19 +310,14 @@ size_t AudioManager::readRecordedData(uint8_t* buffer, size_t maxLength) {
   
   totalReads++;
   
-  // Check if ALL samples in this read are zero
-  bool allZerosThisRead = true;
-  for (size_t i = 0; i < samplesRead && i < 10; i++) {
-    if (i2sBuffer[i] != 0x00000000) {
-      allZerosThisRead = false;
-      lastNonZeroTime = millis();
-      break;
-    }
+  if (!allZerosThisRead) {
+    lastNonZeroTime = millis();
   }
   
   if (allZerosThisRead) {
     consecutiveZeroReads++;
     zeroReads++;
+    captureStats.droppedBlocks++;
     
     // Log warning if we get many consecutive zeros (intermittent issue)
     if (consecutiveZeroReads == 10) {
@@ -321,20 +326,7 @@ size_t AudioManager::readRecordedData(uint8_t* buffer, size_t maxLength) {
     } else if (consecutiveZeroReads == 50) {
       LOG_W("Audio", "⚠️  INTERMITTENT FAILURE: 50 consecutive zero reads!");
       LOG_W("Audio", "Microphone data stopped. Check: power, wiring, loose connections");
-      LOG_W("Audio", "Attempting automatic I2S restart...");
-      
-      // Automatic recovery: restart I2S
-      if (currentMode == AUDIO_MODE_RECORDING) {
-        uint32_t savedRate = currentSampleRate;
-        shutdownI2S();
-        delay(100);
-        if (reconfigureI2S(AUDIO_MODE_RECORDING, savedRate)) {
-          LOG_I("Audio", "✅ I2S restarted successfully - monitoring for recovery");
-          consecutiveZeroReads = 0;  // Reset counter
-        } else {
-          LOG_E("Audio", "❌ I2S restart failed!");
-        }
-      }
+      LOG_W("Audio", "I2S restart is left to the mic watchdog (off the read path)");
     }
   } else {
     // Got non-zero data - reset counter
@@ -388,14 +380,274 @@ size_t AudioManager::readRecordedData(uint8_t* buffer, size_t maxLength) {
   return monoSampleCount * sizeof(int16_t);
 }
 
+// ============================================
+// PROCESS CAPTURE BLOCK (conversion + DSP + stats)
+// ============================================
+// Pure computation on a block already read from I2S; split out of
+// readRecordedDataLocked() so it can be benchmarked without the microphone.
+size_t AudioManager::processCaptureBlock(const uint32_t* i2sBuffer, size_t samplesRead, int16_t* outputBuffer,
+                                         bool* allZerosOut, bool* allOnesOut) {
+  // SPH0645LM4H: 24-bit signed audio left-justified in 32-bit word
+  // Data is in bits [31:8], bits [7:0] are padding
+  // I2S configured for stereo (RIGHT_LEFT) - mono mode causes all-zero samples on ESP32
+  // Extract only LEFT channel samples (even indices: 0, 2, 4, ...)
+  // Properly sign-extend 24-bit sample before converting to 16-bit PCM
+  
+  // DC Offset Removal Filter
+  // Uses a running average (IIR high-pass) to track and remove DC bias
+  // Algorithm: dc_estimate slowly tracks DC component, then subtract it from signal
+  // Filter coefficient N=7: time constant ≈ 128 samples (8ms at 16kHz)
+  // Integer-only math for embedded real-time processing
+  static int32_t dc_estimate = 0;  // Running estimate of DC offset
+  const int N = 7;  // Filter coefficient: 1/128 per sample (slow DC tracking)
+  
+  // Capture statistics are accumulated in this same pass (no second pass over the clip)
+  bool allZeros = true;
+  bool allOnes = true;
+  
+  size_t monoSampleCount = 0;
+  for (size_t i = 0; i < samplesRead; i += 2) {  // Step by 2 to get LEFT channel only (even indices)
+    if (i >= samplesRead) break;  // Safety check
+    
+    uint32_t raw = i2sBuffer[i];  // LEFT channel (even index)
+    if (raw != 0x00000000) {
+      allZeros = false;
+    }
+    if (raw != 0x00000001) {
+      allOnes = false;
+    }
+    
+    // Extract 24-bit signed PCM from bits [31:8]
+    // Cast to int32_t first, then shift: this preserves sign bit (bit 31)
+    // Right-shift by 8 moves 24-bit data to bits [23:0], with automatic sign extension
+    int32_t sample24bit = ((int32_t)raw) >> 8;  // Sign-extends correctly from bit 31
+    
+    // Convert to 16-bit PCM: shift right by 8 more bits (truncate lower 8 bits of 24-bit sample)
+    int16_t pcm = (int16_t)(sample24bit >> 8);
+    
+    // DC Offset Removal: IIR high-pass filter
+    // Update DC estimate using slow low-pass filter: dc_estimate = dc_estimate * (1 - 1/2^N) + pcm
+    // This tracks the slowly-varying DC component (bias around -3500)
+    dc_estimate = dc_estimate - (dc_estimate >> N) + (int32_t)pcm;
+    
+    // Remove DC offset: subtract the filtered DC estimate from the signal
+    // This centers the audio around zero while preserving audio content
+    int32_t pcm_dc_removed = (int32_t)pcm - (dc_estimate >> N);
+    
+    // High-Pass Filter: Remove low-frequency noise and rumble (< 80Hz)
+    // First-order IIR high-pass filter: y[n] = a*y[n-1] + a*(x[n] - x[n-1])
+    // Cutoff ~80Hz at 22kHz: a ≈ 0.997 (calculated: a = exp(-2*π*fc/fs))
+    // Integer implementation: a = 1023/1024 (close approximation)
+    static int32_t hp_last_input = 0;
+    static int32_t hp_last_output = 0;
+    const int32_t hp_alpha = 1023;  // a * 1024 for integer math
+    int32_t hp_input = pcm_dc_removed;
+    int32_t hp_output = (hp_alpha * hp_last_output) / 1024 + (hp_alpha * (hp_input - hp_last_input)) / 1024;
+    hp_last_input = hp_input;
+    hp_last_output = hp_output;
+    int32_t pcm_filtered = hp_output;
+    
+    // Clamp to 16-bit range to prevent overflow
+    if (pcm_filtered > 32767) pcm_filtered = 32767;
+    if (pcm_filtered < -32768) pcm_filtered = -32768;
+    
+    outputBuffer[monoSampleCount++] = (int16_t)pcm_filtered;
+    
+    // Update per-clip quality statistics
+    int32_t absRaw = (pcm < 0) ? -(int32_t)pcm : (int32_t)pcm;
+    int32_t absOut = (pcm_filtered < 0) ? -pcm_filtered : pcm_filtered;
+    captureStats.rawSum += pcm;
+    captureStats.sumSquares += (uint64_t)((int64_t)pcm_filtered * pcm_filtered);
+    if (absOut > captureStats.peak) captureStats.peak = (uint16_t)absOut;
+    if (absRaw >= CAPTURE_CLIP_LEVEL || absOut >= CAPTURE_CLIP_LEVEL) captureStats.clippedSamples++;
+    if (absOut < CAPTURE_SILENCE_LEVEL) captureStats.silentSamples++;
+  }
+  
+  captureStats.sampleCount += monoSampleCount;
+  captureStats.blockCount++;
+  
+  *allZerosOut = allZeros;
+  *allOnesOut = allOnes;
+  return monoSampleCount;
+}
+
 // ============================================
 // STOP RECORDING
 // ============================================
 void AudioManager::stopRecording() {
+  if (i2sLock != NULL) {
+    xSemaphoreTake(i2sLock, portMAX_DELAY);
+  }
+  
   if (currentMode == AUDIO_MODE_RECORDING) {
     LOG_I("Audio", "Stopping recording");
     shutdownI2S();
   }
+  recovering = false;
+  backfillEndMs = backfillStartMs;
+  backfillSamples = 0;
+  
+  if (i2sLock != NULL) {
+    xSemaphoreGive(i2sLock);
+  }
+}
+
+// ============================================
+// RESTART CAPTURE (called by MicWatchdog)
+// ============================================
+// Runs in the watchdog task. The reader gets silence backfill while this holds
+// the I2S lock, so the blocking shutdown/reconfigure never stalls the caller.
+bool AudioManager::restartCapture() {
+  if (currentMode != AUDIO_MODE_RECORDING || i2sLock == NULL) {
+    return false;
+  }
+  
+  // Publish backfill window before taking the lock so the reader never sees a stale start
+  backfillStartMs = millis();
+  backfillEndMs = backfillStartMs;
+  backfillSamples = 0;
+  recovering = true;
+  
+  xSemaphoreTake(i2sLock, portMAX_DELAY);
+  
+  bool ok = false;
+  if (currentMode == AUDIO_MODE_RECORDING) {
+    uint32_t savedRate = currentSampleRate;
+    shutdownI2S();
+    delay(100);
+    ok = reconfigureI2S(AUDIO_MODE_RECORDING, savedRate);
+    if (ok) {
+      i2s_zero_dma_buffer(I2S_PORT_RECORDING);
+    }
+  }
+  
+  stuckBlockRun = 0;
+  lastGoodBlockMs = millis();
+  if (currentMode == AUDIO_MODE_RECORDING) {
+    backfillEndMs = millis();
+  } else {
+    // Recording stopped meanwhile: the clip has ended, nothing is owed
+    backfillEndMs = backfillStartMs;
+    backfillSamples = 0;
+  }
+  recovering = false;
+  
+  xSemaphoreGive(i2sLock);
+  return ok;
+}
+
+// ============================================
+// HEALTH COUNTERS (read by MicWatchdog)
+// ============================================
+uint32_t AudioManager::getStuckBlockRun() {
+  return stuckBlockRun;
+}
+
+uint32_t AudioManager::getMsSinceLastGoodBlock() {
+  return millis() - lastGoodBlockMs;
+}
+
+uint32_t AudioManager::getCaptureGeneration() {
+  return captureGeneration;
+}
+
+// ============================================
+// SILENCE BACKFILL
+// ============================================
+// Samples owed = time covered by the recovery window at the current sample rate
+// minus what has already been handed out.
+bool AudioManager::isBackfillPending() {
+  uint32_t endMs = recovering ? millis() : backfillEndMs;
+  uint32_t owed = (uint32_t)((uint64_t)(endMs - backfillStartMs) * currentSampleRate / 1000);
+  return owed > backfillSamples;
+}
+
+size_t AudioManager::readSilenceBackfill(uint8_t* buffer, size_t maxLength) {
+  uint32_t endMs = recovering ? millis() : backfillEndMs;
+  uint32_t owed = (uint32_t)((uint64_t)(endMs - backfillStartMs) * currentSampleRate / 1000);
+  if (owed <= backfillSamples) {
+    return 0;
+  }
+  
+  size_t samples = owed - backfillSamples;
+  size_t maxSamples = maxLength / sizeof(int16_t);
+  if (samples > maxSamples) {
+    samples = maxSamples;
+  }
+  
+  memset(buffer, 0, samples * sizeof(int16_t));
+  backfillSamples += samples;
+  
+  captureStats.sampleCount += samples;
+  captureStats.silentSamples += samples;
+  
+  return samples * sizeof(int16_t);
+}
+
+// ============================================
+// RESET CAPTURE STATISTICS
+// ============================================
+void AudioManager::resetCaptureStats() {
+  memset(&captureStats, 0, sizeof(captureStats));
+}
+
+// ============================================
+// GET CAPTURE STATISTICS
+// ============================================
+const CaptureStats& AudioManager::getCaptureStats() {
+  return captureStats;
+}
+
+// ============================================
+// GET CAPTURE RMS
+// ============================================
+float AudioManager::getCaptureRms() {
+  if (captureStats.sampleCount == 0) {
+    return 0.0f;
+  }
+  return sqrtf((float)((double)captureStats.sumSquares / captureStats.sampleCount));
+}
+
+// ============================================
+// GET CAPTURE DC OFFSET (raw, before DC removal)
+// ============================================
+float AudioManager::getCaptureDcOffset() {
+  if (captureStats.sampleCount == 0) {
+    return 0.0f;
+  }
+  return (float)((double)captureStats.rawSum / captureStats.sampleCount);
+}
+
+// ============================================
+// GET CAPTURE SILENT PERCENTAGE
+// ============================================
+float AudioManager::getCaptureSilentPercent() {
+  if (captureStats.sampleCount == 0) {
+    return 0.0f;
+  }
+  return 100.0f * captureStats.silentSamples / captureStats.sampleCount;
+}
+
+// ============================================
+// FORMAT CAPTURE STATISTICS
+// ============================================
+// Format: rms=<f>;peak=<n>;clip=<n>;dc=<f>;silent=<f>;dropped=<n>;samples=<n>
+size_t AudioManager::formatCaptureStats(char* buffer, size_t bufferSize) {
+  if (buffer == nullptr || bufferSize == 0) {
+    return 0;
+  }
+  int written = snprintf(buffer, bufferSize,
+                         "rms=%.1f;peak=%u;clip=%lu;dc=%.1f;silent=%.1f;dropped=%lu;samples=%lu",
+                         getCaptureRms(), captureStats.peak,
+                         (unsigned long)captureStats.clippedSamples,
+                         getCaptureDcOffset(), getCaptureSilentPercent(),
+                         (unsigned long)captureStats.droppedBlocks,
+                         (unsigned long)captureStats.sampleCount);
+  if (written < 0) {
+    buffer[0] = '\0';
+    return 0;
+  }
+  return ((size_t)written < bufferSize) ? (size_t)written : bufferSize - 1;
 }
 
 // ============================================
@@ -10,6 +10,8 @@
 
 #include <Arduino.h>
 #include <driver/i2s.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 // ============================================
 // AUDIO MODE
@@ -20,6 +22,22 @@ enum AudioMode {
   AUDIO_MODE_RECORDING
 };
 
+// ============================================
+// CAPTURE STATISTICS (per recording clip)
+// ============================================
+// Updated incrementally in readRecordedData() in the same pass as the
+// 32-bit -> 16-bit conversion, so no second pass over the clip is needed.
+struct CaptureStats {
+  uint32_t sampleCount;      // Mono samples delivered to caller
+  uint32_t blockCount;       // I2S blocks converted
+  uint32_t droppedBlocks;    // Failed reads + all-zero blocks from mic
+  uint32_t clippedSamples;   // |sample| >= CAPTURE_CLIP_LEVEL (raw or after filtering)
+  uint32_t silentSamples;    // |sample| < CAPTURE_SILENCE_LEVEL (after filtering)
+  uint16_t peak;             // Max |sample| after filtering
+  int64_t  rawSum;           // Sum of raw (pre-filter) samples, for DC offset
+  uint64_t sumSquares;       // Sum of squared filtered samples, for RMS
+};
+
 // ============================================
 // AUDIO MANAGER CLASS
 // ============================================
@@ -53,11 +71,53 @@ public:
   
   // Read recorded audio data
   // Returns number of bytes actually read
+  // During a watchdog restart, returns silence at the real-time rate instead
   size_t readRecordedData(uint8_t* buffer, size_t maxLength);
   
   // Stop recording
   void stopRecording();
   
+  // ========================================
+  // CAPTURE QUALITY FUNCTIONS
+  // ========================================
+  
+  // Convert one raw I2S block (stereo 32-bit words) to filtered 16-bit mono,
+  // updating capture statistics. Called by readRecordedData(); public so the
+  // DSP can be benchmarked on synthetic input. Returns mono samples written.
+  size_t processCaptureBlock(const uint32_t* i2sBuffer, size_t samplesRead, int16_t* outputBuffer,
+                             bool* allZeros, bool* allOnes);
+  
+  // Reset per-clip statistics (called automatically by startRecording)
+  void resetCaptureStats();
+  
+  // Raw per-clip statistics accumulated so far
+  const CaptureStats& getCaptureStats();
+  
+  // Derived values
+  float getCaptureRms();
+  float getCaptureDcOffset();       // Mean raw sample before DC removal
+  float getCaptureSilentPercent();
+  
+  // Format stats as compact "key=value;..." metadata for upload
+  // Returns number of characters written (excluding terminator)
+  size_t formatCaptureStats(char* buffer, size_t bufferSize);
+  
+  // ========================================
+  // HEALTH FUNCTIONS (used by MicWatchdog task)
+  // ========================================
+  
+  // Restart I2S capture off the read path (blocking; call from watchdog task)
+  bool restartCapture();
+  
+  // Consecutive blocks stuck at 0x00000000 or 0x00000001
+  uint32_t getStuckBlockRun();
+  
+  // Time since the last block with real microphone data
+  uint32_t getMsSinceLastGoodBlock();
+  
+  // Incremented on every startRecording() (one per clip)
+  uint32_t getCaptureGeneration();
+  
   // ========================================
   // STATUS FUNCTIONS
   // ========================================
@@ -82,6 +142,21 @@ private:
   bool initialized;
   uint32_t currentSampleRate;
   
+  // Per-clip capture statistics
+  CaptureStats captureStats;
+  
+  // Health monitor state (shared with MicWatchdog task)
+  SemaphoreHandle_t i2sLock;          // Held during I2S reads and restarts
+  volatile bool recovering;           // Watchdog restart in progress
+  volatile uint32_t stuckBlockRun;
+  volatile uint32_t lastGoodBlockMs;
+  volatile uint32_t captureGeneration;
+  
+  // Silence backfill window covering a restart
+  volatile uint32_t backfillStartMs;
+  volatile uint32_t backfillEndMs;
+  uint32_t backfillSamples;           // Samples already handed out
+  
   // I2S configuration helpers
   i2s_config_t getPlaybackConfig(uint32_t sampleRate);
   i2s_pin_config_t getPlaybackPins();
@@ -89,6 +164,11 @@ private:
   i2s_config_t getRecordingConfig(uint32_t sampleRate);
   i2s_pin_config_t getRecordingPins();
   
+  // Recording helpers
+  size_t readRecordedDataLocked(uint8_t* buffer, size_t maxLength);
+  bool isBackfillPending();
+  size_t readSilenceBackfill(uint8_t* buffer, size_t maxLength);
+  
   // Safe reconfiguration
   bool reconfigureI2S(AudioMode newMode, uint32_t sampleRate);
   void shutdownI2S();
@@ -0,0 +1,162 @@
+/*
+ * audio_prefetch.cpp
+ * 
+ * Implementation of background audio prefetch
+ */
+
+#include "audio_prefetch.h"
+#include "logger.h"
+#include "config.h"
+
+// ============================================
+// START PREFETCHER
+// ============================================
+bool AudioPrefetcher::begin(PrefetchFetchFn fetchFn, size_t bufferSize) {
+  fetch = fetchFn;
+  state = PREFETCH_EMPTY;
+  requestedUid[0] = '\0';
+  holdUid[0] = '\0';
+  retryDelayMs = 0;
+  prefetchLength = 0;
+  prefetchBufferSize = bufferSize;
+  
+  prefetchBuffer = (uint8_t*)malloc(bufferSize);
+  if (!prefetchBuffer) {
+    LOG_E("Prefetch", "Failed to allocate prefetch buffer");
+    return false;
+  }
+  
+  // Stack sized for LTEManager (String-based AT parsing)
+  if (xTaskCreate(taskEntry, "prefetch", 8192, this, 1, &taskHandle) != pdPASS) {
+    LOG_E("Prefetch", "Failed to create prefetch task");
+    free(prefetchBuffer);
+    prefetchBuffer = NULL;
+    return false;
+  }
+  
+  Logger::printf(LOG_INFO, "Prefetch", "Prefetcher ready (%d byte buffer)", bufferSize);
+  return true;
+}
+
+// ============================================
+// REQUEST PREFETCH
+// ============================================
+bool AudioPrefetcher::request(const char* uid) {
+  if (prefetchBuffer == NULL || state == PREFETCH_BUSY) {
+    return false;
+  }
+  
+  // Already have fresh audio for this tag
+  if (state == PREFETCH_READY && strcmp(requestedUid, uid) == 0 &&
+      millis() - readyTime < PREFETCH_MAX_AGE_MS) {
+    return false;
+  }
+  
+  if (strcmp(holdUid, uid) == 0 && (long)(millis() - holdUntil) < 0) {
+    return false;
+  }
+  
+  strncpy(requestedUid, uid, sizeof(requestedUid) - 1);
+  requestedUid[sizeof(requestedUid) - 1] = '\0';
+  requestTime = millis();
+  state = PREFETCH_BUSY;
+  
+  Logger::printf(LOG_INFO, "Prefetch", "Tag %s seen - prefetching audio", requestedUid);
+  xTaskNotifyGive(taskHandle);
+  return true;
+}
+
+// ============================================
+// STATUS
+// ============================================
+bool AudioPrefetcher::isBusy() {
+  return state == PREFETCH_BUSY;
+}
+
+bool AudioPrefetcher::waitIdle(uint32_t timeout_ms) {
+  unsigned long start = millis();
+  while (state == PREFETCH_BUSY) {
+    if (millis() - start >= timeout_ms) {
+      return false;
+    }
+    delay(10);
+  }
+  return true;
+}
+
+// ============================================
+// TAKE PREFETCHED AUDIO (buffer swap)
+// ============================================
+bool AudioPrefetcher::take(const char* uid, uint8_t** buffer, size_t* length) {
+  if (state != PREFETCH_READY || strcmp(requestedUid, uid) != 0) {
+    return false;
+  }
+  if (millis() - readyTime >= PREFETCH_MAX_AGE_MS) {
+    LOG_I("Prefetch", "Prefetched audio too old - discarding");
+    invalidate();
+    return false;
+  }
+  
+  uint8_t* swap = *buffer;
+  *buffer = prefetchBuffer;
+  *length = prefetchLength;
+  prefetchBuffer = swap;
+  prefetchLength = 0;
+  state = PREFETCH_EMPTY;
+  
+  // The tag is likely still on the reader; its audio was just delivered
+  retryDelayMs = 0;
+  holdOff(uid, PREFETCH_MAX_AGE_MS);
+  return true;
+}
+
+void AudioPrefetcher::invalidate() {
+  if (state != PREFETCH_BUSY) {
+    state = PREFETCH_EMPTY;
+    prefetchLength = 0;
+  }
+}
+
+void AudioPrefetcher::holdOff(const char* uid, uint32_t delayMs) {
+  strncpy(holdUid, uid, sizeof(holdUid) - 1);
+  holdUid[sizeof(holdUid) - 1] = '\0';
+  holdUntil = millis() + delayMs;
+}
+
+// ============================================
+// WORKER TASK
+// ============================================
+void AudioPrefetcher::taskEntry(void* arg) {
+  ((AudioPrefetcher*)arg)->run();
+}
+
+void AudioPrefetcher::run() {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (state != PREFETCH_BUSY) {
+      continue;
+    }
+    
+    size_t length = 0;
+    bool ok = fetch(requestedUid, prefetchBuffer, prefetchBufferSize, &length) && length > 0;
+    
+    prefetchLength = ok ? length : 0;
+    readyTime = millis();
+    Logger::printf(ok ? LOG_INFO : LOG_WARN, "Prefetch", "Prefetch for %s %s in %lu ms (%d bytes)", 
+                   requestedUid, ok ? "done" : "failed", readyTime - requestTime, prefetchLength);
+    if (ok) {
+      retryDelayMs = 0;
+      holdUid[0] = '\0';
+    } else {
+      // Back off per tag: a failing tag left on the reader is not re-fetched every poll
+      bool again = strcmp(holdUid, requestedUid) == 0 && retryDelayMs > 0;
+      retryDelayMs = again ? retryDelayMs * 2 : PREFETCH_RETRY_MS;
+      if (retryDelayMs > PREFETCH_RETRY_MAX_MS) {
+        retryDelayMs = PREFETCH_RETRY_MAX_MS;
+      }
+      holdOff(requestedUid, retryDelayMs);
+      Logger::printf(LOG_INFO, "Prefetch", "Not retrying %s for %lu ms", requestedUid, (unsigned long)retryDelayMs);
+    }
+    state = ok ? PREFETCH_READY : PREFETCH_FAILED;
+  }
+}
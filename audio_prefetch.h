@@ -0,0 +1,81 @@
+/*
+ * audio_prefetch.h
+ * 
+ * Background prefetch of a tag's audio while the tag is on the reader
+ * 
+ * A FreeRTOS task runs the fetch into a private buffer; when the user then
+ * presses the button, the buffer is swapped with the playback buffer.
+ * While a fetch is in flight the task owns the LTE modem, so the main loop
+ * must check isBusy() (or call waitIdle()) before using LTEManager.
+ */
+
+#ifndef AUDIO_PREFETCH_H
+#define AUDIO_PREFETCH_H
+
+#include <Arduino.h>
+
+// Fetch function: fill buffer with the message for uid, return false on failure.
+// "uid" is whatever key the caller requests by (the sketch uses the cache key
+// of the URL the tag resolves to, so a take() never mixes up URLs).
+typedef bool (*PrefetchFetchFn)(const char* uid, uint8_t* buffer, size_t bufferSize, size_t* length);
+
+// ============================================
+// PREFETCH STATE
+// ============================================
+enum PrefetchState {
+  PREFETCH_EMPTY,      // Nothing fetched
+  PREFETCH_BUSY,       // Fetch in progress (task owns the modem)
+  PREFETCH_READY,      // Audio for readyUid is buffered
+  PREFETCH_FAILED      // Last fetch failed
+};
+
+// ============================================
+// AUDIO PREFETCHER CLASS
+// ============================================
+class AudioPrefetcher {
+public:
+  // Allocate prefetch buffer and start the worker task
+  bool begin(PrefetchFetchFn fetchFn, size_t bufferSize);
+  
+  // Start a background fetch for uid (ignored if busy, already ready for uid,
+  // or uid is held off: its last prefetch failed or its audio was just taken)
+  bool request(const char* uid);
+  
+  // True while the worker task owns the modem
+  bool isBusy();
+  
+  // Block until no fetch is in flight (returns false on timeout)
+  bool waitIdle(uint32_t timeout_ms);
+  
+  // Take prefetched audio for uid by swapping buffers with the caller.
+  // buffer must be a bufferSize allocation; on success it is replaced by the
+  // prefetched buffer and the old one becomes the new prefetch buffer.
+  bool take(const char* uid, uint8_t** buffer, size_t* length);
+  
+  // Drop any buffered result
+  void invalidate();
+
+private:
+  PrefetchFetchFn fetch;
+  TaskHandle_t taskHandle;
+  uint8_t* prefetchBuffer;
+  size_t prefetchBufferSize;
+  size_t prefetchLength;
+  
+  volatile PrefetchState state;
+  char requestedUid[32];
+  unsigned long requestTime;
+  unsigned long readyTime;
+  
+  // Hold-off for one tag so a tag left on the reader is not fetched on every poll
+  char holdUid[32];
+  unsigned long holdUntil;
+  uint32_t retryDelayMs;     // Doubles per failed prefetch of holdUid
+  
+  void holdOff(const char* uid, uint32_t delayMs);
+  
+  static void taskEntry(void* arg);
+  void run();
+};
+
+#endif // AUDIO_PREFETCH_H
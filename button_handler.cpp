@@ -5,6 +5,7 @@
  */
 
 #include "button_handler.h"
+#include <soc/gpio_reg.h>
 
 // ============================================
 // INITIALIZE BUTTON HANDLER
@@ -21,68 +22,105 @@ void ButtonHandler::init(uint8_t pin, uint32_t longPressMs, uint32_t debounceMs)
   
   // Initialize state variables
   currentState = false;
-  lastRawState = readRawState();
-  lastDebounceTime = 0;
+  candidateState = readRawState();
+  candidateTime = millis();
   pressStartTime = 0;
+  lastEventTime = 0;
   
   shortPressFlag = false;
   longPressFlag = false;
   longPressTriggered = false;
+  
+  edgeHead = 0;
+  edgeTail = 0;
+  edgeOverflow = false;
+  lastQueuedLevel = candidateState;
+  droppedEdges = 0;
+  edgeHook = nullptr;
+  gestures = nullptr;
+  
+  attachInterruptArg(digitalPinToInterrupt(buttonPin), edgeIsr, this, CHANGE);
+}
+
+// ============================================
+// EDGE INTERRUPT
+// ============================================
+void IRAM_ATTR ButtonHandler::edgeIsr(void* arg) {
+  ButtonHandler* self = (ButtonHandler*)arg;
+  bool pressed = self->readRawState();
+  
+  // Bounce can deliver two interrupts for one level change
+  if (pressed != self->lastQueuedLevel) {
+    uint8_t next = (self->edgeHead + 1) % BUTTON_EDGE_QUEUE_SIZE;
+    if (next == self->edgeTail) {
+      self->edgeOverflow = true;
+      self->droppedEdges++;
+    } else {
+      self->edges[self->edgeHead].timeMs = millis();
+      self->edges[self->edgeHead].pressed = pressed;
+      self->edgeHead = next;
+      self->lastQueuedLevel = pressed;
+    }
+  }
+  
+  if (self->edgeHook != nullptr) {
+    self->edgeHook();
+  }
+}
+
+void ButtonHandler::setEdgeHook(void (*hook)()) {
+  edgeHook = hook;
+}
+
+void ButtonHandler::setGestureRecognizer(GestureRecognizer* recognizer) {
+  gestures = recognizer;
 }
 
 // ============================================
 // READ RAW BUTTON STATE
 // ============================================
-bool ButtonHandler::readRawState() {
+// Also called from edgeIsr(), which can run while flash writes (LittleFS)
+// have the cache disabled: IRAM, and the GPIO input registers read directly
+// (digitalRead and gpio_get_level live in flash)
+bool IRAM_ATTR ButtonHandler::readRawState() {
+  uint32_t level = (buttonPin < 32) ? (REG_READ(GPIO_IN_REG) >> buttonPin)
+                                    : (REG_READ(GPIO_IN1_REG) >> (buttonPin - 32));
   // Button is active LOW (pressed = LOW due to INPUT_PULLUP)
-  return digitalRead(buttonPin) == LOW;
+  return (level & 1) == 0;
 }
 
 // ============================================
 // UPDATE BUTTON STATE (non-blocking)
 // ============================================
 void ButtonHandler::update() {
-  unsigned long now = millis();
-  bool rawState = readRawState();
+  uint32_t now = millis();
   
   // ========================================
-  // DEBOUNCE LOGIC
+  // DEBOUNCE LOGIC (edge timestamps)
   // ========================================
-  // If state changed, reset debounce timer
-  if (rawState != lastRawState) {
-    lastDebounceTime = now;
-  }
-  lastRawState = rawState;
-  
-  // If enough time has passed, update current state
-  if ((now - lastDebounceTime) > debounceDelay) {
-    bool previousState = currentState;
-    currentState = rawState;
+  // A level counts once it held for debounceDelay before the next edge
+  while (edgeTail != edgeHead) {
+    uint32_t edgeTime = edges[edgeTail].timeMs;
+    bool edgePressed = edges[edgeTail].pressed;
+    edgeTail = (edgeTail + 1) % BUTTON_EDGE_QUEUE_SIZE;
     
-    // ========================================
-    // DETECT PRESS (rising edge)
-    // ========================================
-    if (currentState && !previousState) {
-      // Button was just pressed
-      pressStartTime = now;
-      longPressTriggered = false;
-    }
-    
-    // ========================================
-    // DETECT RELEASE (falling edge)
-    // ========================================
-    else if (!currentState && previousState) {
-      // Button was just released
-      uint32_t pressDuration = now - pressStartTime;
-      
-      // Determine if it was short or long press
-      if (!longPressTriggered) {
-        if (pressDuration < longPressThreshold) {
-          shortPressFlag = true;
-        }
-        // Note: long press flag is set below while button is held
-      }
+    if (candidateState != currentState && (edgeTime - candidateTime) > debounceDelay) {
+      commitState(candidateState, candidateTime);
     }
+    candidateState = edgePressed;
+    candidateTime = edgeTime;
+  }
+  
+  // Queue overflowed - trust the pin over the lost edges
+  if (edgeOverflow) {
+    edgeOverflow = false;
+    candidateState = readRawState();
+    candidateTime = now;
+    lastQueuedLevel = candidateState;
+  }
+  
+  if (candidateState != currentState && (now - candidateTime) > debounceDelay) {
+    commitState(candidateState, candidateTime);
   }
   
   // ========================================
@@ -93,6 +131,46 @@ void ButtonHandler::update() {
     if (pressDuration >= longPressThreshold) {
       longPressFlag = true;
       longPressTriggered = true;  // Prevent repeated triggers
+      lastEventTime = pressStartTime + longPressThreshold;
+    }
+  }
+  
+  if (gestures != nullptr) {
+    gestures->update(now);
+  }
+}
+
+// ============================================
+// COMMIT DEBOUNCED STATE CHANGE
+// ============================================
+void ButtonHandler::commitState(bool pressed, uint32_t timeMs) {
+  currentState = pressed;
+  if (gestures != nullptr) {
+    gestures->onEdge(pressed, timeMs);
+  }
+  
+  // ========================================
+  // DETECT PRESS (rising edge)
+  // ========================================
+  if (pressed) {
+    pressStartTime = timeMs;
+    longPressTriggered = false;
+    return;
+  }
+  
+  // ========================================
+  // DETECT RELEASE (falling edge)
+  // ========================================
+  if (!longPressTriggered) {
+    uint32_t pressDuration = timeMs - pressStartTime;
+    if (pressDuration < longPressThreshold) {
+      shortPressFlag = true;
+      lastEventTime = timeMs;
+    } else {
+      // Held past the threshold while update() was not running
+      longPressFlag = true;
+      longPressTriggered = true;
+      lastEventTime = pressStartTime + longPressThreshold;
     }
   }
 }
@@ -126,6 +204,14 @@ bool ButtonHandler::isCurrentlyPressed() {
   return currentState;
 }
 
+// ============================================
+// CHECK IF IDLE (released, debounce settled)
+// ============================================
+bool ButtonHandler::isIdle() {
+  return !currentState && !candidateState && edgeTail == edgeHead &&
+         (gestures == nullptr || gestures->isIdle());
+}
+
 // ============================================
 // GET CURRENT PRESS DURATION
 // ============================================
@@ -135,3 +221,17 @@ uint32_t ButtonHandler::getCurrentPressDuration() {
   }
   return 0;
 }
+
+// ============================================
+// GET LAST EVENT TIME
+// ============================================
+uint32_t ButtonHandler::getLastEventTime() {
+  return lastEventTime;
+}
+
+// ============================================
+// GET DROPPED EDGES
+// ============================================
+uint32_t ButtonHandler::getDroppedEdges() {
+  return droppedEdges;
+}
@@ -2,12 +2,19 @@
  * button_handler.h
  * 
  * Button input handler with debouncing and short/long press detection
+ * 
+ * A GPIO interrupt pushes timestamped edges into a small queue; update()
+ * debounces and classifies from those timestamps, so press durations stay
+ * correct even when the loop was blocked (e.g. during an LTE call).
  */
 
 #ifndef BUTTON_HANDLER_H
 #define BUTTON_HANDLER_H
 
 #include <Arduino.h>
+#include "gesture_recognizer.h"
+
+#define BUTTON_EDGE_QUEUE_SIZE  16   // Edges buffered between update() calls
 
 // ============================================
 // BUTTON HANDLER CLASS
@@ -23,6 +30,12 @@ public:
   // Update button state (call every loop iteration)
   void update();
   
+  // Called from the edge interrupt after queuing (must be IRAM-safe)
+  void setEdgeHook(void (*hook)());
+  
+  // Feed debounced edges to a gesture recognizer (nullptr to detach)
+  void setGestureRecognizer(GestureRecognizer* recognizer);
+  
   // Check if short press occurred (clears flag after reading)
   bool wasShortPress();
   
@@ -32,19 +45,43 @@ public:
   // Check if button is currently pressed
   bool isCurrentlyPressed();
   
+  // True when released, debounced and no gesture is pending - nothing left to time
+  bool isIdle();
+  
   // Get current press duration in milliseconds
   uint32_t getCurrentPressDuration();
+  
+  // millis() timestamp of the edge behind the last short/long press event
+  uint32_t getLastEventTime();
+  
+  // Edges lost to a full queue (state is resynced from the pin)
+  uint32_t getDroppedEdges();
 
 private:
   uint8_t buttonPin;
   uint32_t longPressThreshold;
   uint32_t debounceDelay;
   
+  // Edge queue (written by the ISR, drained by update())
+  struct Edge {
+    uint32_t timeMs;
+    bool pressed;
+  };
+  volatile Edge edges[BUTTON_EDGE_QUEUE_SIZE];
+  volatile uint8_t edgeHead;
+  volatile uint8_t edgeTail;
+  volatile bool edgeOverflow;
+  volatile bool lastQueuedLevel;
+  volatile uint32_t droppedEdges;
+  void (*edgeHook)();
+  GestureRecognizer* gestures;
+  
   // State tracking
   bool currentState;           // Current debounced button state
-  bool lastRawState;           // Last raw reading
-  unsigned long lastDebounceTime;
-  unsigned long pressStartTime;
+  bool candidateState;         // Latest raw level, waiting out the debounce
+  uint32_t candidateTime;      // When the raw level last changed
+  uint32_t pressStartTime;
+  uint32_t lastEventTime;
   
   // Event flags
   bool shortPressFlag;
@@ -52,7 +89,9 @@ private:
   bool longPressTriggered;     // Prevents multiple long press triggers
   
   // Helper functions
-  bool readRawState();
+  bool IRAM_ATTR readRawState();
+  void commitState(bool pressed, uint32_t timeMs);
+  static void IRAM_ATTR edgeIsr(void* arg);
 };
 
 #endif // BUTTON_HANDLER_H
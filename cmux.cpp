@@ -0,0 +1,662 @@
+/*
+ * cmux.cpp
+ * 
+ * Implementation of the GSM 07.10 multiplexer
+ */
+
+#include "cmux.h"
+#include "logger.h"
+
+// Frame fields (TS 27.010 5.2)
+#define CMUX_FLAG       0xF9
+#define CMUX_EA         0x01
+#define CMUX_CR         0x02
+#define CMUX_PF         0x10
+#define CMUX_SABM       0x2F
+#define CMUX_UA         0x63
+#define CMUX_DM         0x0F
+#define CMUX_DISC       0x43
+#define CMUX_UIH        0xEF
+#define CMUX_UI         0x03
+#define CMUX_FCS_GOOD   0xCF   // CRC over header + FCS of an intact frame
+#define CMUX_FRAME_OVERHEAD 6  // Flags, address, control, length, FCS
+
+// Mux command types on DLCI 0 (TS 27.010 5.4.6.3)
+#define CMUX_CMD_NSC    0x04   // Not supported (our answer to unknown commands)
+#define CMUX_CMD_FCOFF  0x18
+#define CMUX_CMD_FCON   0x28
+#define CMUX_CMD_CLD    0x30
+#define CMUX_CMD_MSC    0x38
+
+// V.24 signals in MSC: EA, RTC, RTR, DV (FC = 0x02 asks the peer to hold TX)
+#define CMUX_MSC_SIGNALS 0x8D
+#define CMUX_MSC_FC      0x02
+
+// Reflected CRC-8, polynomial x^8 + x^2 + x + 1 (TS 27.010 annex B)
+static const uint8_t fcsTable[256] = {
+  0x00, 0x91, 0xE3, 0x72, 0x07, 0x96, 0xE4, 0x75, 0x0E, 0x9F, 0xED, 0x7C, 0x09, 0x98, 0xEA, 0x7B,
+  0x1C, 0x8D, 0xFF, 0x6E, 0x1B, 0x8A, 0xF8, 0x69, 0x12, 0x83, 0xF1, 0x60, 0x15, 0x84, 0xF6, 0x67,
+  0x38, 0xA9, 0xDB, 0x4A, 0x3F, 0xAE, 0xDC, 0x4D, 0x36, 0xA7, 0xD5, 0x44, 0x31, 0xA0, 0xD2, 0x43,
+  0x24, 0xB5, 0xC7, 0x56, 0x23, 0xB2, 0xC0, 0x51, 0x2A, 0xBB, 0xC9, 0x58, 0x2D, 0xBC, 0xCE, 0x5F,
+  0x70, 0xE1, 0x93, 0x02, 0x77, 0xE6, 0x94, 0x05, 0x7E, 0xEF, 0x9D, 0x0C, 0x79, 0xE8, 0x9A, 0x0B,
+  0x6C, 0xFD, 0x8F, 0x1E, 0x6B, 0xFA, 0x88, 0x19, 0x62, 0xF3, 0x81, 0x10, 0x65, 0xF4, 0x86, 0x17,
+  0x48, 0xD9, 0xAB, 0x3A, 0x4F, 0xDE, 0xAC, 0x3D, 0x46, 0xD7, 0xA5, 0x34, 0x41, 0xD0, 0xA2, 0x33,
+  0x54, 0xC5, 0xB7, 0x26, 0x53, 0xC2, 0xB0, 0x21, 0x5A, 0xCB, 0xB9, 0x28, 0x5D, 0xCC, 0xBE, 0x2F,
+  0xE0, 0x71, 0x03, 0x92, 0xE7, 0x76, 0x04, 0x95, 0xEE, 0x7F, 0x0D, 0x9C, 0xE9, 0x78, 0x0A, 0x9B,
+  0xFC, 0x6D, 0x1F, 0x8E, 0xFB, 0x6A, 0x18, 0x89, 0xF2, 0x63, 0x11, 0x80, 0xF5, 0x64, 0x16, 0x87,
+  0xD8, 0x49, 0x3B, 0xAA, 0xDF, 0x4E, 0x3C, 0xAD, 0xD6, 0x47, 0x35, 0xA4, 0xD1, 0x40, 0x32, 0xA3,
+  0xC4, 0x55, 0x27, 0xB6, 0xC3, 0x52, 0x20, 0xB1, 0xCA, 0x5B, 0x29, 0xB8, 0xCD, 0x5C, 0x2E, 0xBF,
+  0x90, 0x01, 0x73, 0xE2, 0x97, 0x06, 0x74, 0xE5, 0x9E, 0x0F, 0x7D, 0xEC, 0x99, 0x08, 0x7A, 0xEB,
+  0x8C, 0x1D, 0x6F, 0xFE, 0x8B, 0x1A, 0x68, 0xF9, 0x82, 0x13, 0x61, 0xF0, 0x85, 0x14, 0x66, 0xF7,
+  0xA8, 0x39, 0x4B, 0xDA, 0xAF, 0x3E, 0x4C, 0xDD, 0xA6, 0x37, 0x45, 0xD4, 0xA1, 0x30, 0x42, 0xD3,
+  0xB4, 0x25, 0x57, 0xC6, 0xB3, 0x22, 0x50, 0xC1, 0xBA, 0x2B, 0x59, 0xC8, 0xBD, 0x2C, 0x5E, 0xCF
+};
+
+uint8_t Cmux::crc(uint8_t value, const uint8_t* data, size_t length) {
+  while (length-- > 0) {
+    value = fcsTable[value ^ *data++];
+  }
+  return value;
+}
+
+Cmux::Cmux() {
+  uart = nullptr;
+  open = false;
+  lock = nullptr;
+  rings = nullptr;
+  memset(&stats, 0, sizeof(stats));
+  state = PARSE_HUNT;
+  target = nullptr;
+  answered = 0;
+  refused = 0;
+  closeSeen = 0;
+  txStopped = false;
+}
+
+// ============================================
+// BEGIN / END
+// ============================================
+bool Cmux::begin(Stream* modemUart) {
+  if (rings == nullptr) {
+    rings = (uint8_t*)malloc(CMUX_CHANNELS * LTE_CMUX_RING);
+  }
+  if (lock == nullptr) {
+    lock = xSemaphoreCreateMutex();
+  }
+  if (rings == nullptr || lock == nullptr) {
+    LOG_E("CMUX", "Not enough memory for the channel rings");
+    return false;
+  }
+  
+  uart = modemUart;
+  memset(&stats, 0, sizeof(stats));
+  state = PARSE_HUNT;
+  target = nullptr;
+  answered = 0;
+  refused = 0;
+  closeSeen = 0;
+  txStopped = false;
+  for (uint8_t i = 0; i < CMUX_CHANNELS; i++) {
+    CmuxChannel& channel = channels[i];
+    channel.mux = this;
+    channel.dlci = i + 1;
+    channel.ring = rings + i * LTE_CMUX_RING;
+    channel.head = 0;
+    channel.count = 0;
+    channel.pending = 0;
+    channel.lastTakeMs = millis();
+    channel.stopped = false;
+  }
+  open = true;
+  
+  for (uint8_t dlci = 0; dlci <= CMUX_CHANNELS; dlci++) {
+    if (!openChannel(dlci)) {
+      Logger::printf(LOG_ERROR, "CMUX", "DLCI %u not opened", dlci);
+      end();
+      return false;
+    }
+  }
+  Logger::printf(LOG_INFO, "CMUX", "%u channels open, %u byte frames", CMUX_CHANNELS, LTE_CMUX_FRAME_SIZE);
+  return true;
+}
+
+void Cmux::end() {
+  if (!open) {
+    return;
+  }
+  xSemaphoreTake(lock, portMAX_DELAY);
+  sendMuxCommand(CMUX_CMD_CLD, nullptr, 0, true);
+  xSemaphoreGive(lock);
+  if (!waitFor(&closeSeen, 1, CMUX_ANSWER_TIMEOUT_MS)) {
+    LOG_W("CMUX", "No close-down response");
+  }
+  
+  // Under the lock: a reader in poll() or take() finishes before the rings
+  // go, and any later one sees the mux closed and empty channels
+  xSemaphoreTake(lock, portMAX_DELAY);
+  open = false;
+  free(rings);
+  rings = nullptr;
+  for (uint8_t i = 0; i < CMUX_CHANNELS; i++) {
+    channels[i].ring = nullptr;
+    channels[i].count = 0;
+    channels[i].pending = 0;
+  }
+  target = nullptr;
+  xSemaphoreGive(lock);
+  Logger::printf(LOG_INFO, "CMUX", "Closed (%lu frames in, %lu out, %lu bad)", (unsigned long)stats.framesIn,
+                 (unsigned long)stats.framesOut, (unsigned long)stats.badFrames);
+}
+
+bool Cmux::isOpen() {
+  return open;
+}
+
+CmuxChannel* Cmux::getChannel(uint8_t dlci) {
+  if (!open || dlci < 1 || dlci > CMUX_CHANNELS) {
+    return nullptr;
+  }
+  return &channels[dlci - 1];
+}
+
+const CmuxStats& Cmux::getStats() {
+  return stats;
+}
+
+// SABM, then UA (or DM: refused); channels also get our V.24 signals
+bool Cmux::openChannel(uint8_t dlci) {
+  uint8_t bit = 1 << dlci;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  writeFrame(dlci, CMUX_SABM | CMUX_PF, true, nullptr, 0);
+  xSemaphoreGive(lock);
+  if (!waitFor(&answered, bit, CMUX_ANSWER_TIMEOUT_MS) || (refused & bit)) {
+    return false;
+  }
+  if (dlci > 0) {
+    uint8_t values[2] = { (uint8_t)(dlci << 2 | CMUX_CR | CMUX_EA), CMUX_MSC_SIGNALS };
+    xSemaphoreTake(lock, portMAX_DELAY);
+    sendMuxCommand(CMUX_CMD_MSC, values, 2, true);
+    xSemaphoreGive(lock);
+  }
+  return true;
+}
+
+bool Cmux::waitFor(volatile uint8_t* flags, uint8_t mask, uint32_t timeout_ms) {
+  unsigned long start = millis();
+  while (true) {
+    poll();
+    if (*flags & mask) {
+      return true;
+    }
+    if (millis() - start >= timeout_ms) {
+      return false;
+    }
+    delay(1);
+  }
+}
+
+// ============================================
+// FRAME OUTPUT
+// ============================================
+// Header and trailer around the caller's bytes: the info is never copied
+void Cmux::writeFrame(uint8_t dlci, uint8_t control, bool command, const uint8_t* info, size_t length) {
+  uint8_t frame[5];
+  size_t n = 0;
+  frame[n++] = CMUX_FLAG;
+  frame[n++] = dlci << 2 | (command ? CMUX_CR : 0) | CMUX_EA;
+  frame[n++] = control;
+  if (length <= 127) {
+    frame[n++] = length << 1 | CMUX_EA;
+  } else {
+    frame[n++] = (length & 0x7F) << 1;
+    frame[n++] = length >> 7;
+  }
+  uint8_t trailer[2] = { (uint8_t)(0xFF - crc(0xFF, frame + 1, n - 1)), CMUX_FLAG };
+  
+  uart->write(frame, n);
+  if (length > 0) {
+    uart->write(info, length);
+  }
+  uart->write(trailer, sizeof(trailer));
+  stats.framesOut++;
+}
+
+void Cmux::sendMuxCommand(uint8_t type, const uint8_t* values, uint8_t count, bool command) {
+  uint8_t info[2 + 8];
+  if (count > 8) {
+    count = 8;
+  }
+  info[0] = type << 2 | (command ? CMUX_CR : 0) | CMUX_EA;
+  info[1] = count << 1 | CMUX_EA;
+  if (count > 0) {
+    memcpy(info + 2, values, count);
+  }
+  writeFrame(0, CMUX_UIH, true, info, 2 + count);
+}
+
+size_t Cmux::send(uint8_t dlci, const uint8_t* data, size_t length) {
+  CmuxChannel* channel = getChannel(dlci);
+  size_t sent = 0;
+  while (channel != nullptr && open && sent < length) {
+    // Held by the modem (FCoff or the channel's MSC flow control bit)
+    unsigned long start = millis();
+    while (open && (txStopped || channel->stopped) && millis() - start < LTE_COMMAND_TIMEOUT_MS) {
+      poll();
+      delay(1);
+    }
+    if (!open || txStopped || channel->stopped) {
+      LOG_W("CMUX", "TX held by the modem, giving up");
+      break;
+    }
+    
+    size_t n = length - sent;
+    if (n > LTE_CMUX_FRAME_SIZE) {
+      n = LTE_CMUX_FRAME_SIZE;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    writeFrame(dlci, CMUX_UIH, true, data + sent, n);
+    xSemaphoreGive(lock);
+    sent += n;
+  }
+  return sent;
+}
+
+void Cmux::writeCloseDown(Stream* modemUart) {
+  uint8_t frame[8] = { CMUX_FLAG, CMUX_CR | CMUX_EA, CMUX_UIH, 2 << 1 | CMUX_EA,
+                       CMUX_CMD_CLD << 2 | CMUX_CR | CMUX_EA, CMUX_EA, 0, CMUX_FLAG };
+  frame[6] = 0xFF - crc(0xFF, frame + 1, 3);
+  modemUart->write(frame, sizeof(frame));
+}
+
+// ============================================
+// RECEIVE
+// ============================================
+// Least free space over the channel rings. A control or URC ring whose reader
+// has taken nothing for LTE_CMUX_RING_HOLD_MS stops counting below one frame:
+// its oldest bytes make room then (see PARSE_INFO), so an unread ring cannot
+// stall the data channel.
+size_t Cmux::ringSpace() {
+  size_t space = sizeof(rxBuffer);
+  for (uint8_t i = 0; i < CMUX_CHANNELS; i++) {
+    CmuxChannel& channel = channels[i];
+    size_t channelSpace = channel.freeSpace();
+    if (channel.dlci != CMUX_CHANNEL_DATA && channelSpace < CMUX_FRAME_OVERHEAD + LTE_CMUX_FRAME_SIZE &&
+        millis() - channel.lastTakeMs >= LTE_CMUX_RING_HOLD_MS) {
+      channelSpace = CMUX_FRAME_OVERHEAD + LTE_CMUX_FRAME_SIZE;
+    }
+    if (channelSpace < space) {
+      space = channelSpace;
+    }
+  }
+  return space;
+}
+
+// A span of n bytes carries at most n info bytes for any one channel, so
+// reading no more than the fullest ring can take never overflows the data
+// ring, nor a control or URC ring that is being read
+void Cmux::poll() {
+  if (!open) {
+    return;
+  }
+  xSemaphoreTake(lock, portMAX_DELAY);
+  int avail;
+  while (open && (avail = uart->available()) > 0) {
+    size_t room = ringSpace();
+    if (room == 0) {
+      stats.stalls++;
+      break;
+    }
+    size_t n = ((size_t)avail < room) ? avail : room;
+    n = uart->readBytes((char*)rxBuffer, n);
+    if (n == 0) {
+      break;
+    }
+    parse(rxBuffer, n);
+  }
+  xSemaphoreGive(lock);
+}
+
+void Cmux::parse(const uint8_t* data, size_t length) {
+  size_t i = 0;
+  while (i < length) {
+    uint8_t b = data[i];
+    switch (state) {
+      case PARSE_HUNT:
+        i++;
+        if (b == CMUX_FLAG) {
+          state = PARSE_ADDRESS;
+        } else {
+          stats.discarded++;
+        }
+        break;
+      
+      case PARSE_ADDRESS:
+        i++;
+        if (b == CMUX_FLAG) {
+          break;  // Back-to-back flags
+        }
+        if (!(b & CMUX_EA)) {
+          stats.discarded++;  // Only one-byte addresses exist in basic option
+          state = PARSE_HUNT;
+          break;
+        }
+        header[0] = b;
+        headerLength = 1;
+        state = PARSE_CONTROL;
+        break;
+      
+      case PARSE_CONTROL: {
+        i++;
+        uint8_t type = b & ~CMUX_PF;
+        if (type != CMUX_UIH && type != CMUX_UI && type != CMUX_UA && type != CMUX_DM &&
+            type != CMUX_SABM && type != CMUX_DISC) {
+          // Not a frame (noise after a flag): hunt again, this byte may be the flag
+          stats.discarded += 2;
+          state = (b == CMUX_FLAG) ? PARSE_ADDRESS : PARSE_HUNT;
+          break;
+        }
+        header[headerLength++] = b;
+        state = PARSE_LENGTH;
+        break;
+      }
+      
+      case PARSE_LENGTH:
+        i++;
+        header[headerLength++] = b;
+        infoLength = b >> 1;
+        if (b & CMUX_EA) {
+          startInfo();
+        } else {
+          state = PARSE_LENGTH2;
+        }
+        break;
+      
+      case PARSE_LENGTH2:
+        i++;
+        header[headerLength++] = b;
+        infoLength |= (size_t)b << 7;
+        startInfo();
+        break;
+      
+      case PARSE_INFO: {
+        // In place: straight from the span into the ring (or the DLCI 0 buffer)
+        size_t n = length - i;
+        if (n > infoRemaining) {
+          n = infoRemaining;
+        }
+        if (target != nullptr) {
+          if (n > target->freeSpace() && target->dlci != CMUX_CHANNEL_DATA) {
+            stats.overwritten += target->dropOldest(n - target->freeSpace());
+          }
+          if (n > target->freeSpace()) {
+            dropFrame();
+            state = PARSE_HUNT;
+            break;
+          }
+          size_t tail = (target->head + target->count + target->pending) % LTE_CMUX_RING;
+          size_t first = (n < LTE_CMUX_RING - tail) ? n : LTE_CMUX_RING - tail;
+          memcpy(target->ring + tail, data + i, first);
+          memcpy(target->ring, data + i + first, n - first);
+          target->pending += n;
+        } else if ((header[0] >> 2) == 0) {
+          size_t keep = sizeof(muxInfo) - muxInfoLength;
+          keep = (n < keep) ? n : keep;
+          memcpy(muxInfo + muxInfoLength, data + i, keep);
+          muxInfoLength += keep;
+        }
+        i += n;
+        infoRemaining -= n;
+        if (infoRemaining == 0) {
+          state = PARSE_FCS;
+        }
+        break;
+      }
+      
+      case PARSE_FCS:
+        i++;
+        fcs = b;
+        state = PARSE_END;
+        break;
+      
+      case PARSE_END:
+        if (b != CMUX_FLAG) {
+          dropFrame();  // Lost sync; this byte is looked at again while hunting
+          state = PARSE_HUNT;
+          break;
+        }
+        i++;
+        if (crc(crc(0xFF, header, headerLength), &fcs, 1) == CMUX_FCS_GOOD) {
+          onFrame();
+        } else {
+          dropFrame();
+        }
+        state = PARSE_ADDRESS;  // The closing flag may open the next frame
+        break;
+    }
+  }
+}
+
+void Cmux::startInfo() {
+  if (infoLength > LTE_CMUX_FRAME_SIZE) {
+    dropFrame();
+    state = PARSE_HUNT;
+    return;
+  }
+  uint8_t dlci = header[0] >> 2;
+  uint8_t type = header[1] & ~CMUX_PF;
+  target = nullptr;
+  if ((type == CMUX_UIH || type == CMUX_UI) && dlci >= 1 && dlci <= CMUX_CHANNELS &&
+      (answered & ~refused & (1 << dlci))) {
+    target = &channels[dlci - 1];
+  }
+  muxInfoLength = 0;
+  infoRemaining = infoLength;
+  state = (infoLength > 0) ? PARSE_INFO : PARSE_FCS;
+}
+
+void Cmux::dropFrame() {
+  if (target != nullptr) {
+    target->pending = 0;  // Roll back what the frame put in the ring
+    target = nullptr;
+  }
+  stats.badFrames++;
+}
+
+void Cmux::onFrame() {
+  uint8_t dlci = header[0] >> 2;
+  uint8_t type = header[1] & ~CMUX_PF;
+  stats.framesIn++;
+  
+  if ((type == CMUX_UA || type == CMUX_DM) && dlci <= CMUX_CHANNELS) {
+    answered |= 1 << dlci;
+    if (type == CMUX_DM) {
+      refused |= 1 << dlci;
+    }
+  } else if (type == CMUX_UIH || type == CMUX_UI) {
+    if (target != nullptr) {
+      target->count += target->pending;
+      target->pending = 0;
+    } else if (dlci == 0) {
+      onMuxCommand();
+    } else {
+      stats.discarded += infoLength;  // Channel we did not open
+    }
+  }
+  target = nullptr;
+}
+
+// Modem commands are answered with the same values; responses to ours are
+// only looked at for close-down
+void Cmux::onMuxCommand() {
+  if (muxInfoLength < 2) {
+    return;
+  }
+  uint8_t type = muxInfo[0] >> 2;
+  bool command = (muxInfo[0] & CMUX_CR) != 0;
+  uint8_t count = muxInfo[1] >> 1;
+  const uint8_t* values = muxInfo + 2;
+  if (count > muxInfoLength - 2) {
+    count = muxInfoLength - 2;
+  }
+  
+  if (!command) {
+    if (type == CMUX_CMD_CLD) {
+      closeSeen = 1;
+    }
+    return;
+  }
+  
+  switch (type) {
+    case CMUX_CMD_MSC:
+      if (count >= 2) {
+        uint8_t dlci = values[0] >> 2;
+        if (dlci >= 1 && dlci <= CMUX_CHANNELS) {
+          channels[dlci - 1].stopped = (values[1] & CMUX_MSC_FC) != 0;
+        }
+      }
+      sendMuxCommand(type, values, count, false);
+      break;
+    case CMUX_CMD_FCOFF:
+    case CMUX_CMD_FCON:
+      txStopped = (type == CMUX_CMD_FCOFF);
+      sendMuxCommand(type, nullptr, 0, false);
+      break;
+    case CMUX_CMD_CLD:
+      // The modem is leaving multiplexed mode on its own
+      sendMuxCommand(type, nullptr, 0, false);
+      LOG_W("CMUX", "Close-down requested by the modem");
+      break;
+    default: {
+      uint8_t unknown = muxInfo[0];
+      sendMuxCommand(CMUX_CMD_NSC, &unknown, 1, false);
+      break;
+    }
+  }
+}
+
+// ============================================
+// CHANNEL STREAM
+// ============================================
+CmuxChannel::CmuxChannel() {
+  mux = nullptr;
+  dlci = 0;
+  ring = nullptr;
+  head = 0;
+  count = 0;
+  pending = 0;
+  lastTakeMs = 0;
+  stopped = false;
+}
+
+size_t CmuxChannel::freeSpace() {
+  return (ring != nullptr) ? LTE_CMUX_RING - count - pending : 0;
+}
+
+// Copy out of the ring; the caller holds the mux lock
+size_t CmuxChannel::take(uint8_t* out, size_t length) {
+  size_t n = (length < count) ? length : count;
+  if (n == 0) {
+    return 0;  // Also covers a ring freed by end()
+  }
+  size_t first = (n < LTE_CMUX_RING - head) ? n : LTE_CMUX_RING - head;
+  memcpy(out, ring + head, first);
+  memcpy(out + first, ring, n - first);
+  head = (head + n) % LTE_CMUX_RING;
+  count -= n;
+  lastTakeMs = millis();
+  return n;
+}
+
+// Discard up to length of the oldest readable bytes; the caller holds the
+// mux lock. Returns bytes discarded.
+size_t CmuxChannel::dropOldest(size_t length) {
+  size_t n = (length < count) ? length : count;
+  head = (head + n) % LTE_CMUX_RING;
+  count -= n;
+  return n;
+}
+
+int CmuxChannel::available() {
+  if (mux == nullptr || !mux->open) {
+    return 0;
+  }
+  mux->poll();
+  xSemaphoreTake(mux->lock, portMAX_DELAY);
+  int n = (int)count;
+  xSemaphoreGive(mux->lock);
+  return n;
+}
+
+int CmuxChannel::read() {
+  uint8_t b;
+  return (readBytes((char*)&b, 1) == 1) ? b : -1;
+}
+
+int CmuxChannel::peek() {
+  if (available() <= 0) {
+    return -1;
+  }
+  xSemaphoreTake(mux->lock, portMAX_DELAY);
+  int b = (count > 0) ? ring[head] : -1;
+  xSemaphoreGive(mux->lock);
+  return b;
+}
+
+size_t CmuxChannel::readBytes(char* buffer, size_t length) {
+  if (available() <= 0) {
+    return 0;
+  }
+  xSemaphoreTake(mux->lock, portMAX_DELAY);
+  size_t n = take((uint8_t*)buffer, length);
+  xSemaphoreGive(mux->lock);
+  return n;
+}
+
+int CmuxChannel::readLine(char* out, size_t size, uint32_t timeout_ms) {
+  if (size < 2) {
+    return -1;
+  }
+  unsigned long start = millis();
+  while (true) {
+    if (available() > 0) {
+      xSemaphoreTake(mux->lock, portMAX_DELAY);
+      size_t lineLength = 0;
+      for (size_t i = 0; i < count; i++) {
+        if (ring[(head + i) % LTE_CMUX_RING] == '\n') {
+          lineLength = i + 1;
+          break;
+        }
+      }
+      if (lineLength > 0) {
+        size_t n = take((uint8_t*)out, (lineLength < size - 1) ? lineLength : size - 1);
+        head = (head + lineLength - n) % LTE_CMUX_RING;  // Drop the cut-off rest
+        count -= lineLength - n;
+        out[n] = '\0';
+        xSemaphoreGive(mux->lock);
+        return n;
+      }
+      xSemaphoreGive(mux->lock);
+    }
+    if (millis() - start >= timeout_ms) {
+      return -1;
+    }
+    delay(1);
+  }
+}
+
+size_t CmuxChannel::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t CmuxChannel::write(const uint8_t* buffer, size_t size) {
+  if (mux == nullptr) {
+    return 0;
+  }
+  return mux->send(dlci, buffer, size);
+}
+
+void CmuxChannel::flush() {
+  if (mux != nullptr && mux->uart != nullptr) {
+    mux->uart->flush();
+  }
+}
@@ -0,0 +1,185 @@
+/*
+ * cmux.h
+ * 
+ * GSM 07.10 (3GPP TS 27.010) multiplexer on the modem UART
+ * 
+ * After AT+CMUX the SIM7070 frames everything it sends and expects the same:
+ *   F9 | address | control | length (1-2 bytes) | info | FCS | F9
+ * address = DLCI << 2 | C/R | EA, and the FCS is a CRC-8 over address,
+ * control and length only (basic option, UIH frames). DLCI 0 carries mux
+ * commands; every other DLCI is an AT interpreter of its own:
+ *   CMUX_CHANNEL_CONTROL  short commands (CSQ/CESQ, bearer checks)
+ *   CMUX_CHANNEL_DATA     HTTP and socket transfers
+ *   CMUX_CHANNEL_URC      no commands; what the modem reports there is URCs
+ * so a signal check no longer waits for the end of an upload.
+ * 
+ * Each channel is a Stream; LTEManager uses it like the UART. poll() reads
+ * the UART in LTE_RX_CHUNK spans and parses each span in place: no frame is
+ * assembled, info bytes go from the span straight into their channel's ring.
+ * They stay pending there until the frame's FCS checks out, and a bad frame
+ * is rolled back. poll() reads no more than every ring can take, so a slow
+ * reader holds the rest in the UART instead of losing it. Nobody may be
+ * reading the control or URC ring, though: once a full one has had no reads
+ * for LTE_CMUX_RING_HOLD_MS it stops holding the UART back and its oldest
+ * bytes make room (counted as overwritten), so it cannot stall a transfer.
+ * 
+ * Channels may be used from different tasks (one task per channel); poll()
+ * and frame writes are serialized by a mutex.
+ */
+
+#ifndef CMUX_H
+#define CMUX_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "config.h"
+
+#define CMUX_CHANNEL_CONTROL   1
+#define CMUX_CHANNEL_DATA      2
+#define CMUX_CHANNEL_URC       3
+#define CMUX_CHANNELS          3      // DLCIs 1..CMUX_CHANNELS are opened
+#define CMUX_ANSWER_TIMEOUT_MS 1000   // ms - wait for UA/DM or a mux command response
+
+// ============================================
+// STATISTICS
+// ============================================
+// Counted since begin()
+struct CmuxStats {
+  uint32_t framesIn;
+  uint32_t framesOut;
+  uint32_t badFrames;        // Dropped: bad FCS, oversized or no closing flag
+  uint32_t discarded;        // Bytes outside valid frames
+  uint32_t stalls;           // poll() calls that left bytes in the UART (the data ring was full)
+  uint32_t overwritten;      // Oldest bytes dropped from a full control or URC ring
+};
+
+class Cmux;
+
+// ============================================
+// VIRTUAL CHANNEL (Stream per DLCI)
+// ============================================
+class CmuxChannel : public Stream {
+public:
+  CmuxChannel();
+  
+  // One line including its "\n", NUL-terminated (cut to size - 1 bytes).
+  // Returns the length, -1 if no whole line arrives within timeout_ms.
+  int readLine(char* out, size_t size, uint32_t timeout_ms);
+  
+  // Stream
+  int available() override;
+  int read() override;
+  int peek() override;
+  void flush() override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t* buffer, size_t size) override;  // UIH frames, no copy
+  size_t readBytes(char* buffer, size_t length) override;     // Buffered bytes only
+  using Stream::readBytes;
+  using Print::write;
+
+private:
+  friend class Cmux;
+  Cmux* mux;
+  uint8_t dlci;
+  uint8_t* ring;             // LTE_CMUX_RING bytes (allocated by Cmux::begin)
+  size_t head;               // Next byte to read
+  size_t count;              // Readable bytes
+  size_t pending;            // Bytes of the frame being parsed (not yet checked)
+  unsigned long lastTakeMs;  // Last read from the ring
+  bool stopped;              // The modem asked us to hold TX (MSC FC bit)
+  
+  size_t freeSpace();
+  size_t take(uint8_t* out, size_t length);
+  size_t dropOldest(size_t length);
+};
+
+// ============================================
+// MULTIPLEXER CLASS
+// ============================================
+class Cmux {
+public:
+  Cmux();
+  
+  // Open DLCI 0 and the channels on a modem that has just answered AT+CMUX
+  // with OK. Returns false (mux closed again) if the modem does not answer.
+  bool begin(Stream* uart);
+  
+  // Close-down command (the modem goes back to plain AT), free the rings
+  void end();
+  
+  bool isOpen();
+  
+  // Channel stream for a DLCI 1..CMUX_CHANNELS, nullptr if closed
+  CmuxChannel* getChannel(uint8_t dlci);
+  
+  // Move received bytes from the UART into the channel rings
+  void poll();
+  
+  // Send bytes on a channel as UIH frames of up to LTE_CMUX_FRAME_SIZE.
+  // Returns bytes sent (fewer if the modem held TX for LTE_COMMAND_TIMEOUT_MS).
+  size_t send(uint8_t dlci, const uint8_t* data, size_t length);
+  
+  const CmuxStats& getStats();
+  
+  // Close-down frame for a modem left multiplexing (e.g. by a reset); it
+  // reads as junk to a modem in plain AT mode
+  static void writeCloseDown(Stream* uart);
+
+private:
+  friend class CmuxChannel;
+  
+  // Frame parser states
+  enum ParseState {
+    PARSE_HUNT,              // Skipping to a flag
+    PARSE_ADDRESS,
+    PARSE_CONTROL,
+    PARSE_LENGTH,
+    PARSE_LENGTH2,
+    PARSE_INFO,
+    PARSE_FCS,
+    PARSE_END                // Closing flag
+  };
+  
+  Stream* uart;
+  bool open;
+  SemaphoreHandle_t lock;
+  CmuxChannel channels[CMUX_CHANNELS];
+  uint8_t* rings;
+  uint8_t rxBuffer[LTE_RX_CHUNK];
+  CmuxStats stats;
+  
+  // Parser
+  ParseState state;
+  uint8_t header[4];         // Address, control, length (1-2 bytes)
+  uint8_t headerLength;
+  size_t infoLength;
+  size_t infoRemaining;
+  CmuxChannel* target;       // Channel receiving the current frame's info
+  uint8_t muxInfo[16];       // DLCI 0 frame info (mux commands)
+  uint8_t muxInfoLength;
+  uint8_t fcs;
+  
+  // Answers seen by the parser (bit per DLCI)
+  volatile uint8_t answered;       // UA or DM
+  volatile uint8_t refused;        // DM
+  volatile uint8_t closeSeen;      // Close-down response
+  bool txStopped;                  // FCoff from the modem
+  
+  void parse(const uint8_t* data, size_t length);
+  void startInfo();
+  void onFrame();
+  void onMuxCommand();
+  void dropFrame();
+  bool openChannel(uint8_t dlci);
+  bool waitFor(volatile uint8_t* flags, uint8_t mask, uint32_t timeout_ms);
+  size_t ringSpace();
+  
+  // Frame output; the caller holds the lock
+  void writeFrame(uint8_t dlci, uint8_t control, bool command, const uint8_t* info, size_t length);
+  void sendMuxCommand(uint8_t type, const uint8_t* values, uint8_t count, bool command);
+  
+  static uint8_t crc(uint8_t value, const uint8_t* data, size_t length);
+};
+
+#endif // CMUX_H
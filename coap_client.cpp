@@ -0,0 +1,418 @@
+/*
+ * coap_client.cpp
+ * 
+ * Implementation of the CoAP client
+ */
+
+#include "coap_client.h"
+#include "logger.h"
+
+// Block size exponent: size = 2^(SZX + 4)
+static uint8_t blockSzx() {
+  uint8_t szx = 0;
+  while ((16u << szx) < COAP_BLOCK_SIZE && szx < 6) {
+    szx++;
+  }
+  return szx;
+}
+
+// ============================================
+// INITIALIZE CLIENT
+// ============================================
+CoapClient::CoapClient() {
+  lte = nullptr;
+  socketId = 0;
+  host = "";
+  port = 0;
+  connected = false;
+  nextMessageId = 0;
+  rng = 1;
+  memset(token, 0, sizeof(token));
+  memset(&stats, 0, sizeof(stats));
+}
+
+void CoapClient::begin(LTEManager* lteManager, uint8_t socket, const char* serverHost, uint16_t serverPort,
+                       uint32_t seed) {
+  lte = lteManager;
+  socketId = socket;
+  host = serverHost;
+  port = serverPort;
+  connected = false;
+  rng = (seed != 0) ? seed : 1;
+  nextMessageId = (uint16_t)nextRandom();
+  memset(&stats, 0, sizeof(stats));
+}
+
+// ============================================
+// REQUEST
+// ============================================
+int CoapClient::request(uint8_t method, const char* path, const char* query, uint16_t format,
+                        const uint8_t* payload, size_t length,
+                        uint8_t* response, size_t* responseLength, size_t maxResponse) {
+  stats.requests++;
+  *responseLength = 0;
+  
+  if (!connected) {
+    if (!lte->socketOpenUdp(socketId, host, port)) {
+      stats.failures++;
+      return -1;
+    }
+    connected = true;
+  }
+  
+  uint32_t t = nextRandom();
+  memcpy(token, &t, COAP_MAX_TOKEN);
+  uint8_t szx = blockSzx();
+  CoapMessage reply;
+  
+  // Request payload; Block1 when it does not fit one message
+  size_t offset = 0;
+  while (true) {
+    size_t n = length - offset;
+    bool more = false;
+    int32_t block1 = -1;
+    if (length > COAP_BLOCK_SIZE) {
+      if (n > COAP_BLOCK_SIZE) {
+        n = COAP_BLOCK_SIZE;
+        more = true;
+      }
+      block1 = (int32_t)((offset / COAP_BLOCK_SIZE) << 4) | (more ? 0x08 : 0) | szx;
+    }
+    
+    uint16_t messageId = nextMessageId++;
+    size_t messageLength = encode(tx, sizeof(tx), COAP_CON, method, messageId, token, COAP_MAX_TOKEN, path, query,
+                                  (length > 0) ? format : COAP_FORMAT_NONE, block1, -1,
+                                  payload + offset, n);
+    if (messageLength == 0) {
+      LOG_E("CoAP", "Request too large for one message");
+      return -1;
+    }
+    if (!exchange(messageLength, messageId, &reply)) {
+      stats.failures++;
+      return -1;
+    }
+    if (!more) {
+      break;
+    }
+    if (reply.code != COAP_CONTINUE) {
+      return reply.code;  // Server rejected the body part way
+    }
+    offset += n;
+  }
+  
+  // Response payload, fetching further Block2 blocks
+  while (true) {
+    size_t n = reply.payloadLength;
+    if (*responseLength + n > maxResponse) {
+      n = maxResponse - *responseLength;
+    }
+    memcpy(response + *responseLength, reply.payload, n);
+    *responseLength += n;
+    
+    if (reply.block2 < 0 || (reply.block2 & 0x08) == 0 || *responseLength >= maxResponse) {
+      break;
+    }
+    int32_t block2 = (((reply.block2 >> 4) + 1) << 4) | (reply.block2 & 0x07);
+    uint16_t messageId = nextMessageId++;
+    size_t messageLength = encode(tx, sizeof(tx), COAP_CON, method, messageId, token, COAP_MAX_TOKEN, path, query,
+                                  COAP_FORMAT_NONE, -1, block2, nullptr, 0);
+    if (!exchange(messageLength, messageId, &reply)) {
+      stats.failures++;
+      return -1;
+    }
+  }
+  
+  if (*responseLength < maxResponse) {
+    response[*responseLength] = '\0';
+  }
+  Logger::printf(LOG_DEBUG, "CoAP", "%s -> %u.%02u (%u bytes)", path, COAP_CODE_CLASS(reply.code),
+                 reply.code & 0x1F, (unsigned)*responseLength);
+  return reply.code;
+}
+
+// Send a CON message and wait for its ACK (or separate response)
+bool CoapClient::exchange(size_t length, uint16_t messageId, CoapMessage* reply) {
+  uint32_t timeout = COAP_ACK_TIMEOUT_MS + nextRandom() % (COAP_ACK_TIMEOUT_MS / 2 + 1);
+  bool separate = false;
+  
+  for (int attempt = 0; attempt <= COAP_MAX_RETRANSMIT; attempt++) {
+    if (attempt > 0) {
+      stats.retransmissions++;
+      Logger::printf(LOG_DEBUG, "CoAP", "Retransmit %d (MID %u)", attempt, messageId);
+    }
+    if (!sendDatagram(tx, length)) {
+      return false;
+    }
+    
+    uint32_t start = millis();
+    while (millis() - start < timeout) {
+      int n = lte->socketReceive(socketId, rx, sizeof(rx), timeout - (millis() - start));
+      if (n < 0) {
+        connected = false;
+        return false;
+      }
+      if (n == 0) {
+        break;
+      }
+      stats.bytesReceived += n + COAP_IP_UDP_OVERHEAD;
+      
+      CoapMessage m;
+      if (!parse(rx, n, &m)) {
+        continue;
+      }
+      bool ourToken = (m.tokenLength == COAP_MAX_TOKEN && memcmp(m.token, token, COAP_MAX_TOKEN) == 0);
+      if (m.type == COAP_ACK && m.messageId == messageId) {
+        if (m.code == 0) {
+          // Empty ACK: the response follows as its own message
+          separate = true;
+          start = millis();
+          timeout = LTE_HTTP_TIMEOUT_MS;
+          continue;
+        }
+        if (ourToken) {
+          *reply = m;
+          return true;
+        }
+      } else if (m.type == COAP_RST && m.messageId == messageId) {
+        LOG_W("CoAP", "Request reset by server");
+        return false;
+      } else if ((m.type == COAP_CON || m.type == COAP_NON) && ourToken) {
+        if (m.type == COAP_CON) {
+          sendEmptyAck(m.messageId);
+        }
+        *reply = m;
+        return true;
+      }
+    }
+    
+    if (separate) {
+      return false;  // Acknowledged, but the response never came
+    }
+    timeout *= 2;
+  }
+  return false;
+}
+
+bool CoapClient::sendDatagram(const uint8_t* data, size_t length) {
+  if (!lte->socketSend(socketId, data, length)) {
+    connected = false;
+    return false;
+  }
+  stats.messages++;
+  stats.bytesSent += length + COAP_IP_UDP_OVERHEAD;
+  return true;
+}
+
+void CoapClient::sendEmptyAck(uint16_t messageId) {
+  uint8_t ack[4] = { (uint8_t)(0x40 | (COAP_ACK << 4)), 0, (uint8_t)(messageId >> 8), (uint8_t)messageId };
+  sendDatagram(ack, sizeof(ack));
+}
+
+void CoapClient::close() {
+  if (connected) {
+    lte->socketClose(socketId);
+    connected = false;
+  }
+}
+
+const CoapStats& CoapClient::getStats() {
+  return stats;
+}
+
+// xorshift32
+uint32_t CoapClient::nextRandom() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+// ============================================
+// ENCODE
+// ============================================
+uint8_t* CoapClient::putOption(uint8_t* p, uint8_t* end, uint16_t* last, uint16_t number,
+                               const uint8_t* value, size_t length) {
+  if (p == nullptr) {
+    return nullptr;
+  }
+  uint16_t delta = number - *last;
+  uint8_t header[5];
+  size_t h = 1;
+  
+  // Delta and length nibbles: <13 inline, 13 = +1 byte, 14 = +2 bytes
+  uint8_t deltaNibble = (delta < 13) ? delta : (delta < 269) ? 13 : 14;
+  uint8_t lengthNibble = (length < 13) ? length : (length < 269) ? 13 : 14;
+  header[0] = (deltaNibble << 4) | lengthNibble;
+  if (deltaNibble == 13) {
+    header[h++] = delta - 13;
+  } else if (deltaNibble == 14) {
+    header[h++] = (delta - 269) >> 8;
+    header[h++] = (delta - 269) & 0xFF;
+  }
+  if (lengthNibble == 13) {
+    header[h++] = length - 13;
+  } else if (lengthNibble == 14) {
+    header[h++] = (length - 269) >> 8;
+    header[h++] = (length - 269) & 0xFF;
+  }
+  
+  if (p + h + length > end) {
+    return nullptr;
+  }
+  memcpy(p, header, h);
+  memcpy(p + h, value, length);
+  *last = number;
+  return p + h + length;
+}
+
+// Unsigned option in the fewest bytes (0 = empty)
+uint8_t* CoapClient::putUintOption(uint8_t* p, uint8_t* end, uint16_t* last, uint16_t number, uint32_t value) {
+  uint8_t bytes[4];
+  size_t n = 0;
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    uint8_t b = (value >> shift) & 0xFF;
+    if (n > 0 || b != 0) {
+      bytes[n++] = b;
+    }
+  }
+  return putOption(p, end, last, number, bytes, n);
+}
+
+// One option per non-empty segment ("a/b" -> "a", "b")
+uint8_t* CoapClient::putSegments(uint8_t* p, uint8_t* end, uint16_t* last, uint16_t number,
+                                 const char* text, char separator) {
+  if (text == nullptr) {
+    return p;
+  }
+  while (*text != '\0' && p != nullptr) {
+    const char* segmentEnd = strchr(text, separator);
+    size_t n = (segmentEnd != nullptr) ? (size_t)(segmentEnd - text) : strlen(text);
+    if (n > 0) {
+      p = putOption(p, end, last, number, (const uint8_t*)text, n);
+    }
+    text += n;
+    if (*text == separator) {
+      text++;
+    }
+  }
+  return p;
+}
+
+size_t CoapClient::encode(uint8_t* out, size_t size, uint8_t type, uint8_t code, uint16_t messageId,
+                          const uint8_t* token, uint8_t tokenLength, const char* path, const char* query,
+                          uint16_t format, int32_t block1, int32_t block2, const uint8_t* payload, size_t length) {
+  if (size < 4u + tokenLength) {
+    return 0;
+  }
+  out[0] = 0x40 | (type << 4) | tokenLength;  // Version 1
+  out[1] = code;
+  out[2] = messageId >> 8;
+  out[3] = messageId & 0xFF;
+  memcpy(out + 4, token, tokenLength);
+  
+  // Options in ascending number order
+  uint8_t* p = out + 4 + tokenLength;
+  uint8_t* end = out + size;
+  uint16_t last = 0;
+  p = putSegments(p, end, &last, COAP_OPT_URI_PATH, path, '/');
+  if (format != COAP_FORMAT_NONE) {
+    p = putUintOption(p, end, &last, COAP_OPT_CONTENT_FORMAT, format);
+  }
+  p = putSegments(p, end, &last, COAP_OPT_URI_QUERY, query, '&');
+  if (block2 >= 0) {
+    p = putUintOption(p, end, &last, COAP_OPT_BLOCK2, block2);
+  }
+  if (block1 >= 0) {
+    p = putUintOption(p, end, &last, COAP_OPT_BLOCK1, block1);
+  }
+  
+  if (p != nullptr && length > 0) {
+    if (p + 1 + length > end) {
+      return 0;
+    }
+    *p++ = 0xFF;  // Payload marker
+    memcpy(p, payload, length);
+    p += length;
+  }
+  return (p != nullptr) ? p - out : 0;
+}
+
+// ============================================
+// PARSE
+// ============================================
+bool CoapClient::parse(const uint8_t* data, size_t length, CoapMessage* message) {
+  if (length < 4 || (data[0] >> 6) != 1) {
+    return false;
+  }
+  message->type = (data[0] >> 4) & 0x03;
+  message->tokenLength = data[0] & 0x0F;
+  message->code = data[1];
+  message->messageId = ((uint16_t)data[2] << 8) | data[3];
+  message->block1 = -1;
+  message->block2 = -1;
+  message->payload = nullptr;
+  message->payloadLength = 0;
+  if (message->tokenLength > 8 || 4u + message->tokenLength > length) {
+    return false;
+  }
+  memcpy(message->token, data + 4, message->tokenLength);
+  
+  const uint8_t* p = data + 4 + message->tokenLength;
+  const uint8_t* end = data + length;
+  uint16_t number = 0;
+  while (p < end) {
+    if (*p == 0xFF) {
+      message->payload = p + 1;
+      message->payloadLength = end - (p + 1);
+      return message->payloadLength > 0;  // Marker with no payload is a format error
+    }
+    uint16_t delta = *p >> 4;
+    uint16_t optionLength = *p & 0x0F;
+    p++;
+    if (delta == 15 || optionLength == 15) {
+      return false;
+    }
+    if (delta == 13) {
+      if (p >= end) {
+        return false;
+      }
+      delta = 13 + *p++;
+    } else if (delta == 14) {
+      if (p + 2 > end) {
+        return false;
+      }
+      delta = 269 + (((uint16_t)p[0] << 8) | p[1]);
+      p += 2;
+    }
+    if (optionLength == 13) {
+      if (p >= end) {
+        return false;
+      }
+      optionLength = 13 + *p++;
+    } else if (optionLength == 14) {
+      if (p + 2 > end) {
+        return false;
+      }
+      optionLength = 269 + (((uint16_t)p[0] << 8) | p[1]);
+      p += 2;
+    }
+    if (p + optionLength > end) {
+      return false;
+    }
+    
+    number += delta;
+    if ((number == COAP_OPT_BLOCK1 || number == COAP_OPT_BLOCK2) && optionLength <= 3) {
+      int32_t value = 0;
+      for (uint16_t i = 0; i < optionLength; i++) {
+        value = (value << 8) | p[i];
+      }
+      if (number == COAP_OPT_BLOCK1) {
+        message->block1 = value;
+      } else {
+        message->block2 = value;
+      }
+    }
+    p += optionLength;
+  }
+  return true;
+}
@@ -0,0 +1,144 @@
+/*
+ * coap_client.h
+ * 
+ * Compact CoAP (RFC 7252) client over a modem UDP socket
+ * 
+ * For small control exchanges (upload start/status, telemetry) that would
+ * otherwise each pay a TCP + TLS handshake and a few hundred bytes of HTTP
+ * headers. A request is one datagram with a 4-byte header, a short token
+ * and delta-encoded options; the response normally comes back piggybacked
+ * on the ACK.
+ * 
+ *   - Confirmable requests, retransmitted with exponential backoff
+ *     (COAP_ACK_TIMEOUT_MS x 1..1.5, doubled COAP_MAX_RETRANSMIT times)
+ *   - Separate responses (empty ACK, then a CON response that is ACKed)
+ *   - Block-wise transfer (RFC 7959): request payloads over COAP_BLOCK_SIZE
+ *     go as Block1, large responses are fetched with Block2
+ * 
+ * Not encrypted: there is no DTLS on the modem's UDP sockets, so use it
+ * only for data that may travel in the clear (or over a private APN).
+ * Bulk audio stays on HTTPS.
+ */
+
+#ifndef COAP_CLIENT_H
+#define COAP_CLIENT_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "lte_manager.h"
+
+// Message types
+#define COAP_CON  0
+#define COAP_NON  1
+#define COAP_ACK  2
+#define COAP_RST  3
+
+// Codes: class.detail packed as c.dd
+#define COAP_CODE(c, dd)       (((c) << 5) | (dd))
+#define COAP_CODE_CLASS(code)  ((code) >> 5)
+#define COAP_GET               COAP_CODE(0, 1)
+#define COAP_POST              COAP_CODE(0, 2)
+#define COAP_PUT               COAP_CODE(0, 3)
+#define COAP_CREATED           COAP_CODE(2, 1)
+#define COAP_CHANGED           COAP_CODE(2, 4)
+#define COAP_CONTENT           COAP_CODE(2, 5)
+#define COAP_CONTINUE          COAP_CODE(2, 31)
+
+// Options used here
+#define COAP_OPT_URI_PATH        11
+#define COAP_OPT_CONTENT_FORMAT  12
+#define COAP_OPT_URI_QUERY       15
+#define COAP_OPT_BLOCK2          23
+#define COAP_OPT_BLOCK1          27
+
+#define COAP_FORMAT_NONE    0xFFFF
+#define COAP_FORMAT_OCTETS  42
+#define COAP_FORMAT_JSON    50
+
+#define COAP_MAX_TOKEN        4
+#define COAP_MAX_MESSAGE      (COAP_BLOCK_SIZE + 160)  // Block + header/options
+#define COAP_IP_UDP_OVERHEAD  28                       // IPv4 + UDP header per datagram
+
+// ============================================
+// MESSAGE (parsed; payload points into the receive buffer)
+// ============================================
+struct CoapMessage {
+  uint8_t type;
+  uint8_t code;
+  uint16_t messageId;
+  uint8_t token[8];
+  uint8_t tokenLength;
+  int32_t block1;              // Raw Block1 value, -1 if absent
+  int32_t block2;              // Raw Block2 value, -1 if absent
+  const uint8_t* payload;
+  size_t payloadLength;
+};
+
+// ============================================
+// STATISTICS
+// ============================================
+struct CoapStats {
+  uint32_t requests;           // request() calls
+  uint32_t messages;           // Datagrams sent (including retransmissions and ACKs)
+  uint32_t retransmissions;
+  uint32_t failures;           // Requests that got no answer
+  uint32_t bytesSent;          // On air, including IP/UDP headers
+  uint32_t bytesReceived;
+};
+
+// ============================================
+// COAP CLIENT CLASS
+// ============================================
+class CoapClient {
+public:
+  CoapClient();
+  
+  // seed: message ID / token / backoff randomness (e.g. esp_random())
+  void begin(LTEManager* lte, uint8_t socketId, const char* host, uint16_t port, uint32_t seed);
+  
+  // Confirmable request. path "a/b", query "k=v&k2=v2" (either may be nullptr),
+  // format: COAP_FORMAT_xxx for the payload. The response payload (all
+  // Block2 blocks) is copied to response, NUL-terminated when it fits.
+  // Returns the response code (COAP_CODE_CLASS 2 = success) or -1 if the
+  // server never answered - the caller should fall back to HTTPS.
+  int request(uint8_t method, const char* path, const char* query, uint16_t format,
+              const uint8_t* payload, size_t length,
+              uint8_t* response, size_t* responseLength, size_t maxResponse);
+  
+  // Release the modem socket (reopened on the next request)
+  void close();
+  
+  const CoapStats& getStats();
+  
+  // Wire format (public so they can be benchmarked without a modem)
+  static size_t encode(uint8_t* out, size_t size, uint8_t type, uint8_t code, uint16_t messageId,
+                       const uint8_t* token, uint8_t tokenLength, const char* path, const char* query,
+                       uint16_t format, int32_t block1, int32_t block2, const uint8_t* payload, size_t length);
+  static bool parse(const uint8_t* data, size_t length, CoapMessage* message);
+
+private:
+  LTEManager* lte;
+  uint8_t socketId;
+  const char* host;
+  uint16_t port;
+  bool connected;
+  uint16_t nextMessageId;
+  uint32_t rng;
+  uint8_t token[COAP_MAX_TOKEN];
+  CoapStats stats;
+  
+  uint8_t tx[COAP_MAX_MESSAGE];
+  uint8_t rx[COAP_MAX_MESSAGE];
+  
+  bool exchange(size_t length, uint16_t messageId, CoapMessage* reply);
+  bool sendDatagram(const uint8_t* data, size_t length);
+  void sendEmptyAck(uint16_t messageId);
+  uint32_t nextRandom();
+  static uint8_t* putOption(uint8_t* p, uint8_t* end, uint16_t* last, uint16_t number,
+                            const uint8_t* value, size_t length);
+  static uint8_t* putUintOption(uint8_t* p, uint8_t* end, uint16_t* last, uint16_t number, uint32_t value);
+  static uint8_t* putSegments(uint8_t* p, uint8_t* end, uint16_t* last, uint16_t number,
+                              const char* text, char separator);
+};
+
+#endif // COAP_CLIENT_H
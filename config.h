@@ -21,6 +21,17 @@
 // Audio buffer sizes (in bytes)
 #define AUDIO_BUFFER_SIZE     32768  // 32KB = ~1 second at 16kHz 16-bit mono
 
+// Capture quality thresholds (per-clip stats, see AudioManager::getCaptureStats)
+#define CAPTURE_SILENCE_LEVEL 64     // |sample| below this counts as silent
+#define CAPTURE_CLIP_LEVEL    32000  // |sample| at or above this counts as clipped
+
+// Microphone watchdog (background health monitor, see mic_watchdog.h)
+#define MIC_WATCHDOG_PERIOD_MS      100   // ms - how often capture counters are checked
+#define MIC_WATCHDOG_STUCK_BLOCKS   50    // consecutive stuck blocks before restart
+#define MIC_WATCHDOG_STALL_MS       1500  // ms - no good block for this long triggers restart
+#define MIC_WATCHDOG_MAX_RESTARTS   3     // restart budget per recording clip
+#define MIC_WATCHDOG_HOLDOFF_MS     1000  // ms - minimum spacing between restarts
+
 // ============================================
 // LTE MODEM CONFIGURATION
 // ============================================
@@ -30,6 +41,22 @@
 #define LTE_SKIP_NETWORK_CHECK  0  // 1=skip CPIN?/CREG? (avoids modem bad state when CPIN? returns ERROR)
 #define LTE_SKIP_EPS_ATTACH     1  // 1=skip wait for +CGATT:1; proceed to APN/bearer (modem may attach on CNACT)
 #define LTE_SKIP_APN_CONFIG     1  // 1=skip CGDCONT if it fails; try CNACT with default/SIM APN
+#define LTE_UART_DRIVER       1      // 1=ESP-IDF UART driver with a large RX ring and line detection (see modem_uart.h)
+#define LTE_UART_RX_RING      16384  // Driver RX ring bytes (~140 ms at 921600 baud)
+#define LTE_UART_TX_RING      2048   // Driver TX ring bytes (0 = write() blocks until sent)
+#define LTE_UART_EVENT_QUEUE  32     // Driver event queue depth
+#define LTE_UART_PATTERN_QUEUE 64    // '\n' positions remembered for unread data
+#define LTE_RX_CHUNK          512    // LTEManager staging buffer (bytes per bulk read)
+#define LTE_BAUD_NEGOTIATION  1      // 1=raise the UART rate with AT+IPR after power-on, step down on errors
+#define LTE_FAST_BAUD_RATES   { 921600, 230400 }  // Tried fastest first (rates the SIM7070 AT+IPR accepts)
+#define LTE_FLOW_CONTROL      1      // 1=modem holds our TX with CTS (AT+IFC=0,2); the board has no RTS line
+#define LTE_BAUD_PROBES       3      // AT round trips that must all pass at a new rate
+#define LTE_BAUD_MAX_FAILURES 3      // Unanswered commands in a row (or UART frame errors) before stepping down
+#define LTE_CMUX              1      // 1=GSM 07.10 multiplexing after bring-up: control, data and URC channels (see cmux.h)
+#define LTE_CMUX_FRAME_SIZE   127    // Max info bytes per frame (N1, sent with AT+CMUX)
+#define LTE_CMUX_RING         2048   // RX ring per channel (allocated while the mux is open)
+#define LTE_CMUX_RING_HOLD_MS 200    // ms - a full control/URC ring unread this long is overwritten instead of holding the UART
+#define LTE_CMUX_SIGNAL_POLL_MS 10000 // ms - signal readings on the control channel while a transfer waits
 #define API_BASE_URL          "https://rmhfhawfcyutzdtwsfnj.supabase.co/functions/v1"
 #define DEVICE_TOKEN          "device_b6525ecf-f009-4068-baa1-c26f5057e6ae"
 // SIM Info (for reference):
@@ -41,7 +68,18 @@
 // ============================================
 #define LONG_PRESS_MS         800    // ms - button hold time for long press
 #define DEBOUNCE_MS           50     // ms - button debounce time
+#define BUTTON_GESTURES       1      // 1=tap/double/triple/hold gestures (tap waits GESTURE_TAP_GAP_MS)
+#define GESTURE_TAP_GAP_MS    250    // ms - max gap between taps of a multi-tap
+#define GESTURE_REPEAT_MS     500    // ms - repeat interval while holding
+#define GESTURE_HOLD_GAP_MS   400    // ms - max gap for hold-release-hold
 #define NFC_READ_TIMEOUT_MS   2000   // ms - timeout for NFC read operation
+#define NFC_IRQ_DETECTION     1      // 1=wait for cards on the PN532 IRQ line instead of polling I2C
+#define NFC_DUTY_CYCLE        1      // 1=switch the RF field off between detection windows in IDLE
+#define NFC_FIELD_ON_MS       100    // ms - detection window (field on)
+#define NFC_FIELD_OFF_MIN_MS  200    // ms - field off between windows while tags are around
+#define NFC_FIELD_OFF_MAX_MS  1000   // ms - field off cap after backing off
+#define NFC_BACKOFF_WINDOWS   10     // Empty windows before the off time doubles
+#define NFC_NDEF_MAX_BYTES    504    // NDEF data area read limit (NTAG215 user memory)
 #define LTE_COMMAND_TIMEOUT_MS 5000  // ms - timeout for AT commands
 #define LTE_HTTP_TIMEOUT_MS   15000  // ms - timeout for HTTP operations
 #define MAX_RECORDING_MS      30000  // ms - maximum recording duration (30 seconds)
@@ -52,11 +90,90 @@
 #define NETWORK_ATTACH_RETRIES  3    // Number of network attach attempts
 #define HTTP_RETRY_COUNT        3    // Number of HTTP request retries
 
+// Adaptive AT/HTTP timeouts (see adaptive_timeout.h)
+#define ADAPTIVE_TIMEOUTS       1    // 1=learn per-command timeouts from response times (kept in NVS)
+#define RTO_TABLE_SIZE          16   // Commands tracked (the one with the fewest samples is replaced)
+#define RTO_MIN_SAMPLES         4    // Answers before a command's fixed timeout is replaced
+#define RTO_MIN_MS              500  // ms - shortest learned timeout
+#define RTO_GRANULARITY_MS      200  // ms - least margin over the mean (UART and task jitter)
+#define RTO_MAX_FACTOR          2    // Longest learned timeout, in multiples of the fixed one
+#define RTO_PEAK_HEADROOM_PERCENT 100 // Never below the recent slowest answer plus this much
+#define RTO_PEAK_DECAY          1024 // The recent slowest answer decays by 1/this per sample
+#define RTO_SAVE_EVERY          64   // New samples between NVS writes
+
+// Socket transport and HTTP/1.1 client (see http_client.h)
+#define HTTP_SOCKET_TRANSPORT   1    // 1=audio downloads and upload requests over HttpClient (0 = AT+HTTP stack)
+#define HTTP_SOCKET_ID          0    // Modem socket for HttpClient
+#define LTE_SOCKET_CHUNK        1460 // Max bytes per AT+CASEND / AT+CARECV
+#define LTE_SOCKET_POLL_MS      20   // ms - first AT+CARECV poll interval (backs off 8x)
+#define HTTP_CLIENT_RX_BUFFER   512  // Response header/body read buffer
+
+// CoAP control channel (see coap_client.h); not encrypted
+#define COAP_ENABLED            0      // 1=upload start/status over CoAP/UDP, HTTPS as fallback
+#define COAP_HOST               "coap.example.com"
+#define COAP_PORT               5683
+#define COAP_SOCKET_ID          2      // Modem socket for CoAP
+#define COAP_BLOCK_SIZE         512    // Block-wise transfer size (16..1024, power of two)
+#define COAP_ACK_TIMEOUT_MS     2000   // ms - first retransmission timeout (x1..1.5 random)
+#define COAP_MAX_RETRANSMIT     2      // Retransmissions before falling back (~21 s worst case)
+
+// Resumable upload (see resumable_upload.h)
+#define UPLOAD_CHUNK_SIZE       8192 // Bytes per chunk (server acknowledges each chunk)
+#define UPLOAD_CHUNK_RETRIES    4    // Retries per chunk before giving up (resumes on next attempt)
+#define UPLOAD_BACKOFF_BASE_MS  500  // ms - first retry delay, doubled per retry
+#define UPLOAD_BACKOFF_MAX_MS   8000 // ms - retry delay cap
+
+// Store-and-forward outbox in flash (see outbox.h)
+#define OUTBOX_SEGMENT_SIZE     65536   // Bytes per append-only segment file
+#define OUTBOX_MAX_BYTES        786432  // Oldest segments are dropped beyond this
+#define OUTBOX_DRAIN_INTERVAL_MS 30000  // ms - how often IDLE checks the bearer to drain
+
+// Latency telemetry (see latency_report.h)
+#define LATENCY_TELEMETRY       1      // 1=send state/LTE latency histograms with the next upload
+#define LATENCY_REPORT_MAX_BYTES 1536  // JSON body size for one snapshot
+
+// Batched telemetry events (see telemetry_batch.h)
+#define TELEMETRY_BATCHING      1      // 1=record events, send them with uploads or on a timer
+#define TELEMETRY_RING_BYTES    1024   // Delta-encoded event ring (~200 events; oldest dropped)
+#define TELEMETRY_TIME_UNIT_MS  100    // ms - event time resolution
+#define TELEMETRY_MAX_BYTES     2048   // JSON size of one batch (the rest waits for the next)
+#define TELEMETRY_FLUSH_FILL_PERCENT 75       // Send on its own once the ring is this full...
+#define TELEMETRY_FLUSH_INTERVAL_MS  21600000 // ms - ...or the oldest event is this old (6 h)
+#define TELEMETRY_CHECK_INTERVAL_MS  60000    // ms - how often IDLE checks the flush policy
+
+// Signal-aware bulk transfers (see link_monitor.h)
+#define LINK_AWARE_UPLOADS      1       // 1=defer/shrink uploads on a poor link (clips wait in the outbox)
+#define LINK_CSQ_POOR           8       // CSQ below this is a poor link
+#define LINK_CSQ_GOOD           15      // CSQ from this up is a good link (between: fair)
+#define LINK_RSRP_POOR_DBM      -115    // dBm - RSRP below this is a poor link
+#define LINK_RSRP_GOOD_DBM      -105    // dBm - RSRP from this up is a good link
+#define LINK_MAX_DEFER_MS       1800000 // ms - a deferred upload is sent anyway after this (30 min)
+#define LINK_MAX_TRANSFER_MS    120000  // ms - on a fair link, defer uploads estimated to take longer
+#define LINK_POOR_CHUNK_SIZE    2048    // Chunk size when sending on a poor link anyway
+#define LINK_SAMPLE_MAX_AGE_MS  60000   // ms - older signal readings count as unknown
+
+// Downloaded message cache in flash, keyed by NFC UID (see message_cache.h)
+#define MSG_CACHE_MAX_ENTRIES   16      // Messages kept (LRU eviction)
+#define MSG_CACHE_MAX_BYTES     524288  // Total cached PCM bytes (LRU eviction)
+
+// Predictive prefetch on tag presence (see audio_prefetch.h)
+#define PREFETCH_ENABLED        1      // 1=start fetching as soon as a tag is seen in IDLE
+#define PREFETCH_POLL_MS        500    // ms - IDLE tag presence poll interval
+#define PREFETCH_MAX_AGE_MS     60000  // ms - prefetched audio older than this is discarded
+#define PREFETCH_RETRY_MS       5000   // ms - first wait before re-fetching a tag whose prefetch failed (doubles)
+#define PREFETCH_RETRY_MAX_MS   60000  // ms - cap on that wait
+
+// Main loop scheduler (see scheduler.h)
+#define SCHEDULER_IDLE_MAX_WAIT_MS   1000   // ms - longest idle sleep without a timer or event
+#define SCHEDULER_ACTIVE_WAIT_MS     10     // ms - loop pace while a state is busy
+#define SCHEDULER_STATS_INTERVAL_MS  300000 // ms - how often wakeup/dispatch stats are logged
+
 // ============================================
 // SERIAL DEBUG
 // ============================================
 #define SERIAL_BAUD_RATE      115200
 #define ENABLE_DEBUG_LOGGING  true
+#define ENABLE_PROFILING      0      // 1=time hot paths with the cycle counter (see profiler.h)
 
 // ============================================
 // MEMORY MANAGEMENT
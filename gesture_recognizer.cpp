@@ -0,0 +1,208 @@
+/*
+ * gesture_recognizer.cpp
+ * 
+ * Implementation of the table-driven button gesture engine
+ */
+
+#include "gesture_recognizer.h"
+
+#define GESTURE_MAX_TAPS  3
+
+// ============================================
+// TRANSITION TABLE
+// ============================================
+// First row matching (state, input) whose guard passes wins.
+// Unlisted combinations are ignored.
+const GestureRecognizer::Transition GestureRecognizer::table[] = {
+  // state         input       guard            next           action
+  { ST_IDLE,       IN_PRESS,   GUARD_NONE,      ST_PRESSED,    ACT_PRESS      },
+  
+  { ST_PRESSED,    IN_RELEASE, GUARD_MORE_TAPS, ST_TAP_GAP,    ACT_TAP        },
+  { ST_PRESSED,    IN_RELEASE, GUARD_LAST_TAP,  ST_IDLE,       ACT_TRIPLE     },
+  { ST_PRESSED,    IN_TIMEOUT, GUARD_NONE,      ST_HOLDING,    ACT_HOLD_START },
+  
+  { ST_TAP_GAP,    IN_PRESS,   GUARD_NONE,      ST_PRESSED,    ACT_PRESS      },
+  { ST_TAP_GAP,    IN_TIMEOUT, GUARD_NONE,      ST_IDLE,       ACT_EMIT_TAPS  },
+  
+  { ST_HOLDING,    IN_TIMEOUT, GUARD_NONE,      ST_HOLDING,    ACT_REPEAT     },
+  { ST_HOLDING,    IN_RELEASE, GUARD_NONE,      ST_HOLD_GAP,   ACT_HOLD_END   },
+  
+  { ST_HOLD_GAP,   IN_PRESS,   GUARD_NONE,      ST_REPRESSED,  ACT_PRESS      },
+  { ST_HOLD_GAP,   IN_TIMEOUT, GUARD_NONE,      ST_IDLE,       ACT_NONE       },
+  
+  { ST_REPRESSED,  IN_TIMEOUT, GUARD_NONE,      ST_HOLDING,    ACT_HOLD_AGAIN },
+  { ST_REPRESSED,  IN_RELEASE, GUARD_NONE,      ST_IDLE,       ACT_NONE       },  // Tap after a hold: ignored
+};
+
+const uint8_t GestureRecognizer::tableSize = sizeof(table) / sizeof(table[0]);
+
+// ============================================
+// INITIALIZE
+// ============================================
+void GestureRecognizer::init(uint32_t tapGap, uint32_t hold, uint32_t repeat, uint32_t holdGap) {
+  tapGapMs = tapGap;
+  holdMs = hold;
+  repeatMs = repeat;
+  holdGapMs = holdGap;
+  
+  state = ST_IDLE;
+  tapCount = 0;
+  pressStartMs = 0;
+  deadline = 0;
+  deadlineArmed = false;
+  clear();
+}
+
+// ============================================
+// INPUTS
+// ============================================
+void GestureRecognizer::onEdge(bool pressed, uint32_t timeMs) {
+  // Deadlines that expired before this edge happened first
+  update(timeMs);
+  feed(pressed ? IN_PRESS : IN_RELEASE, timeMs);
+}
+
+void GestureRecognizer::update(uint32_t nowMs) {
+  while (deadlineArmed && (int32_t)(nowMs - deadline) >= 0) {
+    deadlineArmed = false;
+    feed(IN_TIMEOUT, deadline);
+  }
+}
+
+// ============================================
+// STATE MACHINE
+// ============================================
+void GestureRecognizer::feed(Input input, uint32_t timeMs) {
+  for (uint8_t i = 0; i < tableSize; i++) {
+    const Transition& t = table[i];
+    if (t.state != state || t.input != input || !checkGuard(t.guard)) {
+      continue;
+    }
+    
+    // Edges cancel a pending deadline; actions re-arm what they need
+    if (input != IN_TIMEOUT) {
+      deadlineArmed = false;
+    }
+    state = t.next;
+    runAction(t.action, timeMs);
+    if (state == ST_IDLE) {
+      tapCount = 0;
+    }
+    return;
+  }
+}
+
+bool GestureRecognizer::checkGuard(Guard guard) {
+  switch (guard) {
+    case GUARD_MORE_TAPS: return tapCount + 1 < GESTURE_MAX_TAPS;
+    case GUARD_LAST_TAP:  return tapCount + 1 >= GESTURE_MAX_TAPS;
+    default:              return true;
+  }
+}
+
+void GestureRecognizer::runAction(Action action, uint32_t timeMs) {
+  switch (action) {
+    case ACT_PRESS:
+      if (tapCount == 0) {
+        pressStartMs = timeMs;
+      }
+      arm(timeMs + holdMs);
+      break;
+    
+    case ACT_TAP:
+      tapCount++;
+      arm(timeMs + tapGapMs);
+      break;
+    
+    case ACT_TRIPLE:
+      emit(GESTURE_TRIPLE_TAP, timeMs);
+      break;
+    
+    case ACT_EMIT_TAPS:
+      emit(tapCount >= 2 ? GESTURE_DOUBLE_TAP : GESTURE_TAP, timeMs);
+      break;
+    
+    case ACT_HOLD_START:
+      // Taps before the hold do not count - it is a hold
+      tapCount = 0;
+      pressStartMs = timeMs - holdMs;
+      emit(GESTURE_HOLD_START, timeMs);
+      arm(timeMs + repeatMs);
+      break;
+    
+    case ACT_REPEAT:
+      emit(GESTURE_HOLD_REPEAT, timeMs);
+      arm(timeMs + repeatMs);
+      break;
+    
+    case ACT_HOLD_END:
+      emit(GESTURE_HOLD_END, timeMs);
+      arm(timeMs + holdGapMs);
+      break;
+    
+    case ACT_HOLD_AGAIN:
+      emit(GESTURE_HOLD_RELEASE_HOLD, timeMs);
+      arm(timeMs + repeatMs);
+      break;
+    
+    default:
+      break;
+  }
+}
+
+void GestureRecognizer::arm(uint32_t at) {
+  deadline = at;
+  deadlineArmed = true;
+}
+
+// ============================================
+// EVENT QUEUE
+// ============================================
+void GestureRecognizer::emit(GestureType type, uint32_t timeMs) {
+  // Full queue: drop the oldest, the app only cares about recent gestures
+  if (queueCount == GESTURE_QUEUE_SIZE) {
+    queueHead = (queueHead + 1) % GESTURE_QUEUE_SIZE;
+    queueCount--;
+  }
+  
+  GestureEvent& e = queue[(queueHead + queueCount) % GESTURE_QUEUE_SIZE];
+  e.type = type;
+  e.timeMs = timeMs;
+  e.startMs = pressStartMs;
+  queueCount++;
+}
+
+bool GestureRecognizer::nextGesture(GestureEvent& event) {
+  if (queueCount == 0) {
+    return false;
+  }
+  event = queue[queueHead];
+  queueHead = (queueHead + 1) % GESTURE_QUEUE_SIZE;
+  queueCount--;
+  return true;
+}
+
+void GestureRecognizer::clear() {
+  queueHead = 0;
+  queueCount = 0;
+}
+
+bool GestureRecognizer::isIdle() {
+  return state == ST_IDLE;
+}
+
+// ============================================
+// GESTURE NAMES (for logging)
+// ============================================
+const char* GestureRecognizer::getGestureName(uint8_t type) {
+  switch (type) {
+    case GESTURE_TAP:               return "TAP";
+    case GESTURE_DOUBLE_TAP:        return "DOUBLE_TAP";
+    case GESTURE_TRIPLE_TAP:        return "TRIPLE_TAP";
+    case GESTURE_HOLD_START:        return "HOLD_START";
+    case GESTURE_HOLD_REPEAT:       return "HOLD_REPEAT";
+    case GESTURE_HOLD_END:          return "HOLD_END";
+    case GESTURE_HOLD_RELEASE_HOLD: return "HOLD_RELEASE_HOLD";
+    default:                        return "NONE";
+  }
+}
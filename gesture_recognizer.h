@@ -0,0 +1,138 @@
+/*
+ * gesture_recognizer.h
+ * 
+ * Table-driven gesture engine for the single button
+ * 
+ * Fed with debounced press/release timestamps by ButtonHandler. All state
+ * lives in fixed fields and a small event ring - no dynamic allocation.
+ * 
+ * Classification latency (worst case, plus the debounce time and one loop pass):
+ *   TAP                tapGapMs after release (must rule out a second tap)
+ *   DOUBLE_TAP         tapGapMs after the second release
+ *   TRIPLE_TAP         at the third release
+ *   HOLD_START         holdMs after press
+ *   HOLD_REPEAT        every repeatMs while held
+ *   HOLD_END           at release
+ *   HOLD_RELEASE_HOLD  holdMs after the re-press (re-press within holdGapMs of release)
+ */
+
+#ifndef GESTURE_RECOGNIZER_H
+#define GESTURE_RECOGNIZER_H
+
+#include <Arduino.h>
+
+#define GESTURE_QUEUE_SIZE  8
+
+enum GestureType {
+  GESTURE_NONE = 0,
+  GESTURE_TAP,
+  GESTURE_DOUBLE_TAP,
+  GESTURE_TRIPLE_TAP,
+  GESTURE_HOLD_START,
+  GESTURE_HOLD_REPEAT,
+  GESTURE_HOLD_END,
+  GESTURE_HOLD_RELEASE_HOLD
+};
+
+struct GestureEvent {
+  uint8_t type;       // GestureType
+  uint32_t timeMs;    // When the gesture was complete (edge/deadline time)
+  uint32_t startMs;   // Press that started it
+};
+
+// ============================================
+// GESTURE RECOGNIZER CLASS
+// ============================================
+class GestureRecognizer {
+public:
+  // Set timing (ms)
+  void init(uint32_t tapGapMs, uint32_t holdMs, uint32_t repeatMs, uint32_t holdGapMs);
+  
+  // Debounced edge from ButtonHandler (timestamps must be non-decreasing)
+  void onEdge(bool pressed, uint32_t timeMs);
+  
+  // Fire deadlines up to now (call every loop pass)
+  void update(uint32_t nowMs);
+  
+  // Pop the oldest gesture (false if none)
+  bool nextGesture(GestureEvent& event);
+  
+  // Drop queued gestures
+  void clear();
+  
+  // True when no gesture is in progress (no deadline pending)
+  bool isIdle();
+  
+  static const char* getGestureName(uint8_t type);
+
+private:
+  // Recognizer states
+  enum State : uint8_t {
+    ST_IDLE,
+    ST_PRESSED,      // Down, not yet a hold
+    ST_TAP_GAP,      // Released after a tap, waiting for another
+    ST_HOLDING,      // Held past holdMs
+    ST_HOLD_GAP,     // Released after a hold, waiting for a re-press
+    ST_REPRESSED     // Pressed again after a hold
+  };
+  
+  // Inputs
+  enum Input : uint8_t {
+    IN_PRESS,
+    IN_RELEASE,
+    IN_TIMEOUT
+  };
+  
+  // Guards and actions referenced by the transition table
+  enum Guard : uint8_t {
+    GUARD_NONE,
+    GUARD_MORE_TAPS,   // Another tap can still follow
+    GUARD_LAST_TAP     // This release completes a triple tap
+  };
+  
+  enum Action : uint8_t {
+    ACT_NONE,
+    ACT_PRESS,         // Arm the hold deadline
+    ACT_TAP,           // Count a tap, arm the tap gap
+    ACT_TRIPLE,        // Emit triple tap
+    ACT_EMIT_TAPS,     // Emit tap / double tap
+    ACT_HOLD_START,    // Emit hold start, arm repeat
+    ACT_REPEAT,        // Emit repeat, re-arm
+    ACT_HOLD_END,      // Emit hold end, arm re-press gap
+    ACT_HOLD_AGAIN     // Emit hold-release-hold, arm repeat
+  };
+  
+  struct Transition {
+    State state;
+    Input input;
+    Guard guard;
+    State next;
+    Action action;
+  };
+  
+  static const Transition table[];
+  static const uint8_t tableSize;
+  
+  uint32_t tapGapMs;
+  uint32_t holdMs;
+  uint32_t repeatMs;
+  uint32_t holdGapMs;
+  
+  State state;
+  uint8_t tapCount;
+  uint32_t pressStartMs;
+  uint32_t deadline;
+  bool deadlineArmed;
+  
+  GestureEvent queue[GESTURE_QUEUE_SIZE];
+  uint8_t queueHead;
+  uint8_t queueCount;
+  
+  void feed(Input input, uint32_t timeMs);
+  bool checkGuard(Guard guard);
+  void runAction(Action action, uint32_t timeMs);
+  void emit(GestureType type, uint32_t timeMs);
+  void arm(uint32_t at);
+};
+
+#endif // GESTURE_RECOGNIZER_H
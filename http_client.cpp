@@ -0,0 +1,624 @@
+/*
+ * http_client.cpp
+ * 
+ * Implementation of the socket HTTP/1.1 client
+ */
+
+#include "http_client.h"
+#include "logger.h"
+
+// ============================================
+// INITIALIZE CLIENT
+// ============================================
+HttpClient::HttpClient() {
+  lte = nullptr;
+  socketId = 0;
+  connected = false;
+  reused = false;
+  host[0] = '\0';
+  port = 0;
+  tls = false;
+  txLength = 0;
+  requestSent = false;
+  chunkedRequest = false;
+  chunkStart = 0;
+  chunkOpen = false;
+  rxLength = 0;
+  rxPos = 0;
+  headRequest = false;
+  contentLength = -1;
+  chunkedResponse = false;
+  remaining = 0;
+  bodyDone = true;
+  keepAlive = false;
+  firstChunk = true;
+  captureName = nullptr;
+  captureValue = nullptr;
+  captureSize = 0;
+  connectionsOpened = 0;
+  requestsSent = 0;
+}
+
+void HttpClient::begin(LTEManager* lteManager, uint8_t socket) {
+  lte = lteManager;
+  socketId = socket;
+}
+
+// ============================================
+// REQUEST
+// ============================================
+bool HttpClient::beginRequest(const char* method, const char* url, const char* extraHeaders, int32_t length) {
+  char newHost[HTTP_CLIENT_MAX_HOST];
+  uint16_t newPort;
+  bool newTls;
+  const char* path;
+  if (!parseUrl(url, newHost, sizeof(newHost), &newPort, &newTls, &path)) {
+    Logger::printf(LOG_ERROR, "HTTP", "Bad URL: %s", url);
+    return false;
+  }
+  
+  // Previous response not read to the end: skip it before reusing the socket
+  if (connected && !bodyDone) {
+    finish();
+  }
+  if (connected && (strcmp(host, newHost) != 0 || port != newPort || tls != newTls)) {
+    close();
+  }
+  strcpy(host, newHost);
+  port = newPort;
+  tls = newTls;
+  
+  reused = connected;
+  if (!connected && !connect()) {
+    return false;
+  }
+  
+  txLength = 0;
+  requestSent = false;
+  chunkOpen = false;
+  chunkedRequest = (length == HTTP_CHUNKED);
+  headRequest = (strcmp(method, "HEAD") == 0);
+  captureName = nullptr;
+  bool bodyMethod = strcmp(method, "POST") == 0 || strcmp(method, "PUT") == 0 || strcmp(method, "PATCH") == 0;
+  requestsSent++;
+  Logger::printf(LOG_DEBUG, "HTTP", "%s %s%s", method, url, reused ? " (kept-alive)" : "");
+  
+  // Request head; HTTP/1.1 keeps the connection open unless either side says close
+  char line[48];
+  bool ok = append(method, strlen(method)) && append(" ", 1) && append(path, strlen(path)) &&
+            append(" HTTP/1.1\r\nHost: ", 17) && append(host, strlen(host));
+  if (ok && port != (tls ? 443 : 80)) {
+    snprintf(line, sizeof(line), ":%u", port);
+    ok = append(line, strlen(line));
+  }
+  ok = ok && append("\r\n", 2);
+  if (ok && extraHeaders != nullptr) {
+    ok = append(extraHeaders, strlen(extraHeaders));
+  }
+  if (ok && chunkedRequest) {
+    ok = append("Transfer-Encoding: chunked\r\n", 28);
+  } else if (ok && (length > 0 || bodyMethod)) {
+    // An empty POST still says so; some servers answer 411 otherwise
+    snprintf(line, sizeof(line), "Content-Length: %ld\r\n", (long)length);
+    ok = append(line, strlen(line));
+  }
+  return ok && append("\r\n", 2);
+}
+
+void HttpClient::captureHeader(const char* name, char* value, size_t valueSize) {
+  captureName = name;
+  captureValue = value;
+  captureSize = valueSize;
+  if (valueSize > 0) {
+    value[0] = '\0';
+  }
+}
+
+bool HttpClient::write(const uint8_t* data, size_t length) {
+  if (length == 0) {
+    return true;
+  }
+  if (!chunkedRequest) {
+    return append(data, length);
+  }
+  
+  // Each tx buffer's worth of body becomes one chunk: "XXXX\r\n<data>\r\n"
+  while (length > 0) {
+    if (!chunkOpen) {
+      if (txLength + 6 + 2 >= sizeof(tx) && !flush()) {
+        return false;
+      }
+      chunkStart = txLength;
+      txLength += 6;  // Size field, filled in by closeChunk()
+      chunkOpen = true;
+    }
+    size_t room = sizeof(tx) - 2 - txLength;
+    size_t n = (length < room) ? length : room;
+    memcpy(tx + txLength, data, n);
+    txLength += n;
+    data += n;
+    length -= n;
+    if (txLength + 2 >= sizeof(tx) && !flush()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int HttpClient::endRequest() {
+  if (chunkedRequest) {
+    closeChunk();
+    if (txLength + 5 > sizeof(tx) && !flush()) {
+      return -1;
+    }
+    append("0\r\n\r\n", 5);
+  }
+  
+  // A request still whole in tx can be sent again; flush() leaves tx intact
+  size_t requestLength = txLength;
+  bool replayable = reused && !requestSent;
+  if (!flush()) {
+    return -1;
+  }
+  
+  int status = readHead();
+  if (status < 0 && replayable && reused && rxLength == 0 && !connected) {
+    // A kept-alive socket the server closed usually accepts the send and
+    // only fails on the read: nothing was answered, reconnect and resend once
+    LOG_I("HTTP", "Kept-alive connection lost, reconnecting");
+    reused = false;
+    lte->socketClose(socketId);
+    connected = false;
+    if (!connect() || !lte->socketSend(socketId, tx, requestLength)) {
+      close();
+      return -1;
+    }
+    status = readHead();
+  }
+  if (status < 0) {
+    close();
+  }
+  return status;
+}
+
+// Status line and headers (skipping any 100 Continue); -1 on error
+int HttpClient::readHead() {
+  rxLength = 0;
+  rxPos = 0;
+  char line[128];
+  int status;
+  do {
+    if (!readLine(line, sizeof(line)) || strncmp(line, "HTTP/1.", 7) != 0) {
+      LOG_E("HTTP", "No valid status line");
+      return -1;
+    }
+    keepAlive = (line[7] == '1');
+    const char* code = strchr(line, ' ');
+    status = (code != nullptr) ? atoi(code + 1) : -1;
+    
+    contentLength = -1;
+    chunkedResponse = false;
+    while (true) {
+      if (!readLine(line, sizeof(line))) {
+        LOG_E("HTTP", "Response headers truncated");
+        return -1;
+      }
+      if (line[0] == '\0') {
+        break;
+      }
+      if (strncasecmp(line, "Content-Length:", 15) == 0) {
+        contentLength = atol(line + 15);
+      } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+        chunkedResponse = (strstr(line + 18, "chunked") != nullptr);
+      } else if (strncasecmp(line, "Connection:", 11) == 0) {
+        const char* value = line + 11;
+        while (*value == ' ') {
+          value++;
+        }
+        if (strncasecmp(value, "close", 5) == 0) {
+          keepAlive = false;
+        } else if (strncasecmp(value, "keep-alive", 10) == 0) {
+          keepAlive = true;
+        }
+      } else if (captureName != nullptr && captureSize > 0 &&
+                 strncasecmp(line, captureName, strlen(captureName)) == 0 && line[strlen(captureName)] == ':') {
+        const char* value = line + strlen(captureName) + 1;
+        while (*value == ' ') {
+          value++;
+        }
+        if (strlen(value) < captureSize) {
+          strcpy(captureValue, value);
+        }
+      }
+    }
+  } while (status == 100);
+  
+  // Body framing
+  bodyDone = false;
+  firstChunk = true;
+  if (headRequest || status == 204 || status == 304 || status < 200) {
+    remaining = 0;
+    bodyDone = true;
+  } else if (chunkedResponse) {
+    remaining = 0;
+    contentLength = -1;
+  } else if (contentLength >= 0) {
+    remaining = contentLength;
+    bodyDone = (remaining == 0);
+  } else {
+    remaining = -1;  // Body ends when the server closes
+    keepAlive = false;
+  }
+  
+  Logger::printf(LOG_DEBUG, "HTTP", "Status %d, %s body", status,
+                 chunkedResponse ? "chunked" : (remaining < 0 ? "close-delimited" : "sized"));
+  return status;
+}
+
+// ============================================
+// RESPONSE BODY
+// ============================================
+int HttpClient::read(uint8_t* buffer, size_t maxLength) {
+  if (bodyDone || maxLength == 0) {
+    return 0;
+  }
+  if (chunkedResponse && remaining == 0) {
+    if (!nextChunk()) {
+      LOG_E("HTTP", "Bad chunk framing");
+      close();
+      return -1;
+    }
+    if (bodyDone) {
+      return 0;
+    }
+  }
+  
+  size_t want = maxLength;
+  if (remaining >= 0 && (size_t)remaining < want) {
+    want = remaining;
+  }
+  
+  size_t n;
+  if (rxPos < rxLength) {
+    n = rxLength - rxPos;
+    if (n > want) {
+      n = want;
+    }
+    memcpy(buffer, rx + rxPos, n);
+    rxPos += n;
+  } else {
+    // Nothing buffered: receive straight into the caller's buffer
+    int got = connected ? lte->socketReceive(socketId, buffer, want, LTE_HTTP_TIMEOUT_MS) : -1;
+    if (got <= 0) {
+      if (remaining < 0 && got < 0) {
+        close();  // Server closed: end of a close-delimited body
+        return 0;
+      }
+      LOG_E("HTTP", "Response body truncated");
+      close();
+      return -1;
+    }
+    n = got;
+  }
+  
+  if (remaining >= 0) {
+    remaining -= n;
+    if (!chunkedResponse && remaining == 0) {
+      bodyDone = true;
+    }
+  }
+  return (int)n;
+}
+
+int32_t HttpClient::getContentLength() {
+  return contentLength;
+}
+
+void HttpClient::finish() {
+  if (connected && keepAlive && !bodyDone) {
+    uint8_t scratch[128];
+    while (read(scratch, sizeof(scratch)) > 0) {
+    }
+  }
+  if (!keepAlive || !bodyDone) {
+    close();
+  }
+}
+
+void HttpClient::close() {
+  if (connected) {
+    lte->socketClose(socketId);
+    connected = false;
+  }
+  bodyDone = true;
+  rxLength = 0;
+  rxPos = 0;
+}
+
+// ============================================
+// WHOLE-REQUEST HELPERS
+// ============================================
+bool HttpClient::get(const char* url, uint8_t* buffer, size_t* length, size_t maxLength, int* statusCode) {
+  *length = 0;
+  *statusCode = 0;
+  if (!beginRequest("GET", url, nullptr, 0)) {
+    return false;
+  }
+  int status = endRequest();
+  if (status < 0) {
+    return false;
+  }
+  *statusCode = status;
+  return readBody(buffer, length, maxLength);
+}
+
+bool HttpClient::post(const char* url, const uint8_t* data, size_t length, const char* contentType, int* statusCode) {
+  *statusCode = 0;
+  char header[96];
+  snprintf(header, sizeof(header), "Content-Type: %s\r\n", contentType);
+  if (!beginRequest("POST", url, header, length) || !write(data, length)) {
+    close();
+    return false;
+  }
+  int status = endRequest();
+  if (status < 0) {
+    return false;
+  }
+  *statusCode = status;
+  finish();
+  return true;
+}
+
+bool HttpClient::getConditional(const char* url, const char* ifNoneMatch, uint8_t* buffer, size_t* length,
+                                size_t maxLength, char* etagOut, size_t etagOutSize, int* statusCode) {
+  *length = 0;
+  *statusCode = 0;
+  
+  // The tag is echoed into the request head: only a well-formed one
+  char header[96];
+  header[0] = '\0';
+  if (ifNoneMatch != nullptr && ifNoneMatch[0] != '\0' && LTEManager::isEntityTag(ifNoneMatch)) {
+    snprintf(header, sizeof(header), "If-None-Match: %s\r\n", ifNoneMatch);
+  }
+  if (!beginRequest("GET", url, header[0] != '\0' ? header : nullptr, 0)) {
+    return false;
+  }
+  if (etagOut != nullptr) {
+    captureHeader("ETag", etagOut, etagOutSize);
+  }
+  int status = endRequest();
+  captureName = nullptr;
+  if (status < 0) {
+    return false;
+  }
+  *statusCode = status;
+  if (etagOut != nullptr && etagOutSize > 0 && !LTEManager::isEntityTag(etagOut)) {
+    etagOut[0] = '\0';
+  }
+  if (status != 200) {
+    finish();
+    return status == 304;
+  }
+  
+  return readBody(buffer, length, maxLength);
+}
+
+// Whole body straight into the caller's buffer as it arrives. A body larger
+// than maxLength fails instead of being cut short.
+bool HttpClient::readBody(uint8_t* buffer, size_t* length, size_t maxLength) {
+  if (contentLength > (int32_t)maxLength) {
+    Logger::printf(LOG_ERROR, "HTTP", "Body of %ld bytes exceeds buffer (%u)", (long)contentLength, (unsigned)maxLength);
+    close();
+    return false;
+  }
+  while (*length < maxLength) {
+    int n = read(buffer + *length, maxLength - *length);
+    if (n < 0) {
+      return false;
+    }
+    if (n == 0) {
+      break;
+    }
+    *length += n;
+  }
+  if (*length == maxLength && !bodyDone) {
+    // Chunked or close-delimited: full buffer, is there more?
+    uint8_t extra;
+    int n = read(&extra, 1);
+    if (n != 0) {
+      if (n > 0) {
+        Logger::printf(LOG_ERROR, "HTTP", "Body exceeds buffer (%u)", (unsigned)maxLength);
+      }
+      close();
+      return false;
+    }
+  }
+  finish();
+  return true;
+}
+
+uint32_t HttpClient::getConnectionsOpened() {
+  return connectionsOpened;
+}
+
+uint32_t HttpClient::getRequestsSent() {
+  return requestsSent;
+}
+
+// ============================================
+// CONNECTION AND TX BUFFER
+// ============================================
+bool HttpClient::connect() {
+  if (!lte->socketOpen(socketId, host, port, tls)) {
+    return false;
+  }
+  connected = true;
+  connectionsOpened++;
+  return true;
+}
+
+bool HttpClient::append(const void* data, size_t length) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  while (length > 0) {
+    if (txLength >= sizeof(tx) && !flush()) {
+      return false;
+    }
+    size_t n = sizeof(tx) - txLength;
+    if (n > length) {
+      n = length;
+    }
+    memcpy(tx + txLength, bytes, n);
+    txLength += n;
+    bytes += n;
+    length -= n;
+  }
+  return true;
+}
+
+bool HttpClient::flush() {
+  closeChunk();
+  if (txLength == 0) {
+    return true;
+  }
+  
+  if (!lte->socketSend(socketId, tx, txLength)) {
+    // A kept-alive socket the server has since closed fails on the first
+    // send; reconnect once and resend (nothing of the request is out yet)
+    bool retried = false;
+    if (reused && !requestSent) {
+      LOG_I("HTTP", "Kept-alive connection lost, reconnecting");
+      reused = false;
+      lte->socketClose(socketId);
+      connected = false;
+      retried = connect() && lte->socketSend(socketId, tx, txLength);
+    }
+    if (!retried) {
+      close();
+      return false;
+    }
+  }
+  requestSent = true;
+  txLength = 0;
+  return true;
+}
+
+// Fill in the open chunk's size field and terminate it
+void HttpClient::closeChunk() {
+  if (!chunkOpen) {
+    return;
+  }
+  chunkOpen = false;
+  size_t payload = txLength - chunkStart - 6;
+  if (payload == 0) {
+    txLength = chunkStart;
+    return;
+  }
+  // Fixed-width size (leading zeros are valid) so the field can be reserved up front
+  char size[8];
+  snprintf(size, sizeof(size), "%04X\r\n", (unsigned)payload);
+  memcpy(tx + chunkStart, size, 6);
+  tx[txLength++] = '\r';
+  tx[txLength++] = '\n';
+}
+
+// ============================================
+// RX BUFFER
+// ============================================
+bool HttpClient::fill() {
+  if (!connected) {
+    return false;
+  }
+  int n = lte->socketReceive(socketId, rx, sizeof(rx), LTE_HTTP_TIMEOUT_MS);
+  if (n <= 0) {
+    if (n < 0) {
+      connected = false;
+    }
+    return false;
+  }
+  rxLength = n;
+  rxPos = 0;
+  return true;
+}
+
+// Read one CRLF-terminated line; overlong lines are truncated
+bool HttpClient::readLine(char* line, size_t size) {
+  size_t n = 0;
+  while (true) {
+    if (rxPos >= rxLength && !fill()) {
+      return false;
+    }
+    char c = rx[rxPos++];
+    if (c == '\n') {
+      break;
+    }
+    if (c != '\r' && n + 1 < size) {
+      line[n++] = c;
+    }
+  }
+  line[n] = '\0';
+  return true;
+}
+
+// Read the next chunk-size line (after the previous chunk's CRLF)
+bool HttpClient::nextChunk() {
+  char line[32];
+  if (!firstChunk && (!readLine(line, sizeof(line)) || line[0] != '\0')) {
+    return false;
+  }
+  firstChunk = false;
+  if (!readLine(line, sizeof(line))) {
+    return false;
+  }
+  char* end;
+  long size = strtol(line, &end, 16);
+  if (end == line || size < 0) {
+    return false;
+  }
+  remaining = size;
+  if (size == 0) {
+    // Last chunk: skip trailers up to the blank line
+    while (readLine(line, sizeof(line)) && line[0] != '\0') {
+    }
+    bodyDone = true;
+  }
+  return true;
+}
+
+// ============================================
+// URL PARSING
+// ============================================
+bool HttpClient::parseUrl(const char* url, char* hostOut, size_t hostSize, uint16_t* portOut, bool* tlsOut,
+                          const char** path) {
+  const char* p = url;
+  if (strncmp(p, "https://", 8) == 0) {
+    *tlsOut = true;
+    *portOut = 443;
+    p += 8;
+  } else if (strncmp(p, "http://", 7) == 0) {
+    *tlsOut = false;
+    *portOut = 80;
+    p += 7;
+  } else {
+    return false;
+  }
+  
+  const char* end = p;
+  while (*end != '\0' && *end != '/' && *end != ':') {
+    end++;
+  }
+  size_t n = end - p;
+  if (n == 0 || n >= hostSize) {
+    return false;
+  }
+  memcpy(hostOut, p, n);
+  hostOut[n] = '\0';
+  
+  if (*end == ':') {
+    *portOut = (uint16_t)atoi(end + 1);
+    while (*end != '\0' && *end != '/') {
+      end++;
+    }
+  }
+  *path = (*end == '/') ? end : "/";
+  return true;
+}
@@ -0,0 +1,143 @@
+/*
+ * http_client.h
+ * 
+ * Minimal HTTP/1.1 client over the modem's TCP/TLS sockets
+ * 
+ * Unlike the AT+HTTP* stack, the body is never staged in the modem: it is
+ * streamed to the socket as the caller writes it, and the response is read
+ * incrementally, so neither side has a size limit beyond the caller's
+ * buffers. Supports:
+ *   - Content-Length or chunked request bodies (HTTP_CHUNKED)
+ *   - Content-Length, chunked and read-until-close response bodies
+ *   - Keep-alive: consecutive requests to the same host reuse the socket;
+ *     a reused socket the server has closed is reopened once, whether the
+ *     send fails or (once the request went out in one piece) the response
+ *     never starts
+ * 
+ * Usage:
+ *   http.beginRequest("POST", url, "Content-Type: audio/wav\r\n", HTTP_CHUNKED);
+ *   http.write(block, n);  ...
+ *   int status = http.endRequest();
+ *   while ((n = http.read(buf, sizeof(buf))) > 0) { ... }
+ *   http.finish();
+ * 
+ * Request bytes are packed into LTE_SOCKET_CHUNK-sized AT+CASEND calls;
+ * a small request (headers + body) goes out in one.
+ * 
+ * With HTTP_SOCKET_TRANSPORT the sketch fetches audio with getConditional()
+ * and ResumableUploader sends its requests through this client, so all chunks
+ * of an upload share one connection.
+ */
+
+#ifndef HTTP_CLIENT_H
+#define HTTP_CLIENT_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "lte_manager.h"
+
+#define HTTP_CHUNKED  -1   // contentLength for a body of unknown size
+
+#define HTTP_CLIENT_MAX_HOST  64
+
+// ============================================
+// HTTP CLIENT CLASS
+// ============================================
+class HttpClient {
+public:
+  HttpClient();
+  
+  // socketId: modem socket used for this client's connection
+  void begin(LTEManager* lte, uint8_t socketId);
+  
+  // Connect (or reuse the kept-alive connection) and queue the request head
+  // extraHeaders: "Name: value\r\n" lines or nullptr
+  // contentLength: body bytes to follow, 0 for none, or HTTP_CHUNKED
+  bool beginRequest(const char* method, const char* url, const char* extraHeaders, int32_t contentLength);
+  
+  // Copy one response header's value (e.g. "ETag") into value during the
+  // next endRequest(); "" if absent. Call after beginRequest().
+  void captureHeader(const char* name, char* value, size_t valueSize);
+  
+  // Request body bytes (may be called any number of times)
+  bool write(const uint8_t* data, size_t length);
+  
+  // Send the rest of the request and read the response head
+  // Returns the HTTP status, or -1 on a transport/protocol error
+  int endRequest();
+  
+  // Response body, streamed; returns bytes read, 0 at the end, -1 on error
+  int read(uint8_t* buffer, size_t maxLength);
+  
+  // Content-Length of the response, -1 if chunked or unknown
+  int32_t getContentLength();
+  
+  // Skip the unread body so the connection can be reused (or close it)
+  void finish();
+  
+  // Close the connection
+  void close();
+  
+  // Whole-request helpers; return false on transport errors (check status)
+  // or a response body larger than maxLength
+  bool get(const char* url, uint8_t* buffer, size_t* length, size_t maxLength, int* statusCode);
+  bool post(const char* url, const uint8_t* data, size_t length, const char* contentType, int* statusCode);
+  
+  // GET with ETag revalidation, as LTEManager::httpGetConditional()
+  bool getConditional(const char* url, const char* ifNoneMatch, uint8_t* buffer, size_t* length,
+                      size_t maxLength, char* etagOut, size_t etagOutSize, int* statusCode);
+  
+  // Connections opened / requests sent (keep-alive reuse = requests - connections)
+  uint32_t getConnectionsOpened();
+  uint32_t getRequestsSent();
+
+private:
+  LTEManager* lte;
+  uint8_t socketId;
+  
+  // Connection
+  bool connected;
+  bool reused;                 // Current request runs on a kept-alive socket
+  char host[HTTP_CLIENT_MAX_HOST];
+  uint16_t port;
+  bool tls;
+  
+  // Request
+  uint8_t tx[LTE_SOCKET_CHUNK];
+  size_t txLength;
+  bool requestSent;            // Any bytes of this request reached the socket
+  bool chunkedRequest;
+  size_t chunkStart;           // Offset of the open chunk's size field in tx
+  bool chunkOpen;
+  
+  // Response
+  uint8_t rx[HTTP_CLIENT_RX_BUFFER];
+  size_t rxLength;
+  size_t rxPos;
+  bool headRequest;
+  int32_t contentLength;
+  bool chunkedResponse;
+  int32_t remaining;           // Bytes left in body/chunk, -1 = until close
+  bool bodyDone;
+  bool keepAlive;
+  bool firstChunk;
+  const char* captureName;
+  char* captureValue;
+  size_t captureSize;
+  
+  uint32_t connectionsOpened;
+  uint32_t requestsSent;
+  
+  bool connect();
+  bool append(const void* data, size_t length);
+  bool flush();
+  void closeChunk();
+  int readHead();
+  bool readBody(uint8_t* buffer, size_t* length, size_t maxLength);
+  bool fill();
+  bool readLine(char* line, size_t size);
+  bool nextChunk();
+  static bool parseUrl(const char* url, char* host, size_t hostSize, uint16_t* port, bool* tls, const char** path);
+};
+
+#endif // HTTP_CLIENT_H
@@ -0,0 +1,135 @@
+/*
+ * latency_histogram.cpp
+ * 
+ * Implementation of the log-scale latency histogram
+ */
+
+#include "latency_histogram.h"
+
+LatencyHistogram::LatencyHistogram() {
+  reset();
+}
+
+// ============================================
+// BUCKET LAYOUT
+// ============================================
+uint8_t LatencyHistogram::bucketIndex(uint32_t ms) {
+  if (ms < LAT_HIST_SUB_BUCKETS) {
+    return (uint8_t)ms;
+  }
+  
+  // Octave = position of the top bit; the next two bits pick the sub-bucket
+  uint8_t msb = 31 - __builtin_clz(ms);
+  uint8_t sub = (ms >> (msb - 2)) & (LAT_HIST_SUB_BUCKETS - 1);
+  uint32_t index = LAT_HIST_SUB_BUCKETS + (uint32_t)(msb - 2) * LAT_HIST_SUB_BUCKETS + sub;
+  return (index < LAT_HIST_BUCKETS) ? (uint8_t)index : LAT_HIST_BUCKETS - 1;
+}
+
+uint32_t LatencyHistogram::bucketLow(uint8_t index) {
+  if (index < LAT_HIST_SUB_BUCKETS) {
+    return index;
+  }
+  uint8_t shift = (index - LAT_HIST_SUB_BUCKETS) / LAT_HIST_SUB_BUCKETS;
+  uint8_t sub = (index - LAT_HIST_SUB_BUCKETS) % LAT_HIST_SUB_BUCKETS;
+  return (uint32_t)(LAT_HIST_SUB_BUCKETS + sub) << shift;
+}
+
+uint32_t LatencyHistogram::bucketHigh(uint8_t index) {
+  if (index < LAT_HIST_SUB_BUCKETS) {
+    return index;
+  }
+  uint8_t shift = (index - LAT_HIST_SUB_BUCKETS) / LAT_HIST_SUB_BUCKETS;
+  return bucketLow(index) + (1UL << shift) - 1;
+}
+
+// ============================================
+// RECORD / MERGE / RESET
+// ============================================
+void LatencyHistogram::record(uint32_t ms) {
+  uint8_t index = bucketIndex(ms);
+  if (counts[index] < UINT16_MAX) {
+    counts[index]++;
+  }
+  total++;
+  if (ms > maxMs) {
+    maxMs = ms;
+  }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+  for (uint8_t i = 0; i < LAT_HIST_BUCKETS; i++) {
+    uint32_t sum = (uint32_t)counts[i] + other.counts[i];
+    counts[i] = (sum > UINT16_MAX) ? UINT16_MAX : (uint16_t)sum;
+  }
+  total += other.total;
+  if (other.maxMs > maxMs) {
+    maxMs = other.maxMs;
+  }
+}
+
+void LatencyHistogram::reset() {
+  memset(counts, 0, sizeof(counts));
+  total = 0;
+  maxMs = 0;
+}
+
+// ============================================
+// QUERIES
+// ============================================
+uint32_t LatencyHistogram::getCount() const {
+  return total;
+}
+
+uint32_t LatencyHistogram::getMax() const {
+  return maxMs;
+}
+
+uint32_t LatencyHistogram::getPercentile(float p) const {
+  // Walk the buckets rather than trusting total (buckets may have saturated)
+  uint32_t bucketTotal = 0;
+  for (uint8_t i = 0; i < LAT_HIST_BUCKETS; i++) {
+    bucketTotal += counts[i];
+  }
+  if (bucketTotal == 0) {
+    return 0;
+  }
+  
+  uint32_t rank = (uint32_t)(p / 100.0f * bucketTotal + 0.5f);
+  if (rank < 1) {
+    rank = 1;
+  }
+  
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < LAT_HIST_BUCKETS; i++) {
+    seen += counts[i];
+    if (seen >= rank) {
+      uint32_t mid = (bucketLow(i) + bucketHigh(i)) / 2;
+      return (mid < maxMs) ? mid : maxMs;
+    }
+  }
+  return maxMs;
+}
+
+// ============================================
+// EXPORT
+// ============================================
+bool LatencyHistogram::format(char* out, size_t outSize) const {
+  size_t pos = 0;
+  if (outSize == 0) {
+    return false;
+  }
+  out[0] = '\0';
+  
+  for (uint8_t i = 0; i < LAT_HIST_BUCKETS; i++) {
+    if (counts[i] == 0) {
+      continue;
+    }
+    int n = snprintf(out + pos, outSize - pos, "%s%u:%u", pos ? "," : "", i, counts[i]);
+    if (n < 0 || (size_t)n >= outSize - pos) {
+      out[pos] = '\0';
+      return false;
+    }
+    pos += n;
+  }
+  return true;
+}
@@ -0,0 +1,73 @@
+/*
+ * latency_histogram.h
+ * 
+ * Fixed-bucket log-scale latency histogram (milliseconds)
+ * 
+ * Buckets are log2 with 4 linear sub-buckets per octave: values 0-3 get
+ * their own bucket, above that every bucket is 1/4 of its power of two wide,
+ * so a recorded value is off by at most 25% of its bucket (~12% at the
+ * midpoint). The layout is fixed, so histograms from different devices and
+ * upload windows merge by adding counts. No dynamic allocation.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <Arduino.h>
+
+#define LAT_HIST_SUB_BUCKETS  4
+#define LAT_HIST_OCTAVES      16     // 4 ms .. 262 s
+#define LAT_HIST_BUCKETS      (LAT_HIST_SUB_BUCKETS + LAT_HIST_OCTAVES * LAT_HIST_SUB_BUCKETS)
+#define LAT_HIST_SCHEME       "log2x4"  // Reported with every export
+
+// ============================================
+// LATENCY HISTOGRAM CLASS
+// ============================================
+class LatencyHistogram {
+public:
+  LatencyHistogram();
+  
+  // Count one sample (values past the last bucket land in it)
+  void record(uint32_t ms);
+  
+  // Add another histogram's counts (same fixed layout)
+  void merge(const LatencyHistogram& other);
+  
+  void reset();
+  
+  uint32_t getCount() const;
+  uint32_t getMax() const;
+  
+  // Estimated value at percentile p (0-100): midpoint of the bucket holding it
+  uint32_t getPercentile(float p) const;
+  
+  // Sparse export "index:count,index:count" (false if it did not fit)
+  bool format(char* out, size_t outSize) const;
+  
+  // Bucket layout
+  static uint8_t bucketIndex(uint32_t ms);
+  static uint32_t bucketLow(uint8_t index);
+  static uint32_t bucketHigh(uint8_t index);
+
+private:
+  uint16_t counts[LAT_HIST_BUCKETS];   // Saturate at 65535 per bucket
+  uint32_t total;
+  uint32_t maxMs;
+};
+
+// ============================================
+// LATENCY SCOPE
+// ============================================
+// Records the time from construction to destruction into a histogram,
+// so functions with several return paths are covered by one line.
+class LatencyScope {
+public:
+  explicit LatencyScope(LatencyHistogram& hist) : hist(hist), startMs(millis()) {}
+  ~LatencyScope() { hist.record(millis() - startMs); }
+
+private:
+  LatencyHistogram& hist;
+  uint32_t startMs;
+};
+
+#endif // LATENCY_HISTOGRAM_H
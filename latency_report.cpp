@@ -0,0 +1,165 @@
+/*
+ * latency_report.cpp
+ * 
+ * Implementation of the latency telemetry snapshot
+ */
+
+#include "latency_report.h"
+#include "logger.h"
+#include <stdarg.h>
+
+// Append formatted text at *pos; false if it did not fit
+static bool appendf(char* out, size_t outSize, size_t* pos, const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(out + *pos, outSize - *pos, fmt, args);
+  va_end(args);
+  if (n < 0 || (size_t)n >= outSize - *pos) {
+    return false;
+  }
+  *pos += n;
+  return true;
+}
+
+LatencyReport::LatencyReport() {
+  seriesCount = 0;
+  snapshotActive = false;
+}
+
+// ============================================
+// REGISTER SERIES
+// ============================================
+bool LatencyReport::add(const char* group, const char* name, LatencyHistogram* hist) {
+  if (seriesCount >= LATENCY_REPORT_MAX_SERIES || hist == nullptr) {
+    Logger::printf(LOG_ERROR, "Latency", "Cannot add series %s/%s", group, name);
+    return false;
+  }
+  Series& s = series[seriesCount++];
+  s.group = group;
+  s.name = name;
+  s.live = hist;
+  s.pending.reset();
+  s.carried = false;
+  return true;
+}
+
+// ============================================
+// SNAPSHOT
+// ============================================
+bool LatencyReport::snapshot(char* out, size_t outSize) {
+  if (snapshotActive) {
+    finish(false);  // Previous snapshot was never resolved
+  }
+  
+  uint32_t samples = 0;
+  for (uint8_t i = 0; i < seriesCount; i++) {
+    series[i].pending = *series[i].live;
+    series[i].live->reset();
+    samples += series[i].pending.getCount();
+  }
+  snapshotActive = true;
+  
+  if (samples == 0) {
+    finish(false);
+    return false;
+  }
+  
+  // Series stop 3 bytes short of the end: room for the closing "}}}"
+  size_t pos = 0;
+  size_t limit = (outSize > 3) ? outSize - 3 : 0;
+  if (!appendf(out, limit, &pos, "{\"latency\":{\"scheme\":\"%s\",\"unit\":\"ms\"", LAT_HIST_SCHEME)) {
+    finish(false);
+    return false;
+  }
+  size_t headerEnd = pos;
+  const char* group = nullptr;
+  uint8_t carried = 0;
+  uint8_t dropped = 0;
+  
+  for (uint8_t i = 0; i < seriesCount; i++) {
+    Series& s = series[i];
+    if (s.pending.getCount() == 0) {
+      continue;
+    }
+    size_t mark = pos;
+    const char* markGroup = group;
+    
+    // Open a new group object (closing the previous one)
+    bool ok;
+    if (group == nullptr || strcmp(group, s.group) != 0) {
+      ok = appendf(out, limit, &pos, "%s,\"%s\":{", group ? "}" : "", s.group);
+      group = s.group;
+    } else {
+      ok = appendf(out, limit, &pos, ",");
+    }
+    
+    ok = ok && appendf(out, limit, &pos, "\"%s\":\"", s.name);
+    ok = ok && s.pending.format(out + pos, limit - pos);
+    if (ok) {
+      pos += strlen(out + pos);
+      ok = appendf(out, limit, &pos, "\"");
+    }
+    if (ok) {
+      s.carried = false;
+      continue;
+    }
+    
+    // Leave this series out. It goes in the next report, unless it did not
+    // fit there either or does not fit on its own: it would only grow.
+    pos = mark;
+    group = markGroup;
+    out[pos] = '\0';
+    if (mark == headerEnd || s.carried) {
+      s.carried = false;
+      dropped++;
+    } else {
+      s.live->merge(s.pending);
+      s.carried = true;
+      carried++;
+    }
+    s.pending.reset();
+  }
+  
+  if (carried > 0 || dropped > 0) {
+    Logger::printf(LOG_WARN, "Latency", "Report exceeds %u bytes - %u series carried over, %u dropped",
+                   outSize, carried, dropped);
+  }
+  if (pos == headerEnd) {
+    finish(false);
+    return false;
+  }
+  appendf(out, outSize, &pos, "%s}}", group ? "}" : "");
+  return true;
+}
+
+// ============================================
+// FINISH (drop or restore the snapshot)
+// ============================================
+void LatencyReport::finish(bool delivered) {
+  if (!snapshotActive) {
+    return;
+  }
+  for (uint8_t i = 0; i < seriesCount; i++) {
+    if (!delivered) {
+      series[i].live->merge(series[i].pending);
+    }
+    series[i].pending.reset();
+  }
+  snapshotActive = false;
+}
+
+// ============================================
+// LOG
+// ============================================
+void LatencyReport::log() {
+  for (uint8_t i = 0; i < seriesCount; i++) {
+    const LatencyHistogram* h = series[i].live;
+    if (h->getCount() == 0) {
+      continue;
+    }
+    Logger::printf(LOG_INFO, "Latency", "%s/%-12s n=%lu p50=%lu ms p99=%lu ms max=%lu ms",
+                   series[i].group, series[i].name, (unsigned long)h->getCount(),
+                   (unsigned long)h->getPercentile(50), (unsigned long)h->getPercentile(99),
+                   (unsigned long)h->getMax());
+  }
+}
@@ -0,0 +1,63 @@
+/*
+ * latency_report.h
+ * 
+ * Collects named latency histograms and exports them as telemetry
+ * 
+ * Series are registered once (state dwell, LTE operations, ...). snapshot()
+ * moves every live histogram into a private copy, resets it and formats the
+ * copies as JSON:
+ *   {"latency":{"scheme":"log2x4","unit":"ms",
+ *               "state":{"FETCH_AUDIO":"14:2,21:1",...},"lte":{...}}}
+ * Each value is LatencyHistogram::format() output. finish(false) merges the
+ * copies back into the live histograms, so samples are never lost when the
+ * report did not reach the server, and never sent twice when it did.
+ * 
+ * Series that do not fit in the output are left out and carried over to the
+ * next report. One that did not fit in that report either is reset (merged
+ * counts only grow, so it would block telemetry for good).
+ */
+
+#ifndef LATENCY_REPORT_H
+#define LATENCY_REPORT_H
+
+#include <Arduino.h>
+#include "latency_histogram.h"
+
+#define LATENCY_REPORT_MAX_SERIES  24
+
+// ============================================
+// LATENCY REPORT CLASS
+// ============================================
+class LatencyReport {
+public:
+  LatencyReport();
+  
+  // Register a histogram; series of one group must be added together
+  bool add(const char* group, const char* name, LatencyHistogram* hist);
+  
+  // Move live counts into the snapshot and format the series that fit.
+  // Returns false (and restores the counts) if no series fits or there is
+  // nothing to report.
+  bool snapshot(char* out, size_t outSize);
+  
+  // Report delivered (drop the snapshot) or not (merge it back)
+  void finish(bool delivered);
+  
+  // Log p50/p99/max of every non-empty live series
+  void log();
+
+private:
+  struct Series {
+    const char* group;
+    const char* name;
+    LatencyHistogram* live;
+    LatencyHistogram pending;
+    bool carried;            // Left out of the last report for size
+  };
+  
+  Series series[LATENCY_REPORT_MAX_SERIES];
+  uint8_t seriesCount;
+  bool snapshotActive;
+};
+
+#endif // LATENCY_REPORT_H
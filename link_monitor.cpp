@@ -0,0 +1,137 @@
+/*
+ * link_monitor.cpp
+ * 
+ * Implementation of the link quality monitor
+ */
+
+#include "link_monitor.h"
+#include "logger.h"
+
+static const char* const classNames[] = { "UNKNOWN", "POOR", "FAIR", "GOOD" };
+
+LinkMonitor::LinkMonitor() {
+  lastCsq = 99;
+  lastRsrp = 0;
+  lastSampleMs = 0;
+  haveSample = false;
+  throughput = 0;
+  failurePercent = 0;
+  lastTransferMs = 0;
+  deferredSinceMs = 0;
+  deferring = false;
+  memset(&stats, 0, sizeof(stats));
+}
+
+// ============================================
+// INPUTS
+// ============================================
+void LinkMonitor::onSignal(uint32_t nowMs, int csq, int rsrpDbm) {
+  stats.samples++;
+  lastCsq = csq;
+  lastRsrp = rsrpDbm;
+  lastSampleMs = nowMs;
+  haveSample = true;
+}
+
+void LinkMonitor::onTransfer(uint32_t nowMs, uint32_t bytes, uint32_t ms, bool ok) {
+  stats.transfers++;
+  lastTransferMs = nowMs;
+  
+  // EWMA weight 1/4: a couple of failures in a row are enough to matter
+  uint8_t outcome = ok ? 0 : 100;
+  failurePercent = (uint8_t)((failurePercent * 3 + outcome) / 4);
+  if (!ok) {
+    stats.failures++;
+    return;  // Bytes moved before a timeout say little about the link rate
+  }
+  
+  if (ms > 0 && bytes > 0) {
+    uint32_t rate = (uint32_t)((uint64_t)bytes * 1000 / ms);
+    throughput = (throughput == 0) ? rate : (throughput * 3 + rate) / 4;
+  }
+}
+
+// ============================================
+// CLASSIFY
+// ============================================
+LinkClass LinkMonitor::getClass(uint32_t nowMs) {
+  if (!haveSample || nowMs - lastSampleMs > LINK_SAMPLE_MAX_AGE_MS) {
+    return LINK_UNKNOWN;
+  }
+  
+  bool csqKnown = (lastCsq >= 0 && lastCsq <= 31);
+  bool rsrpKnown = (lastRsrp < 0);
+  if (!csqKnown && !rsrpKnown) {
+    return LINK_UNKNOWN;
+  }
+  
+  LinkClass linkClass = LINK_GOOD;
+  if ((csqKnown && lastCsq < LINK_CSQ_POOR) || (rsrpKnown && lastRsrp < LINK_RSRP_POOR_DBM)) {
+    linkClass = LINK_POOR;
+  } else if ((csqKnown && lastCsq < LINK_CSQ_GOOD) || (rsrpKnown && lastRsrp < LINK_RSRP_GOOD_DBM)) {
+    linkClass = LINK_FAIR;
+  }
+  
+  // Recent transfers failing despite the signal: one class down
+  if (failurePercent >= 50 && nowMs - lastTransferMs < LINK_MAX_DEFER_MS && linkClass > LINK_POOR) {
+    linkClass = (LinkClass)(linkClass - 1);
+  }
+  return linkClass;
+}
+
+// ============================================
+// BULK DECISION
+// ============================================
+bool LinkMonitor::shouldSendBulk(uint32_t nowMs, size_t bytes) {
+  LinkClass linkClass = getClass(nowMs);
+  bool send = true;
+  
+  if (linkClass == LINK_POOR) {
+    send = false;
+  } else if (linkClass == LINK_FAIR && throughput > 0 &&
+             (uint64_t)bytes * 1000 / throughput > LINK_MAX_TRANSFER_MS) {
+    send = false;
+  }
+  
+  if (send) {
+    deferring = false;
+    return true;
+  }
+  
+  if (!deferring) {
+    deferring = true;
+    deferredSinceMs = nowMs;
+  }
+  if (nowMs - deferredSinceMs >= LINK_MAX_DEFER_MS) {
+    stats.forcedSends++;
+    deferring = false;
+    Logger::printf(LOG_INFO, "Link", "Link still %s after %lu s - sending anyway",
+                   classNames[linkClass], (unsigned long)(LINK_MAX_DEFER_MS / 1000));
+    return true;
+  }
+  
+  stats.deferrals++;
+  Logger::printf(LOG_DEBUG, "Link", "Deferring %u bytes (link %s, CSQ %d, %lu B/s)",
+                 bytes, classNames[linkClass], lastCsq, (unsigned long)throughput);
+  return false;
+}
+
+size_t LinkMonitor::getChunkSize(uint32_t nowMs) {
+  switch (getClass(nowMs)) {
+    case LINK_POOR: return LINK_POOR_CHUNK_SIZE;
+    case LINK_FAIR: return UPLOAD_CHUNK_SIZE / 2;
+    default:        return UPLOAD_CHUNK_SIZE;
+  }
+}
+
+uint32_t LinkMonitor::getThroughput() {
+  return throughput;
+}
+
+const LinkStats& LinkMonitor::getStats() {
+  return stats;
+}
+
+const char* LinkMonitor::getClassName(LinkClass linkClass) {
+  return (linkClass <= LINK_GOOD) ? classNames[linkClass] : "?";
+}
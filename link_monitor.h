@@ -0,0 +1,93 @@
+/*
+ * link_monitor.h
+ * 
+ * Link quality tracking and the send/defer decision for bulk transfers
+ * 
+ * At CSQ < 8 uploads mostly time out and retry, so every attempt costs
+ * radio time at high TX power without moving the clip forward. The monitor
+ * classifies the link from the latest CSQ/CESQ reading and from how recent
+ * transfers went, and the caller asks it before bulk work:
+ *   - POOR: defer (the clip waits in the outbox) for up to
+ *     LINK_MAX_DEFER_MS, then send anyway in LINK_POOR_CHUNK_SIZE chunks
+ *   - FAIR: send in half-size chunks, unless the throughput estimate says
+ *     it would take longer than LINK_MAX_TRANSFER_MS
+ *   - GOOD / UNKNOWN: send normally
+ * Small control messages never ask; they always go.
+ * 
+ * Pure bookkeeping: the caller reads the modem (LTEManager::getSignalQuality
+ * / getExtendedSignalQuality) and passes times in, like NfcDutyCycle.
+ */
+
+#ifndef LINK_MONITOR_H
+#define LINK_MONITOR_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================
+// LINK CLASS
+// ============================================
+enum LinkClass {
+  LINK_UNKNOWN = 0,        // No recent reading
+  LINK_POOR,
+  LINK_FAIR,
+  LINK_GOOD
+};
+
+// ============================================
+// STATISTICS
+// ============================================
+struct LinkStats {
+  uint32_t samples;            // Signal readings
+  uint32_t transfers;          // Reported transfers
+  uint32_t failures;           // ... that failed
+  uint32_t deferrals;          // Bulk sends refused
+  uint32_t forcedSends;        // Bulk sends let through after LINK_MAX_DEFER_MS
+};
+
+// ============================================
+// LINK MONITOR CLASS
+// ============================================
+class LinkMonitor {
+public:
+  LinkMonitor();
+  
+  // Signal reading: csq 0-31 (99 = unknown), rsrpDbm from CESQ (0 = unknown)
+  void onSignal(uint32_t nowMs, int csq, int rsrpDbm);
+  
+  // A finished transfer (bytes moved in ms), for the throughput/failure estimates
+  void onTransfer(uint32_t nowMs, uint32_t bytes, uint32_t ms, bool ok);
+  
+  LinkClass getClass(uint32_t nowMs);
+  
+  // Whether a bulk transfer of `bytes` should start now. Deferring starts a
+  // clock; once it passes LINK_MAX_DEFER_MS the transfer goes regardless.
+  bool shouldSendBulk(uint32_t nowMs, size_t bytes);
+  
+  // Upload chunk size for the current link
+  size_t getChunkSize(uint32_t nowMs);
+  
+  // Throughput estimate in bytes/s (0 = none yet)
+  uint32_t getThroughput();
+  
+  const LinkStats& getStats();
+  
+  static const char* getClassName(LinkClass linkClass);
+
+private:
+  int lastCsq;
+  int lastRsrp;
+  uint32_t lastSampleMs;
+  bool haveSample;
+  
+  uint32_t throughput;         // EWMA, bytes/s
+  uint8_t failurePercent;      // EWMA of failed transfers
+  uint32_t lastTransferMs;
+  
+  uint32_t deferredSinceMs;
+  bool deferring;
+  
+  LinkStats stats;
+};
+
+#endif // LINK_MONITOR_H
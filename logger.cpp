@@ -5,6 +5,7 @@
  */
 
 #include "logger.h"
+#include "profiler.h"
 #include <stdarg.h>
 
 // Initialize static members
@@ -59,6 +60,7 @@ void Logger::print(LogLevel level, const char* module, const char* message) {
   if (level > currentLogLevel) {
     return;
   }
+  PROFILE_ZONE(PROF_LOG);
   
   // Format: [timestamp] [LEVEL] [Module] Message
   char buffer[32];
@@ -79,6 +81,7 @@ void Logger::printf(LogLevel level, const char* module, const char* format, ...)
   if (level > currentLogLevel) {
     return;
   }
+  PROFILE_ZONE(PROF_LOG);
   
   // Format timestamp and header
   char headerBuf[64];
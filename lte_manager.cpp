@@ -7,6 +7,9 @@
 #include "lte_manager.h"
 #include "logger.h"
 #include "config.h"
+#include "profiler.h"
+
+static const uint32_t defaultBaudRates[] = LTE_FAST_BAUD_RATES;
 
 // ============================================
 // INITIALIZE LTE MANAGER
@@ -16,18 +19,36 @@ bool LTEManager::init(uint8_t txPin, uint8_t rxPin, uint8_t pwrkeyPin, uint8_t r
   pinReset = resetPin;
   initialized = false;
   powered = false;
+  bytesSent = 0;
   
   LOG_I("LTE", "Initializing LTE modem...");
   
+  // Response times learned on previous boots
+  timeouts.load();
+  persistTimeouts = true;
+  
   // Configure control pins
   pinMode(pinPwrkey, OUTPUT);
   pinMode(pinReset, OUTPUT);
   digitalWrite(pinPwrkey, HIGH);  // PWRKEY is active LOW
   digitalWrite(pinReset, HIGH);   // RESET is active LOW
   
-  // Initialize UART (Serial2 on ESP32)
-  modemSerial = &Serial2;
-  modemSerial->begin(baudRate, SERIAL_8N1, rxPin, txPin);
+  // Initialize UART (UART2 on ESP32)
+#if LTE_UART_DRIVER
+  if (!modemUart.begin(2, baudRate, rxPin, txPin)) {
+    LOG_E("LTE", "UART driver init failed");
+    return false;
+  }
+  uart = &modemUart;
+#else
+  Serial2.begin(baudRate, SERIAL_8N1, rxPin, txPin);
+  uart = &Serial2;
+#endif
+  modemSerial = uart;
+  rxHead = 0;
+  rxLen = 0;
+  resetBaudState(baudRate);
+  cmuxActive = false;
   
   // Log UART configuration
   Logger::printf(LOG_INFO, "LTE", "UART: RX=GPIO%d, TX=GPIO%d, Baud=%d", rxPin, txPin, baudRate);
@@ -43,6 +64,38 @@ bool LTEManager::init(uint8_t txPin, uint8_t rxPin, uint8_t pwrkeyPin, uint8_t r
   return true;
 }
 
+// ============================================
+// INITIALIZE WITH SIMULATED MODEM
+// ============================================
+bool LTEManager::initWithStream(Stream* stream) {
+  uart = nullptr;
+  modemSerial = stream;
+  rxHead = 0;
+  rxLen = 0;
+  resetBaudState(LTE_BAUD_RATE);
+  cmuxActive = false;
+  initialized = true;
+  powered = true;
+  bytesSent = 0;
+  timeouts.clear();
+  persistTimeouts = false;  // A simulated modem must not teach the real one
+  LOG_I("LTE", "LTE manager initialized on a stream");
+  return true;
+}
+
+// ============================================
+// SET MODEM STREAM
+// ============================================
+void LTEManager::setStream(Stream* stream) {
+  modemSerial = (stream != nullptr) ? stream : uart;
+  rxHead = 0;  // Staged bytes came from the old stream
+  rxLen = 0;
+}
+
+Stream* LTEManager::getUart() {
+  return uart;
+}
+
 // ============================================
 // POWER ON MODEM
 // ============================================
@@ -68,6 +121,31 @@ bool LTEManager::powerOn() {
     delay(500);
   }
   
+  // A simulated modem has no PWRKEY to pulse
+  if (uart == nullptr) {
+    LOG_E("LTE", "Simulated modem not responding");
+    return false;
+  }
+  
+#if LTE_CMUX
+  // Maybe still multiplexing (the ESP32 reset with the mux open)
+  if (closeStaleCmux()) {
+    powered = true;
+    LOG_I("LTE", "Modem already powered on (mux closed)");
+    return true;
+  }
+#endif
+  
+#if LTE_BAUD_NEGOTIATION
+  // Maybe on at another rate (the ESP32 reset after AT+IPR); a PWRKEY pulse
+  // would switch it off
+  if (findModemBaudRate()) {
+    powered = true;
+    LOG_I("LTE", "Modem already powered on");
+    return true;
+  }
+#endif
+  
   // Modem not responding - power it on
   LOG_I("LTE", "Modem off, powering on...");
   
@@ -92,6 +170,13 @@ bool LTEManager::powerOn() {
     }
   }
   
+#if LTE_BAUD_NEGOTIATION
+  if (findModemBaudRate()) {
+    powered = true;
+    return true;
+  }
+#endif
+  
   LOG_E("LTE", "Failed to communicate with modem after power-on");
   LOG_I("LTE", "Check: 1) UART wiring, 2) Modem power (5V), 3) TX/RX not swapped");
   return false;
@@ -106,11 +191,15 @@ bool LTEManager::powerOff() {
   }
   
   LOG_I("LTE", "Powering off modem...");
-  
-  // Pulse PWRKEY to turn off
-  digitalWrite(pinPwrkey, LOW);
-  delay(1500);
-  digitalWrite(pinPwrkey, HIGH);
+  saveTimeouts();
+  stopCmux();
+  
+  // Pulse PWRKEY to turn off (no pin for a simulated modem)
+  if (uart != nullptr) {
+    digitalWrite(pinPwrkey, LOW);
+    delay(1500);
+    digitalWrite(pinPwrkey, HIGH);
+  }
   
   powered = false;
   return true;
@@ -120,6 +209,7 @@ bool LTEManager::powerOff() {
 // CHECK NETWORK REGISTRATION
 // ============================================
 bool LTEManager::checkNetwork(uint32_t timeout_ms) {
+  LatencyScope timed(opHist[LTE_OP_NETWORK]);
   if (!powered) {
     LOG_E("LTE", "Modem not powered");
     return false;
@@ -219,7 +309,8 @@ bool LTEManager::waitForModemReady(uint32_t timeout_ms) {
     
     modemSerial->println("AT+CFUN?");
     Logger::printf(LOG_DEBUG, "LTE", "TX: AT+CFUN? (poll %d)", pollCount);
-    String cfunResp = readSerial(readTimeout);
+    bool answered = false;
+    String cfunResp = readResponse(readTimeout, "OK", true, &answered);
     if (cfunResp.indexOf("+CFUN: 1") >= 0 || cfunResp.indexOf("+CFUN:1") >= 0) {
       LOG_I("LTE", "RF ready (+CFUN: 1)");
       LOG_I("LTE", "Modem ready for APN config");
@@ -304,6 +395,7 @@ bool LTEManager::configureBearerAPN(const char* apn) {
 // OPEN BEARER CONNECTION
 // ============================================
 bool LTEManager::openBearer() {
+  LatencyScope timed(opHist[LTE_OP_BEARER_OPEN]);
   LOG_I("LTE", "Activating PDP context...");
   
   // SIM7070E uses AT+CNACT instead of SAPBR
@@ -359,13 +451,86 @@ bool LTEManager::closeBearer() {
   return true;
 }
 
+// ============================================
+// CHECK BEARER STATE
+// ============================================
+bool LTEManager::isBearerOpen() {
+  if (!powered) {
+    return false;
+  }
+  
+  String checkResp;
+  if (!sendATCommandGetResponse("AT+CNACT?", checkResp, 2000)) {
+    return false;
+  }
+  return checkResp.indexOf("+CNACT: 0,1") >= 0;
+}
+
+// ============================================
+// SIGNAL QUALITY (AT+CSQ)
+// ============================================
+int LTEManager::getSignalQuality() {
+  LatencyScope timed(opHist[LTE_OP_AT_COMMAND]);
+  if (!powered) {
+    return -1;
+  }
+  
+  // +CSQ: <rssi>,<ber>; returns on OK instead of waiting out a silence timeout
+  clearSerialBuffer();
+  modemSerial->println("AT+CSQ");
+  if (waitForToken("+CSQ: ", LTE_COMMAND_TIMEOUT_MS) != 1) {
+    return -1;
+  }
+  long rssi = readNumber(LTE_COMMAND_TIMEOUT_MS);
+  waitForToken("OK", LTE_COMMAND_TIMEOUT_MS);
+  return (rssi >= 0 && rssi <= 31) || rssi == 99 ? (int)rssi : -1;
+}
+
+int LTEManager::getRsrp() {
+  LatencyScope timed(opHist[LTE_OP_AT_COMMAND]);
+  if (!powered) {
+    return 0;
+  }
+  
+  // +CESQ: <rxlev>,<ber>,<rscp>,<ecno>,<rsrq>,<rsrp>; rsrp 0-97 = -140 + n dBm, 255 = unknown
+  clearSerialBuffer();
+  modemSerial->println("AT+CESQ");
+  if (waitForToken("+CESQ: ", LTE_COMMAND_TIMEOUT_MS) != 1) {
+    return 0;
+  }
+  long field = -1;
+  for (uint8_t i = 0; i < 6; i++) {
+    field = readNumber(LTE_COMMAND_TIMEOUT_MS);
+  }
+  waitForToken("OK", LTE_COMMAND_TIMEOUT_MS);
+  return (field >= 0 && field <= 97) ? (int)field - 140 : 0;
+}
+
 // ============================================
 // HTTP GET REQUEST
 // ============================================
 bool LTEManager::httpGet(const char* url, uint8_t* buffer, size_t* length, size_t maxLength) {
-  LOG_I("LTE", "HTTP GET...");
+  int statusCode = 0;
+  if (!httpGetConditional(url, nullptr, buffer, length, maxLength, nullptr, 0, &statusCode)) {
+    return false;
+  }
+  return statusCode == 200;
+}
+
+// ============================================
+// HTTP CONDITIONAL GET (ETag revalidation)
+// ============================================
+bool LTEManager::httpGetConditional(const char* url, const char* ifNoneMatch,
+                                    uint8_t* buffer, size_t* length, size_t maxLength,
+                                    char* etagOut, size_t etagOutSize, int* statusCode) {
+  LatencyScope timed(opHist[LTE_OP_HTTP_GET]);
+  LOG_I("LTE", ifNoneMatch != nullptr ? "HTTP GET (conditional)..." : "HTTP GET...");
   
   *length = 0;
+  *statusCode = 0;
+  if (etagOut != nullptr && etagOutSize > 0) {
+    etagOut[0] = '\0';
+  }
   
   // Initialize HTTP
   if (!httpInit()) {
@@ -384,22 +549,56 @@ bool LTEManager::httpGet(const char* url, uint8_t* buffer, size_t* length, size_
     return false;
   }
   
+  // Revalidate cached copy: server answers 304 with no body if unchanged.
+  // The tag's quotes would end the AT string, so they go as V.250 escapes
+  // (\22; a backslash as \5C).
+  if (ifNoneMatch != nullptr && ifNoneMatch[0] != '\0' && !isEntityTag(ifNoneMatch)) {
+    Logger::printf(LOG_WARN, "LTE", "Cached ETag %s is malformed - not revalidating", ifNoneMatch);
+  } else if (ifNoneMatch != nullptr && ifNoneMatch[0] != '\0') {
+    char header[160];
+    size_t n = snprintf(header, sizeof(header), "If-None-Match: ");
+    for (const char* p = ifNoneMatch; *p != '\0' && n + 4 < sizeof(header); p++) {
+      if (*p == '"' || *p == '\\') {
+        n += snprintf(header + n, sizeof(header) - n, "\\%02X", (uint8_t)*p);
+      } else {
+        header[n++] = *p;
+      }
+    }
+    header[n] = '\0';
+    if (!httpSetParameter("USERDATA", header)) {
+      httpTerminate();
+      return false;
+    }
+  }
+  
   // Execute GET
-  int statusCode, dataLength;
-  if (!httpAction(HTTP_GET, &statusCode, &dataLength)) {
+  int dataLength;
+  if (!httpAction(HTTP_GET, statusCode, &dataLength)) {
     httpTerminate();
     return false;
   }
   
-  Logger::printf(LOG_INFO, "LTE", "HTTP status: %d, length: %d", statusCode, dataLength);
+  Logger::printf(LOG_INFO, "LTE", "HTTP status: %d, length: %d", *statusCode, dataLength);
   
   // Check status code
-  if (statusCode != 200) {
+  if (*statusCode == 304) {
+    LOG_I("LTE", "Not modified (cached copy is current)");
+    httpTerminate();
+    return true;
+  }
+  if (*statusCode != 200) {
     LOG_E("LTE", "HTTP request failed");
     httpTerminate();
     return false;
   }
   
+  // Capture ETag for the cache; anything but a quoted entity-tag is not kept
+  if (etagOut != nullptr && etagOutSize > 0 &&
+      httpReadHeader("ETag", etagOut, etagOutSize) && !isEntityTag(etagOut)) {
+    Logger::printf(LOG_WARN, "LTE", "Ignoring malformed ETag: %s", etagOut);
+    etagOut[0] = '\0';
+  }
+  
   // Read data
   if (!httpRead(buffer, length, maxLength)) {
     httpTerminate();
@@ -416,7 +615,8 @@ bool LTEManager::httpGet(const char* url, uint8_t* buffer, size_t* length, size_
 // ============================================
 // HTTP POST REQUEST
 // ============================================
-bool LTEManager::httpPost(const char* url, const uint8_t* data, size_t length) {
+bool LTEManager::httpPost(const char* url, const uint8_t* data, size_t length, const char* userHeader) {
+  LatencyScope timed(opHist[LTE_OP_HTTP_POST]);
   LOG_I("LTE", "HTTP POST...");
   
   // Initialize HTTP
@@ -442,6 +642,14 @@ bool LTEManager::httpPost(const char* url, const uint8_t* data, size_t length) {
     return false;
   }
   
+  // Optional metadata header (sent alongside the body, e.g. capture stats)
+  if (userHeader != nullptr && userHeader[0] != '\0') {
+    if (!httpSetParameter("USERDATA", userHeader)) {
+      httpTerminate();
+      return false;
+    }
+  }
+  
   // Upload data
   if (!httpPostData(data, length)) {
     httpTerminate();
@@ -469,39 +677,217 @@ bool LTEManager::httpPost(const char* url, const uint8_t* data, size_t length) {
   return false;
 }
 
+// ============================================
+// HTTP POST WITH RESPONSE
+// ============================================
+bool LTEManager::httpPostWithResponse(const char* url, const uint8_t* data, size_t length,
+                                      const char* contentType, const char* userHeader,
+                                      int* statusCode, String& response) {
+  LatencyScope timed(opHist[LTE_OP_HTTP_POST]);
+  Logger::printf(LOG_INFO, "LTE", "HTTP POST %d bytes...", length);
+  
+  response = "";
+  *statusCode = 0;
+  
+  // Initialize HTTP
+  if (!httpInit()) {
+    return false;
+  }
+  
+  // Set URL
+  if (!httpSetParameter("URL", url)) {
+    httpTerminate();
+    return false;
+  }
+  
+  // Set CID
+  if (!httpSetParameter("CID", "1")) {
+    httpTerminate();
+    return false;
+  }
+  
+  // Set content type
+  if (!httpSetParameter("CONTENT", contentType)) {
+    httpTerminate();
+    return false;
+  }
+  
+  // Optional extra header
+  if (userHeader != nullptr && userHeader[0] != '\0') {
+    if (!httpSetParameter("USERDATA", userHeader)) {
+      httpTerminate();
+      return false;
+    }
+  }
+  
+  // Upload body (may be empty for control requests)
+  if (length > 0 && !httpPostData(data, length)) {
+    httpTerminate();
+    return false;
+  }
+  
+  // Execute POST
+  int dataLength;
+  if (!httpAction(HTTP_POST, statusCode, &dataLength)) {
+    httpTerminate();
+    return false;
+  }
+  
+  Logger::printf(LOG_INFO, "LTE", "HTTP POST status: %d, response length: %d", *statusCode, dataLength);
+  
+  // Read response body (small JSON acknowledgements)
+  if (dataLength > 0) {
+    uint8_t* buffer = (uint8_t*)malloc(dataLength + 1);
+    if (buffer) {
+      size_t readLength = 0;
+      if (httpRead(buffer, &readLength, dataLength)) {
+        buffer[readLength] = '\0';
+        response = String((char*)buffer);
+      } else {
+        LOG_E("LTE", "Failed to read HTTP response");
+      }
+      free(buffer);
+    } else {
+      LOG_E("LTE", "Failed to allocate response buffer");
+    }
+  }
+  
+  // Terminate HTTP
+  httpTerminate();
+  return true;
+}
+
+// ============================================
+// GET BYTES SENT
+// ============================================
+uint32_t LTEManager::getBytesSent() {
+  return bytesSent;
+}
+
+// ============================================
+// OPERATION HISTOGRAMS
+// ============================================
+LatencyHistogram* LTEManager::getOpHistogram(uint8_t op) {
+  return (op < LTE_OP_COUNT) ? &opHist[op] : nullptr;
+}
+
+const char* LTEManager::getOpName(uint8_t op) {
+  switch (op) {
+    case LTE_OP_AT_COMMAND:   return "AT";
+    case LTE_OP_NETWORK:      return "NETWORK";
+    case LTE_OP_BEARER_OPEN:  return "BEARER_OPEN";
+    case LTE_OP_HTTP_GET:     return "HTTP_GET";
+    case LTE_OP_HTTP_POST:    return "HTTP_POST";
+    case LTE_OP_HTTP_DATA:    return "HTTP_DATA";
+    case LTE_OP_HTTP_ACTION:  return "HTTP_ACTION";
+    case LTE_OP_HTTP_READ:    return "HTTP_READ";
+    case LTE_OP_SOCKET_OPEN:  return "SOCKET_OPEN";
+    case LTE_OP_SOCKET_SEND:  return "SOCKET_SEND";
+    case LTE_OP_SOCKET_RECV:  return "SOCKET_RECV";
+    default:                  return "UNKNOWN";
+  }
+}
+
 // ============================================
 // UPDATE (process incoming data)
 // ============================================
 void LTEManager::update() {
   // Process any unsolicited messages from modem
-  while (modemSerial->available()) {
-    char c = modemSerial->read();
+  char line[128];
+  int length;
+  if (cmuxActive) {
+    // URCs have a channel of their own; the data channel belongs to the
+    // command in progress (update() may run from the wait hook)
+    CmuxChannel* urc = cmux.getChannel(CMUX_CHANNEL_URC);
+    while ((length = urc->readLine(line, sizeof(line), 0)) >= 0) {
+      handleUrc(line, length);
+    }
+    return;
+  }
+#if LTE_UART_DRIVER
+  if (modemSerial == uart && uart != nullptr && rxHead == rxLen) {
+    // Whole URC lines straight from the driver ring
+    while ((length = modemUart.readLine(line, sizeof(line), 0)) >= 0) {
+      handleUrc(line, length);
+    }
+  }
+#endif
+  while (nextByte() >= 0) {
     // Could log unsolicited responses here if needed
   }
 }
 
+void LTEManager::handleUrc(char* line, int length) {
+  while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+    length--;
+  }
+  if (length == 0) {
+    return;
+  }
+  line[length] = '\0';
+  Logger::printf(LOG_DEBUG, "LTE", "URC: %s", line);
+  if (urcHook != nullptr) {
+    urcHook(line);
+  }
+}
+
+void LTEManager::setUrcHook(void (*hook)(const char* line)) {
+  urcHook = hook;
+}
+
+void LTEManager::setWaitHook(void (*hook)()) {
+  waitHook = hook;
+}
+
+// ============================================
+// SET RECEIVE HOOK
+// ============================================
+void LTEManager::setReceiveHook(void (*hook)()) {
+  if (uart == nullptr) {
+    return;
+  }
+#if LTE_UART_DRIVER
+  modemUart.setReceiveHook(hook);
+#else
+  Serial2.onReceive(hook);
+#endif
+}
+
 // ============================================
 // SEND AT COMMAND
 // ============================================
 bool LTEManager::sendATCommand(const char* cmd, const char* expected, uint32_t timeout_ms) {
+  LatencyScope timed(opHist[LTE_OP_AT_COMMAND]);
+  PROFILE_ZONE(PROF_AT_COMMAND);
   Logger::printf(LOG_DEBUG, "LTE", "TX: %s", cmd);
   
   clearSerialBuffer();
   modemSerial->println(cmd);
   
-  return waitForResponse(expected, timeout_ms);
+  unsigned long start = millis();
+  bool answered = false;
+  String response = readResponse(timeouts.get(cmd, timeout_ms), expected, true, &answered);
+  reportLatency(cmd, start, answered);
+  Logger::printf(LOG_DEBUG, "LTE", "RX: %s", response.c_str());
+  
+  return response.indexOf(expected) >= 0;
 }
 
 // ============================================
 // SEND AT COMMAND AND GET RESPONSE
 // ============================================
 bool LTEManager::sendATCommandGetResponse(const char* cmd, String& response, uint32_t timeout_ms) {
+  LatencyScope timed(opHist[LTE_OP_AT_COMMAND]);
+  PROFILE_ZONE(PROF_AT_COMMAND);
   Logger::printf(LOG_DEBUG, "LTE", "TX: %s", cmd);
   
   clearSerialBuffer();
   modemSerial->println(cmd);
   
-  response = readSerial(timeout_ms);
+  unsigned long start = millis();
+  bool answered = false;
+  response = readResponse(timeouts.get(cmd, timeout_ms), "OK", true, &answered);
+  reportLatency(cmd, start, answered);
   Logger::printf(LOG_DEBUG, "LTE", "RX: %s", response.c_str());
   
   return response.length() > 0;
@@ -511,7 +897,8 @@ bool LTEManager::sendATCommandGetResponse(const char* cmd, String& response, uin
 // WAIT FOR RESPONSE
 // ============================================
 bool LTEManager::waitForResponse(const char* expected, uint32_t timeout_ms) {
-  String response = readSerial(timeout_ms);
+  bool answered = false;
+  String response = readResponse(timeout_ms, expected, false, &answered);
   Logger::printf(LOG_DEBUG, "LTE", "RX: %s", response.c_str());
   
   return response.indexOf(expected) >= 0;
@@ -521,11 +908,48 @@ bool LTEManager::waitForResponse(const char* expected, uint32_t timeout_ms) {
 // CLEAR SERIAL BUFFER
 // ============================================
 void LTEManager::clearSerialBuffer() {
-  while (modemSerial->available()) {
-    modemSerial->read();
+  while (fillRx()) {
+    rxHead = rxLen;
   }
 }
 
+// ============================================
+// RECEIVE STAGING
+// ============================================
+bool LTEManager::fillRx() {
+  if (rxHead < rxLen) {
+    return true;
+  }
+  int avail = modemSerial->available();
+  if (avail <= 0) {
+    return false;
+  }
+  size_t n = ((size_t)avail < sizeof(rxBuffer)) ? avail : sizeof(rxBuffer);
+  rxHead = 0;
+  rxLen = modemSerial->readBytes(rxBuffer, n);
+  return rxLen > 0;
+}
+
+int LTEManager::nextByte() {
+  if (!fillRx()) {
+    return -1;
+  }
+  return (uint8_t)rxBuffer[rxHead++];
+}
+
+void LTEManager::waitRx(uint32_t wait_ms) {
+  if (waitHook != nullptr) {
+    waitHook();
+  }
+#if LTE_UART_DRIVER
+  if (uart != nullptr && (modemSerial == uart || cmuxActive)) {
+    modemUart.waitForData(wait_ms);
+    return;
+  }
+#endif
+  delay(wait_ms);
+}
+
 // ============================================
 // READ SERIAL DATA
 // ============================================
@@ -536,8 +960,9 @@ String LTEManager::readSerial(uint32_t timeout_ms) {
   bool hadNonNull = false;
   
   while (millis() - startTime < timeout_ms) {
-    while (modemSerial->available()) {
-      char c = modemSerial->read();
+    int next;
+    while ((next = nextByte()) >= 0) {
+      char c = (char)next;
       // Ignore leading null bytes (noise / modem busy); don't reset timeout on nulls
       // so we don't hang if modem trickles nulls for minutes
       if (c == 0 && !hadNonNull) {
@@ -549,7 +974,7 @@ String LTEManager::readSerial(uint32_t timeout_ms) {
       bytesReceived++;
       startTime = millis();  // Reset timeout on data received
     }
-    delay(10);
+    waitRx(10);
   }
   
   // Debug: show if we received any bytes at all
@@ -574,6 +999,322 @@ String LTEManager::readSerial(uint32_t timeout_ms) {
   return result;
 }
 
+// ============================================
+// READ RESPONSE (returns at the final result)
+// ============================================
+// Like readSerial(), but returns as soon as a line starting with `until`, or
+// a final ERROR / +CME ERROR: line, is complete instead of waiting for the
+// modem to go quiet. With untilFinal a bare OK line ends the wait too (the
+// command has finished even if `until` never came); callers waiting for a
+// URC after the OK pass false. Only whole lines count, so the command echo
+// or a data line that merely contains OK or ERROR does not end the wait.
+// timeout_ms counts from the call. *answered: such a line arrived.
+static bool isResultLine(const char* line, const char* result) {
+  size_t n = strlen(result);
+  return strncmp(line, result, n) == 0 && (line[n] == '\r' || line[n] == '\n');
+}
+
+String LTEManager::readResponse(uint32_t timeout_ms, const char* until, bool untilFinal, bool* answered) {
+  String result = "";
+  unsigned long startTime = millis();
+  bool hadNonNull = false;
+  size_t lineStart = 0;
+  *answered = false;
+  
+  while (millis() - startTime < timeout_ms) {
+    int next;
+    while ((next = nextByte()) >= 0) {
+      char c = (char)next;
+      if (c == 0 && !hadNonNull) {
+        continue;  // Leading nulls (see readSerial)
+      }
+      hadNonNull = true;
+      result += c;
+      if (c != '\n') {
+        continue;
+      }
+      
+      const char* line = result.c_str() + lineStart;
+      if (strncmp(line, until, strlen(until)) == 0 || isResultLine(line, "ERROR") ||
+          strncmp(line, "+CME ERROR:", 11) == 0 || (untilFinal && isResultLine(line, "OK"))) {
+        *answered = true;
+        return result;
+      }
+      lineStart = result.length();
+    }
+    waitRx(1);
+  }
+  
+  Logger::printf(LOG_DEBUG, "LTE", "No %s within %lu ms", until, (unsigned long)timeout_ms);
+  return result;
+}
+
+// ============================================
+// ADAPTIVE TIMEOUTS
+// ============================================
+void LTEManager::reportLatency(const char* cmd, unsigned long startMs, bool answered) {
+  if (!answered) {
+    timeouts.onTimeout(cmd);
+  } else {
+    timeouts.onResponse(cmd, millis() - startMs);
+    if (persistTimeouts) {
+      timeouts.save(false);
+    }
+  }
+  checkLinkHealth(answered);
+}
+
+void LTEManager::saveTimeouts() {
+  if (persistTimeouts) {
+    timeouts.save(true);
+  }
+}
+
+// ============================================
+// UART RATE NEGOTIATION
+// ============================================
+void LTEManager::resetBaudState(uint32_t baudRate) {
+  baudBase = baudRate;
+  baudCurrent = baudRate;
+  baudRates = defaultBaudRates;
+  baudRateCount = sizeof(defaultBaudRates) / sizeof(defaultBaudRates[0]);
+  baudFirst = 0;
+  baudFailures = 0;
+  baudFrameErrors = 0;
+  baudSwitching = false;
+}
+
+void LTEManager::setBaudRates(const uint32_t* rates, uint8_t count) {
+  baudRates = rates;
+  baudRateCount = count;
+  baudFirst = 0;
+}
+
+uint32_t LTEManager::getBaudRate() {
+  return baudCurrent;
+}
+
+void LTEManager::setBaudRateHook(void (*hook)(uint32_t baudRate)) {
+  baudHook = hook;
+}
+
+bool LTEManager::negotiateBaudRate(int8_t ctsPin) {
+  if (!powered) {
+    return false;
+  }
+  baudSwitching = true;
+  if (ctsPin >= 0) {
+    enableFlowControl(ctsPin);
+  }
+  for (uint8_t i = baudFirst; i < baudRateCount && baudRates[i] > baudCurrent; i++) {
+    if (switchBaudRate(baudRates[i])) {
+      break;
+    }
+    baudFirst = i + 1;
+  }
+  baudSwitching = false;
+  return baudCurrent > baudBase;
+}
+
+void LTEManager::setUartBaudRate(uint32_t baudRate) {
+  baudCurrent = baudRate;
+  baudFailures = 0;
+  if (uart != nullptr) {
+#if LTE_UART_DRIVER
+    modemUart.setBaudRate(baudRate);
+    baudFrameErrors = modemUart.getStats().frameErrors;
+#else
+    Serial2.updateBaudRate(baudRate);
+#endif
+  }
+  if (baudHook != nullptr) {
+    baudHook(baudRate);
+  }
+  delay(20);  // The modem switches after its OK has gone out
+  clearSerialBuffer();
+}
+
+bool LTEManager::probeModem(uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (!sendATCommand("AT", "OK", 500)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// AT+IPR answers at the old rate, then the modem switches
+bool LTEManager::switchBaudRate(uint32_t baudRate) {
+  uint32_t previous = baudCurrent;
+  char cmd[24];
+  snprintf(cmd, sizeof(cmd), "AT+IPR=%lu", (unsigned long)baudRate);
+  if (!sendATCommand(cmd, "OK", LTE_COMMAND_TIMEOUT_MS)) {
+    return false;  // Refused; the modem stays at the old rate
+  }
+  setUartBaudRate(baudRate);
+  if (probeModem(LTE_BAUD_PROBES)) {
+    Logger::printf(LOG_INFO, "LTE", "UART now at %lu baud", (unsigned long)baudRate);
+    return true;
+  }
+  
+  // The modem switched but the link does not hold: take both ends back
+  Logger::printf(LOG_WARN, "LTE", "No stable link at %lu baud, back to %lu",
+                 (unsigned long)baudRate, (unsigned long)previous);
+  snprintf(cmd, sizeof(cmd), "AT+IPR=%lu", (unsigned long)previous);
+  sendATCommand(cmd, "OK", 1000);
+  setUartBaudRate(previous);
+  if (!probeModem(1)) {
+    findModemBaudRate();
+  }
+  return false;
+}
+
+// Modem rate unknown: try the boot rate, then every faster one
+bool LTEManager::findModemBaudRate() {
+  bool wasSwitching = baudSwitching;
+  baudSwitching = true;
+  bool found = false;
+  for (int i = -1; i < (int)baudRateCount && !found; i++) {
+    setUartBaudRate((i < 0) ? baudBase : baudRates[i]);
+    found = probeModem(1);
+#if LTE_CMUX
+    found = found || closeStaleCmux();
+#endif
+  }
+  if (found) {
+    Logger::printf(LOG_INFO, "LTE", "Modem found at %lu baud", (unsigned long)baudCurrent);
+  } else {
+    setUartBaudRate(baudBase);
+  }
+  baudSwitching = wasSwitching;
+  return found;
+}
+
+// If the probe fails with CTS on, the line is not wired: turn it back off
+void LTEManager::enableFlowControl(int8_t ctsPin) {
+#if !LTE_UART_DRIVER
+  if (uart != nullptr) {
+    LOG_W("LTE", "Flow control needs LTE_UART_DRIVER");
+    return;
+  }
+#endif
+  if (!sendATCommand("AT+IFC=0,2", "OK", LTE_COMMAND_TIMEOUT_MS)) {
+    LOG_W("LTE", "Modem refused CTS flow control");
+    return;
+  }
+  if (uart == nullptr) {
+    return;  // Simulated modem: nothing to switch on this side
+  }
+#if LTE_UART_DRIVER
+  modemUart.setFlowControl(ctsPin);
+  if (!probeModem(1)) {
+    LOG_W("LTE", "No answer with CTS flow control, disabling it");
+    modemUart.setFlowControl(-1);
+    sendATCommand("AT+IFC=0,0", "OK", LTE_COMMAND_TIMEOUT_MS);
+    return;
+  }
+  Logger::printf(LOG_INFO, "LTE", "CTS flow control on GPIO%d", ctsPin);
+#endif
+}
+
+// Step down one rate after LTE_BAUD_MAX_FAILURES unanswered commands in a
+// row (or as many UART frame errors) at a negotiated rate
+void LTEManager::checkLinkHealth(bool answered) {
+#if LTE_BAUD_NEGOTIATION
+  if (baudSwitching || baudCurrent <= baudBase || cmuxActive) {
+    return;  // AT+IPR inside the mux would change the rate under every channel
+  }
+  baudFailures = answered ? 0 : baudFailures + 1;
+#if LTE_UART_DRIVER
+  if (uart != nullptr && modemUart.getStats().frameErrors - baudFrameErrors >= LTE_BAUD_MAX_FAILURES) {
+    baudFailures = LTE_BAUD_MAX_FAILURES;
+  }
+#endif
+  if (baudFailures < LTE_BAUD_MAX_FAILURES) {
+    return;
+  }
+  
+  // Never this fast again this boot
+  uint8_t i = 0;
+  while (i < baudRateCount && baudRates[i] > baudCurrent) {
+    i++;
+  }
+  baudFirst = i + 1;
+  uint32_t lower = (baudFirst < baudRateCount) ? baudRates[baudFirst] : baudBase;
+  Logger::printf(LOG_WARN, "LTE", "Link unstable at %lu baud, stepping down to %lu",
+                 (unsigned long)baudCurrent, (unsigned long)lower);
+  
+  baudSwitching = true;
+  char cmd[24];
+  snprintf(cmd, sizeof(cmd), "AT+IPR=%lu", (unsigned long)lower);
+  sendATCommand(cmd, "OK", LTE_COMMAND_TIMEOUT_MS);  // May be lost on the bad link
+  setUartBaudRate(lower);
+  if (!probeModem(1)) {
+    findModemBaudRate();
+  }
+  baudSwitching = false;
+#endif
+}
+
+// A modem left multiplexing answers no plain AT until the mux is closed
+bool LTEManager::closeStaleCmux() {
+  Cmux::writeCloseDown(modemSerial);
+  delay(100);
+  clearSerialBuffer();
+  return probeModem(1);
+}
+
+// ============================================
+// GSM 07.10 MULTIPLEXING
+// ============================================
+bool LTEManager::startCmux() {
+  if (cmuxActive) {
+    return true;
+  }
+  if (!powered) {
+    return false;
+  }
+  
+  // <mode>,<subset>,<port speed>,<N1>: basic option, UIH frames, rate unchanged
+  char cmd[32];
+  snprintf(cmd, sizeof(cmd), "AT+CMUX=0,0,,%u", LTE_CMUX_FRAME_SIZE);
+  if (!sendATCommand(cmd, "OK", LTE_COMMAND_TIMEOUT_MS)) {
+    LOG_W("LTE", "Modem refused CMUX");
+    return false;
+  }
+  rxHead = 0;  // Anything staged after the OK predates the mux
+  rxLen = 0;
+  
+  cmuxBase = modemSerial;
+  if (!cmux.begin(cmuxBase)) {
+    LOG_E("LTE", "CMUX channels not opened, staying in AT mode");
+    clearSerialBuffer();
+    return false;
+  }
+  modemSerial = cmux.getChannel(CMUX_CHANNEL_DATA);
+  cmuxActive = true;
+  return true;
+}
+
+void LTEManager::stopCmux() {
+  if (!cmuxActive) {
+    return;
+  }
+  cmux.end();
+  cmuxActive = false;
+  modemSerial = cmuxBase;
+  rxHead = 0;
+  rxLen = 0;
+  clearSerialBuffer();
+}
+
+bool LTEManager::isCmuxActive() {
+  return cmuxActive;
+}
+
+Stream* LTEManager::getCmuxChannel(uint8_t channel) {
+  return cmuxActive ? cmux.getChannel(channel) : nullptr;
+}
 
 bool LTEManager::waitForEPSAttach(uint32_t timeout_ms) {
   LOG_I("LTE", "Waiting for EPS attach (+CGATT: 1)...");
@@ -619,6 +1360,8 @@ bool LTEManager::httpSetParameter(const char* param, const char* value) {
 // HTTP ACTION
 // ============================================
 bool LTEManager::httpAction(HttpMethod method, int* statusCode, int* dataLength) {
+  LatencyScope timed(opHist[LTE_OP_HTTP_ACTION]);
+  PROFILE_ZONE(PROF_AT_COMMAND);
   char cmd[32];
   snprintf(cmd, sizeof(cmd), "AT+HTTPACTION=%d", method);
   
@@ -626,9 +1369,19 @@ bool LTEManager::httpAction(HttpMethod method, int* statusCode, int* dataLength)
   Logger::printf(LOG_DEBUG, "LTE", "TX: %s", cmd);
   
   // Wait for +HTTPACTION response (can take several seconds)
-  String response = readSerial(30000);
+  unsigned long start = millis();
+  bool answered = false;
+  String response = readResponse(timeouts.get(cmd, 30000), "+HTTPACTION:", false, &answered);
+  reportLatency(cmd, start, answered);
   Logger::printf(LOG_DEBUG, "LTE", "RX: %s", response.c_str());
   
+  return parseHttpAction(response, statusCode, dataLength);
+}
+
+// ============================================
+// PARSE +HTTPACTION URC
+// ============================================
+bool LTEManager::parseHttpAction(const String& response, int* statusCode, int* dataLength) {
   // Parse response: +HTTPACTION: <method>,<status>,<length>
   int actionStart = response.indexOf("+HTTPACTION:");
   if (actionStart >= 0) {
@@ -649,6 +1402,7 @@ bool LTEManager::httpAction(HttpMethod method, int* statusCode, int* dataLength)
 // HTTP READ
 // ============================================
 bool LTEManager::httpRead(uint8_t* buffer, size_t* length, size_t maxLength) {
+  LatencyScope timed(opHist[LTE_OP_HTTP_READ]);
   modemSerial->println("AT+HTTPREAD");
   LOG_D("LTE", "TX: AT+HTTPREAD");
   
@@ -682,10 +1436,78 @@ bool LTEManager::httpRead(uint8_t* buffer, size_t* length, size_t maxLength) {
   return true;
 }
 
+// ============================================
+// HTTP READ HEADER
+// ============================================
+// AT+HTTPHEAD returns the response headers of the last HTTPACTION
+bool LTEManager::httpReadHeader(const char* name, char* value, size_t valueSize) {
+  value[0] = '\0';
+  
+  modemSerial->println("AT+HTTPHEAD");
+  LOG_D("LTE", "TX: AT+HTTPHEAD");
+  String response = readSerial(5000);
+  
+  // Case-insensitive search for "<name>:" at the start of a line
+  String lower = response;
+  lower.toLowerCase();
+  String key = String(name) + ":";
+  key.toLowerCase();
+  
+  int pos = 0;
+  while ((pos = lower.indexOf(key, pos)) >= 0) {
+    if (pos == 0 || lower[pos - 1] == '\n') {
+      break;
+    }
+    pos += key.length();
+  }
+  if (pos < 0) {
+    return false;
+  }
+  
+  int start = pos + key.length();
+  while (start < (int)response.length() && response[start] == ' ') {
+    start++;
+  }
+  int end = response.indexOf('\r', start);
+  if (end < 0) {
+    end = response.indexOf('\n', start);
+  }
+  if (end < 0) {
+    end = response.length();
+  }
+  
+  size_t len = end - start;
+  if (len == 0 || len >= valueSize) {
+    return false;
+  }
+  memcpy(value, response.c_str() + start, len);
+  value[len] = '\0';
+  Logger::printf(LOG_DEBUG, "LTE", "Header %s: %s", name, value);
+  return true;
+}
+
+// RFC 7232 entity-tag: [W/] "<printable ASCII except quote>"
+bool LTEManager::isEntityTag(const char* tag) {
+  if (strncmp(tag, "W/", 2) == 0) {
+    tag += 2;
+  }
+  size_t length = strlen(tag);
+  if (length < 2 || tag[0] != '"' || tag[length - 1] != '"') {
+    return false;
+  }
+  for (size_t i = 1; i + 1 < length; i++) {
+    if (tag[i] <= 0x20 || tag[i] == '"' || tag[i] >= 0x7F) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // ============================================
 // HTTP POST DATA
 // ============================================
 bool LTEManager::httpPostData(const uint8_t* data, size_t length) {
+  LatencyScope timed(opHist[LTE_OP_HTTP_DATA]);
   char cmd[64];
   snprintf(cmd, sizeof(cmd), "AT+HTTPDATA=%d,10000", length);
   
@@ -700,6 +1522,7 @@ bool LTEManager::httpPostData(const uint8_t* data, size_t length) {
   
   // Send binary data
   modemSerial->write(data, length);
+  bytesSent += length;
   LOG_D("LTE", "Sent binary data");
   
   // Wait for OK
@@ -717,6 +1540,7 @@ bool LTEManager::httpTerminate() {
 // HTTP POST JSON WITH BEARER TOKEN AUTH
 // ============================================
 bool LTEManager::httpPostJsonWithAuth(const char* url, const char* jsonBody, const char* bearerToken, String& response) {
+  LatencyScope timed(opHist[LTE_OP_HTTP_POST]);
   LOG_I("LTE", "HTTP POST JSON with Bearer auth...");
   Logger::printf(LOG_INFO, "LTE", "URL: %s", url);
   Logger::printf(LOG_INFO, "LTE", "Body: %s", jsonBody);
@@ -782,6 +1606,7 @@ bool LTEManager::httpPostJsonWithAuth(const char* url, const char* jsonBody, con
   
   // Send JSON data
   modemSerial->print(jsonBody);
+  bytesSent += jsonLen;
   Logger::printf(LOG_DEBUG, "LTE", "Sent JSON: %s", jsonBody);
   
   // Wait for OK
@@ -830,3 +1655,246 @@ bool LTEManager::httpPostJsonWithAuth(const char* url, const char* jsonBody, con
   Logger::printf(LOG_ERROR, "LTE", "HTTP POST failed with status %d", statusCode);
   return false;
 }
+
+// ============================================
+// SOCKET OPEN (AT+CAOPEN)
+// ============================================
+bool LTEManager::socketOpen(uint8_t cid, const char* host, uint16_t port, bool tls) {
+  return openSocket(cid, "TCP", host, port, tls);
+}
+
+// UDP "connects" only locally: the modem fixes the peer, nothing is sent
+bool LTEManager::socketOpenUdp(uint8_t cid, const char* host, uint16_t port) {
+  return openSocket(cid, "UDP", host, port, false);
+}
+
+bool LTEManager::openSocket(uint8_t cid, const char* protocol, const char* host, uint16_t port, bool tls) {
+  LatencyScope timed(opHist[LTE_OP_SOCKET_OPEN]);
+  if (!powered) {
+    LOG_E("LTE", "Modem not powered");
+    return false;
+  }
+  
+  Logger::printf(LOG_INFO, "LTE", "Socket %u: %s to %s:%u%s", cid, protocol, host, port, tls ? " (TLS)" : "");
+  
+  char cmd[160];
+  snprintf(cmd, sizeof(cmd), "AT+CASSLCFG=%u,\"SSL\",%d", cid, tls ? 1 : 0);
+  if (!sendSocketCommand(cmd, LTE_COMMAND_TIMEOUT_MS)) {
+    LOG_E("LTE", "CASSLCFG failed");
+    return false;
+  }
+  
+  snprintf(cmd, sizeof(cmd), "AT+CAOPEN=%u,0,\"%s\",\"%s\",%u", cid, protocol, host, port);
+  clearSerialBuffer();
+  modemSerial->println(cmd);
+  Logger::printf(LOG_DEBUG, "LTE", "TX: %s", cmd);
+  
+  // +CAOPEN: <cid>,<result> once connected (and handshaken, for TLS); 0 = success
+  char token[16];
+  snprintf(token, sizeof(token), "+CAOPEN: %u,", cid);
+  unsigned long start = millis();
+  int found = waitForToken(token, timeouts.get(cmd, LTE_HTTP_TIMEOUT_MS));
+  reportLatency(cmd, start, found != 0);
+  if (found != 1) {
+    LOG_E("LTE", "CAOPEN failed");
+    return false;
+  }
+  long result = readNumber(LTE_COMMAND_TIMEOUT_MS);
+  waitForToken("OK", LTE_COMMAND_TIMEOUT_MS);
+  if (result != 0) {
+    Logger::printf(LOG_ERROR, "LTE", "Socket %u: connect failed (result %ld)", cid, result);
+    return false;
+  }
+  
+  Logger::printf(LOG_INFO, "LTE", "Socket %u: connected", cid);
+  return true;
+}
+
+// ============================================
+// SOCKET SEND (AT+CASEND)
+// ============================================
+bool LTEManager::socketSend(uint8_t cid, const uint8_t* data, size_t length) {
+  LatencyScope timed(opHist[LTE_OP_SOCKET_SEND]);
+  char cmd[32];
+  size_t offset = 0;
+  
+  while (offset < length) {
+    size_t chunk = length - offset;
+    if (chunk > LTE_SOCKET_CHUNK) {
+      chunk = LTE_SOCKET_CHUNK;
+    }
+    
+    snprintf(cmd, sizeof(cmd), "AT+CASEND=%u,%u", cid, (unsigned)chunk);
+    clearSerialBuffer();
+    modemSerial->println(cmd);
+    Logger::printf(LOG_DEBUG, "LTE", "TX: %s", cmd);
+    
+    // Modem prompts with "> " for exactly chunk bytes
+    if (waitForToken(">", LTE_COMMAND_TIMEOUT_MS) != 1) {
+      LOG_E("LTE", "CASEND prompt not received");
+      return false;
+    }
+    modemSerial->write(data + offset, chunk);
+    unsigned long start = millis();
+    int acked = waitForToken("OK", timeouts.get(cmd, LTE_HTTP_TIMEOUT_MS));
+    reportLatency(cmd, start, acked != 0);
+    if (acked != 1) {
+      LOG_E("LTE", "CASEND not acknowledged");
+      return false;
+    }
+    
+    offset += chunk;
+    bytesSent += chunk;
+  }
+  return true;
+}
+
+// ============================================
+// SOCKET RECEIVE (AT+CARECV)
+// ============================================
+int LTEManager::socketReceive(uint8_t cid, uint8_t* buffer, size_t maxLength, uint32_t timeout_ms) {
+  LatencyScope timed(opHist[LTE_OP_SOCKET_RECV]);
+  size_t want = (maxLength < LTE_SOCKET_CHUNK) ? maxLength : LTE_SOCKET_CHUNK;
+  char cmd[32];
+  snprintf(cmd, sizeof(cmd), "AT+CARECV=%u,%u", cid, (unsigned)want);
+  
+  unsigned long start = millis();
+  uint32_t pollMs = LTE_SOCKET_POLL_MS;
+  while (true) {
+    clearSerialBuffer();
+    modemSerial->println(cmd);
+    
+    // +CARECV: <len>[,<data>]; ERROR once the peer has closed the socket
+    if (waitForToken("+CARECV: ", LTE_COMMAND_TIMEOUT_MS) != 1) {
+      Logger::printf(LOG_DEBUG, "LTE", "Socket %u: receive failed (closed?)", cid);
+      return -1;
+    }
+    long received = readNumber(LTE_COMMAND_TIMEOUT_MS);
+    if (received > 0) {
+      if ((size_t)received > want || !readExact(buffer, received, LTE_COMMAND_TIMEOUT_MS)) {
+        LOG_E("LTE", "CARECV data truncated");
+        return -1;
+      }
+      waitForToken("OK", LTE_COMMAND_TIMEOUT_MS);
+      return (int)received;
+    }
+    waitForToken("OK", LTE_COMMAND_TIMEOUT_MS);
+    if (received < 0) {
+      return -1;
+    }
+    
+    if (millis() - start >= timeout_ms) {
+      return 0;
+    }
+    // Nothing buffered yet: back off the polling up to 8x
+    delay(pollMs);
+    if (pollMs < LTE_SOCKET_POLL_MS * 8) {
+      pollMs *= 2;
+    }
+  }
+}
+
+// ============================================
+// SOCKET CLOSE (AT+CACLOSE)
+// ============================================
+bool LTEManager::socketClose(uint8_t cid) {
+  char cmd[24];
+  snprintf(cmd, sizeof(cmd), "AT+CACLOSE=%u", cid);
+  Logger::printf(LOG_INFO, "LTE", "Socket %u: closing", cid);
+  return sendSocketCommand(cmd, LTE_COMMAND_TIMEOUT_MS);
+}
+
+// ============================================
+// SOCKET RESPONSE HELPERS
+// ============================================
+bool LTEManager::sendSocketCommand(const char* cmd, uint32_t timeout_ms) {
+  LatencyScope timed(opHist[LTE_OP_AT_COMMAND]);
+  PROFILE_ZONE(PROF_AT_COMMAND);
+  Logger::printf(LOG_DEBUG, "LTE", "TX: %s", cmd);
+  
+  clearSerialBuffer();
+  modemSerial->println(cmd);
+  
+  unsigned long start = millis();
+  int result = waitForToken("OK", timeouts.get(cmd, timeout_ms));
+  reportLatency(cmd, start, result != 0);
+  return result == 1;
+}
+
+int LTEManager::waitForToken(const char* token, uint32_t timeout_ms) {
+  static const char errorToken[] = "ERROR";
+  size_t tokenLength = strlen(token);
+  size_t matched = 0;
+  size_t errorMatched = 0;
+  unsigned long start = millis();
+  
+  while (millis() - start < timeout_ms) {
+    int next = nextByte();
+    if (next < 0) {
+      waitRx(1);
+      continue;
+    }
+    char c = (char)next;
+    
+    // Restart the match on a mismatch; none of the tokens repeat their own prefix
+    matched = (c == token[matched]) ? matched + 1 : (c == token[0]) ? 1 : 0;
+    if (matched == tokenLength) {
+      return 1;
+    }
+    errorMatched = (c == errorToken[errorMatched]) ? errorMatched + 1 : (c == errorToken[0]) ? 1 : 0;
+    if (errorMatched == sizeof(errorToken) - 1) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Decimal number at the current position; consumes the character after it
+long LTEManager::readNumber(uint32_t timeout_ms) {
+  long value = -1;
+  unsigned long start = millis();
+  
+  while (millis() - start < timeout_ms) {
+    int next = nextByte();
+    if (next < 0) {
+      waitRx(1);
+      continue;
+    }
+    char c = (char)next;
+    if (c < '0' || c > '9') {
+      return value;
+    }
+    value = ((value < 0) ? 0 : value * 10) + (c - '0');
+  }
+  return -1;
+}
+
+bool LTEManager::readExact(uint8_t* buffer, size_t length, uint32_t timeout_ms) {
+  size_t got = 0;
+  unsigned long start = millis();
+  
+  // Staged bytes first, then straight from the stream into the caller's buffer
+  if (rxHead < rxLen) {
+    got = rxLen - rxHead;
+    if (got > length) {
+      got = length;
+    }
+    memcpy(buffer, rxBuffer + rxHead, got);
+    rxHead += got;
+  }
+  
+  while (got < length && millis() - start < timeout_ms) {
+    int avail = modemSerial->available();
+    if (avail <= 0) {
+      waitRx(1);
+      continue;
+    }
+    size_t n = length - got;
+    if ((size_t)avail < n) {
+      n = avail;
+    }
+    got += modemSerial->readBytes(buffer + got, n);
+    start = millis();  // Reset timeout on data received
+  }
+  return got == length;
+}
@@ -9,6 +9,13 @@
 
 #include <Arduino.h>
 #include <HardwareSerial.h>
+#include "latency_histogram.h"
+#include "adaptive_timeout.h"
+#include "cmux.h"
+#include "config.h"
+#if LTE_UART_DRIVER
+#include "modem_uart.h"
+#endif
 
 // ============================================
 // HTTP METHOD
@@ -18,6 +25,24 @@ enum HttpMethod {
   HTTP_POST = 1
 };
 
+// ============================================
+// TIMED OPERATIONS (latency histograms)
+// ============================================
+enum LteOp {
+  LTE_OP_AT_COMMAND,     // Single AT command round trip
+  LTE_OP_NETWORK,        // checkNetwork() (SIM + registration)
+  LTE_OP_BEARER_OPEN,    // openBearer()
+  LTE_OP_HTTP_GET,       // Whole GET, init to terminate
+  LTE_OP_HTTP_POST,      // Whole POST, init to terminate
+  LTE_OP_HTTP_DATA,      // AT+HTTPDATA body transfer to the modem
+  LTE_OP_HTTP_ACTION,    // AT+HTTPACTION (request on the network)
+  LTE_OP_HTTP_READ,      // AT+HTTPREAD
+  LTE_OP_SOCKET_OPEN,    // AT+CAOPEN (TCP connect / TLS handshake)
+  LTE_OP_SOCKET_SEND,    // socketSend(), all AT+CASEND chunks
+  LTE_OP_SOCKET_RECV,    // socketReceive(), including polls for data
+  LTE_OP_COUNT
+};
+
 // ============================================
 // LTE MANAGER CLASS
 // ============================================
@@ -26,12 +51,54 @@ public:
   // Initialize LTE manager and UART
   bool init(uint8_t txPin, uint8_t rxPin, uint8_t pwrkeyPin, uint8_t resetPin, uint32_t baudRate);
   
+  // Initialize against a simulated modem (e.g. ModemTraceReplay) or a CMUX
+  // channel of another LTEManager; no pins or UART are touched and the modem
+  // counts as powered
+  bool initWithStream(Stream* stream);
+  
+  // Route modem I/O through another stream, e.g. a ModemTraceRecorder
+  // wrapping the UART (nullptr = back to the UART)
+  void setStream(Stream* stream);
+  
+  // The modem UART itself (nullptr when simulated), e.g. to wrap in a recorder
+  Stream* getUart();
+  
   // Power on modem (pulse PWRKEY)
   bool powerOn();
   
   // Power off modem
   bool powerOff();
   
+  // Raise the UART rate with AT+IPR, fastest allowed rate first; each must
+  // pass LTE_BAUD_PROBES round trips or both ends go back. ctsPin >= 0 first
+  // enables CTS flow control (AT+IFC=0,2). Returns true if faster than the
+  // boot rate. After LTE_BAUD_MAX_FAILURES unanswered commands in a row the
+  // link steps down a rate on its own, and that rate is not tried again.
+  bool negotiateBaudRate(int8_t ctsPin);
+  
+  // Rates negotiateBaudRate() may use, fastest first (default LTE_FAST_BAUD_RATES)
+  void setBaudRates(const uint32_t* rates, uint8_t count);
+  
+  uint32_t getBaudRate();
+  
+  // Called after every UART rate change (a simulated modem follows it here)
+  void setBaudRateHook(void (*hook)(uint32_t baudRate));
+  
+  // Switch the UART to GSM 07.10 multiplexing (AT+CMUX, see cmux.h). This
+  // manager moves to the data channel, update() reads the URC channel and
+  // the control channel is left for a second LTEManager (initWithStream).
+  // Returns false, staying in plain AT mode, if the modem refuses. No rate
+  // changes while the mux is open.
+  bool startCmux();
+  
+  // Close the mux, back to plain AT on the UART (also done by powerOff())
+  void stopCmux();
+  
+  bool isCmuxActive();
+  
+  // Virtual channel stream (CMUX_CHANNEL_*), nullptr while the mux is closed
+  Stream* getCmuxChannel(uint8_t channel);
+  
   // Check network registration
   bool checkNetwork(uint32_t timeout_ms);
   
@@ -49,27 +116,131 @@ public:
   // Close bearer connection
   bool closeBearer();
   
+  // Quick check whether the PDP context is active (AT+CNACT?)
+  bool isBearerOpen();
+  
+  // Signal quality (AT+CSQ): RSSI 0-31, 99 = unknown, -1 = no answer
+  int getSignalQuality();
+  
+  // LTE RSRP (AT+CESQ) in dBm, 0 = unknown or no answer
+  int getRsrp();
+  
   // HTTP GET request
   // Returns true if successful, fills buffer with response data
   bool httpGet(const char* url, uint8_t* buffer, size_t* length, size_t maxLength);
   
+  // HTTP GET with ETag revalidation
+  // ifNoneMatch: cached ETag or nullptr; a 304 returns true with *length = 0
+  // etagOut: receives the response ETag on 200 (may be nullptr); left empty
+  // unless it is a well-formed entity-tag
+  // Returns true for 200 or 304; check statusCode
+  bool httpGetConditional(const char* url, const char* ifNoneMatch,
+                          uint8_t* buffer, size_t* length, size_t maxLength,
+                          char* etagOut, size_t etagOutSize, int* statusCode);
+  
   // HTTP POST request
+  // userHeader: optional extra header line (e.g. "X-Capture-Stats: rms=...")
   // Returns true if successful
-  bool httpPost(const char* url, const uint8_t* data, size_t length);
+  bool httpPost(const char* url, const uint8_t* data, size_t length, const char* userHeader = nullptr);
+  
+  // HTTP POST with status code and response body
+  // contentType: e.g. "application/octet-stream"; userHeader may be nullptr
+  // Returns true if the request completed (any status); check statusCode
+  bool httpPostWithResponse(const char* url, const uint8_t* data, size_t length,
+                            const char* contentType, const char* userHeader,
+                            int* statusCode, String& response);
   
   // HTTP POST JSON with Bearer token authentication
   // Returns true if successful, fills responseBuffer with response
   bool httpPostJsonWithAuth(const char* url, const char* jsonBody, const char* bearerToken, String& response);
   
+  // TCP/TLS socket (AT+CAOPEN/CASEND/CARECV) on the PDP context opened by
+  // openBearer(); see http_client.h for HTTP on top of it
+  // cid: modem socket id (0-12)
+  bool socketOpen(uint8_t cid, const char* host, uint16_t port, bool tls);
+  
+  // UDP socket to one peer; each send/receive is one datagram (coap_client.h)
+  bool socketOpenUdp(uint8_t cid, const char* host, uint16_t port);
+  
+  // Send all bytes, split into LTE_SOCKET_CHUNK-sized AT+CASEND calls
+  bool socketSend(uint8_t cid, const uint8_t* data, size_t length);
+  
+  // Read up to maxLength bytes, polling until some arrive or timeout_ms passes
+  // Returns bytes read, 0 on timeout, -1 if the socket is closed or errored
+  int socketReceive(uint8_t cid, uint8_t* buffer, size_t maxLength, uint32_t timeout_ms);
+  
+  bool socketClose(uint8_t cid);
+  
   // Update function (call in loop to process incoming data)
   void update();
+  
+  // Called (from the UART event task) when modem bytes arrive
+  void setReceiveHook(void (*hook)());
+  
+  // Called by update() with each URC line, CR/LF stripped (needs
+  // LTE_UART_DRIVER or an open mux; otherwise update() only drains)
+  void setUrcHook(void (*hook)(const char* line));
+  
+  // Called whenever a command waits for modem bytes (every few ms). With the
+  // mux open it may use the other channels, e.g. read the signal through a
+  // second LTEManager or call update(), but no other command of this manager.
+  void setWaitHook(void (*hook)());
+  
+  // Total HTTP body bytes handed to the modem since init (for bytes-on-air accounting)
+  uint32_t getBytesSent();
+  
+  // Parse "+HTTPACTION: <method>,<status>,<length>" out of a modem response
+  // (public so the parser can be benchmarked without a modem)
+  static bool parseHttpAction(const String& response, int* statusCode, int* dataLength);
+  
+  // RFC 7232 entity-tag ([W/]"..." of printable ASCII), safe to send back
+  static bool isEntityTag(const char* tag);
+  
+  // Duration histogram per operation (callers may snapshot/reset/merge it)
+  LatencyHistogram* getOpHistogram(uint8_t op);
+  static const char* getOpName(uint8_t op);
+  
+  // Write learned AT timeouts to NVS now (also done on powerOff())
+  void saveTimeouts();
 
 private:
-  HardwareSerial* modemSerial;
+  Stream* uart;               // nullptr when simulated
+#if LTE_UART_DRIVER
+  ModemUart modemUart;
+#endif
+  Stream* modemSerial;        // All modem I/O goes through this
+  
+  // Received bytes staged by one bulk read; the parsers below take them from
+  // here instead of calling available()/read() per byte
+  char rxBuffer[LTE_RX_CHUNK];
+  uint16_t rxHead;
+  uint16_t rxLen;
   uint8_t pinPwrkey;
   uint8_t pinReset;
   bool initialized;
   bool powered;
+  uint32_t bytesSent;
+  LatencyHistogram opHist[LTE_OP_COUNT];
+  AdaptiveTimeout timeouts;
+  bool persistTimeouts;
+  
+  // UART rate negotiation
+  uint32_t baudBase;          // Rate the modem boots with
+  uint32_t baudCurrent;
+  const uint32_t* baudRates;  // Faster rates, fastest first
+  uint8_t baudRateCount;
+  uint8_t baudFirst;          // Fastest rate not yet found unstable
+  uint8_t baudFailures;       // Unanswered commands in a row at baudCurrent
+  uint32_t baudFrameErrors;   // ModemUart frame errors when baudCurrent was set
+  bool baudSwitching;
+  void (*baudHook)(uint32_t baudRate);
+  
+  // GSM 07.10 multiplexing
+  Cmux cmux;
+  bool cmuxActive;
+  Stream* cmuxBase;           // Stream the mux runs on
+  void (*urcHook)(const char* line);
+  void (*waitHook)();
   
   // Response buffer
   String responseBuffer;
@@ -86,14 +257,51 @@ private:
   // Clear serial buffer
   void clearSerialBuffer();
   
+  // Next received byte, -1 if none is buffered (refills rxBuffer in one read)
+  int nextByte();
+  bool fillRx();
+  
+  // Sleep up to wait_ms, waking early when modem bytes arrive (driver mode)
+  void waitRx(uint32_t wait_ms);
+  
   // Read available serial data
   String readSerial(uint32_t timeout_ms);
   
+  // Read until a line starting with `until`, a final ERROR (or a bare OK
+  // with untilFinal; *answered) or the deadline
+  String readResponse(uint32_t timeout_ms, const char* until, bool untilFinal, bool* answered);
+  
+  // Feed a command's response time (or timeout) to the timeout estimator
+  void reportLatency(const char* cmd, unsigned long startMs, bool answered);
+  
+  // Baud rate helpers
+  void resetBaudState(uint32_t baudRate);
+  void setUartBaudRate(uint32_t baudRate);
+  bool switchBaudRate(uint32_t baudRate);
+  bool probeModem(uint8_t count);
+  bool findModemBaudRate();
+  void enableFlowControl(int8_t ctsPin);
+  void checkLinkHealth(bool answered);
+  bool closeStaleCmux();
+  
+  // Log a URC line and pass it to the URC hook
+  void handleUrc(char* line, int length);
+  
+  // Socket helpers: return as soon as the response is complete instead of
+  // waiting out the silence timeout like readSerial()
+  // waitForToken: 1 = token seen, -1 = ERROR seen, 0 = timeout
+  int waitForToken(const char* token, uint32_t timeout_ms);
+  long readNumber(uint32_t timeout_ms);
+  bool readExact(uint8_t* buffer, size_t length, uint32_t timeout_ms);
+  bool sendSocketCommand(const char* cmd, uint32_t timeout_ms);
+  bool openSocket(uint8_t cid, const char* protocol, const char* host, uint16_t port, bool tls);
+  
   // HTTP helper functions
   bool httpInit();
   bool httpSetParameter(const char* param, const char* value);
   bool httpAction(HttpMethod method, int* statusCode, int* dataLength);
   bool httpRead(uint8_t* buffer, size_t* length, size_t maxLength);
+  bool httpReadHeader(const char* name, char* value, size_t valueSize);
   bool httpPostData(const uint8_t* data, size_t length);
   bool httpTerminate();
 };
@@ -0,0 +1,275 @@
+/*
+ * message_cache.cpp
+ * 
+ * Implementation of flash-backed message cache
+ */
+
+#include "message_cache.h"
+#include "logger.h"
+
+#define MSG_CACHE_DIR         "/cache"
+#define MSG_CACHE_INDEX_PATH  "/cache/index"
+#define MSG_CACHE_TMP_PATH    "/cache/incoming.tmp"
+#define MSG_CACHE_INDEX_TMP   "/cache/index.tmp"
+
+// ============================================
+// MOUNT AND LOAD INDEX
+// ============================================
+bool MessageCache::begin() {
+  mounted = false;
+  useCounter = 0;
+  memset(entries, 0, sizeof(entries));
+  memset(&stats, 0, sizeof(stats));
+  
+  if (!LittleFS.begin(true)) {
+    LOG_E("Cache", "LittleFS mount failed");
+    return false;
+  }
+  
+  if (!LittleFS.exists(MSG_CACHE_DIR)) {
+    LittleFS.mkdir(MSG_CACHE_DIR);
+  }
+  
+  File index = LittleFS.open(MSG_CACHE_INDEX_PATH, "r");
+  if (index) {
+    if (index.read((uint8_t*)entries, sizeof(entries)) != sizeof(entries)) {
+      LOG_W("Cache", "Index unreadable - starting empty");
+      memset(entries, 0, sizeof(entries));
+    }
+    index.close();
+  }
+  
+  // Drop entries whose file is missing or truncated (e.g. power loss mid-store)
+  int count = 0;
+  size_t totalBytes = 0;
+  for (int i = 0; i < MSG_CACHE_MAX_ENTRIES; i++) {
+    if (!entries[i].valid) {
+      continue;
+    }
+    entries[i].uid[MSG_CACHE_UID_LEN - 1] = '\0';
+    entries[i].etag[MSG_CACHE_ETAG_LEN - 1] = '\0';
+    
+    char path[64];
+    entryPath(entries[i].uid, path, sizeof(path));
+    File file = LittleFS.open(path, "r");
+    if (!file || file.size() != entries[i].size) {
+      entries[i].valid = 0;
+      if (file) file.close();
+      continue;
+    }
+    file.close();
+    
+    if (entries[i].lastUsed > useCounter) {
+      useCounter = entries[i].lastUsed;
+    }
+    count++;
+    totalBytes += entries[i].size;
+  }
+  
+  mounted = true;
+  Logger::printf(LOG_INFO, "Cache", "Message cache ready: %d entries, %u bytes", count, totalBytes);
+  return true;
+}
+
+// ============================================
+// LOOKUP
+// ============================================
+bool MessageCache::lookup(const char* uid, char* etag, size_t etagSize) {
+  int idx = findEntry(uid);
+  if (idx < 0) {
+    return false;
+  }
+  strncpy(etag, entries[idx].etag, etagSize - 1);
+  etag[etagSize - 1] = '\0';
+  return true;
+}
+
+// ============================================
+// LOAD CACHED AUDIO
+// ============================================
+bool MessageCache::load(const char* uid, uint8_t* buffer, size_t bufferSize, size_t* length) {
+  *length = 0;
+  int idx = findEntry(uid);
+  if (idx < 0 || entries[idx].size > bufferSize) {
+    return false;
+  }
+  
+  char path[64];
+  entryPath(uid, path, sizeof(path));
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    remove(uid);
+    return false;
+  }
+  size_t bytesRead = file.read(buffer, entries[idx].size);
+  file.close();
+  
+  if (bytesRead != entries[idx].size) {
+    Logger::printf(LOG_WARN, "Cache", "Short read for %s - dropping entry", uid);
+    remove(uid);
+    return false;
+  }
+  
+  // LRU touch (index is rewritten lazily on the next store/remove)
+  entries[idx].lastUsed = ++useCounter;
+  *length = bytesRead;
+  return true;
+}
+
+// ============================================
+// STORE AUDIO
+// ============================================
+bool MessageCache::store(const char* uid, const char* etag, const uint8_t* data, size_t length) {
+  if (!mounted || length == 0 || length > MSG_CACHE_MAX_BYTES) {
+    return false;
+  }
+  if (strlen(uid) >= MSG_CACHE_UID_LEN || etag == nullptr || etag[0] == '\0' ||
+      strlen(etag) >= MSG_CACHE_ETAG_LEN) {
+    return false;  // No validator - nothing to revalidate against later
+  }
+  
+  // Write to a temp file first so a power cut never leaves a half-written entry
+  File file = LittleFS.open(MSG_CACHE_TMP_PATH, "w");
+  if (!file) {
+    return false;
+  }
+  size_t written = file.write(data, length);
+  file.close();
+  if (written != length) {
+    LittleFS.remove(MSG_CACHE_TMP_PATH);
+    LOG_W("Cache", "Cache write failed (flash full?)");
+    return false;
+  }
+  
+  // Replacing an existing entry frees its space first
+  remove(uid);
+  int slot = evictForSpace(length);
+  
+  char path[64];
+  entryPath(uid, path, sizeof(path));
+  if (!LittleFS.rename(MSG_CACHE_TMP_PATH, path)) {
+    LittleFS.remove(MSG_CACHE_TMP_PATH);
+    return false;
+  }
+  
+  Entry& entry = entries[slot];
+  memset(&entry, 0, sizeof(entry));
+  strncpy(entry.uid, uid, MSG_CACHE_UID_LEN - 1);
+  strncpy(entry.etag, etag, MSG_CACHE_ETAG_LEN - 1);
+  entry.size = length;
+  entry.lastUsed = ++useCounter;
+  entry.valid = 1;
+  
+  Logger::printf(LOG_INFO, "Cache", "Cached %s: %u bytes, ETag %s", uid, length, etag);
+  return saveIndex();
+}
+
+// ============================================
+// REMOVE ENTRY
+// ============================================
+void MessageCache::remove(const char* uid) {
+  int idx = findEntry(uid);
+  if (idx < 0) {
+    return;
+  }
+  char path[64];
+  entryPath(uid, path, sizeof(path));
+  LittleFS.remove(path);
+  entries[idx].valid = 0;
+  saveIndex();
+}
+
+// ============================================
+// STATISTICS
+// ============================================
+void MessageCache::recordHit(size_t bytesSaved, uint32_t latencyMs) {
+  stats.hits++;
+  stats.bytesSaved += bytesSaved;
+  stats.hitLatencyMs += latencyMs;
+}
+
+void MessageCache::recordMiss(bool hadEntry, uint32_t latencyMs) {
+  if (hadEntry) {
+    stats.refreshes++;
+  } else {
+    stats.misses++;
+  }
+  stats.missLatencyMs += latencyMs;
+}
+
+const MessageCacheStats& MessageCache::getStats() {
+  return stats;
+}
+
+void MessageCache::logStats() {
+  uint32_t lookups = stats.hits + stats.misses + stats.refreshes;
+  uint32_t downloads = stats.misses + stats.refreshes;
+  Logger::printf(LOG_INFO, "Cache", "Hit rate %lu/%lu, %lu bytes saved, avg latency hit=%lu ms miss=%lu ms", 
+                 (unsigned long)stats.hits, (unsigned long)lookups, (unsigned long)stats.bytesSaved,
+                 (unsigned long)(stats.hits ? stats.hitLatencyMs / stats.hits : 0),
+                 (unsigned long)(downloads ? stats.missLatencyMs / downloads : 0));
+}
+
+// ============================================
+// HELPERS
+// ============================================
+int MessageCache::findEntry(const char* uid) {
+  if (!mounted) {
+    return -1;
+  }
+  for (int i = 0; i < MSG_CACHE_MAX_ENTRIES; i++) {
+    if (entries[i].valid && strcmp(entries[i].uid, uid) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Evict least recently used entries until `needed` bytes and one slot are free
+int MessageCache::evictForSpace(size_t needed) {
+  for (;;) {
+    size_t totalBytes = 0;
+    int freeSlot = -1;
+    int lruSlot = -1;
+    for (int i = 0; i < MSG_CACHE_MAX_ENTRIES; i++) {
+      if (!entries[i].valid) {
+        if (freeSlot < 0) freeSlot = i;
+        continue;
+      }
+      totalBytes += entries[i].size;
+      if (lruSlot < 0 || entries[i].lastUsed < entries[lruSlot].lastUsed) {
+        lruSlot = i;
+      }
+    }
+    
+    if (freeSlot >= 0 && totalBytes + needed <= MSG_CACHE_MAX_BYTES) {
+      return freeSlot;
+    }
+    
+    Logger::printf(LOG_INFO, "Cache", "Evicting %s (%lu bytes)", 
+                   entries[lruSlot].uid, (unsigned long)entries[lruSlot].size);
+    char path[64];
+    entryPath(entries[lruSlot].uid, path, sizeof(path));
+    LittleFS.remove(path);
+    entries[lruSlot].valid = 0;
+  }
+}
+
+void MessageCache::entryPath(const char* uid, char* path, size_t pathSize) {
+  snprintf(path, pathSize, MSG_CACHE_DIR "/%s.pcm", uid);
+}
+
+// Same temp file + rename as store(): a power cut leaves the old index or the new one
+bool MessageCache::saveIndex() {
+  File index = LittleFS.open(MSG_CACHE_INDEX_TMP, "w");
+  if (!index) {
+    return false;
+  }
+  bool ok = index.write((const uint8_t*)entries, sizeof(entries)) == sizeof(entries);
+  index.close();
+  if (!ok || !LittleFS.rename(MSG_CACHE_INDEX_TMP, MSG_CACHE_INDEX_PATH)) {
+    LittleFS.remove(MSG_CACHE_INDEX_TMP);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,81 @@
+/*
+ * message_cache.h
+ * 
+ * LRU cache of downloaded messages in flash (LittleFS), keyed by NFC UID
+ * (the sketch appends a hash of the URL when NDEF hints redirect the tag)
+ * 
+ * Each entry keeps the server ETag so a repeat tap only needs a conditional
+ * GET (If-None-Match); a 304 reply means the flash copy is played as-is.
+ */
+
+#ifndef MESSAGE_CACHE_H
+#define MESSAGE_CACHE_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "config.h"
+
+#define MSG_CACHE_UID_LEN   32
+#define MSG_CACHE_ETAG_LEN  64
+
+// ============================================
+// CACHE STATISTICS
+// ============================================
+struct MessageCacheStats {
+  uint32_t hits;            // Served from flash (304, or the tag named the cached version)
+  uint32_t misses;          // No usable entry, full download
+  uint32_t refreshes;       // Entry existed but server sent new content (200)
+  uint32_t bytesSaved;      // Download bytes avoided by hits
+  uint32_t hitLatencyMs;    // Sum of fetch-to-audio latency on hits
+  uint32_t missLatencyMs;   // Sum of fetch-to-audio latency on misses/refreshes
+};
+
+// ============================================
+// MESSAGE CACHE CLASS
+// ============================================
+class MessageCache {
+public:
+  // Mount filesystem and load index
+  bool begin();
+  
+  // Look up a UID; fills etag if cached
+  bool lookup(const char* uid, char* etag, size_t etagSize);
+  
+  // Load cached audio for a UID into buffer (marks entry as recently used)
+  bool load(const char* uid, uint8_t* buffer, size_t bufferSize, size_t* length);
+  
+  // Store/replace audio for a UID (evicts least recently used entries as needed)
+  bool store(const char* uid, const char* etag, const uint8_t* data, size_t length);
+  
+  // Drop an entry (e.g. unreadable file)
+  void remove(const char* uid);
+  
+  // Record outcome of a fetch for hit-rate / latency reporting
+  void recordHit(size_t bytesSaved, uint32_t latencyMs);
+  void recordMiss(bool hadEntry, uint32_t latencyMs);
+  
+  // Statistics
+  const MessageCacheStats& getStats();
+  void logStats();
+
+private:
+  struct Entry {
+    char uid[MSG_CACHE_UID_LEN];
+    char etag[MSG_CACHE_ETAG_LEN];
+    uint32_t size;
+    uint32_t lastUsed;        // Monotonic use counter (LRU)
+    uint8_t valid;
+  };
+  
+  bool mounted;
+  Entry entries[MSG_CACHE_MAX_ENTRIES];
+  uint32_t useCounter;
+  MessageCacheStats stats;
+  
+  int findEntry(const char* uid);
+  int evictForSpace(size_t needed);
+  void entryPath(const char* uid, char* path, size_t pathSize);
+  bool saveIndex();
+};
+
+#endif // MESSAGE_CACHE_H
@@ -0,0 +1,117 @@
+/*
+ * mic_watchdog.cpp
+ * 
+ * Implementation of microphone health monitor
+ */
+
+#include "mic_watchdog.h"
+#include "logger.h"
+#include "config.h"
+
+// ============================================
+// START MONITOR TASK
+// ============================================
+bool MicWatchdog::begin(AudioManager* audioManager) {
+  audio = audioManager;
+  clipGeneration = audio->getCaptureGeneration();
+  restartsThisClip = 0;
+  totalRestarts = 0;
+  lastRestartTime = 0;
+  
+  // Low priority: recovery must never preempt the capture path
+  BaseType_t result = xTaskCreate(taskEntry, "mic_wdt", 4096, this, 1, &taskHandle);
+  if (result != pdPASS) {
+    LOG_E("MicWdt", "Failed to create watchdog task");
+    taskHandle = NULL;
+    return false;
+  }
+  
+  Logger::printf(LOG_INFO, "MicWdt", "Mic watchdog started (budget %d restarts/clip)", 
+                 MIC_WATCHDOG_MAX_RESTARTS);
+  return true;
+}
+
+// ============================================
+// STOP MONITOR TASK
+// ============================================
+void MicWatchdog::end() {
+  if (taskHandle != NULL) {
+    vTaskDelete(taskHandle);
+    taskHandle = NULL;
+  }
+}
+
+// ============================================
+// RESTART COUNTERS
+// ============================================
+uint8_t MicWatchdog::getRestartCount() {
+  return restartsThisClip;
+}
+
+uint32_t MicWatchdog::getTotalRestarts() {
+  return totalRestarts;
+}
+
+bool MicWatchdog::isBudgetExhausted() {
+  return restartsThisClip >= MIC_WATCHDOG_MAX_RESTARTS;
+}
+
+// ============================================
+// TASK ENTRY
+// ============================================
+void MicWatchdog::taskEntry(void* arg) {
+  MicWatchdog* self = (MicWatchdog*)arg;
+  for (;;) {
+    self->check();
+    vTaskDelay(pdMS_TO_TICKS(MIC_WATCHDOG_PERIOD_MS));
+  }
+}
+
+// ============================================
+// CHECK CAPTURE HEALTH
+// ============================================
+void MicWatchdog::check() {
+  if (audio->getCurrentMode() != AUDIO_MODE_RECORDING) {
+    return;
+  }
+  
+  // New clip - refill restart budget
+  uint32_t generation = audio->getCaptureGeneration();
+  if (generation != clipGeneration) {
+    clipGeneration = generation;
+    restartsThisClip = 0;
+  }
+  
+  uint32_t stuckBlocks = audio->getStuckBlockRun();
+  uint32_t sinceGood = audio->getMsSinceLastGoodBlock();
+  bool stuck = stuckBlocks >= MIC_WATCHDOG_STUCK_BLOCKS;
+  bool stalled = sinceGood >= MIC_WATCHDOG_STALL_MS;
+  if (!stuck && !stalled) {
+    return;
+  }
+  
+  if (restartsThisClip >= MIC_WATCHDOG_MAX_RESTARTS) {
+    // Budget spent - stay quiet, the clip's capture stats record the damage
+    return;
+  }
+  
+  if (lastRestartTime != 0 && millis() - lastRestartTime < MIC_WATCHDOG_HOLDOFF_MS) {
+    return;
+  }
+  
+  restartsThisClip++;
+  totalRestarts++;
+  lastRestartTime = millis();
+  
+  Logger::printf(LOG_WARN, "MicWdt", "Mic unhealthy (%lu stuck blocks, %lu ms since good data) - restart %d/%d", 
+                 (unsigned long)stuckBlocks, (unsigned long)sinceGood, 
+                 restartsThisClip, MIC_WATCHDOG_MAX_RESTARTS);
+  
+  unsigned long start = millis();
+  if (audio->restartCapture()) {
+    Logger::printf(LOG_INFO, "MicWdt", "I2S restarted in %lu ms (gap backfilled with silence)", 
+                   millis() - start);
+  } else {
+    LOG_E("MicWdt", "I2S restart failed");
+  }
+}
@@ -0,0 +1,49 @@
+/*
+ * mic_watchdog.h
+ * 
+ * Background health monitor for the I2S microphone
+ * Watches AudioManager capture counters and restarts I2S off the read path
+ */
+
+#ifndef MIC_WATCHDOG_H
+#define MIC_WATCHDOG_H
+
+#include <Arduino.h>
+#include "audio_manager.h"
+
+// ============================================
+// MIC WATCHDOG CLASS
+// ============================================
+class MicWatchdog {
+public:
+  // Start the monitor task (call after audio.init())
+  bool begin(AudioManager* audioManager);
+  
+  // Stop the monitor task
+  void end();
+  
+  // Restarts performed for the current clip
+  uint8_t getRestartCount();
+  
+  // Total restarts since begin()
+  uint32_t getTotalRestarts();
+  
+  // True if the current clip has used its whole restart budget
+  bool isBudgetExhausted();
+
+private:
+  AudioManager* audio;
+  TaskHandle_t taskHandle;
+  
+  // Per-clip restart budget
+  uint32_t clipGeneration;
+  volatile uint8_t restartsThisClip;
+  volatile uint32_t totalRestarts;
+  unsigned long lastRestartTime;
+  
+  // Task body
+  static void taskEntry(void* arg);
+  void check();
+};
+
+#endif // MIC_WATCHDOG_H
@@ -0,0 +1,669 @@
+/*
+ * modem_trace.cpp
+ * 
+ * Implementation of modem trace replay and recording
+ */
+
+#include "modem_trace.h"
+
+// ============================================
+// TRACE PARSING
+// ============================================
+// Next non-blank, non-comment line; line/length exclude the line ending
+bool ModemTraceReplay::nextLine(const char** cursor, const char** line, size_t* length) {
+  const char* p = *cursor;
+  while (p != nullptr && *p != '\0') {
+    const char* start = p;
+    while (*p != '\0' && *p != '\n') {
+      p++;
+    }
+    const char* end = p;
+    if (*p == '\n') {
+      p++;
+    }
+    if (end > start && end[-1] == '\r') {
+      end--;
+    }
+    if (end > start && start[0] != '#') {
+      *cursor = p;
+      *line = start;
+      *length = end - start;
+      return true;
+    }
+  }
+  *cursor = p;
+  return false;
+}
+
+size_t ModemTraceReplay::decode(const char* text, size_t length, uint8_t* out, size_t outSize) {
+  size_t n = 0;
+  for (size_t i = 0; i < length && n < outSize; i++) {
+    char c = text[i];
+    if (c != '\\' || i + 1 >= length) {
+      out[n++] = (uint8_t)c;
+      continue;
+    }
+    char e = text[++i];
+    switch (e) {
+      case 'r': out[n++] = '\r'; break;
+      case 'n': out[n++] = '\n'; break;
+      case '0': out[n++] = 0x00; break;
+      case 'x':
+        if (i + 2 < length) {
+          char hex[3] = { text[i + 1], text[i + 2], '\0' };
+          out[n++] = (uint8_t)strtoul(hex, nullptr, 16);
+          i += 2;
+        }
+        break;
+      default:  out[n++] = (uint8_t)e; break;   // \\ and anything else
+    }
+  }
+  return n;
+}
+
+// ============================================
+// REPLAY: SETUP
+// ============================================
+ModemTraceReplay::ModemTraceReplay() {
+  jitterPercent = 0;
+  jitterSeed = 1;
+  begin("", 115200);
+}
+
+void ModemTraceReplay::setJitter(uint8_t percent, uint32_t seed) {
+  jitterPercent = (percent > 100) ? 100 : percent;
+  jitterSeed = (seed != 0) ? seed : 1;
+}
+
+void ModemTraceReplay::begin(const char* trace, uint32_t baudRate) {
+  cursor = trace;
+  finished = false;
+  expectHost = false;
+  expected = nullptr;
+  expectedLength = 0;
+  rxLength = 0;
+  rxPos = 0;
+  rxStartUs = 0;
+  byteNs = (baudRate > 0) ? 10000000000ULL / baudRate : 0;  // 10 bits per byte (8N1)
+  hostByteNs = byteNs;
+  txFractionNs = 0;
+  hostLength = 0;
+  hostLines = 0;
+  mismatches = 0;
+  skipped = 0;
+  garbled = 0;
+  rng = jitterSeed;
+  lastEventUs = micros();
+  txDoneUs = lastEventUs;
+  loadNext();
+}
+
+// Parse the next event at the cursor
+void ModemTraceReplay::loadNext() {
+  const char* line;
+  size_t length;
+  rxLength = 0;
+  rxPos = 0;
+  expectHost = false;
+  
+  while (nextLine(&cursor, &line, &length)) {
+    if (line[0] == '>') {
+      size_t skip = 1;
+      while (skip < length && line[skip] == ' ') {
+        skip++;
+      }
+      expected = line + skip;
+      expectedLength = length - skip;
+      expectHost = true;
+      return;
+    }
+    
+    if (line[0] == '<') {
+      // "< <delay ms> <escaped bytes>"
+      size_t i = 1;
+      while (i < length && line[i] == ' ') {
+        i++;
+      }
+      uint32_t delayMs = 0;
+      while (i < length && line[i] >= '0' && line[i] <= '9') {
+        delayMs = delayMs * 10 + (line[i] - '0');
+        i++;
+      }
+      if (i < length && line[i] == ' ') {
+        i++;
+      }
+      if (jitterPercent > 0 && delayMs > 0) {
+        // xorshift32: deterministic per seed
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        uint32_t range = delayMs * jitterPercent / 100;
+        delayMs = delayMs - range + rng % (2 * range + 1);
+      }
+      rxLength = decode(line + i, length - i, rx, sizeof(rx));
+      rxStartUs = lastEventUs + delayMs * 1000;
+      return;
+    }
+    
+    if (line[0] == '=') {
+      // "= <baud>": the modem's UART rate changes
+      uint32_t baudRate = strtoul(line + 1, nullptr, 10);
+      byteNs = (baudRate > 0) ? 10000000000ULL / baudRate : 0;
+      continue;
+    }
+    // Unknown line types are ignored
+  }
+  
+  finished = true;
+}
+
+// ============================================
+// REPLAY: RX SIDE
+// ============================================
+// Bytes of the current RX event whose time has come (paced at the baud rate)
+size_t ModemTraceReplay::rxDue() {
+  int32_t elapsed = (int32_t)(micros() - rxStartUs);
+  if (elapsed < 0) {
+    return 0;
+  }
+  size_t due = (byteNs > 0) ? (size_t)((uint64_t)elapsed * 1000 / byteNs) + 1 : rxLength;
+  return (due < rxLength) ? due : rxLength;
+}
+
+// Move past RX events the host has fully read
+void ModemTraceReplay::service() {
+  while (!finished && !expectHost && rxPos >= rxLength) {
+    lastEventUs = rxStartUs + (uint32_t)((uint64_t)rxLength * byteNs / 1000);
+    loadNext();
+  }
+}
+
+int ModemTraceReplay::available() {
+  service();
+  if (finished || expectHost) {
+    return 0;
+  }
+  size_t due = rxDue();
+  return (due > rxPos) ? (int)(due - rxPos) : 0;
+}
+
+// At a mismatched rate every byte is framed wrongly; the junk never reads as text
+int ModemTraceReplay::read() {
+  if (available() <= 0) {
+    return -1;
+  }
+  uint8_t b = rx[rxPos++];
+  return (hostByteNs == byteNs) ? b : (b | 0x80);
+}
+
+int ModemTraceReplay::peek() {
+  if (available() <= 0) {
+    return -1;
+  }
+  return (hostByteNs == byteNs) ? rx[rxPos] : (rx[rxPos] | 0x80);
+}
+
+void ModemTraceReplay::setBaudRate(uint32_t baudRate) {
+  hostByteNs = (baudRate > 0) ? 10000000000ULL / baudRate : 0;
+}
+
+// ============================================
+// REPLAY: HOST SIDE
+// ============================================
+size_t ModemTraceReplay::write(uint8_t b) {
+  uint32_t now = micros();
+  if ((int32_t)(txDoneUs - now) < 0) {
+    txDoneUs = now;
+  }
+  txFractionNs += hostByteNs;
+  txDoneUs += txFractionNs / 1000;
+  txFractionNs %= 1000;
+  
+  if (b == '\n') {
+    hostLine[hostLength] = '\0';
+    onHostLine();
+    hostLength = 0;
+  } else if (b == '\r') {
+    // Line ending, dropped
+  } else if (b < 0x20 || b > 0x7E) {
+    hostLength = 0;  // Binary payload (e.g. HTTPDATA body): keep only the text after it
+  } else {
+    if (hostLength >= sizeof(hostLine) - 1) {
+      memmove(hostLine, hostLine + 1, hostLength - 1);
+      hostLength--;
+    }
+    hostLine[hostLength++] = (char)b;
+  }
+  return 1;
+}
+
+bool ModemTraceReplay::matches(const char* text, size_t length) {
+  if (length == 1 && text[0] == '*') {
+    return true;
+  }
+  if (length > hostLength) {
+    return false;
+  }
+  return memcmp(hostLine + hostLength - length, text, length) == 0;
+}
+
+void ModemTraceReplay::onHostLine() {
+  hostLines++;
+  if (hostByteNs != byteNs) {
+    garbled++;  // The modem cannot make sense of it
+    return;
+  }
+  // The modem reacts once the whole line has arrived
+  uint32_t now = micros();
+  if ((int32_t)(txDoneUs - now) > 0) {
+    now = txDoneUs;
+  }
+  
+  if (expectHost && matches(expected, expectedLength)) {
+    lastEventUs = now;
+    loadNext();
+    return;
+  }
+  
+  // The host moved on (e.g. timed out): find the entry it is at now.
+  // Unread bytes of the current RX event are dropped.
+  const char* scan = cursor;
+  const char* line;
+  size_t length;
+  uint32_t passed = expectHost ? 1 : 0;
+  while (nextLine(&scan, &line, &length)) {
+    if (line[0] != '>') {
+      continue;
+    }
+    size_t skip = 1;
+    while (skip < length && line[skip] == ' ') {
+      skip++;
+    }
+    if (matches(line + skip, length - skip)) {
+      skipped += passed;
+      cursor = scan;
+      lastEventUs = now;
+      loadNext();
+      return;
+    }
+    passed++;
+  }
+  
+  mismatches++;
+}
+
+// ============================================
+// REPLAY: STATUS
+// ============================================
+bool ModemTraceReplay::isFinished() {
+  service();
+  if (finished) {
+    return true;
+  }
+  if (expectHost) {
+    return false;
+  }
+  // Only modem output left (e.g. the tail of a final OK the host never read)
+  const char* scan = cursor;
+  const char* line;
+  size_t length;
+  while (nextLine(&scan, &line, &length)) {
+    if (line[0] == '>') {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t ModemTraceReplay::getMismatches() {
+  return mismatches;
+}
+
+uint32_t ModemTraceReplay::getSkipped() {
+  return skipped;
+}
+
+uint32_t ModemTraceReplay::getHostLines() {
+  return hostLines;
+}
+
+uint32_t ModemTraceReplay::getGarbled() {
+  return garbled;
+}
+
+// ============================================
+// CMUX REPLAY
+// ============================================
+ModemCmuxReplay::ModemCmuxReplay() {
+  begin("", nullptr, 115200);
+}
+
+void ModemCmuxReplay::begin(const char* plainTrace, const char* const* channelTraces, uint32_t baudRate) {
+  plain.begin(plainTrace, baudRate);
+  for (uint8_t i = 0; i < MODEM_TRACE_CMUX_CHANNELS; i++) {
+    const char* trace = (channelTraces != nullptr && channelTraces[i] != nullptr) ? channelTraces[i] : "";
+    channels[i].begin(trace, baudRate);
+  }
+  muxed = false;
+  closing = false;
+  outLength = 0;
+  outPos = 0;
+  frameLength = 0;
+  inFrame = false;
+  frames = 0;
+  frameErrors = 0;
+}
+
+void ModemCmuxReplay::setJitter(uint8_t percent, uint32_t seed) {
+  plain.setJitter(percent, seed);
+  for (uint8_t i = 0; i < MODEM_TRACE_CMUX_CHANNELS; i++) {
+    channels[i].setJitter(percent, seed + i + 1);
+  }
+}
+
+// CRC-8 (reflected x^8 + x^2 + x + 1) one bit at a time
+uint8_t ModemCmuxReplay::fcs(const uint8_t* data, size_t length) {
+  uint8_t crc = 0xFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x01) ? (crc >> 1) ^ 0xE0 : crc >> 1;
+    }
+  }
+  return 0xFF - crc;
+}
+
+void ModemCmuxReplay::queueFrame(uint8_t dlci, uint8_t control, const uint8_t* info, size_t length) {
+  if (outPos == outLength) {
+    outPos = 0;
+    outLength = 0;
+  }
+  if (outLength + length + 6 > sizeof(out)) {
+    return;
+  }
+  uint8_t* p = out + outLength;
+  p[0] = 0xF9;
+  p[1] = (uint8_t)(dlci << 2 | 0x01);
+  p[2] = control;
+  p[3] = (uint8_t)(length << 1 | 0x01);
+  memcpy(p + 4, info, length);
+  p[4 + length] = fcs(p + 1, 3);
+  p[5 + length] = 0xF9;
+  outLength += length + 6;
+}
+
+// Frame what the channel replays have due
+void ModemCmuxReplay::pump() {
+  uint8_t info[MODEM_TRACE_CMUX_FRAME];
+  for (uint8_t i = 0; i < MODEM_TRACE_CMUX_CHANNELS; i++) {
+    while (channels[i].available() > 0) {
+      if (outPos == outLength) {
+        outPos = 0;
+        outLength = 0;
+      }
+      if (outLength + sizeof(info) + 6 > sizeof(out)) {
+        return;
+      }
+      size_t n = 0;
+      int c;
+      while (n < sizeof(info) && (c = channels[i].read()) >= 0) {
+        info[n++] = (uint8_t)c;
+      }
+      queueFrame(i + 1, 0xEF, info, n);
+    }
+  }
+}
+
+int ModemCmuxReplay::available() {
+  if (!muxed) {
+    return plain.available();
+  }
+  pump();
+  if (outPos == outLength && closing) {
+    muxed = false;  // Close-down response read: plain AT again
+    closing = false;
+    return plain.available();
+  }
+  return (int)(outLength - outPos);
+}
+
+int ModemCmuxReplay::read() {
+  if (available() <= 0) {
+    return -1;
+  }
+  return muxed ? out[outPos++] : plain.read();
+}
+
+int ModemCmuxReplay::peek() {
+  if (available() <= 0) {
+    return -1;
+  }
+  return muxed ? out[outPos] : plain.peek();
+}
+
+size_t ModemCmuxReplay::write(uint8_t b) {
+  if (!muxed && b == 0xF9) {
+    muxed = true;  // First frame after AT+CMUX
+  }
+  if (!muxed) {
+    return plain.write(b);
+  }
+  onHostByte(b);
+  return 1;
+}
+
+// Frames are taken by their length field: basic option has no byte stuffing
+void ModemCmuxReplay::onHostByte(uint8_t b) {
+  if (!inFrame) {
+    inFrame = (b == 0xF9);
+    frameLength = 0;
+    return;
+  }
+  if (frameLength == 0 && b == 0xF9) {
+    return;
+  }
+  if (frameLength >= sizeof(frame)) {
+    frameErrors++;
+    inFrame = false;
+    return;
+  }
+  frame[frameLength++] = b;
+  if (frameLength < 3) {
+    return;
+  }
+  size_t headerLength = (frame[2] & 0x01) ? 3 : 4;
+  if (frameLength < headerLength) {
+    return;
+  }
+  size_t infoLength = (frame[2] >> 1) | ((headerLength == 4) ? (size_t)frame[3] << 7 : 0);
+  if (frameLength < headerLength + infoLength + 2) {
+    return;
+  }
+  if (b == 0xF9 && fcs(frame, headerLength) == frame[headerLength + infoLength]) {
+    onHostFrame(headerLength, infoLength);
+  } else {
+    frameErrors++;
+  }
+  inFrame = (b == 0xF9);
+  frameLength = 0;
+}
+
+void ModemCmuxReplay::onHostFrame(size_t headerLength, size_t infoLength) {
+  uint8_t dlci = frame[0] >> 2;
+  uint8_t control = frame[1] & ~0x10;
+  const uint8_t* info = frame + headerLength;
+  frames++;
+  
+  if (control == 0x2F || control == 0x43) {
+    queueFrame(dlci, 0x73, nullptr, 0);  // SABM/DISC -> UA
+    return;
+  }
+  if (control != 0xEF) {
+    frameErrors++;
+    return;
+  }
+  if (dlci >= 1 && dlci <= MODEM_TRACE_CMUX_CHANNELS) {
+    for (size_t i = 0; i < infoLength; i++) {
+      channels[dlci - 1].write(info[i]);
+    }
+    return;
+  }
+  
+  // DLCI 0: answer MSC and close-down commands with the same values
+  if (dlci != 0 || infoLength < 2 || !(info[0] & 0x02)) {
+    return;
+  }
+  uint8_t type = info[0] >> 2;
+  if (type == 0x38 || type == 0x30) {
+    uint8_t response[8];
+    size_t n = (infoLength < sizeof(response)) ? infoLength : sizeof(response);
+    memcpy(response, info, n);
+    response[0] &= ~0x02;
+    queueFrame(0, 0xEF, response, n);
+    closing = closing || (type == 0x30);
+  }
+}
+
+bool ModemCmuxReplay::isFinished() {
+  bool done = plain.isFinished();
+  for (uint8_t i = 0; i < MODEM_TRACE_CMUX_CHANNELS; i++) {
+    done = done && channels[i].isFinished();
+  }
+  return done;
+}
+
+bool ModemCmuxReplay::isMultiplexed() {
+  return muxed;
+}
+
+uint32_t ModemCmuxReplay::getMismatches() {
+  uint32_t total = plain.getMismatches();
+  for (uint8_t i = 0; i < MODEM_TRACE_CMUX_CHANNELS; i++) {
+    total += channels[i].getMismatches();
+  }
+  return total;
+}
+
+uint32_t ModemCmuxReplay::getSkipped() {
+  uint32_t total = plain.getSkipped();
+  for (uint8_t i = 0; i < MODEM_TRACE_CMUX_CHANNELS; i++) {
+    total += channels[i].getSkipped();
+  }
+  return total;
+}
+
+uint32_t ModemCmuxReplay::getHostLines() {
+  uint32_t total = plain.getHostLines();
+  for (uint8_t i = 0; i < MODEM_TRACE_CMUX_CHANNELS; i++) {
+    total += channels[i].getHostLines();
+  }
+  return total;
+}
+
+uint32_t ModemCmuxReplay::getFrames() {
+  return frames;
+}
+
+uint32_t ModemCmuxReplay::getFrameErrors() {
+  return frameErrors;
+}
+
+// ============================================
+// RECORDER
+// ============================================
+ModemTraceRecorder::ModemTraceRecorder() {
+  modem = nullptr;
+  sink = nullptr;
+  rxLength = 0;
+  hostLength = 0;
+  lastEventUs = 0;
+  rxFirstUs = 0;
+}
+
+void ModemTraceRecorder::begin(Stream* modemStream, Print* traceSink) {
+  modem = modemStream;
+  sink = traceSink;
+  rxLength = 0;
+  hostLength = 0;
+  lastEventUs = micros();
+  sink->print("# Recorded modem trace\n");
+}
+
+int ModemTraceRecorder::available() {
+  return modem->available();
+}
+
+int ModemTraceRecorder::peek() {
+  return modem->peek();
+}
+
+int ModemTraceRecorder::read() {
+  int c = modem->read();
+  if (c >= 0) {
+    if (rxLength == 0) {
+      rxFirstUs = micros();
+    }
+    rx[rxLength++] = (uint8_t)c;
+    if (rxLength >= sizeof(rx)) {
+      emitRx();
+    }
+  }
+  return c;
+}
+
+size_t ModemTraceRecorder::write(uint8_t b) {
+  if (rxLength > 0) {
+    emitRx();
+  }
+  
+  if (b == '\n') {
+    emitHostLine();
+  } else if (b < 0x20 || b > 0x7E) {
+    if (b != '\r') {
+      hostLength = 0;  // Binary payload: record only the command text after it
+    }
+  } else {
+    if (hostLength >= sizeof(hostLine) - 1) {
+      memmove(hostLine, hostLine + 1, hostLength - 1);
+      hostLength--;
+    }
+    hostLine[hostLength++] = (char)b;
+  }
+  return modem->write(b);
+}
+
+void ModemTraceRecorder::emitRx() {
+  sink->printf("< %lu ", (unsigned long)((rxFirstUs - lastEventUs) / 1000));
+  for (size_t i = 0; i < rxLength; i++) {
+    uint8_t c = rx[i];
+    switch (c) {
+      case '\r': sink->print("\\r"); break;
+      case '\n': sink->print("\\n"); break;
+      case 0x00: sink->print("\\0"); break;
+      case '\\': sink->print("\\\\"); break;
+      default:
+        if (c < 0x20 || c > 0x7E) {
+          sink->printf("\\x%02X", c);
+        } else {
+          sink->write(c);
+        }
+        break;
+    }
+  }
+  sink->print("\n");
+  lastEventUs = rxFirstUs;
+  rxLength = 0;
+}
+
+void ModemTraceRecorder::emitHostLine() {
+  hostLine[hostLength] = '\0';
+  sink->printf("> %s\n", hostLine);
+  lastEventUs = micros();
+  hostLength = 0;
+}
+
+void ModemTraceRecorder::finish() {
+  if (rxLength > 0) {
+    emitRx();
+  }
+}
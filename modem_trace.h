@@ -0,0 +1,219 @@
+/*
+ * modem_trace.h
+ * 
+ * Record and replay modem UART sessions
+ * 
+ * Trace format (text, one event per line):
+ *   # comment                       ignored, as are blank lines
+ *   > AT+CPIN?                      line the host sends (CR/LF stripped); matches
+ *                                   if the sent line ends with it, "*" matches any
+ *   < 35 \r\nERROR\r\n              bytes the modem sends, 35 ms after the
+ *                                   previous event; escapes \r \n \0 \\ \xHH
+ *   = 921600                        the modem's UART rate from here on (AT+IPR)
+ * 
+ * ModemTraceReplay is a Stream that plays a trace back as a simulated modem:
+ * RX bytes become readable at their recorded time, paced at the baud rate,
+ * and each host line advances the trace to the matching '>' entry. Hand the
+ * stream to LTEManager::initWithStream() to run real bring-up/HTTP code
+ * against it; setJitter() perturbs the modem's timing for fuzz runs.
+ * Host bytes take their wire time too: the modem's answer to a host line
+ * starts no earlier than the line's last byte would have arrived. setBaudRate() is the
+ * host UART rate; while it differs from the modem's, RX bytes read as junk
+ * and host lines are lost (counted by getGarbled()).
+ * 
+ * ModemCmuxReplay is the same behind GSM 07.10 framing (cmux.h): one trace
+ * per virtual channel, plus a plain trace for the AT mode around the mux.
+ * 
+ * ModemTraceRecorder wraps the real UART stream (LTEManager::setStream) and
+ * writes the same format to a Print sink (e.g. a LittleFS file). RX times
+ * are taken when the host reads, so they are late by up to one poll
+ * interval of the reader (~10 ms in LTEManager::readSerial).
+ */
+
+#ifndef MODEM_TRACE_H
+#define MODEM_TRACE_H
+
+#include <Arduino.h>
+
+#define MODEM_TRACE_MAX_RX    512   // Longest single RX event (decoded bytes)
+#define MODEM_TRACE_MAX_LINE  128   // Host line kept for matching (tail)
+#define MODEM_TRACE_CMUX_CHANNELS 3   // DLCIs 1..3 (as cmux.h opens them)
+#define MODEM_TRACE_CMUX_FRAME    127 // Info bytes per frame, both ways
+
+// ============================================
+// TRACE REPLAY (simulated modem)
+// ============================================
+class ModemTraceReplay : public Stream {
+public:
+  ModemTraceReplay();
+  
+  // Start replaying a trace (text must stay valid while replaying)
+  void begin(const char* trace, uint32_t baudRate);
+  
+  // Randomize each RX delay by +/- percent (0 = exact replay); applies from
+  // the next begin(). The same seed gives the same run.
+  void setJitter(uint8_t percent, uint32_t seed);
+  
+  // Host UART rate change (LTEManager::setBaudRateHook)
+  void setBaudRate(uint32_t baudRate);
+  
+  // Every host line in the trace has been sent (modem output may remain)
+  bool isFinished();
+  
+  // Host lines that matched no later '>' entry
+  uint32_t getMismatches();
+  
+  // '>' entries skipped because the host moved on to a later one
+  uint32_t getSkipped();
+  
+  uint32_t getHostLines();
+  
+  // Host lines sent while the host and modem rates differed
+  uint32_t getGarbled();
+  
+  // Stream
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t b) override;
+  using Print::write;
+
+private:
+  const char* cursor;          // Next unparsed trace line
+  bool finished;
+  
+  // Current event
+  bool expectHost;             // Waiting for a '>' line
+  const char* expected;        // Expected host text (points into the trace)
+  size_t expectedLength;
+  uint8_t rx[MODEM_TRACE_MAX_RX];
+  size_t rxLength;
+  size_t rxPos;
+  uint32_t rxStartUs;
+  
+  uint32_t lastEventUs;
+  uint32_t byteNs;             // Modem side
+  uint32_t hostByteNs;
+  uint32_t txDoneUs;           // When the last host byte is on the modem side
+  uint32_t txFractionNs;
+  uint8_t jitterPercent;
+  uint32_t jitterSeed;
+  uint32_t rng;
+  
+  char hostLine[MODEM_TRACE_MAX_LINE];
+  size_t hostLength;
+  uint32_t hostLines;
+  uint32_t mismatches;
+  uint32_t skipped;
+  uint32_t garbled;
+  
+  void loadNext();
+  void service();
+  size_t rxDue();
+  void onHostLine();
+  bool matches(const char* text, size_t length);
+  static bool nextLine(const char** cursor, const char** line, size_t* length);
+  static size_t decode(const char* text, size_t length, uint8_t* out, size_t outSize);
+};
+
+// ============================================
+// CMUX REPLAY (simulated multiplexing modem)
+// ============================================
+// Plays the plain trace until the host's first frame. Then host UIH frames
+// go to the replay of their DLCI and its output comes back as UIH frames;
+// SABM/DISC get UA and MSC is answered. After the close-down command the
+// plain trace continues. Frames are checked with a bitwise FCS written
+// apart from cmux.cpp, so the two do not share a mistake. Each channel is
+// paced on its own (frame overhead is not).
+class ModemCmuxReplay : public Stream {
+public:
+  ModemCmuxReplay();
+  
+  // channelTraces[i] plays on DLCI i + 1 (nullptr = silent channel); all
+  // texts must stay valid while replaying
+  void begin(const char* plainTrace, const char* const* channelTraces, uint32_t baudRate);
+  
+  void setJitter(uint8_t percent, uint32_t seed);
+  
+  // Every trace is finished
+  bool isFinished();
+  bool isMultiplexed();
+  
+  // Totals over the plain trace and every channel
+  uint32_t getMismatches();
+  uint32_t getSkipped();
+  uint32_t getHostLines();
+  
+  // Host frames: valid ones, and ones with a bad FCS, length or closing flag
+  uint32_t getFrames();
+  uint32_t getFrameErrors();
+  
+  // Stream
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t b) override;
+  using Print::write;
+
+private:
+  ModemTraceReplay plain;
+  ModemTraceReplay channels[MODEM_TRACE_CMUX_CHANNELS];
+  bool muxed;
+  bool closing;                // Close-down answered: plain once it is read
+  
+  // Modem frames waiting for the host
+  uint8_t out[4 * (MODEM_TRACE_CMUX_FRAME + 6)];
+  size_t outLength;
+  size_t outPos;
+  
+  // Host frame being received (after the opening flag)
+  uint8_t frame[MODEM_TRACE_CMUX_FRAME + 8];
+  size_t frameLength;
+  bool inFrame;
+  uint32_t frames;
+  uint32_t frameErrors;
+  
+  void onHostByte(uint8_t b);
+  void onHostFrame(size_t headerLength, size_t infoLength);
+  void queueFrame(uint8_t dlci, uint8_t control, const uint8_t* info, size_t length);
+  void pump();
+  static uint8_t fcs(const uint8_t* data, size_t length);
+};
+
+// ============================================
+// TRACE RECORDER (wraps the real UART)
+// ============================================
+class ModemTraceRecorder : public Stream {
+public:
+  ModemTraceRecorder();
+  
+  // Record traffic passing through modem into sink
+  void begin(Stream* modem, Print* sink);
+  
+  // Write any buffered RX as an event (call before closing the sink)
+  void finish();
+  
+  // Stream
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t b) override;
+  using Print::write;
+
+private:
+  Stream* modem;
+  Print* sink;
+  uint32_t lastEventUs;
+  
+  uint8_t rx[MODEM_TRACE_MAX_RX];
+  size_t rxLength;
+  uint32_t rxFirstUs;
+  
+  char hostLine[MODEM_TRACE_MAX_LINE];
+  size_t hostLength;
+  
+  void emitRx();
+  void emitHostLine();
+};
+
+#endif // MODEM_TRACE_H
@@ -0,0 +1,281 @@
+/*
+ * modem_trace_corpus.h
+ * 
+ * Modem trace corpus for ModemTraceReplay
+ * 
+ * Each trace reproduces a failure mode from LTE_TROUBLESHOOTING.md that
+ * LTEManager has special-case handling for. They were written from the
+ * troubleshooting notes and SIM7070 logs, not byte-captured; replace them
+ * with recordings (esp32_lte_replay REPLAY_RECORD 1) as they come in.
+ * 
+ * The replay sketch passes TRACE_APN / TRACE_URL(2), the TRACE_COAP_* values
+ * and TRACE_BAUD_RATES, which the '>' lines below expect. The TRACE_CMUX_*
+ * traces expect LTE_CMUX_FRAME_SIZE 127 and LTE_SOCKET_CHUNK 1460.
+ */
+
+#ifndef MODEM_TRACE_CORPUS_H
+#define MODEM_TRACE_CORPUS_H
+
+#define TRACE_APN  "replay.apn"
+#define TRACE_URL  "http://replay.example/audio/0042"
+#define TRACE_URL2 "http://replay.example/audio/0043"
+
+// TRACE_COAP_CONTROL: the MIDs/tokens in the server's datagrams follow from
+// the client seed, and the CASEND sizes from the query and body length
+#define TRACE_COAP_HOST   "replay.example"
+#define TRACE_COAP_PORT   5683
+#define TRACE_COAP_SEED   0x5EED
+#define TRACE_COAP_QUERY  "uid=04A1B2C3D4&size=4096&stats=rms=812,peak=20133,clip=0"
+#define TRACE_COAP_BODY   656   // Start request body length (two Block1 blocks)
+
+// ============================================
+// CPIN? ERROR, THEN CREG REGISTERS (checkNetwork)
+// ============================================
+// SIM not ready straight after power-on; LTEManager carries on to CREG
+static const char TRACE_CPIN_ERROR[] =
+  "# AT+CPIN? returns ERROR while the SIM initializes\n"
+  "> AT+CPIN?\n"
+  "< 40 \\r\\nERROR\\r\\n\n"
+  "> AT+CREG?\n"
+  "< 30 \\r\\n+CREG: 0,2\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CREG?\n"
+  "< 30 \\r\\n+CREG: 0,2\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CREG?\n"
+  "< 30 \\r\\n+CREG: 0,1\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CSQ\n"
+  "< 25 \\r\\n+CSQ: 18,99\\r\\n\\r\\nOK\\r\\n\n";
+
+// ============================================
+// CGDCONT DROPPED BEFORE +CFUN: 1 (configureBearerAPN)
+// ============================================
+// RF still off on the first poll; the first CGDCONT after CFUN:1 gets no
+// answer at all and only the retry is acknowledged
+static const char TRACE_CGDCONT_DROPPED[] =
+  "# +CFUN: 0 first, then 1\n"
+  "> AT+CFUN?\n"
+  "< 35 \\r\\n+CFUN: 0\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CFUN?\n"
+  "< 35 \\r\\n+CFUN: 1\\r\\n\\r\\nOK\\r\\n\n"
+  "# First CGDCONT is silently dropped\n"
+  "> AT+CGDCONT=0,\"IP\",\"" TRACE_APN "\"\n"
+  "> AT+CGDCONT=0,\"IP\",\"" TRACE_APN "\"\n"
+  "< 120 \\r\\nOK\\r\\n\n";
+
+// ============================================
+// LEADING NULS, THEN AN HTTP GET (httpGet)
+// ============================================
+// Modem emits NUL bytes ahead of the first response after waking
+static const char TRACE_NUL_HTTP_GET[] =
+  "# NULs before OK\n"
+  "> AT+HTTPINIT\n"
+  "< 20 \\0\\0\\0\\0\\r\\nOK\\r\\n\n"
+  "> AT+HTTPPARA=\"URL\",\"" TRACE_URL "\"\n"
+  "< 15 \\r\\nOK\\r\\n\n"
+  "> AT+HTTPPARA=\"CID\",\"1\"\n"
+  "< 15 \\r\\nOK\\r\\n\n"
+  "> AT+HTTPACTION=0\n"
+  "< 20 \\r\\nOK\\r\\n\n"
+  "< 1850 \\r\\n+HTTPACTION: 0,200,64\\r\\n\n"
+  "> AT+HTTPREAD\n"
+  "< 40 \\r\\n+HTTPREAD: 64\\r\\n"
+  "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef\\r\\nOK\\r\\n\n"
+  "> AT+HTTPTERM\n"
+  "< 15 \\r\\nOK\\r\\n\n";
+
+// ============================================
+// SOCKET HTTP: KEEP-ALIVE, CHUNKED RESPONSE (HttpClient)
+// ============================================
+// Two GETs on one connection; the first response is sized, the second
+// chunked. The request bytes after each "> " prompt are matched line by line.
+static const char TRACE_SOCKET_HTTP[] =
+  "> AT+CASSLCFG=0,\"SSL\",0\n"
+  "< 15 \\r\\nOK\\r\\n\n"
+  "> AT+CAOPEN=0,0,\"TCP\",\"replay.example\",80\n"
+  "< 350 \\r\\n+CAOPEN: 0,0\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CASEND=0,50\n"
+  "< 10 \\r\\n> \n"
+  "> GET /audio/0042 HTTP/1.1\n"
+  "> Host: replay.example\n"
+  ">\n"
+  "< 20 \\r\\nOK\\r\\n\n"
+  "# Response not in yet: CARECV reports 0 bytes and the client polls again\n"
+  "> AT+CARECV=0,512\n"
+  "< 10 \\r\\n+CARECV: 0\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CARECV=0,512\n"
+  "< 180 \\r\\n+CARECV: 55,HTTP/1.1 200 OK\\r\\nContent-Length: 16\\r\\n\\r\\n"
+  "0123456789abcdef\\r\\nOK\\r\\n\n"
+  "# Second request reuses the socket (no CAOPEN)\n"
+  "> AT+CASEND=0,50\n"
+  "< 10 \\r\\n> \n"
+  "> GET /audio/0043 HTTP/1.1\n"
+  "> Host: replay.example\n"
+  ">\n"
+  "< 20 \\r\\nOK\\r\\n\n"
+  "> AT+CARECV=0,512\n"
+  "< 200 \\r\\n+CARECV: 73,HTTP/1.1 200 OK\\r\\nTransfer-Encoding: chunked\\r\\n\\r\\n"
+  "5\\r\\nhello\\r\\n6\\r\\n world\\r\\n0\\r\\n\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CACLOSE=0\n"
+  "< 15 \\r\\nOK\\r\\n\n";
+
+// ============================================
+// COAP CONTROL EXCHANGE (CoapClient over UDP socket 2)
+// ============================================
+// Recorded against a stand-in CoAP server: upload/start with a Block1 body
+// (2.31 Continue, then 2.01 piggybacked), then upload/status answered as a
+// separate response (empty ACK, CON 2.05 that the client ACKs)
+static const char TRACE_COAP_CONTROL[] =
+  "> AT+CASSLCFG=2,\"SSL\",0\n"
+  "< 20 \\r\\nOK\\r\\n\n"
+  "> AT+CAOPEN=2,0,\"UDP\",\"replay.example\",5683\n"
+  "< 120 \\r\\n+CAOPEN: 2,0\\r\\n\\r\\nOK\\r\\n\n"
+  "# Block 0 of the start request, M=1\n"
+  "> AT+CASEND=2,597\n"
+  "< 10 \\r\\n> \n"
+  "< 20 \\r\\nOK\\r\\n\n"
+  "> AT+CARECV=2,672\n"
+  "< 10 \\r\\n+CARECV: 0\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CARECV=2,672\n"
+  "< 15 \\r\\n+CARECV: 11,d_\\x9Bcd\\xB6\\xD3B\\xD1\\x0E\\r\\r\\nOK\\r\\n\n"
+  "# Block 1, last\n"
+  "> AT+CASEND=2,229\n"
+  "< 10 \\r\\n> \n"
+  "< 20 \\r\\nOK\\r\\n\n"
+  "> AT+CARECV=2,672\n"
+  "< 10 \\r\\n+CARECV: 0\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CARECV=2,672\n"
+  "< 10 \\r\\n+CARECV: 0\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CARECV=2,672\n"
+  "< 15 \\r\\n+CARECV: 47,dA\\x9Bdd\\xB6\\xD3B\\xC12\\xD1\\x02\\x15\\xFF"
+  "{\"upload_id\":\"c0ffee\",\"offset\":0}\\r\\nOK\\r\\n\n"
+  "# Status: empty ACK first, the response follows as a CON\n"
+  "> AT+CASEND=2,32\n"
+  "< 10 \\r\\n> \n"
+  "< 20 \\r\\nOK\\r\\n\n"
+  "> AT+CARECV=2,672\n"
+  "< 10 \\r\\n+CARECV: 0\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CARECV=2,672\n"
+  "< 15 \\r\\n+CARECV: 4,`\\0\\x9Be\\r\\nOK\\r\\n\n"
+  "> AT+CARECV=2,672\n"
+  "< 10 \\r\\n+CARECV: 0\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CARECV=2,672\n"
+  "< 10 \\r\\n+CARECV: 0\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CARECV=2,672\n"
+  "< 15 \\r\\n+CARECV: 26,DEq\\0\\xF2,\\x06\\x88\\xC12\\xFF{\"offset\":4096}\\r\\nOK\\r\\n\n"
+  "# Empty ACK for the separate response\n"
+  "> AT+CASEND=2,4\n"
+  "< 10 \\r\\n> \n"
+  "< 20 \\r\\nOK\\r\\n\n"
+  "> AT+CACLOSE=2\n"
+  "< 20 \\r\\nOK\\r\\n\n";
+
+// ============================================
+// UART RATE NEGOTIATION (LTEManager::negotiateBaudRate)
+// ============================================
+// The modem answers AT+IPR at the old rate, then switches ("= <baud>").
+// Boot rate 115200 (LTE_BAUD_RATE); offered rates:
+#define TRACE_BAUD_RATES  { 921600, 230400 }
+
+// CTS flow control, then the fastest rate holds for all three probes
+static const char TRACE_BAUD_NEGOTIATION[] =
+  "> AT+IFC=0,2\n"
+  "< 15 \\r\\nOK\\r\\n\n"
+  "> AT+IPR=921600\n"
+  "< 15 \\r\\nOK\\r\\n\n"
+  "= 921600\n"
+  "> AT\n"
+  "< 5 \\r\\nOK\\r\\n\n"
+  "> AT\n"
+  "< 5 \\r\\nOK\\r\\n\n"
+  "> AT\n"
+  "< 5 \\r\\nOK\\r\\n\n";
+
+// 921600 is accepted but the first probe's answer arrives corrupted; the
+// host takes the modem back to 115200 and settles on 230400
+static const char TRACE_BAUD_FALLBACK[] =
+  "> AT+IPR=921600\n"
+  "< 15 \\r\\nOK\\r\\n\n"
+  "= 921600\n"
+  "> AT\n"
+  "< 5 \\r\\nO\\xC6\\x80\\r\\n\n"
+  "> AT+IPR=115200\n"
+  "< 15 \\r\\nOK\\r\\n\n"
+  "= 115200\n"
+  "> AT\n"
+  "< 5 \\r\\nOK\\r\\n\n"
+  "> AT+IPR=230400\n"
+  "< 15 \\r\\nOK\\r\\n\n"
+  "= 230400\n"
+  "> AT\n"
+  "< 5 \\r\\nOK\\r\\n\n"
+  "> AT\n"
+  "< 5 \\r\\nOK\\r\\n\n"
+  "> AT\n"
+  "< 5 \\r\\nOK\\r\\n\n";
+
+// Negotiated to 921600, then the link degrades: three commands in a row go
+// unanswered and the host steps down to 230400 on its own
+static const char TRACE_BAUD_STEP_DOWN[] =
+  "> AT+IPR=921600\n"
+  "< 15 \\r\\nOK\\r\\n\n"
+  "= 921600\n"
+  "> AT\n"
+  "< 5 \\r\\nOK\\r\\n\n"
+  "> AT\n"
+  "< 5 \\r\\nOK\\r\\n\n"
+  "> AT\n"
+  "< 5 \\r\\nOK\\r\\n\n"
+  "> AT+CNACT?\n"
+  "> AT+CNACT?\n"
+  "> AT+CNACT?\n"
+  "> AT+IPR=230400\n"
+  "< 15 \\r\\nOK\\r\\n\n"
+  "= 230400\n"
+  "> AT\n"
+  "< 5 \\r\\nOK\\r\\n\n"
+  "> AT+CNACT?\n"
+  "< 20 \\r\\n+CNACT: 0,1,\"10.0.0.5\"\\r\\n\\r\\nOK\\r\\n\n";
+
+// ============================================
+// CMUX: SIGNAL AND URCS DURING AN UPLOAD
+// ============================================
+// Plain AT before AT+CMUX and after the close-down (ModemCmuxReplay). On the
+// data channel four AT+CASEND chunks take a second each to be acknowledged
+// (slow uplink); meanwhile the control channel answers AT+CSQ and the URC
+// channel reports a registration change.
+static const char TRACE_CMUX_PLAIN[] =
+  "> AT+CMUX=0,0,,127\n"
+  "< 20 \\r\\nOK\\r\\n\n"
+  "> AT+CSQ\n"
+  "< 20 \\r\\n+CSQ: 20,99\\r\\n\\r\\nOK\\r\\n\n";
+
+static const char TRACE_CMUX_CONTROL[] =
+  "> AT+CSQ\n"
+  "< 15 \\r\\n+CSQ: 18,99\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CSQ\n"
+  "< 15 \\r\\n+CSQ: 18,99\\r\\n\\r\\nOK\\r\\n\n"
+  "> AT+CSQ\n"
+  "< 15 \\r\\n+CSQ: 18,99\\r\\n\\r\\nOK\\r\\n\n";
+
+static const char TRACE_CMUX_DATA[] =
+  "> AT+CASEND=0,1460\n"
+  "< 10 \\r\\n> \n"
+  "> *\n"
+  "< 1000 \\r\\nOK\\r\\n\n"
+  "> AT+CASEND=0,1460\n"
+  "< 10 \\r\\n> \n"
+  "> *\n"
+  "< 1000 \\r\\nOK\\r\\n\n"
+  "> AT+CASEND=0,1460\n"
+  "< 10 \\r\\n> \n"
+  "> *\n"
+  "< 1000 \\r\\nOK\\r\\n\n"
+  "> AT+CASEND=0,1460\n"
+  "< 10 \\r\\n> \n"
+  "> *\n"
+  "< 1000 \\r\\nOK\\r\\n\n";
+
+static const char TRACE_CMUX_URC[] =
+  "< 300 \\r\\n+CEREG: 5\\r\\n\n"
+  "< 400 \\r\\n+CEREG: 1\\r\\n\n";
+
+#endif // MODEM_TRACE_CORPUS_H
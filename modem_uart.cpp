@@ -0,0 +1,279 @@
+/*
+ * modem_uart.cpp
+ * 
+ * Implementation of the pattern-detecting modem UART
+ */
+
+#include "modem_uart.h"
+#include "logger.h"
+
+ModemUart::ModemUart() {
+  port = UART_NUM_2;
+  open = false;
+  peeked = -1;
+  events = nullptr;
+  dataReady = nullptr;
+  eventTask = nullptr;
+  receiveHook = nullptr;
+  memset(&stats, 0, sizeof(stats));
+}
+
+// ============================================
+// BEGIN / END
+// ============================================
+bool ModemUart::begin(uint8_t uartPort, uint32_t baudRate, int8_t rxPin, int8_t txPin) {
+  if (open) {
+    end();
+  }
+  port = (uart_port_t)uartPort;
+  
+  uart_config_t config;
+  memset(&config, 0, sizeof(config));
+  config.baud_rate = baudRate;
+  config.data_bits = UART_DATA_8_BITS;
+  config.parity = UART_PARITY_DISABLE;
+  config.stop_bits = UART_STOP_BITS_1;
+  config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+  config.source_clk = UART_SCLK_APB;
+  
+  if (uart_driver_install(port, LTE_UART_RX_RING, LTE_UART_TX_RING, LTE_UART_EVENT_QUEUE, &events, 0) != ESP_OK) {
+    LOG_E("UART", "Driver install failed");
+    return false;
+  }
+  if (uart_param_config(port, &config) != ESP_OK ||
+      uart_set_pin(port, txPin, rxPin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK) {
+    LOG_E("UART", "Port configuration failed");
+    uart_driver_delete(port);
+    return false;
+  }
+  
+  // Interrupt on each '\n'; positions queue up for readLine()
+  uart_enable_pattern_det_baud_intr(port, '\n', 1, 9, 0, 0);
+  uart_pattern_queue_reset(port, LTE_UART_PATTERN_QUEUE);
+  
+  dataReady = xSemaphoreCreateBinary();
+  if (dataReady == nullptr ||
+      xTaskCreate(eventTaskEntry, "modem_uart", 2048, this, configMAX_PRIORITIES - 2, &eventTask) != pdPASS) {
+    LOG_E("UART", "Event task creation failed");
+    if (dataReady != nullptr) {
+      vSemaphoreDelete(dataReady);
+      dataReady = nullptr;
+    }
+    uart_driver_delete(port);
+    return false;
+  }
+  
+  open = true;
+  peeked = -1;
+  memset(&stats, 0, sizeof(stats));
+  Logger::printf(LOG_INFO, "UART", "Modem UART%d: %lu baud, %u byte RX ring, line detection",
+                 port, (unsigned long)baudRate, LTE_UART_RX_RING);
+  return true;
+}
+
+void ModemUart::end() {
+  if (!open) {
+    return;
+  }
+  vTaskDelete(eventTask);
+  eventTask = nullptr;
+  uart_driver_delete(port);
+  vSemaphoreDelete(dataReady);
+  dataReady = nullptr;
+  events = nullptr;
+  open = false;
+}
+
+void ModemUart::setBaudRate(uint32_t baudRate) {
+  if (open) {
+    uart_wait_tx_done(port, pdMS_TO_TICKS(100));
+    uart_set_baudrate(port, baudRate);
+  }
+}
+
+bool ModemUart::setFlowControl(int8_t ctsPin) {
+  if (!open) {
+    return false;
+  }
+  if (ctsPin < 0) {
+    return uart_set_hw_flow_ctrl(port, UART_HW_FLOWCTRL_DISABLE, 0) == ESP_OK;
+  }
+  return uart_set_pin(port, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, ctsPin) == ESP_OK &&
+         uart_set_hw_flow_ctrl(port, UART_HW_FLOWCTRL_CTS, 0) == ESP_OK;
+}
+
+// ============================================
+// EVENT TASK
+// ============================================
+void ModemUart::eventTaskEntry(void* arg) {
+  ModemUart* self = (ModemUart*)arg;
+  uart_event_t event;
+  
+  while (true) {
+    if (xQueueReceive(self->events, &event, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+    switch (event.type) {
+      case UART_DATA:
+      case UART_PATTERN_DET:
+        xSemaphoreGive(self->dataReady);
+        if (self->receiveHook != nullptr) {
+          self->receiveHook();
+        }
+        break;
+      case UART_FIFO_OVF:
+      case UART_BUFFER_FULL:
+        // The driver pauses RX until the ring drains; what the FIFO dropped is gone
+        self->stats.overflows++;
+        xSemaphoreGive(self->dataReady);
+        break;
+      case UART_FRAME_ERR:
+      case UART_PARITY_ERR:
+        self->stats.frameErrors++;
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+void ModemUart::setReceiveHook(void (*hook)()) {
+  receiveHook = hook;
+}
+
+bool ModemUart::waitForData(uint32_t timeout_ms) {
+  if (available() > 0) {
+    return true;
+  }
+  xSemaphoreTake(dataReady, pdMS_TO_TICKS(timeout_ms));
+  return available() > 0;
+}
+
+// ============================================
+// LINE READ
+// ============================================
+int ModemUart::readLine(char* out, size_t size, uint32_t timeout_ms) {
+  if (!open || size < 2) {
+    return -1;
+  }
+  unsigned long start = millis();
+  int pos;
+  while ((pos = uart_pattern_pop_pos(port)) < 0) {
+    if (peeked == '\n') {
+      break;
+    }
+    uint32_t elapsed = millis() - start;
+    if (elapsed >= timeout_ms) {
+      return -1;
+    }
+    xSemaphoreTake(dataReady, pdMS_TO_TICKS(timeout_ms - elapsed));
+  }
+  
+  size_t n = 0;
+  if (peeked >= 0) {
+    out[n++] = (char)peeked;
+    peeked = -1;
+    if (out[0] == '\n') {
+      out[n] = '\0';
+      stats.lines++;
+      return n;
+    }
+  }
+  
+  // pos = bytes before the '\n', counted from the driver's read pointer
+  size_t remaining = (size_t)pos + 1;
+  while (remaining > 0) {
+    char discard[32];
+    size_t room = size - 1 - n;
+    char* target = (room > 0) ? out + n : discard;
+    size_t limit = (room > 0) ? room : sizeof(discard);
+    size_t chunk = (remaining < limit) ? remaining : limit;
+    int got = uart_read_bytes(port, (uint8_t*)target, chunk, pdMS_TO_TICKS(LTE_COMMAND_TIMEOUT_MS));
+    if (got <= 0) {
+      break;
+    }
+    stats.readCalls++;
+    stats.bytesRead += got;
+    if (room > 0) {
+      n += got;
+    }
+    remaining -= got;
+  }
+  out[n] = '\0';
+  stats.lines++;
+  return n;
+}
+
+// ============================================
+// STREAM
+// ============================================
+int ModemUart::available() {
+  if (!open) {
+    return 0;
+  }
+  size_t buffered = 0;
+  uart_get_buffered_data_len(port, &buffered);
+  return (int)buffered + (peeked >= 0 ? 1 : 0);
+}
+
+int ModemUart::read() {
+  if (peeked >= 0) {
+    int c = peeked;
+    peeked = -1;
+    return c;
+  }
+  uint8_t c;
+  if (!open || uart_read_bytes(port, &c, 1, 0) != 1) {
+    return -1;
+  }
+  stats.readCalls++;
+  stats.bytesRead++;
+  return c;
+}
+
+int ModemUart::peek() {
+  if (peeked < 0) {
+    peeked = read();
+  }
+  return peeked;
+}
+
+size_t ModemUart::readBytes(char* buffer, size_t length) {
+  size_t n = 0;
+  if (length > 0 && peeked >= 0) {
+    buffer[n++] = (char)peeked;
+    peeked = -1;
+  }
+  if (!open || n == length) {
+    return n;
+  }
+  int got = uart_read_bytes(port, (uint8_t*)buffer + n, length - n, pdMS_TO_TICKS(_timeout));
+  if (got > 0) {
+    stats.readCalls++;
+    stats.bytesRead += got;
+    n += got;
+  }
+  return n;
+}
+
+size_t ModemUart::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t ModemUart::write(const uint8_t* buffer, size_t size) {
+  if (!open) {
+    return 0;
+  }
+  int written = uart_write_bytes(port, (const char*)buffer, size);
+  return (written > 0) ? written : 0;
+}
+
+void ModemUart::flush() {
+  if (open) {
+    uart_wait_tx_done(port, portMAX_DELAY);
+  }
+}
+
+const ModemUartStats& ModemUart::getStats() {
+  return stats;
+}
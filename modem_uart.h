@@ -0,0 +1,88 @@
+/*
+ * modem_uart.h
+ * 
+ * Modem UART on the ESP-IDF driver: large RX ring, '\n' pattern detection
+ * 
+ * With HardwareSerial every received byte costs an available()/read() pair,
+ * and each of those takes the driver lock. Here the driver's RX interrupt
+ * moves the hardware FIFO into an LTE_UART_RX_RING byte ring in bursts
+ * (the ESP32 UART driver has no RX DMA; the FIFO interrupt is the bulk
+ * path), and the pattern detector marks every '\n' as it arrives. Readers
+ * take a whole line (readLine) or a span (readBytes) in one driver call,
+ * and waitForData() sleeps on the driver's event queue instead of polling.
+ * 
+ * It is a Stream, so LTEManager uses it like Serial2 (LTE_UART_DRIVER).
+ */
+
+#ifndef MODEM_UART_H
+#define MODEM_UART_H
+
+#include <Arduino.h>
+#include <driver/uart.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "config.h"
+
+// ============================================
+// STATISTICS
+// ============================================
+// Counted since begin()
+struct ModemUartStats {
+  uint32_t bytesRead;
+  uint32_t readCalls;        // Driver reads; each moves a line or a span
+  uint32_t lines;            // Delivered by readLine()
+  uint32_t overflows;        // FIFO or ring overflows (bytes were lost)
+  uint32_t frameErrors;      // Framing/parity errors (line noise, rate mismatch)
+};
+
+// ============================================
+// MODEM UART CLASS
+// ============================================
+class ModemUart : public Stream {
+public:
+  ModemUart();
+  
+  bool begin(uint8_t port, uint32_t baudRate, int8_t rxPin, int8_t txPin);
+  void end();
+  
+  // One line including its "\n", NUL-terminated; a longer line is cut to
+  // size - 1 bytes and the rest dropped. Returns the length, -1 on timeout.
+  int readLine(char* out, size_t size, uint32_t timeout_ms);
+  
+  // Sleep until received bytes are buffered (or timeout_ms passes)
+  bool waitForData(uint32_t timeout_ms);
+  
+  // Called from the UART event task whenever bytes arrive
+  void setReceiveHook(void (*hook)());
+  
+  void setBaudRate(uint32_t baudRate);
+  
+  // Hold TX while the modem deasserts CTS (-1 = no flow control)
+  bool setFlowControl(int8_t ctsPin);
+  const ModemUartStats& getStats();
+  
+  // Stream
+  int available() override;
+  int read() override;
+  int peek() override;
+  void flush() override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  size_t readBytes(char* buffer, size_t length) override;  // One driver call
+  using Stream::readBytes;
+  using Print::write;
+
+private:
+  uart_port_t port;
+  bool open;
+  int peeked;                // Byte taken from the driver by peek(), -1 = none
+  QueueHandle_t events;
+  SemaphoreHandle_t dataReady;
+  TaskHandle_t eventTask;
+  void (*volatile receiveHook)();
+  ModemUartStats stats;
+  
+  static void eventTaskEntry(void* arg);
+};
+
+#endif // MODEM_UART_H
@@ -0,0 +1,250 @@
+/*
+ * ndef_parser.cpp
+ * 
+ * Implementation of the zero-copy NDEF parser
+ */
+
+#include "ndef_parser.h"
+#include <string.h>
+
+// TLV tags (NFC Forum Type 2 Tag)
+#define TLV_NULL        0x00
+#define TLV_NDEF        0x03
+#define TLV_TERMINATOR  0xFE
+
+// Record header flags
+#define NDEF_FLAG_MB    0x80
+#define NDEF_FLAG_ME    0x40
+#define NDEF_FLAG_CF    0x20
+#define NDEF_FLAG_SR    0x10
+#define NDEF_FLAG_IL    0x08
+#define NDEF_TNF_MASK   0x07
+
+// URI identifier codes 0x00-0x04 (the ones worth storing on a small tag)
+static const char* const uriPrefixes[] = {
+  "", "http://www.", "https://www.", "http://", "https://"
+};
+
+// ============================================
+// FIND NDEF MESSAGE TLV
+// ============================================
+NdefStatus NdefParser::findMessage(const uint8_t* data, size_t length,
+                                   const uint8_t** message, size_t* messageLength) {
+  size_t pos = 0;
+  
+  while (pos < length) {
+    uint8_t tag = data[pos++];
+    
+    if (tag == TLV_NULL) {
+      continue;
+    }
+    if (tag == TLV_TERMINATOR) {
+      return NDEF_NOT_FOUND;
+    }
+    
+    // Length: one byte, or 0xFF followed by a 16-bit big-endian length
+    if (pos >= length) {
+      return NDEF_INCOMPLETE;
+    }
+    size_t valueLength = data[pos++];
+    if (valueLength == 0xFF) {
+      if (pos + 2 > length) {
+        return NDEF_INCOMPLETE;
+      }
+      valueLength = ((size_t)data[pos] << 8) | data[pos + 1];
+      pos += 2;
+    }
+    
+    if (valueLength > length - pos) {
+      // Any TLV may continue on pages not read yet (NTAG213 ships with a
+      // lock control TLV spanning pages 4 and 5)
+      return NDEF_INCOMPLETE;
+    }
+    
+    if (tag == TLV_NDEF) {
+      *message = data + pos;
+      *messageLength = valueLength;
+      return NDEF_OK;
+    }
+    
+    // Lock/memory control or proprietary TLV - skip
+    pos += valueLength;
+  }
+  
+  return NDEF_INCOMPLETE;
+}
+
+// ============================================
+// RECORD ITERATOR
+// ============================================
+NdefParser::NdefParser(const uint8_t* message, size_t messageLength) {
+  cursor = message;
+  end = message + messageLength;
+  malformed = false;
+  done = (messageLength == 0);
+}
+
+bool NdefParser::next(NdefRecord& record) {
+  if (done || malformed) {
+    return false;
+  }
+  
+  size_t remaining = end - cursor;
+  if (remaining < 3) {
+    malformed = true;
+    return false;
+  }
+  
+  uint8_t flags = cursor[0];
+  if (flags & NDEF_FLAG_CF) {
+    // Chunked records are not used on our tags
+    malformed = true;
+    return false;
+  }
+  
+  record.tnf = flags & NDEF_TNF_MASK;
+  record.messageBegin = (flags & NDEF_FLAG_MB) != 0;
+  record.messageEnd = (flags & NDEF_FLAG_ME) != 0;
+  record.typeLength = cursor[1];
+  
+  size_t pos = 2;
+  if (flags & NDEF_FLAG_SR) {
+    record.payloadLength = cursor[pos++];
+  } else {
+    if (remaining < pos + 4) {
+      malformed = true;
+      return false;
+    }
+    record.payloadLength = ((uint32_t)cursor[pos] << 24) | ((uint32_t)cursor[pos + 1] << 16) |
+                           ((uint32_t)cursor[pos + 2] << 8) | cursor[pos + 3];
+    pos += 4;
+  }
+  
+  record.idLength = 0;
+  if (flags & NDEF_FLAG_IL) {
+    if (remaining < pos + 1) {
+      malformed = true;
+      return false;
+    }
+    record.idLength = cursor[pos++];
+  }
+  
+  // Each field is checked against what is left so lengths cannot overflow
+  if (record.typeLength > remaining - pos) {
+    malformed = true;
+    return false;
+  }
+  record.type = cursor + pos;
+  pos += record.typeLength;
+  
+  if (record.idLength > remaining - pos) {
+    malformed = true;
+    return false;
+  }
+  record.id = cursor + pos;
+  pos += record.idLength;
+  
+  if (record.payloadLength > remaining - pos) {
+    malformed = true;
+    return false;
+  }
+  record.payload = cursor + pos;
+  pos += record.payloadLength;
+  
+  cursor += pos;
+  if (record.messageEnd || cursor >= end) {
+    done = true;
+  }
+  return true;
+}
+
+bool NdefParser::isMalformed() const {
+  return malformed;
+}
+
+// ============================================
+// PARSE HINTS
+// ============================================
+bool NdefParser::parseHints(const uint8_t* data, size_t length, NdefTagHints& hints) {
+  hints.messageId[0] = '\0';
+  hints.cacheVersion[0] = '\0';
+  hints.audioUrl[0] = '\0';
+  
+  const uint8_t* message;
+  size_t messageLength;
+  if (findMessage(data, length, &message, &messageLength) != NDEF_OK) {
+    return false;
+  }
+  
+  bool found = false;
+  NdefParser parser(message, messageLength);
+  NdefRecord record;
+  while (parser.next(record)) {
+    if (record.tnf == NDEF_TNF_EXTERNAL && typeEquals(record, NDEF_HINT_TYPE_MSG_ID)) {
+      copyString(hints.messageId, sizeof(hints.messageId), record.payload, record.payloadLength);
+      found = (hints.messageId[0] != '\0') || found;
+    }
+    else if (record.tnf == NDEF_TNF_EXTERNAL && typeEquals(record, NDEF_HINT_TYPE_VERSION)) {
+      copyString(hints.cacheVersion, sizeof(hints.cacheVersion), record.payload, record.payloadLength);
+      found = (hints.cacheVersion[0] != '\0') || found;
+    }
+    else if (record.tnf == NDEF_TNF_WELL_KNOWN && typeEquals(record, "U") && hints.audioUrl[0] == '\0') {
+      decodeUri(record, hints.audioUrl, sizeof(hints.audioUrl));
+      found = (hints.audioUrl[0] != '\0') || found;
+    }
+  }
+  
+  return found;
+}
+
+// ============================================
+// HELPERS
+// ============================================
+bool NdefParser::typeEquals(const NdefRecord& record, const char* type) {
+  size_t len = strlen(type);
+  return record.typeLength == len && memcmp(record.type, type, len) == 0;
+}
+
+// Printable ASCII without '"': a CR, LF or quote in a hint could end the AT
+// string it is pasted into and start a command of the tag writer's choosing
+bool NdefParser::isHintText(const uint8_t* src, size_t length, bool allowSpace) {
+  for (size_t i = 0; i < length; i++) {
+    if (src[i] < (allowSpace ? 0x20 : 0x21) || src[i] > 0x7E || src[i] == '"') {
+      return false;
+    }
+  }
+  return true;
+}
+
+void NdefParser::copyString(char* dest, size_t destSize, const uint8_t* src, size_t length) {
+  if (length >= destSize || !isHintText(src, length, true)) {
+    // Truncated hints would silently point at the wrong message - drop them
+    dest[0] = '\0';
+    return;
+  }
+  memcpy(dest, src, length);
+  dest[length] = '\0';
+}
+
+void NdefParser::decodeUri(const NdefRecord& record, char* dest, size_t destSize) {
+  dest[0] = '\0';
+  if (record.payloadLength < 1) {
+    return;
+  }
+  
+  uint8_t code = record.payload[0];
+  if (code >= sizeof(uriPrefixes) / sizeof(uriPrefixes[0])) {
+    return;
+  }
+  
+  const char* prefix = uriPrefixes[code];
+  size_t prefixLength = strlen(prefix);
+  size_t bodyLength = record.payloadLength - 1;
+  if (prefixLength + bodyLength >= destSize || !isHintText(record.payload + 1, bodyLength, false)) {
+    return;
+  }
+  
+  memcpy(dest, prefix, prefixLength);
+  memcpy(dest + prefixLength, record.payload + 1, bodyLength);
+  dest[prefixLength + bodyLength] = '\0';
+}
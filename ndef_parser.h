@@ -0,0 +1,90 @@
+/*
+ * ndef_parser.h
+ * 
+ * Zero-copy NDEF parser for NFC Forum Type 2 tags (NTAG213/215)
+ * Records point into the caller's buffer - nothing is copied or allocated
+ */
+
+#ifndef NDEF_PARSER_H
+#define NDEF_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// TNF values used by the parser
+#define NDEF_TNF_EMPTY        0x00
+#define NDEF_TNF_WELL_KNOWN   0x01
+#define NDEF_TNF_EXTERNAL     0x04
+
+// External record types carrying device hints
+#define NDEF_HINT_TYPE_MSG_ID   "esp32voice:msg"   // Payload: message ID (ASCII)
+#define NDEF_HINT_TYPE_VERSION  "esp32voice:ver"   // Payload: cache version, compared to the cached ETag's value
+
+// Hint field sizes (including terminator)
+#define NDEF_HINT_ID_LEN      48
+#define NDEF_HINT_VERSION_LEN 64
+#define NDEF_HINT_URL_LEN     160
+
+enum NdefStatus {
+  NDEF_OK,           // Complete NDEF message found
+  NDEF_INCOMPLETE,   // Data ends before the NDEF TLV does (read more pages)
+  NDEF_NOT_FOUND,    // Terminator or end of data without an NDEF TLV
+  NDEF_MALFORMED     // TLV or record structure is invalid
+};
+
+// One record; pointers reference the parsed buffer
+struct NdefRecord {
+  uint8_t tnf;
+  bool messageBegin;
+  bool messageEnd;
+  const uint8_t* type;
+  uint8_t typeLength;
+  const uint8_t* id;
+  uint8_t idLength;
+  const uint8_t* payload;
+  uint32_t payloadLength;
+};
+
+// What a tag can tell the device besides its UID (empty strings when absent).
+// Hints end up in AT command strings, so a hint with anything but printable
+// ASCII, or with a '"', is dropped.
+struct NdefTagHints {
+  char messageId[NDEF_HINT_ID_LEN];
+  char cacheVersion[NDEF_HINT_VERSION_LEN];
+  char audioUrl[NDEF_HINT_URL_LEN];
+};
+
+// ============================================
+// NDEF PARSER CLASS
+// ============================================
+class NdefParser {
+public:
+  // Locate the NDEF message TLV in a Type 2 tag data area (starting at page 4)
+  static NdefStatus findMessage(const uint8_t* data, size_t length,
+                                const uint8_t** message, size_t* messageLength);
+  
+  // Iterate the records of an NDEF message
+  NdefParser(const uint8_t* message, size_t messageLength);
+  
+  // Next record; false at the end or on malformed data (see isMalformed())
+  bool next(NdefRecord& record);
+  
+  bool isMalformed() const;
+  
+  // Extract message ID, cache version and audio URL hints from a tag data area
+  // Returns true if any hint was found
+  static bool parseHints(const uint8_t* data, size_t length, NdefTagHints& hints);
+
+private:
+  const uint8_t* cursor;
+  const uint8_t* end;
+  bool malformed;
+  bool done;
+  
+  static bool typeEquals(const NdefRecord& record, const char* type);
+  static bool isHintText(const uint8_t* src, size_t length, bool allowSpace);
+  static void copyString(char* dest, size_t destSize, const uint8_t* src, size_t length);
+  static void decodeUri(const NdefRecord& record, char* dest, size_t destSize);
+};
+
+#endif // NDEF_PARSER_H
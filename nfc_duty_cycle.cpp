@@ -0,0 +1,128 @@
+/*
+ * nfc_duty_cycle.cpp
+ * 
+ * Implementation of the NFC field duty-cycle scheduler
+ */
+
+#include "nfc_duty_cycle.h"
+
+// ============================================
+// CONSTRUCTOR
+// ============================================
+NfcDutyCycle::NfcDutyCycle() {
+  configure(100, 200, 1000, 10);
+}
+
+// ============================================
+// CONFIGURE
+// ============================================
+void NfcDutyCycle::configure(uint32_t on, uint32_t offMin, uint32_t offMax, uint16_t backoff) {
+  onMs = on;
+  offMinMs = offMin;
+  offMaxMs = (offMax < offMin) ? offMin : offMax;
+  backoffAfter = (backoff == 0) ? 1 : backoff;
+  
+  windows = 0;
+  detections = 0;
+  fieldOnMs = 0;
+  startMs = 0;
+  reset();
+}
+
+// ============================================
+// RESET
+// ============================================
+void NfcDutyCycle::reset() {
+  started = false;
+  fieldOn = false;
+  phaseStartMs = 0;
+  offMs = offMinMs;
+  emptyWindows = 0;
+}
+
+// ============================================
+// UPDATE
+// ============================================
+NfcDutyAction NfcDutyCycle::update(uint32_t nowMs, bool cardDetected) {
+  if (!started) {
+    started = true;
+    if (windows == 0) {
+      startMs = nowMs;
+    }
+    fieldOn = true;
+    phaseStartMs = nowMs;
+    windows++;
+    return NFC_DUTY_FIELD_ON;
+  }
+  
+  if (fieldOn) {
+    if (cardDetected) {
+      fieldOnMs += nowMs - phaseStartMs;
+      detections++;
+      emptyWindows = 0;
+      offMs = offMinMs;
+      fieldOn = false;
+      phaseStartMs = nowMs;
+      return NFC_DUTY_CARD;
+    }
+    
+    if (nowMs - phaseStartMs >= onMs) {
+      fieldOnMs += nowMs - phaseStartMs;
+      fieldOn = false;
+      phaseStartMs = nowMs;
+      
+      // No tags around - stretch the off time
+      if (++emptyWindows >= backoffAfter) {
+        emptyWindows = 0;
+        offMs = (offMs * 2 > offMaxMs) ? offMaxMs : offMs * 2;
+      }
+      return NFC_DUTY_FIELD_OFF;
+    }
+    return NFC_DUTY_NONE;
+  }
+  
+  if (nowMs - phaseStartMs >= offMs) {
+    fieldOn = true;
+    phaseStartMs = nowMs;
+    windows++;
+    return NFC_DUTY_FIELD_ON;
+  }
+  return NFC_DUTY_NONE;
+}
+
+// ============================================
+// ACCESSORS
+// ============================================
+bool NfcDutyCycle::isFieldOn() const {
+  return fieldOn;
+}
+
+uint32_t NfcDutyCycle::getOffMs() const {
+  return offMs;
+}
+
+uint32_t NfcDutyCycle::getMsUntilNextAction(uint32_t nowMs) const {
+  if (!started) {
+    return 0;
+  }
+  uint32_t phaseMs = fieldOn ? onMs : offMs;
+  uint32_t elapsed = nowMs - phaseStartMs;
+  return (elapsed >= phaseMs) ? 0 : phaseMs - elapsed;
+}
+
+NfcDutyStats NfcDutyCycle::getStats(uint32_t nowMs) const {
+  NfcDutyStats stats;
+  stats.windows = windows;
+  stats.detections = detections;
+  stats.fieldOnMs = fieldOnMs + (fieldOn ? nowMs - phaseStartMs : 0);
+  stats.elapsedMs = (windows == 0) ? 0 : nowMs - startMs;
+  return stats;
+}
+
+float NfcDutyCycle::getFieldDutyPercent(uint32_t nowMs) const {
+  NfcDutyStats stats = getStats(nowMs);
+  if (stats.elapsedMs == 0) {
+    return 0.0f;
+  }
+  return 100.0f * (float)stats.fieldOnMs / (float)stats.elapsedMs;
+}
@@ -0,0 +1,79 @@
+/*
+ * nfc_duty_cycle.h
+ * 
+ * Field-on/field-off scheduler for low-power NFC card detection
+ * Pure timing logic - the caller passes the clock and drives the PN532
+ */
+
+#ifndef NFC_DUTY_CYCLE_H
+#define NFC_DUTY_CYCLE_H
+
+#include <stdint.h>
+
+// What the caller should do after update()
+enum NfcDutyAction {
+  NFC_DUTY_NONE,       // Keep current field state
+  NFC_DUTY_FIELD_ON,   // Start a detection window (field on)
+  NFC_DUTY_FIELD_OFF,  // Window expired without a card (field off)
+  NFC_DUTY_CARD        // A card answered - read it, then field off
+};
+
+struct NfcDutyStats {
+  uint32_t windows;     // Detection windows opened
+  uint32_t detections;  // Windows that found a card
+  uint32_t fieldOnMs;   // Total time with the field on
+  uint32_t elapsedMs;   // Time since the scheduler started
+};
+
+// ============================================
+// NFC DUTY CYCLE CLASS
+// ============================================
+// Field-off time starts at offMinMs and doubles after every backoffAfter
+// empty windows, up to offMaxMs. A detection drops it back to offMinMs.
+// Worst-case detection latency is roughly the current off time plus one
+// card activation (~5 ms).
+class NfcDutyCycle {
+public:
+  NfcDutyCycle();
+  
+  // Set window lengths (resets backoff and statistics)
+  void configure(uint32_t onMs, uint32_t offMinMs, uint32_t offMaxMs, uint16_t backoffAfter);
+  
+  // Advance the schedule; cardDetected is the IRQ state of the current window
+  NfcDutyAction update(uint32_t nowMs, bool cardDetected);
+  
+  // Restart the schedule with the next update() opening a window
+  void reset();
+  
+  bool isFieldOn() const;
+  
+  // Current field-off interval after backoff
+  uint32_t getOffMs() const;
+  
+  // Time until update() has something to do (0 = call now)
+  uint32_t getMsUntilNextAction(uint32_t nowMs) const;
+  
+  NfcDutyStats getStats(uint32_t nowMs) const;
+  
+  // Share of elapsed time with the field on (0-100)
+  float getFieldDutyPercent(uint32_t nowMs) const;
+
+private:
+  uint32_t onMs;
+  uint32_t offMinMs;
+  uint32_t offMaxMs;
+  uint16_t backoffAfter;
+  
+  bool started;
+  bool fieldOn;
+  uint32_t phaseStartMs;
+  uint32_t offMs;
+  uint16_t emptyWindows;
+  
+  uint32_t startMs;
+  uint32_t windows;
+  uint32_t detections;
+  uint32_t fieldOnMs;
+};
+
+#endif // NFC_DUTY_CYCLE_H
@@ -6,6 +6,10 @@
 
 #include "nfc_manager.h"
 #include "logger.h"
+#include "config.h"
+#include "profiler.h"
+#include <esp_sleep.h>
+#include <driver/gpio.h>
 
 // ============================================
 // CONSTRUCTOR
@@ -15,12 +19,18 @@ NFCManager::NFCManager() {
   initialized = false;
   pinIrq = 0;
   pinRst = 0;
+  detectionArmed = false;
+  irqFired = false;
+  irqTimeUs = 0;
+  irqHook = nullptr;
+  dutyCycle.configure(NFC_FIELD_ON_MS, NFC_FIELD_OFF_MIN_MS, NFC_FIELD_OFF_MAX_MS, NFC_BACKOFF_WINDOWS);
 }
 
 // ============================================
 // DESTRUCTOR
 // ============================================
 NFCManager::~NFCManager() {
+  stopDetection();
   if (nfc != nullptr) {
     delete nfc;
     nfc = nullptr;
@@ -75,6 +85,7 @@ bool NFCManager::init(uint8_t sdaPin, uint8_t sclPin, uint8_t irqPin, uint8_t rs
 // READ NFC UID
 // ============================================
 bool NFCManager::readUID(uint8_t* uid, uint8_t* length, uint32_t timeout_ms) {
+  PROFILE_ZONE(PROF_NFC_READ);
   if (!initialized) {
     LOG_E("NFC", "Not initialized");
     return false;
@@ -83,6 +94,9 @@ bool NFCManager::readUID(uint8_t* uid, uint8_t* length, uint32_t timeout_ms) {
   uint8_t uidLength;
   bool success;
   
+  // A synchronous read replaces any armed IRQ detection
+  stopDetection();
+  
   if (timeout_ms == 0) {
     // Non-blocking: just try once
     success = nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 0);
@@ -116,10 +130,277 @@ bool NFCManager::isCardPresent() {
   uint8_t uid[10];
   uint8_t uidLength;
   
+  stopDetection();
+  
   // Quick non-blocking check
   return nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 0);
 }
 
+// ============================================
+// READ NDEF (Type 2 tag)
+// ============================================
+bool NFCManager::readNdef(uint8_t* buffer, size_t bufferSize, size_t* length) {
+  PROFILE_ZONE(PROF_NFC_READ);
+  *length = 0;
+  if (!initialized || nfc == nullptr) {
+    return false;
+  }
+  
+  unsigned long startUs = micros();
+  uint8_t page[4];
+  
+  // Capability container: E1 = NDEF formatted, byte 2 = data area size / 8
+  if (!nfc->ntag2xx_ReadPage(3, page) || page[0] != 0xE1) {
+    LOG_D("NFC", "Tag is not NDEF formatted");
+    return false;
+  }
+  size_t dataSize = (size_t)page[2] * 8;
+  if (dataSize > bufferSize) {
+    dataSize = bufferSize;
+  }
+  
+  uint16_t pagesRead = 1;
+  NdefStatus status = NDEF_INCOMPLETE;
+  const uint8_t* message;
+  size_t messageLength;
+  
+  for (uint16_t p = 4; *length + 4 <= dataSize; p++) {
+    if (!nfc->ntag2xx_ReadPage(p, buffer + *length)) {
+      LOG_W("NFC", "NDEF page read failed");
+      return false;
+    }
+    *length += 4;
+    pagesRead++;
+    
+    status = NdefParser::findMessage(buffer, *length, &message, &messageLength);
+    if (status != NDEF_INCOMPLETE) {
+      break;
+    }
+  }
+  
+  unsigned long elapsedUs = micros() - startUs;
+  Logger::printf(LOG_INFO, "NFC", "NDEF: %u bytes, %u pages in %lu us (%lu us/page)",
+                 (unsigned)*length, pagesRead, elapsedUs, elapsedUs / pagesRead);
+  
+  return status == NDEF_OK;
+}
+
+// ============================================
+// IRQ HANDLER
+// ============================================
+void IRAM_ATTR NFCManager::irqHandler(void* arg) {
+  NFCManager* self = (NFCManager*)arg;
+  if (!self->irqFired) {
+    self->irqTimeUs = micros();
+    self->irqFired = true;
+    if (self->irqHook != nullptr) {
+      self->irqHook();
+    }
+  }
+}
+
+void NFCManager::setIrqHook(void (*hook)()) {
+  irqHook = hook;
+}
+
+// ============================================
+// START IRQ DETECTION
+// ============================================
+bool NFCManager::startDetection() {
+  if (!initialized || nfc == nullptr) {
+    return false;
+  }
+  if (detectionArmed) {
+    return true;
+  }
+  
+  irqFired = false;
+  
+  // Sends InListPassiveTarget and returns after the ACK; the response comes later
+  if (!nfc->startPassiveTargetIDDetection(PN532_MIFARE_ISO14443A)) {
+    // Library reports false when a card answered immediately - IRQ is already low
+    if (digitalRead(pinIrq) == LOW) {
+      irqTimeUs = micros();
+      irqFired = true;
+      detectionArmed = true;
+      return true;
+    }
+    LOG_W("NFC", "Failed to arm IRQ detection");
+    return false;
+  }
+  
+  detectionArmed = true;
+  attachInterruptArg(digitalPinToInterrupt(pinIrq), irqHandler, this, FALLING);
+  
+  // Card may have answered between the ACK and attaching the interrupt
+  if (digitalRead(pinIrq) == LOW && !irqFired) {
+    irqTimeUs = micros();
+    irqFired = true;
+  }
+  return true;
+}
+
+// ============================================
+// STOP IRQ DETECTION
+// ============================================
+void NFCManager::stopDetection() {
+  if (!detectionArmed) {
+    return;
+  }
+  detachInterrupt(digitalPinToInterrupt(pinIrq));
+  detectionArmed = false;
+  irqFired = false;
+  // The next command sent to the PN532 aborts the pending InListPassiveTarget
+}
+
+// ============================================
+// DETECTION STATUS
+// ============================================
+bool NFCManager::isDetectionArmed() {
+  return detectionArmed && !irqFired;
+}
+
+bool NFCManager::isCardDetected() {
+  return detectionArmed && irqFired;
+}
+
+// ============================================
+// READ DETECTED UID
+// ============================================
+bool NFCManager::readDetectedUID(uint8_t* uid, uint8_t* length) {
+  PROFILE_ZONE(PROF_NFC_READ);
+  if (!isCardDetected()) {
+    return false;
+  }
+  
+  detachInterrupt(digitalPinToInterrupt(pinIrq));
+  detectionArmed = false;
+  irqFired = false;
+  
+  uint8_t uidLength = 0;
+  if (!nfc->readDetectedPassiveTargetID(uid, &uidLength)) {
+    return false;
+  }
+  *length = uidLength;
+  
+  char uidStr[32];
+  formatUID(uid, uidLength, uidStr, sizeof(uidStr));
+  Logger::printf(LOG_INFO, "NFC", "UID detected via IRQ: %s (%d bytes, read %lu us after IRQ)", 
+                 uidStr, uidLength, (unsigned long)(micros() - irqTimeUs));
+  return true;
+}
+
+// ============================================
+// ENABLE WAKE ON CARD (light sleep)
+// ============================================
+bool NFCManager::enableWakeOnCard() {
+  if (gpio_wakeup_enable((gpio_num_t)pinIrq, GPIO_INTR_LOW_LEVEL) != ESP_OK) {
+    return false;
+  }
+  return esp_sleep_enable_gpio_wakeup() == ESP_OK;
+}
+
+// ============================================
+// SET DUTY CYCLE
+// ============================================
+void NFCManager::setDutyCycle(uint32_t onMs, uint32_t offMinMs, uint32_t offMaxMs, uint16_t backoffAfter) {
+  dutyCycle.configure(onMs, offMinMs, offMaxMs, backoffAfter);
+}
+
+// ============================================
+// POLL LOW POWER (duty-cycled detection)
+// ============================================
+bool NFCManager::pollLowPower(uint8_t* uid, uint8_t* length) {
+  if (!initialized || nfc == nullptr) {
+    return false;
+  }
+  
+  uint32_t offBefore = dutyCycle.getOffMs();
+  bool found = false;
+  
+  switch (dutyCycle.update(millis(), isCardDetected())) {
+    case NFC_DUTY_FIELD_ON:
+      // Arming InListPassiveTarget switches the field on
+      startDetection();
+      break;
+    
+    case NFC_DUTY_FIELD_OFF:
+      stopDetection();
+      setRfField(false);
+      break;
+    
+    case NFC_DUTY_CARD:
+      found = readDetectedUID(uid, length);
+      setRfField(false);
+      break;
+    
+    default:
+      break;
+  }
+  
+  if (dutyCycle.getOffMs() != offBefore) {
+    Logger::printf(LOG_DEBUG, "NFC", "Field off interval now %lu ms", (unsigned long)dutyCycle.getOffMs());
+    logDutyStats();
+  }
+  
+  return found;
+}
+
+uint32_t NFCManager::getLowPowerPollDelay() {
+  // An armed window also ends early on IRQ (see setIrqHook)
+  return dutyCycle.getMsUntilNextAction(millis());
+}
+
+// ============================================
+// SET RF FIELD
+// ============================================
+bool NFCManager::setRfField(bool on) {
+  if (!initialized || nfc == nullptr) {
+    return false;
+  }
+  
+  // RFConfiguration, CfgItem 0x01 (RF field): bit1 = field on, bit0 = auto RFCA off
+  uint8_t cmd[3] = { PN532_COMMAND_RFCONFIGURATION, 0x01, (uint8_t)(on ? 0x02 : 0x00) };
+  if (!nfc->sendCommandCheckAck(cmd, sizeof(cmd))) {
+    LOG_W("NFC", "RFConfiguration not acknowledged");
+    return false;
+  }
+  
+  // The library only reads the ACK; the response would keep IRQ low
+  drainResponse();
+  return true;
+}
+
+// ============================================
+// DRAIN RESPONSE
+// ============================================
+void NFCManager::drainResponse() {
+  unsigned long start = millis();
+  while (digitalRead(pinIrq) != LOW) {
+    if (millis() - start > 20) {
+      return;
+    }
+    delay(1);
+  }
+  
+  // Status byte + preamble/start/len/lcs + TFI/cmd + dcs/postamble
+  Wire.requestFrom((uint8_t)PN532_I2C_ADDRESS, (uint8_t)12);
+  while (Wire.available()) {
+    Wire.read();
+  }
+}
+
+// ============================================
+// LOG DUTY STATS
+// ============================================
+void NFCManager::logDutyStats() {
+  uint32_t now = millis();
+  NfcDutyStats stats = dutyCycle.getStats(now);
+  Logger::printf(LOG_INFO, "NFC", "Duty cycle: %lu windows, %lu detections, field on %.1f%%, off interval %lu ms",
+                 (unsigned long)stats.windows, (unsigned long)stats.detections,
+                 dutyCycle.getFieldDutyPercent(now), (unsigned long)dutyCycle.getOffMs());
+}
+
 // ============================================
 // GET FIRMWARE VERSION
 // ============================================
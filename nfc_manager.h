@@ -10,6 +10,8 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <Adafruit_PN532.h>
+#include "nfc_duty_cycle.h"
+#include "ndef_parser.h"
 
 // ============================================
 // NFC MANAGER CLASS
@@ -35,6 +37,60 @@ public:
   // Check if card is present (quick check)
   bool isCardPresent();
   
+  // Read the NDEF data area of the card selected by the last readUID()
+  // (NTAG213/215). Stops as soon as the NDEF TLV is complete.
+  // buffer receives the raw data area from page 4; returns false if no NDEF message
+  bool readNdef(uint8_t* buffer, size_t bufferSize, size_t* length);
+  
+  // ========================================
+  // IRQ-DRIVEN DETECTION
+  // ========================================
+  // Arms InListPassiveTarget and returns immediately; the PN532 pulls IRQ low
+  // when a card answers, so nothing polls the I2C bus while waiting.
+  // readUID()/isCardPresent() cancel an armed detection.
+  
+  // Arm detection (attaches the IRQ interrupt)
+  bool startDetection();
+  
+  // Cancel armed detection
+  void stopDetection();
+  
+  // True while a detection is armed and no card has answered yet
+  bool isDetectionArmed();
+  
+  // True once the IRQ has fired for an armed detection (ISR-safe flag)
+  bool isCardDetected();
+  
+  // Fetch the UID of the detected card (disarms; call startDetection() again to re-arm)
+  bool readDetectedUID(uint8_t* uid, uint8_t* length);
+  
+  // Let the IRQ line wake the CPU from light sleep
+  bool enableWakeOnCard();
+  
+  // Called from the IRQ interrupt when a card answers (must be IRAM-safe)
+  void setIrqHook(void (*hook)());
+  
+  // ========================================
+  // DUTY-CYCLED LOW-POWER DETECTION
+  // ========================================
+  // Opens short IRQ detection windows and keeps the RF field off in between
+  // (see nfc_duty_cycle.h). Call pollLowPower() from the idle loop.
+  
+  // Set field-on window and field-off range (off time backs off while no tags are seen)
+  void setDutyCycle(uint32_t onMs, uint32_t offMinMs, uint32_t offMaxMs, uint16_t backoffAfter);
+  
+  // Drive the duty cycle; returns true with the UID when a card was detected
+  bool pollLowPower(uint8_t* uid, uint8_t* length);
+  
+  // Switch the RF field on/off (RFConfiguration)
+  bool setRfField(bool on);
+  
+  // Log windows, detections and field duty
+  void logDutyStats();
+  
+  // Milliseconds until pollLowPower() next needs to run
+  uint32_t getLowPowerPollDelay();
+  
   // Get firmware version (for testing)
   uint32_t getFirmwareVersion();
 
@@ -44,6 +100,19 @@ private:
   uint8_t pinIrq;
   uint8_t pinRst;
   
+  // IRQ detection state
+  bool detectionArmed;
+  volatile bool irqFired;
+  volatile uint32_t irqTimeUs;
+  void (*irqHook)();
+  
+  static void IRAM_ATTR irqHandler(void* arg);
+  
+  NfcDutyCycle dutyCycle;
+  
+  // Read and discard a pending PN532 response frame
+  void drainResponse();
+  
   // Helper to format UID as hex string
   void formatUID(const uint8_t* uid, uint8_t length, char* buffer, size_t bufferSize);
 };
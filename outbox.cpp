@@ -0,0 +1,499 @@
+/*
+ * outbox.cpp
+ *
+ * Implementation of flash-backed store-and-forward outbox
+ */
+
+#include "outbox.h"
+#include "logger.h"
+#include "config.h"
+
+#define OUTBOX_DIR           "/outbox"
+#define OUTBOX_CURSOR_PATH   "/outbox/cursor"
+#define OUTBOX_RECORD_MAGIC  0x3158424FUL  // "OBX1"
+
+// ============================================
+// ON-FLASH RECORD HEADER
+// ============================================
+// Followed by metaLength bytes of OutboxMeta, then dataLength bytes of PCM
+struct OutboxRecordHeader {
+  uint32_t magic;
+  uint16_t metaLength;
+  uint16_t reserved;
+  uint32_t dataLength;
+  uint32_t crc;          // CRC32 over meta + data
+};
+
+struct OutboxCursor {
+  uint32_t segment;
+  uint32_t offset;
+  uint32_t crc;          // CRC32 over segment + offset
+};
+
+// ============================================
+// MOUNT AND RECOVER
+// ============================================
+bool Outbox::begin() {
+  mounted = false;
+  peekedRecordSize = 0;
+  pendingCount = 0;
+  storedBytes = 0;
+  
+  if (!LittleFS.begin(true)) {  // Format on first use
+    LOG_E("Outbox", "LittleFS mount failed");
+    return false;
+  }
+  
+  if (!LittleFS.exists(OUTBOX_DIR)) {
+    LittleFS.mkdir(OUTBOX_DIR);
+  }
+  
+  // Find oldest and newest segment
+  firstSegment = 0;
+  lastSegment = 0;
+  File dir = LittleFS.open(OUTBOX_DIR);
+  File entry = dir.openNextFile();
+  while (entry) {
+    unsigned long id = 0;
+    const char* name = entry.name();
+    const char* slash = strrchr(name, '/');
+    if (slash != nullptr) {
+      name = slash + 1;
+    }
+    if (sscanf(name, "%08lu.seg", &id) == 1 && id > 0) {
+      if (firstSegment == 0 || id < firstSegment) firstSegment = id;
+      if (id > lastSegment) lastSegment = id;
+      storedBytes += entry.size();
+    }
+    entry = dir.openNextFile();
+  }
+  dir.close();
+  
+  if (lastSegment == 0) {
+    firstSegment = 1;
+    lastSegment = 1;
+  }
+  
+  // Restore drain position
+  if (!loadCursor() || cursorSegment < firstSegment || cursorSegment > lastSegment) {
+    cursorSegment = firstSegment;
+    cursorOffset = 0;
+  }
+  
+  // Count pending records and detect a torn tail in the append segment
+  lastSegmentSize = 0;
+  for (uint32_t seg = cursorSegment; seg <= lastSegment; seg++) {
+    uint32_t records = 0;
+    size_t validEnd = 0;
+    size_t fileSize = 0;
+    size_t start = (seg == cursorSegment) ? cursorOffset : 0;
+    if (!scanSegment(seg, start, &records, &validEnd, &fileSize)) {
+      continue;
+    }
+    pendingCount += records;
+    
+    if (seg == lastSegment) {
+      lastSegmentSize = fileSize;
+      if (validEnd < fileSize) {
+        // Power was lost mid-append: leave the valid prefix, append to a new segment
+        Logger::printf(LOG_WARN, "Outbox", "Torn record in segment %lu at %u (size %u) - rotating",
+                       (unsigned long)seg, validEnd, fileSize);
+        lastSegment++;
+        lastSegmentSize = 0;
+      }
+    }
+  }
+  
+  mounted = true;
+  Logger::printf(LOG_INFO, "Outbox", "Outbox ready: %lu pending, segments %lu-%lu, %u bytes",
+                 (unsigned long)pendingCount, (unsigned long)firstSegment,
+                 (unsigned long)lastSegment, storedBytes);
+  return true;
+}
+
+// ============================================
+// APPEND CLIP
+// ============================================
+bool Outbox::append(const OutboxMeta& meta, const uint8_t* data, size_t length) {
+  if (!mounted) {
+    return false;
+  }
+  
+  unsigned long startTime = millis();
+  size_t recordSize = sizeof(OutboxRecordHeader) + sizeof(OutboxMeta) + length;
+  
+  // Rotate to a fresh segment when this one would overflow
+  if (lastSegmentSize > 0 && lastSegmentSize + recordSize > OUTBOX_SEGMENT_SIZE) {
+    lastSegment++;
+    lastSegmentSize = 0;
+  }
+  
+  if (!dropOldestForSpace(recordSize)) {
+    Logger::printf(LOG_ERROR, "Outbox", "No room for clip of %u bytes (limit %u) - not stored",
+                   recordSize, (size_t)OUTBOX_MAX_BYTES);
+    return false;
+  }
+  
+  OutboxRecordHeader header;
+  header.magic = OUTBOX_RECORD_MAGIC;
+  header.metaLength = sizeof(OutboxMeta);
+  header.reserved = 0;
+  header.dataLength = length;
+  header.crc = crc32Update(0, (const uint8_t*)&meta, sizeof(OutboxMeta));
+  header.crc = crc32Update(header.crc, data, length);
+  
+  char path[32];
+  segmentPath(lastSegment, path, sizeof(path));
+  File file = LittleFS.open(path, "a");
+  if (!file) {
+    Logger::printf(LOG_ERROR, "Outbox", "Cannot open %s", path);
+    return false;
+  }
+  
+  size_t written = file.write((const uint8_t*)&header, sizeof(header));
+  written += file.write((const uint8_t*)&meta, sizeof(OutboxMeta));
+  written += file.write(data, length);
+  file.flush();
+  file.close();
+  
+  if (written != recordSize) {
+    // Partial record on flash: CRC will reject it, keep appending elsewhere
+    Logger::printf(LOG_ERROR, "Outbox", "Short write (%u/%u) - rotating segment", written, recordSize);
+    storedBytes += written;
+    lastSegment++;
+    lastSegmentSize = 0;
+    return false;
+  }
+  
+  lastSegmentSize += recordSize;
+  storedBytes += recordSize;
+  pendingCount++;
+  
+  unsigned long elapsed = millis() - startTime;
+  Logger::printf(LOG_INFO, "Outbox", "Stored clip for %s: %u bytes in %lu ms (%lu KB/s), %lu pending",
+                 meta.uid, length, elapsed,
+                 (unsigned long)(elapsed > 0 ? recordSize / elapsed : 0),
+                 (unsigned long)pendingCount);
+  return true;
+}
+
+// ============================================
+// PEEK OLDEST CLIP
+// ============================================
+bool Outbox::peek(OutboxMeta& meta, uint8_t* buffer, size_t bufferSize, size_t* length) {
+  peekedRecordSize = 0;
+  *length = 0;
+  if (!mounted) {
+    return false;
+  }
+  
+  while (cursorSegment <= lastSegment) {
+    char path[32];
+    segmentPath(cursorSegment, path, sizeof(path));
+    
+    if (!LittleFS.exists(path)) {
+      if (cursorSegment == lastSegment) {
+        return false;  // Append segment not created yet - nothing pending
+      }
+      cursorSegment++;
+      cursorOffset = 0;
+      continue;
+    }
+    
+    File file = LittleFS.open(path, "r");
+    size_t fileSize = file.size();
+    if (cursorOffset >= fileSize) {
+      file.close();
+      if (cursorSegment == lastSegment) {
+        return false;  // Fully drained, waiting for appends
+      }
+      dropSegment(cursorSegment);
+      cursorSegment++;
+      cursorOffset = 0;
+      saveCursor();
+      continue;
+    }
+    
+    unsigned long startTime = millis();
+    OutboxRecordHeader header;
+    bool valid = file.seek(cursorOffset) &&
+                 file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+                 header.magic == OUTBOX_RECORD_MAGIC &&
+                 cursorOffset + sizeof(header) + header.metaLength + header.dataLength <= fileSize;
+    
+    if (valid && header.dataLength > bufferSize) {
+      file.close();
+      Logger::printf(LOG_ERROR, "Outbox", "Clip of %lu bytes does not fit drain buffer (%u)",
+                     (unsigned long)header.dataLength, bufferSize);
+      return false;
+    }
+    
+    if (valid) {
+      // Metadata may be larger (newer format) or smaller (older format) than ours
+      memset(&meta, 0, sizeof(meta));
+      size_t metaCopy = (header.metaLength < sizeof(OutboxMeta)) ? header.metaLength : sizeof(OutboxMeta);
+      uint32_t crc = 0;
+      valid = file.read((uint8_t*)&meta, metaCopy) == metaCopy;
+      crc = crc32Update(crc, (const uint8_t*)&meta, metaCopy);
+      for (size_t i = metaCopy; valid && i < header.metaLength; i++) {
+        int b = file.read();
+        uint8_t byte = (uint8_t)b;
+        valid = (b >= 0);
+        crc = crc32Update(crc, &byte, 1);
+      }
+      valid = valid && file.read(buffer, header.dataLength) == header.dataLength;
+      crc = crc32Update(crc, buffer, header.dataLength);
+      valid = valid && (crc == header.crc);
+      meta.uid[sizeof(meta.uid) - 1] = '\0';
+      meta.captureStats[sizeof(meta.captureStats) - 1] = '\0';
+    }
+    file.close();
+    
+    if (valid) {
+      peekedRecordSize = sizeof(header) + header.metaLength + header.dataLength;
+      *length = header.dataLength;
+      unsigned long elapsed = millis() - startTime;
+      Logger::printf(LOG_DEBUG, "Outbox", "Read clip for %s: %lu bytes in %lu ms",
+                     meta.uid, (unsigned long)header.dataLength, elapsed);
+      return true;
+    }
+    
+    // Corrupt or torn record: nothing after it in this segment can be trusted
+    Logger::printf(LOG_WARN, "Outbox", "Invalid record in segment %lu at %u - skipping rest of segment",
+                   (unsigned long)cursorSegment, cursorOffset);
+    if (cursorSegment == lastSegment) {
+      lastSegment++;
+      lastSegmentSize = 0;
+    }
+    dropSegment(cursorSegment);
+    cursorSegment++;
+    cursorOffset = 0;
+    saveCursor();
+    
+    // The dropped tail may have held counted records; recount what is left
+    pendingCount = countPending();
+  }
+  
+  return false;
+}
+
+// ============================================
+// MARK PEEKED CLIP DELIVERED
+// ============================================
+bool Outbox::pop() {
+  if (!mounted || peekedRecordSize == 0) {
+    return false;
+  }
+  
+  cursorOffset += peekedRecordSize;
+  peekedRecordSize = 0;
+  if (pendingCount > 0) {
+    pendingCount--;
+  }
+  
+  // Everything drained: delete the append segment too and start clean
+  if (cursorSegment == lastSegment && cursorOffset >= lastSegmentSize) {
+    dropSegment(cursorSegment);
+    lastSegment++;
+    lastSegmentSize = 0;
+    cursorSegment = lastSegment;
+    cursorOffset = 0;
+  }
+  
+  return saveCursor();
+}
+
+// ============================================
+// STATUS
+// ============================================
+uint32_t Outbox::getPendingCount() {
+  return pendingCount;
+}
+
+bool Outbox::isEmpty() {
+  return pendingCount == 0;
+}
+
+// ============================================
+// SEGMENT HELPERS
+// ============================================
+void Outbox::segmentPath(uint32_t segment, char* path, size_t pathSize) {
+  snprintf(path, pathSize, OUTBOX_DIR "/%08lu.seg", (unsigned long)segment);
+}
+
+// Walks records from startOffset; validEnd = end of the last record with a good CRC
+bool Outbox::scanSegment(uint32_t segment, size_t startOffset, uint32_t* validRecords, size_t* validEnd, size_t* fileSize) {
+  char path[32];
+  segmentPath(segment, path, sizeof(path));
+  *validRecords = 0;
+  *validEnd = startOffset;
+  *fileSize = 0;
+  
+  if (!LittleFS.exists(path)) {
+    return false;
+  }
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    return false;
+  }
+  *fileSize = file.size();
+  
+  uint8_t chunk[256];
+  size_t offset = startOffset;
+  while (offset + sizeof(OutboxRecordHeader) <= *fileSize) {
+    OutboxRecordHeader header;
+    if (!file.seek(offset) || file.read((uint8_t*)&header, sizeof(header)) != sizeof(header)) {
+      break;
+    }
+    size_t bodyLength = (size_t)header.metaLength + header.dataLength;
+    if (header.magic != OUTBOX_RECORD_MAGIC || offset + sizeof(header) + bodyLength > *fileSize) {
+      break;
+    }
+    
+    uint32_t crc = 0;
+    size_t remaining = bodyLength;
+    while (remaining > 0) {
+      size_t n = (remaining < sizeof(chunk)) ? remaining : sizeof(chunk);
+      if (file.read(chunk, n) != n) {
+        break;
+      }
+      crc = crc32Update(crc, chunk, n);
+      remaining -= n;
+    }
+    if (remaining != 0 || crc != header.crc) {
+      break;
+    }
+    
+    offset += sizeof(header) + bodyLength;
+    (*validRecords)++;
+    *validEnd = offset;
+  }
+  
+  file.close();
+  return true;
+}
+
+void Outbox::dropSegment(uint32_t segment) {
+  char path[32];
+  segmentPath(segment, path, sizeof(path));
+  
+  File file = LittleFS.open(path, "r");
+  if (file) {
+    size_t size = file.size();
+    file.close();
+    storedBytes = (storedBytes > size) ? storedBytes - size : 0;
+    LittleFS.remove(path);
+  }
+  
+  if (segment == firstSegment && firstSegment < lastSegment) {
+    firstSegment++;
+  }
+}
+
+// Valid records from the drain cursor to the end of the append segment
+uint32_t Outbox::countPending() {
+  uint32_t total = 0;
+  for (uint32_t seg = cursorSegment; seg <= lastSegment; seg++) {
+    uint32_t records = 0;
+    size_t validEnd = 0;
+    size_t fileSize = 0;
+    size_t start = (seg == cursorSegment) ? cursorOffset : 0;
+    if (scanSegment(seg, start, &records, &validEnd, &fileSize)) {
+      total += records;
+    }
+  }
+  return total;
+}
+
+// Drop whole oldest segments (undelivered clips included) to stay under OUTBOX_MAX_BYTES
+// Returns false if the record cannot fit even with everything else dropped
+bool Outbox::dropOldestForSpace(size_t needed) {
+  if (needed > OUTBOX_MAX_BYTES) {
+    return false;
+  }
+  
+  while (storedBytes + needed > OUTBOX_MAX_BYTES) {
+    if (firstSegment >= lastSegment) {
+      if (lastSegmentSize == 0) {
+        break;  // Nothing left that could be dropped
+      }
+      // Only the append segment holds data: move appends on so it can go
+      lastSegment++;
+      lastSegmentSize = 0;
+    }
+    
+    uint32_t segment = firstSegment;
+    if (segment >= cursorSegment) {
+      uint32_t records = 0;
+      size_t validEnd = 0;
+      size_t fileSize = 0;
+      size_t start = (segment == cursorSegment) ? cursorOffset : 0;
+      if (scanSegment(segment, start, &records, &validEnd, &fileSize)) {
+        pendingCount = (pendingCount > records) ? pendingCount - records : 0;
+        Logger::printf(LOG_WARN, "Outbox", "Outbox full - dropping %lu undelivered clip(s)",
+                       (unsigned long)records);
+      }
+    }
+    
+    dropSegment(segment);
+    firstSegment = segment + 1;
+    if (cursorSegment <= segment) {
+      cursorSegment = segment + 1;
+      cursorOffset = 0;
+      peekedRecordSize = 0;
+    }
+  }
+  saveCursor();
+  return storedBytes + needed <= OUTBOX_MAX_BYTES;
+}
+
+// ============================================
+// CURSOR PERSISTENCE
+// ============================================
+bool Outbox::loadCursor() {
+  File file = LittleFS.open(OUTBOX_CURSOR_PATH, "r");
+  if (!file) {
+    return false;
+  }
+  OutboxCursor cursor;
+  bool ok = file.read((uint8_t*)&cursor, sizeof(cursor)) == sizeof(cursor);
+  file.close();
+  
+  if (!ok || cursor.crc != crc32Update(0, (const uint8_t*)&cursor, offsetof(OutboxCursor, crc))) {
+    LOG_W("Outbox", "Cursor file invalid - draining from oldest segment");
+    return false;
+  }
+  cursorSegment = cursor.segment;
+  cursorOffset = cursor.offset;
+  return true;
+}
+
+bool Outbox::saveCursor() {
+  OutboxCursor cursor;
+  cursor.segment = cursorSegment;
+  cursor.offset = cursorOffset;
+  cursor.crc = crc32Update(0, (const uint8_t*)&cursor, offsetof(OutboxCursor, crc));
+  
+  // Small whole-file rewrite; LittleFS commits it copy-on-write
+  File file = LittleFS.open(OUTBOX_CURSOR_PATH, "w");
+  if (!file) {
+    return false;
+  }
+  bool ok = file.write((const uint8_t*)&cursor, sizeof(cursor)) == sizeof(cursor);
+  file.close();
+  return ok;
+}
+
+// ============================================
+// CRC32 (IEEE, bitwise - no table in RAM)
+// ============================================
+uint32_t Outbox::crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
@@ -0,0 +1,81 @@
+/*
+ * outbox.h
+ * 
+ * Store-and-forward outbox for recorded clips (LittleFS)
+ * 
+ * Clips that could not be uploaded are appended to log-structured segment
+ * files (/outbox/NNNNNNNN.seg). Records are never rewritten in place:
+ *   - appends go to the newest segment, rotating at OUTBOX_SEGMENT_SIZE
+ *   - a small cursor file records how far the oldest segment was drained
+ *   - fully drained segments are deleted whole
+ * Each record carries a CRC32, so a record torn by power loss is detected
+ * and skipped; appends after a torn tail go to a fresh segment.
+ */
+
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+// ============================================
+// CLIP METADATA (stored with each record)
+// ============================================
+struct OutboxMeta {
+  char uid[32];              // NFC UID hex string
+  uint32_t recordedAtMs;     // millis() when recorded (boot-relative)
+  uint32_t sampleRate;       // PCM sample rate
+  char captureStats[128];    // Capture stats (AudioManager::formatCaptureStats)
+};
+
+// ============================================
+// OUTBOX CLASS
+// ============================================
+class Outbox {
+public:
+  // Mount filesystem, locate segments and recover from power loss
+  bool begin();
+  
+  // Append a clip; returns false if the filesystem write failed or the
+  // clip is larger than OUTBOX_MAX_BYTES
+  bool append(const OutboxMeta& meta, const uint8_t* data, size_t length);
+  
+  // Read the oldest undelivered clip into buffer (does not remove it)
+  // Returns false if the outbox is empty or the record does not fit
+  bool peek(OutboxMeta& meta, uint8_t* buffer, size_t bufferSize, size_t* length);
+  
+  // Mark the clip returned by peek() as delivered
+  bool pop();
+  
+  // Number of undelivered clips
+  uint32_t getPendingCount();
+  
+  // Check if anything is waiting
+  bool isEmpty();
+
+private:
+  bool mounted;
+  uint32_t firstSegment;       // Oldest segment on flash
+  uint32_t lastSegment;        // Segment receiving appends
+  size_t lastSegmentSize;
+  uint32_t cursorSegment;      // Drain position
+  size_t cursorOffset;
+  size_t peekedRecordSize;     // Size of record returned by last peek (0 = none)
+  uint32_t pendingCount;
+  size_t storedBytes;          // Sum of segment file sizes
+  
+  // Segment helpers
+  void segmentPath(uint32_t segment, char* path, size_t pathSize);
+  bool scanSegment(uint32_t segment, size_t startOffset, uint32_t* validRecords, size_t* validBytes, size_t* fileSize);
+  void dropSegment(uint32_t segment);
+  uint32_t countPending();
+  bool dropOldestForSpace(size_t needed);
+  
+  // Cursor persistence
+  bool loadCursor();
+  bool saveCursor();
+  
+  static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length);
+};
+
+#endif // OUTBOX_H
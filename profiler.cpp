@@ -0,0 +1,55 @@
+/*
+ * profiler.cpp
+ * 
+ * Per-zone table for the cycle-count profiler
+ */
+
+#include "profiler.h"
+#include "logger.h"
+
+ProfileZoneStats Profiler::zones[PROF_ZONE_COUNT];
+
+ProfileZoneStats Profiler::getStats(uint8_t zone) {
+  ProfileZoneStats empty = { 0, 0, 0 };
+  return (zone < PROF_ZONE_COUNT) ? zones[zone] : empty;
+}
+
+const char* Profiler::getZoneName(uint8_t zone) {
+  switch (zone) {
+    case PROF_MIC_READ:    return "MIC_READ";
+    case PROF_SPK_WRITE:   return "SPK_WRITE";
+    case PROF_AT_COMMAND:  return "AT_COMMAND";
+    case PROF_NFC_READ:    return "NFC_READ";
+    case PROF_LOG:         return "LOG";
+    default:               return "UNKNOWN";
+  }
+}
+
+void Profiler::reset() {
+  memset(zones, 0, sizeof(zones));
+}
+
+// ============================================
+// DUMP TABLE
+// ============================================
+void Profiler::log() {
+#if ENABLE_PROFILING
+  // Copy first: logging below runs inside the LOG zone
+  ProfileZoneStats snapshot[PROF_ZONE_COUNT];
+  memcpy(snapshot, zones, sizeof(snapshot));
+  uint32_t mhz = getCpuFrequencyMhz();
+  
+  Logger::printf(LOG_INFO, "Prof", "%-11s %8s %10s %10s %10s", "zone", "calls", "avg us", "max us", "total ms");
+  for (uint8_t i = 0; i < PROF_ZONE_COUNT; i++) {
+    const ProfileZoneStats& z = snapshot[i];
+    if (z.calls == 0) {
+      continue;
+    }
+    Logger::printf(LOG_INFO, "Prof", "%-11s %8lu %10lu %10lu %10lu", getZoneName(i), (unsigned long)z.calls,
+                   (unsigned long)(z.totalCycles / z.calls / mhz), (unsigned long)(z.maxCycles / mhz),
+                   (unsigned long)(z.totalCycles / mhz / 1000));
+  }
+#else
+  LOG_I("Prof", "Profiling disabled (ENABLE_PROFILING 0)");
+#endif
+}
@@ -0,0 +1,89 @@
+/*
+ * profiler.h
+ * 
+ * Scoped cycle-count profiler for subsystem hot paths
+ * 
+ * PROFILE_ZONE(PROF_xxx) at the top of a function times it until return
+ * with the CPU cycle counter (CCOUNT) and folds the result into a per-zone
+ * table: calls, total and max cycles. A zone costs two counter reads and a
+ * few adds; with ENABLE_PROFILING 0 the macro compiles to nothing.
+ * 
+ * Limits:
+ *   - CCOUNT is 32 bits: a zone longer than ~17 s at 240 MHz wraps
+ *   - CCOUNT is per core: a task that migrates mid-zone reads garbage
+ *     (loop() is pinned to core 1; the prefetch/watchdog tasks are not)
+ *   - Updates are not locked; concurrent zones may lose a count
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================
+// ZONES
+// ============================================
+enum ProfileZone {
+  PROF_MIC_READ,       // AudioManager::readRecordedData
+  PROF_SPK_WRITE,      // AudioManager::writePlaybackData
+  PROF_AT_COMMAND,     // LTEManager AT command round trip
+  PROF_NFC_READ,       // NFCManager UID / NDEF reads
+  PROF_LOG,            // Logger::print / printf
+  PROF_ZONE_COUNT
+};
+
+struct ProfileZoneStats {
+  uint32_t calls;
+  uint64_t totalCycles;
+  uint32_t maxCycles;
+};
+
+// ============================================
+// PROFILER CLASS
+// ============================================
+class Profiler {
+public:
+  static inline void record(uint8_t zone, uint32_t cycles) {
+    ProfileZoneStats& z = zones[zone];
+    z.calls++;
+    z.totalCycles += cycles;
+    if (cycles > z.maxCycles) {
+      z.maxCycles = cycles;
+    }
+  }
+  
+  static ProfileZoneStats getStats(uint8_t zone);
+  static const char* getZoneName(uint8_t zone);
+  static void reset();
+  
+  // Log calls, avg/max us and total ms per zone
+  static void log();
+
+private:
+  static ProfileZoneStats zones[PROF_ZONE_COUNT];
+};
+
+// ============================================
+// PROFILE SCOPE (RAII zone)
+// ============================================
+class ProfileScope {
+public:
+  explicit inline ProfileScope(uint8_t zone) : zone(zone), start(ESP.getCycleCount()) {}
+  inline ~ProfileScope() { Profiler::record(zone, ESP.getCycleCount() - start); }
+
+private:
+  uint8_t zone;
+  uint32_t start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b)  PROFILE_CONCAT_(a, b)
+
+#if ENABLE_PROFILING
+#define PROFILE_ZONE(zone) ProfileScope PROFILE_CONCAT(profZone, __LINE__)(zone)
+#else
+#define PROFILE_ZONE(zone) do {} while (0)
+#endif
+
+#endif // PROFILER_H
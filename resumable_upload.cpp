@@ -0,0 +1,388 @@
+/*
+ * resumable_upload.cpp
+ * 
+ * Implementation of chunked, resumable upload
+ */
+
+#include "resumable_upload.h"
+#include "logger.h"
+#include "config.h"
+
+// ============================================
+// INITIALIZE UPLOADER
+// ============================================
+void ResumableUploader::init(LTEManager* lteManager) {
+  lte = lteManager;
+  coap = nullptr;
+  http = nullptr;
+  chunkSize = UPLOAD_CHUNK_SIZE;
+  memset(&stats, 0, sizeof(stats));
+  abandon();
+}
+
+// ============================================
+// UPLOAD CLIP (resumes a pending session if possible)
+// ============================================
+bool ResumableUploader::upload(const char* baseUrl, const char* uid, uint32_t clipId, const uint8_t* data,
+                               size_t length, const char* userHeader, const char* startBody) {
+  unsigned long startTime = millis();
+  uint32_t bytesBefore = lte->getBytesSent();
+  memset(&stats, 0, sizeof(stats));
+  
+  // Resume only if this is the same clip as the pending session
+  bool resume = (uploadId[0] != '\0') && (pendingClipId == clipId) && (pendingLength == length) &&
+                (strcmp(pendingUid, uid) == 0);
+  if (resume) {
+    Logger::printf(LOG_INFO, "Upload", "Resuming upload %s", uploadId);
+    if (queryOffset(baseUrl)) {
+      stats.resumed = true;
+    } else {
+      LOG_W("Upload", "Pending session not found on server - starting over");
+      abandon();
+      resume = false;
+    }
+  }
+  
+  if (!resume) {
+    abandon();
+    if (!startSession(baseUrl, uid, clipId, length, userHeader, startBody)) {
+      stats.bytesOnAir = lte->getBytesSent() - bytesBefore;
+      stats.durationMs = millis() - startTime;
+      return false;
+    }
+    stats.startBodySent = (startBody != nullptr && startBody[0] != '\0');
+  }
+  
+  // Send chunks from the server's committed offset. Retries only reset once
+  // the offset passes its high-water mark, so a server that never lets it
+  // advance still runs out of UPLOAD_CHUNK_RETRIES.
+  int attempt = 0;
+  size_t highWater = committedOffset;
+  while (committedOffset < length) {
+    size_t remaining = length - committedOffset;
+    size_t chunkLength = (remaining < chunkSize) ? remaining : chunkSize;
+    
+    if (sendChunk(baseUrl, data, committedOffset, chunkLength)) {
+      if (committedOffset > highWater) {
+        highWater = committedOffset;
+        attempt = 0;
+        continue;
+      }
+      // Re-sending bytes the server had already acknowledged: no progress
+    }
+    
+    stats.chunkRetries++;
+    attempt++;
+    if (attempt > UPLOAD_CHUNK_RETRIES) {
+      Logger::printf(LOG_ERROR, "Upload", "Chunk at offset %u failed %d times - session kept for resume", 
+                     committedOffset, attempt);
+      stats.bytesOnAir = lte->getBytesSent() - bytesBefore;
+      stats.durationMs = millis() - startTime;
+      return false;
+    }
+    
+    backoff(attempt);
+    
+    // The server may have committed the chunk even though the ack was lost
+    if (queryOffset(baseUrl)) {
+      stats.resyncs++;
+    }
+  }
+  
+  stats.bytesOnAir = lte->getBytesSent() - bytesBefore;
+  stats.durationMs = millis() - startTime;
+  Logger::printf(LOG_INFO, "Upload", "Upload complete: %u bytes, %lu on air, %lu chunks, %lu retries, %lu ms", 
+                 length, (unsigned long)stats.bytesOnAir, (unsigned long)stats.chunksSent,
+                 (unsigned long)stats.chunkRetries, (unsigned long)stats.durationMs);
+  abandon();
+  return true;
+}
+
+// ============================================
+// ABANDON PENDING SESSION
+// ============================================
+void ResumableUploader::setControlChannel(CoapClient* client) {
+  coap = client;
+}
+
+void ResumableUploader::setTransport(HttpClient* client) {
+  http = client;
+}
+
+void ResumableUploader::setChunkSize(size_t bytes) {
+  chunkSize = (bytes > 0) ? bytes : UPLOAD_CHUNK_SIZE;
+}
+
+void ResumableUploader::abandon() {
+  uploadId[0] = '\0';
+  pendingUid[0] = '\0';
+  pendingClipId = 0;
+  pendingLength = 0;
+  committedOffset = 0;
+}
+
+// ============================================
+// GET LAST STATS
+// ============================================
+const UploadStats& ResumableUploader::getLastStats() {
+  return stats;
+}
+
+// ============================================
+// START SESSION
+// ============================================
+bool ResumableUploader::startSession(const char* baseUrl, const char* uid, uint32_t clipId, size_t length,
+                                     const char* userHeader, const char* startBody) {
+  char query[96];
+  snprintf(query, sizeof(query), "uid=%s&size=%u", uid, length);
+  
+  int statusCode = 0;
+  String response;
+  if (!controlRequest(baseUrl, "upload/start", query, startBody, userHeader, &statusCode, response) ||
+      statusCode < 200 || statusCode >= 300) {
+    Logger::printf(LOG_ERROR, "Upload", "Start failed (status %d)", statusCode);
+    return false;
+  }
+  
+  if (!parseJsonString(response, "upload_id", uploadId, sizeof(uploadId))) {
+    Logger::printf(LOG_ERROR, "Upload", "No upload_id in response: %s", response.c_str());
+    uploadId[0] = '\0';
+    return false;
+  }
+  
+  // Server may already hold part of this clip (e.g. a retried start)
+  long offset = 0;
+  parseJsonLong(response, "offset", &offset);
+  if (offset < 0 || (size_t)offset > length) {
+    offset = 0;
+  }
+  
+  strncpy(pendingUid, uid, sizeof(pendingUid) - 1);
+  pendingUid[sizeof(pendingUid) - 1] = '\0';
+  pendingClipId = clipId;
+  pendingLength = length;
+  committedOffset = (size_t)offset;
+  
+  Logger::printf(LOG_INFO, "Upload", "Session %s started (%u bytes, offset %u)", 
+                 uploadId, length, committedOffset);
+  return true;
+}
+
+// ============================================
+// SEND ONE CHUNK
+// ============================================
+bool ResumableUploader::sendChunk(const char* baseUrl, const uint8_t* data, size_t offset, size_t chunkLength) {
+  char url[256];
+  snprintf(url, sizeof(url), "%s/upload/chunk?id=%s&offset=%u", baseUrl, uploadId, offset);
+  
+  stats.chunksSent++;
+  
+  int statusCode = 0;
+  String response;
+  if (!httpsPost(url, data + offset, chunkLength, "application/octet-stream", nullptr, &statusCode, response)) {
+    Logger::printf(LOG_WARN, "Upload", "Chunk at offset %u: transport error", offset);
+    return false;
+  }
+  
+  long ackOffset = -1;
+  bool hasOffset = parseJsonLong(response, "offset", &ackOffset);
+  
+  if (statusCode == 200 || statusCode == 201) {
+    size_t next = hasOffset ? (size_t)ackOffset : offset + chunkLength;
+    if (!hasOffset || ackOffset < 0 || next > pendingLength) {
+      next = offset + chunkLength;
+    }
+    if (next <= offset) {
+      // Acked without progress: a retry, or a misbehaving server would spin the loop
+      Logger::printf(LOG_WARN, "Upload", "Chunk at offset %u acked at %u - no progress", offset, next);
+      return false;
+    }
+    committedOffset = next;
+    Logger::printf(LOG_DEBUG, "Upload", "Chunk acked: %u/%u", committedOffset, pendingLength);
+    return true;
+  }
+  
+  // 409 = offset mismatch; the server tells us where it actually is
+  if (statusCode == 409 && hasOffset && ackOffset >= 0 && (size_t)ackOffset <= pendingLength) {
+    Logger::printf(LOG_INFO, "Upload", "Offset mismatch: server at %ld, client at %u", ackOffset, offset);
+    committedOffset = (size_t)ackOffset;
+    return committedOffset > offset;  // Behind us (or unmoved) counts as a failed attempt
+  }
+  
+  Logger::printf(LOG_WARN, "Upload", "Chunk at offset %u failed (status %d)", offset, statusCode);
+  return false;
+}
+
+// ============================================
+// QUERY SERVER OFFSET
+// ============================================
+bool ResumableUploader::queryOffset(const char* baseUrl) {
+  char query[64];
+  snprintf(query, sizeof(query), "id=%s", uploadId);
+  
+  int statusCode = 0;
+  String response;
+  if (!controlRequest(baseUrl, "upload/status", query, nullptr, nullptr, &statusCode, response) ||
+      statusCode != 200) {
+    return false;
+  }
+  
+  long offset = -1;
+  if (!parseJsonLong(response, "offset", &offset) || offset < 0 || (size_t)offset > pendingLength) {
+    return false;
+  }
+  
+  committedOffset = (size_t)offset;
+  Logger::printf(LOG_INFO, "Upload", "Server has %u/%u bytes", committedOffset, pendingLength);
+  return true;
+}
+
+// ============================================
+// CONTROL REQUEST (CoAP first, then HTTPS)
+// ============================================
+bool ResumableUploader::controlRequest(const char* baseUrl, const char* path, const char* query, const char* body,
+                                       const char* userHeader, int* statusCode, String& response) {
+  size_t bodyLength = (body != nullptr) ? strlen(body) : 0;
+  
+  if (coap != nullptr) {
+    // The capture stats header travels as a query parameter
+    char coapQuery[256];
+    const char* headerValue = (userHeader != nullptr) ? strstr(userHeader, ": ") : nullptr;
+    if (headerValue != nullptr) {
+      snprintf(coapQuery, sizeof(coapQuery), "%s&stats=%s", query, headerValue + 2);
+    } else {
+      snprintf(coapQuery, sizeof(coapQuery), "%s", query);
+    }
+    
+    char reply[256];
+    size_t replyLength = 0;
+    int code = coap->request(COAP_POST, path, coapQuery, COAP_FORMAT_JSON, (const uint8_t*)body, bodyLength,
+                             (uint8_t*)reply, &replyLength, sizeof(reply) - 1);
+    if (code >= 0) {
+      reply[replyLength] = '\0';
+      response = reply;
+      int codeClass = COAP_CODE_CLASS(code);
+      if (code == COAP_CREATED) {
+        *statusCode = 201;
+      } else if (codeClass == 2) {
+        *statusCode = 200;
+      } else {
+        *statusCode = codeClass * 100 + (code & 0x1F);
+      }
+      stats.coapRequests++;
+      return true;
+    }
+    stats.coapFallbacks++;
+    Logger::printf(LOG_WARN, "Upload", "No CoAP answer for %s, using HTTPS", path);
+  }
+  
+  char url[256];
+  snprintf(url, sizeof(url), "%s/%s?%s", baseUrl, path, query);
+  return httpsPost(url, (const uint8_t*)body, bodyLength, "application/json", userHeader, statusCode, response);
+}
+
+// ============================================
+// HTTPS POST (socket client or AT+HTTP stack)
+// ============================================
+bool ResumableUploader::httpsPost(const char* url, const uint8_t* body, size_t bodyLength, const char* contentType,
+                                  const char* userHeader, int* statusCode, String& response) {
+  if (http == nullptr) {
+    return lte->httpPostWithResponse(url, body, bodyLength, contentType, userHeader, statusCode, response);
+  }
+  
+  char headers[224];
+  snprintf(headers, sizeof(headers), "Content-Type: %s\r\n%s%s", contentType,
+           (userHeader != nullptr) ? userHeader : "", (userHeader != nullptr) ? "\r\n" : "");
+  if (!http->beginRequest("POST", url, headers, bodyLength) || !http->write(body, bodyLength)) {
+    http->close();
+    return false;
+  }
+  int status = http->endRequest();
+  if (status < 0) {
+    return false;
+  }
+  *statusCode = status;
+  
+  // Acknowledgements are short JSON objects
+  char reply[256];
+  size_t replyLength = 0;
+  int n;
+  while ((n = http->read((uint8_t*)reply + replyLength, sizeof(reply) - 1 - replyLength)) > 0) {
+    replyLength += n;
+  }
+  reply[replyLength] = '\0';
+  response = reply;
+  http->finish();
+  return n >= 0;
+}
+
+// ============================================
+// EXPONENTIAL BACKOFF WITH JITTER
+// ============================================
+void ResumableUploader::backoff(int attempt) {
+  uint32_t delayMs = UPLOAD_BACKOFF_BASE_MS;
+  for (int i = 1; i < attempt && delayMs < UPLOAD_BACKOFF_MAX_MS; i++) {
+    delayMs *= 2;
+  }
+  if (delayMs > UPLOAD_BACKOFF_MAX_MS) {
+    delayMs = UPLOAD_BACKOFF_MAX_MS;
+  }
+  delayMs += random(0, delayMs / 4 + 1);  // Jitter so a fleet doesn't retry in lockstep
+  
+  Logger::printf(LOG_INFO, "Upload", "Retry %d/%d in %lu ms", attempt, UPLOAD_CHUNK_RETRIES, (unsigned long)delayMs);
+  delay(delayMs);
+}
+
+// ============================================
+// JSON HELPERS
+// ============================================
+// Finds "key": and returns the index of the first value character, or -1
+static int findJsonValue(const String& json, const char* key) {
+  char pattern[40];
+  snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+  int pos = json.indexOf(pattern);
+  if (pos < 0) {
+    return -1;
+  }
+  pos = json.indexOf(':', pos + strlen(pattern));
+  if (pos < 0) {
+    return -1;
+  }
+  pos++;
+  while (pos < (int)json.length() && (json[pos] == ' ' || json[pos] == '\t')) {
+    pos++;
+  }
+  return (pos < (int)json.length()) ? pos : -1;
+}
+
+bool ResumableUploader::parseJsonLong(const String& json, const char* key, long* value) {
+  int pos = findJsonValue(json, key);
+  if (pos < 0) {
+    return false;
+  }
+  char* end = nullptr;
+  long parsed = strtol(json.c_str() + pos, &end, 10);
+  if (end == json.c_str() + pos) {
+    return false;
+  }
+  *value = parsed;
+  return true;
+}
+
+bool ResumableUploader::parseJsonString(const String& json, const char* key, char* out, size_t outSize) {
+  int pos = findJsonValue(json, key);
+  if (pos < 0 || json[pos] != '"') {
+    return false;
+  }
+  int end = json.indexOf('"', pos + 1);
+  if (end < 0) {
+    return false;
+  }
+  size_t len = end - (pos + 1);
+  if (len == 0 || len >= outSize) {
+    return false;
+  }
+  memcpy(out, json.c_str() + pos + 1, len);
+  out[len] = '\0';
+  return true;
+}
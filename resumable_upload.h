@@ -0,0 +1,110 @@
+/*
+ * resumable_upload.h
+ * 
+ * Chunked, resumable audio upload layered over LTEManager
+ * 
+ * Protocol (all POST, JSON responses):
+ *   {base}/upload/start?uid=<UID>&size=<N>     -> {"upload_id":"<ID>","offset":<O>}
+ *                                                 body = optional JSON telemetry (may be empty)
+ *   {base}/upload/chunk?id=<ID>&offset=<O>     -> {"offset":<O'>}   body = bytes [O, O+chunk)
+ *   {base}/upload/status?id=<ID>               -> {"offset":<O>}
+ * The server's "offset" is the number of bytes it has committed; the client
+ * always continues from that value, so a dropped chunk is re-sent alone.
+ * 
+ * With a control channel set, start and status go as CoAP POSTs to
+ * coap://{host}/upload/start?uid=..&size=..[&stats=<capture stats>] and
+ * /upload/status?id=.. with the same JSON; 2.01/2.04/2.05 map to 200/201 and
+ * 4.xx/5.xx to the matching HTTP status. If CoAP gets no answer the request
+ * is repeated over HTTPS. Chunks always use HTTPS.
+ * 
+ * HTTPS requests go through the modem's AT+HTTP stack, or through an
+ * HttpClient if one is set (setTransport): the chunk body is streamed to the
+ * socket and consecutive requests reuse one connection.
+ */
+
+#ifndef RESUMABLE_UPLOAD_H
+#define RESUMABLE_UPLOAD_H
+
+#include <Arduino.h>
+#include "lte_manager.h"
+#include "coap_client.h"
+#include "http_client.h"
+
+// ============================================
+// UPLOAD STATISTICS (last upload() call)
+// ============================================
+struct UploadStats {
+  uint32_t bytesOnAir;     // HTTP body bytes handed to the modem (including re-sends)
+  uint32_t chunksSent;     // Chunk requests attempted
+  uint32_t chunkRetries;   // Chunk requests that failed and were retried
+  uint32_t resyncs;        // Offset re-queries after a failure
+  uint32_t durationMs;     // Wall time of the call
+  bool resumed;            // Continued an upload session from a previous call
+  bool startBodySent;      // The start request (with its body) was accepted
+  uint32_t coapRequests;   // Control requests answered over CoAP
+  uint32_t coapFallbacks;  // Control requests CoAP could not deliver (sent over HTTPS)
+};
+
+// ============================================
+// RESUMABLE UPLOADER CLASS
+// ============================================
+class ResumableUploader {
+public:
+  // Attach to an initialized LTE manager
+  void init(LTEManager* lteManager);
+  
+  // Upload a clip. If a previous call for the same clip (clipId, uid and
+  // length) failed part way, the existing session is resumed from the
+  // server's committed offset. clipId tells apart clips of the same tag and
+  // length, e.g. the recording start time.
+  // userHeader (optional) is sent with the start request, e.g. capture stats.
+  // startBody (optional) is a JSON body for the start request; it is only sent
+  // when a new session starts - check getLastStats().startBodySent.
+  bool upload(const char* baseUrl, const char* uid, uint32_t clipId, const uint8_t* data, size_t length,
+              const char* userHeader, const char* startBody = nullptr);
+  
+  // Send start/status over CoAP, falling back to HTTPS (nullptr = HTTPS only)
+  void setControlChannel(CoapClient* coap);
+  
+  // Send HTTPS requests through a socket HTTP client (nullptr = AT+HTTP stack)
+  void setTransport(HttpClient* client);
+  
+  // Bytes per chunk request for the next upload() calls (default UPLOAD_CHUNK_SIZE)
+  void setChunkSize(size_t bytes);
+  
+  // Forget any pending session (e.g. the clip was discarded)
+  void abandon();
+  
+  // Statistics for the last upload() call
+  const UploadStats& getLastStats();
+
+private:
+  LTEManager* lte;
+  CoapClient* coap;
+  HttpClient* http;
+  size_t chunkSize;
+  UploadStats stats;
+  
+  // Pending session (kept across upload() calls so retries resume)
+  char uploadId[48];
+  char pendingUid[32];
+  uint32_t pendingClipId;
+  size_t pendingLength;
+  size_t committedOffset;
+  
+  bool startSession(const char* baseUrl, const char* uid, uint32_t clipId, size_t length,
+                    const char* userHeader, const char* startBody);
+  bool sendChunk(const char* baseUrl, const uint8_t* data, size_t offset, size_t chunkLength);
+  bool queryOffset(const char* baseUrl);
+  bool controlRequest(const char* baseUrl, const char* path, const char* query, const char* body,
+                      const char* userHeader, int* statusCode, String& response);
+  bool httpsPost(const char* url, const uint8_t* body, size_t bodyLength, const char* contentType,
+                 const char* userHeader, int* statusCode, String& response);
+  void backoff(int attempt);
+  
+  // Minimal JSON field extraction for server acknowledgements
+  static bool parseJsonLong(const String& json, const char* key, long* value);
+  static bool parseJsonString(const String& json, const char* key, char* out, size_t outSize);
+};
+
+#endif // RESUMABLE_UPLOAD_H
@@ -0,0 +1,203 @@
+/*
+ * scheduler.cpp
+ * 
+ * Implementation of the cooperative timer/event scheduler
+ */
+
+#include "scheduler.h"
+#include "logger.h"
+
+// ============================================
+// BEGIN
+// ============================================
+bool Scheduler::begin() {
+  timerCount = 0;
+  droppedFromISR = 0;
+  startMs = millis();
+  memset(&stats, 0, sizeof(stats));
+  for (uint8_t i = 0; i < SCHED_EVENT_TYPE_COUNT; i++) {
+    handlers[i] = nullptr;
+  }
+  
+  queue = xQueueCreate(SCHED_QUEUE_LENGTH, sizeof(SchedEvent));
+  if (queue == NULL) {
+    LOG_E("Sched", "Failed to create event queue");
+    return false;
+  }
+  return true;
+}
+
+// ============================================
+// TIMERS
+// ============================================
+int8_t Scheduler::addTimer(const char* name, uint32_t periodMs, bool periodic, SchedTimerFn fn, void* arg) {
+  if (timerCount >= SCHED_MAX_TIMERS || fn == nullptr) {
+    Logger::printf(LOG_ERROR, "Sched", "Cannot add timer %s", name);
+    return SCHED_INVALID_TIMER;
+  }
+  
+  Timer& t = timers[timerCount];
+  t.name = name;
+  t.fn = fn;
+  t.arg = arg;
+  t.periodMs = periodMs;
+  t.periodic = periodic;
+  t.deadline = millis() + periodMs;
+  t.armed = true;
+  return (int8_t)timerCount++;
+}
+
+void Scheduler::setTimer(int8_t id, uint32_t delayMs) {
+  if (id < 0 || id >= timerCount) {
+    return;
+  }
+  timers[id].deadline = millis() + delayMs;
+  timers[id].armed = true;
+}
+
+void Scheduler::cancelTimer(int8_t id) {
+  if (id < 0 || id >= timerCount) {
+    return;
+  }
+  timers[id].armed = false;
+}
+
+uint32_t Scheduler::getMsUntilNextTimer() {
+  uint32_t now = millis();
+  uint32_t next = UINT32_MAX;
+  
+  for (uint8_t i = 0; i < timerCount; i++) {
+    if (!timers[i].armed) {
+      continue;
+    }
+    // Signed difference handles millis() wrap
+    int32_t remaining = (int32_t)(timers[i].deadline - now);
+    if (remaining <= 0) {
+      return 0;
+    }
+    if ((uint32_t)remaining < next) {
+      next = remaining;
+    }
+  }
+  return next;
+}
+
+void Scheduler::fireDueTimers() {
+  for (uint8_t i = 0; i < timerCount; i++) {
+    Timer& t = timers[i];
+    if (!t.armed || (int32_t)(t.deadline - millis()) > 0) {
+      continue;
+    }
+    
+    if (t.periodic) {
+      // Keep the cadence; skip missed periods instead of firing a burst
+      t.deadline += t.periodMs;
+      if ((int32_t)(t.deadline - millis()) <= 0) {
+        t.deadline = millis() + t.periodMs;
+      }
+    } else {
+      t.armed = false;
+    }
+    
+    stats.timersFired++;
+    t.fn(t.arg);  // May re-arm itself via setTimer()
+  }
+}
+
+// ============================================
+// EVENTS
+// ============================================
+bool Scheduler::onEvent(uint8_t type, SchedEventFn fn) {
+  if (type >= SCHED_EVENT_TYPE_COUNT) {
+    return false;
+  }
+  handlers[type] = fn;
+  return true;
+}
+
+bool Scheduler::postEvent(uint8_t type, uint32_t arg) {
+  SchedEvent event = { type, arg, (uint32_t)micros() };
+  if (xQueueSend(queue, &event, 0) != pdTRUE) {
+    stats.eventsDropped++;
+    return false;
+  }
+  return true;
+}
+
+bool IRAM_ATTR Scheduler::postEventFromISR(uint8_t type, uint32_t arg) {
+  SchedEvent event = { type, arg, (uint32_t)micros() };
+  BaseType_t woken = pdFALSE;
+  if (xQueueSendFromISR(queue, &event, &woken) != pdTRUE) {
+    droppedFromISR++;
+    return false;
+  }
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+  return true;
+}
+
+void Scheduler::dispatch(const SchedEvent& event) {
+  uint32_t latency = (uint32_t)micros() - event.postedUs;
+  stats.eventsDispatched++;
+  stats.totalDispatchUs += latency;
+  if (latency > stats.maxDispatchUs) {
+    stats.maxDispatchUs = latency;
+  }
+  
+  if (event.type < SCHED_EVENT_TYPE_COUNT && handlers[event.type] != nullptr) {
+    handlers[event.type](event);
+  }
+}
+
+// ============================================
+// RUN (one loop pass)
+// ============================================
+void Scheduler::run(uint32_t maxWaitMs) {
+  uint32_t waitMs = getMsUntilNextTimer();
+  if (waitMs > maxWaitMs) {
+    waitMs = maxWaitMs;
+  }
+  
+  // begin() failed: no event queue, fall back to a plain delay
+  if (queue == NULL) {
+    delay(waitMs);
+    fireDueTimers();
+    return;
+  }
+  
+  // Block until the deadline or the first event
+  SchedEvent event;
+  if (xQueueReceive(queue, &event, pdMS_TO_TICKS(waitMs)) == pdTRUE) {
+    stats.wakeups++;
+    dispatch(event);
+    
+    // Drain whatever else arrived, without waiting
+    while (xQueueReceive(queue, &event, 0) == pdTRUE) {
+      dispatch(event);
+    }
+  } else if (waitMs > 0) {
+    stats.wakeups++;
+  }
+  
+  fireDueTimers();
+}
+
+// ============================================
+// STATISTICS
+// ============================================
+SchedStats Scheduler::getStats() {
+  SchedStats result = stats;
+  result.eventsDropped += droppedFromISR;
+  return result;
+}
+
+void Scheduler::logStats() {
+  SchedStats s = getStats();
+  uint32_t avgUs = s.eventsDispatched ? s.totalDispatchUs / s.eventsDispatched : 0;
+  uint32_t elapsedS = (millis() - startMs) / 1000;
+  float wakeupRate = elapsedS ? (float)s.wakeups / elapsedS : 0.0f;
+  Logger::printf(LOG_INFO, "Sched", "%lu wakeups (%.1f/s), %lu timers, %lu events (avg %lu us, max %lu us), %lu dropped",
+                 (unsigned long)s.wakeups, wakeupRate, (unsigned long)s.timersFired, (unsigned long)s.eventsDispatched,
+                 (unsigned long)avgUs, (unsigned long)s.maxDispatchUs, (unsigned long)s.eventsDropped);
+}
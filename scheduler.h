@@ -0,0 +1,108 @@
+/*
+ * scheduler.h
+ * 
+ * Cooperative timer/event scheduler for the main loop
+ * 
+ * Subsystems register timers (one-shot or periodic) and post events from
+ * ISRs or other tasks. run() blocks on a FreeRTOS queue until the next
+ * timer deadline or the next event, so the CPU idles instead of spinning
+ * through loop() every 10 ms. Callbacks run on the loop task.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+#define SCHED_MAX_TIMERS     12
+#define SCHED_MAX_HANDLERS   8
+#define SCHED_QUEUE_LENGTH   16
+#define SCHED_INVALID_TIMER  -1
+
+// Event types (posted by ISRs / tasks, dispatched on the loop task)
+enum SchedEventType {
+  SCHED_EVENT_WAKE = 0,    // Just wake run(), no handler needed
+  SCHED_EVENT_BUTTON,      // Button edge
+  SCHED_EVENT_NFC_IRQ,     // PN532 IRQ line fell
+  SCHED_EVENT_MODEM_RX,    // Bytes arrived from the modem
+  SCHED_EVENT_TYPE_COUNT
+};
+
+struct SchedEvent {
+  uint8_t type;
+  uint32_t arg;
+  uint32_t postedUs;       // micros() at post time, for dispatch latency
+};
+
+typedef void (*SchedTimerFn)(void* arg);
+typedef void (*SchedEventFn)(const SchedEvent& event);
+
+struct SchedStats {
+  uint32_t wakeups;          // Times run() returned from waiting
+  uint32_t timersFired;
+  uint32_t eventsDispatched;
+  uint32_t eventsDropped;    // Queue full
+  uint32_t maxDispatchUs;    // Worst post-to-dispatch latency
+  uint32_t totalDispatchUs;  // For the average
+};
+
+// ============================================
+// SCHEDULER CLASS
+// ============================================
+class Scheduler {
+public:
+  // Create the event queue
+  bool begin();
+  
+  // Register a timer; first expiry is periodMs from now
+  // Returns a timer id or SCHED_INVALID_TIMER
+  int8_t addTimer(const char* name, uint32_t periodMs, bool periodic, SchedTimerFn fn, void* arg);
+  
+  // Re-arm a timer to fire delayMs from now (also re-enables a cancelled timer)
+  void setTimer(int8_t id, uint32_t delayMs);
+  
+  // Stop a timer without removing it
+  void cancelTimer(int8_t id);
+  
+  // Register a handler for an event type
+  bool onEvent(uint8_t type, SchedEventFn fn);
+  
+  // Post an event (task context / ISR context)
+  bool postEvent(uint8_t type, uint32_t arg = 0);
+  bool IRAM_ATTR postEventFromISR(uint8_t type, uint32_t arg = 0);
+  
+  // Wait for the next timer deadline or event (at most maxWaitMs), then
+  // dispatch everything that is due. Replaces the delay() at the end of loop().
+  void run(uint32_t maxWaitMs);
+  
+  // Milliseconds until the earliest armed timer (UINT32_MAX if none)
+  uint32_t getMsUntilNextTimer();
+  
+  SchedStats getStats();
+  void logStats();
+
+private:
+  struct Timer {
+    const char* name;
+    SchedTimerFn fn;
+    void* arg;
+    uint32_t periodMs;
+    uint32_t deadline;
+    bool periodic;
+    bool armed;
+  };
+  
+  QueueHandle_t queue;
+  Timer timers[SCHED_MAX_TIMERS];
+  uint8_t timerCount;
+  SchedEventFn handlers[SCHED_EVENT_TYPE_COUNT];
+  
+  SchedStats stats;
+  uint32_t startMs;
+  volatile uint32_t droppedFromISR;
+  
+  void dispatch(const SchedEvent& event);
+  void fireDueTimers();
+};
+
+#endif // SCHEDULER_H
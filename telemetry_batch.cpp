@@ -0,0 +1,245 @@
+/*
+ * telemetry_batch.cpp
+ * 
+ * Implementation of the batched telemetry ring
+ */
+
+#include "telemetry_batch.h"
+#include "logger.h"
+
+static const char typeCodes[TELEM_TYPE_COUNT] = { 'T', 'P', 'U', 'S' };
+static const uint8_t typeValues[TELEM_TYPE_COUNT] = { 1, 2, 4, 1 };
+
+// Unsigned LEB128
+static size_t putVarint(uint8_t* out, uint32_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+static uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+TelemetryBatch::TelemetryBatch() {
+  tail = 0;
+  used = 0;
+  count = 0;
+  dropped = 0;
+  headMs = 0;
+  tailMs = 0;
+  memset(headValues, 0, sizeof(headValues));
+  memset(tailValues, 0, sizeof(tailValues));
+  snapshotActive = false;
+  pendingCount = 0;
+  pendingDropped = 0;
+}
+
+// ============================================
+// RECORD
+// ============================================
+bool TelemetryBatch::record(uint32_t nowMs, uint8_t type, int32_t v0, int32_t v1, int32_t v2, int32_t v3) {
+  if (type >= TELEM_TYPE_COUNT) {
+    return false;
+  }
+  if (count == 0 && !snapshotActive) {
+    // Nothing to be relative to: restart both ends at this event
+    headMs = nowMs;
+    tailMs = nowMs;
+    memcpy(tailValues, headValues, sizeof(tailValues));
+  }
+  
+  int32_t values[TELEM_MAX_VALUES] = { v0, v1, v2, v3 };
+  uint8_t encoded[TELEM_MAX_RECORD];
+  uint32_t units = (nowMs - headMs) / TELEMETRY_TIME_UNIT_MS;
+  size_t n = 0;
+  encoded[n++] = type;
+  n += putVarint(encoded + n, units);
+  for (uint8_t i = 0; i < typeValues[type]; i++) {
+    n += putVarint(encoded + n, zigzag((int32_t)((uint32_t)values[i] - (uint32_t)headValues[type][i])));
+  }
+  
+  while (used + n > TELEMETRY_RING_BYTES && count > 0) {
+    popOldest();
+    if (pendingCount > 0) {
+      pendingCount--;       // Was in the snapshot; no longer ours to drop on delivery
+    } else {
+      dropped++;
+    }
+  }
+  
+  for (size_t i = 0; i < n; i++) {
+    ring[(tail + used + i) % TELEMETRY_RING_BYTES] = encoded[i];
+  }
+  used += n;
+  count++;
+  
+  // Quantized, so the decoder reconstructs the same times
+  headMs += units * TELEMETRY_TIME_UNIT_MS;
+  memcpy(headValues[type], values, sizeof(values[0]) * typeValues[type]);
+  return true;
+}
+
+// ============================================
+// DECODE (record at offset bytes from the tail)
+// ============================================
+size_t TelemetryBatch::decode(size_t offset, uint32_t* ms, int32_t values[][TELEM_MAX_VALUES], uint8_t* type) {
+  size_t n = 0;
+  *type = ring[(tail + offset) % TELEMETRY_RING_BYTES];
+  n++;
+  
+  uint32_t fields[1 + TELEM_MAX_VALUES];
+  for (uint8_t f = 0; f < 1 + typeValues[*type]; f++) {
+    uint32_t value = 0;
+    uint8_t shift = 0;
+    uint8_t b;
+    do {
+      b = ring[(tail + offset + n) % TELEMETRY_RING_BYTES];
+      n++;
+      value |= (uint32_t)(b & 0x7F) << shift;
+      shift += 7;
+    } while ((b & 0x80) && shift < 35);
+    fields[f] = value;
+  }
+  
+  *ms += fields[0] * TELEMETRY_TIME_UNIT_MS;
+  for (uint8_t i = 0; i < typeValues[*type]; i++) {
+    values[*type][i] = (int32_t)((uint32_t)values[*type][i] + (uint32_t)unzigzag(fields[1 + i]));
+  }
+  return n;
+}
+
+void TelemetryBatch::popOldest() {
+  uint8_t type;
+  size_t n = decode(0, &tailMs, tailValues, &type);
+  tail = (tail + n) % TELEMETRY_RING_BYTES;
+  used -= n;
+  count--;
+}
+
+// ============================================
+// SNAPSHOT
+// ============================================
+bool TelemetryBatch::snapshot(char* out, size_t outSize, uint32_t nowMs) {
+  if (snapshotActive) {
+    finish(false);  // Previous snapshot was never resolved
+  }
+  if (count == 0) {
+    return false;
+  }
+  
+  // Walk a copy of the decoder state; the ring is only consumed on finish(true)
+  uint32_t ms = tailMs;
+  int32_t values[TELEM_TYPE_COUNT][TELEM_MAX_VALUES];
+  memcpy(values, tailValues, sizeof(values));
+  int32_t sent[TELEM_TYPE_COUNT][TELEM_MAX_VALUES];
+  bool seen[TELEM_TYPE_COUNT] = { false };
+  
+  uint8_t type;
+  size_t offset = decode(0, &ms, values, &type);
+  uint32_t firstMs = ms;
+  uint32_t previousMs = ms;
+  
+  int pos = snprintf(out, outSize, "{\"events\":{\"unit_ms\":%u,\"age\":%lu,\"dropped\":%lu,\"e\":\"",
+                     TELEMETRY_TIME_UNIT_MS, (unsigned long)(nowMs - firstMs), (unsigned long)dropped);
+  if (pos < 0 || (size_t)pos + 4 > outSize) {
+    return false;
+  }
+  
+  uint16_t formatted = 0;
+  while (true) {
+    // One record: code, time step, then absolute-or-delta values
+    char text[12 + TELEM_MAX_VALUES * 12];
+    int n = snprintf(text, sizeof(text), "%s%c%lu", formatted > 0 ? ";" : "", typeCodes[type],
+                     (unsigned long)((ms - previousMs) / TELEMETRY_TIME_UNIT_MS));
+    for (uint8_t i = 0; i < typeValues[type]; i++) {
+      int32_t v = seen[type] ? (int32_t)((uint32_t)values[type][i] - (uint32_t)sent[type][i]) : values[type][i];
+      n += snprintf(text + n, sizeof(text) - n, ",%ld", (long)v);
+    }
+    
+    if ((size_t)pos + n + 4 > outSize) {
+      break;  // Keep the rest for the next batch
+    }
+    memcpy(out + pos, text, n);
+    pos += n;
+    memcpy(sent[type], values[type], sizeof(values[type]));
+    seen[type] = true;
+    previousMs = ms;
+    formatted++;
+    
+    if (formatted == count) {
+      break;
+    }
+    offset += decode(offset, &ms, values, &type);
+  }
+  
+  if (formatted == 0) {
+    Logger::printf(LOG_WARN, "Telemetry", "Batch does not fit %u bytes", outSize);
+    return false;
+  }
+  strcpy(out + pos, "\"}}");
+  
+  snapshotActive = true;
+  pendingCount = formatted;
+  pendingDropped = dropped;
+  Logger::printf(LOG_DEBUG, "Telemetry", "Batch: %u/%u events, %u ring bytes, %d JSON bytes",
+                 formatted, count, used, pos + 3);
+  return true;
+}
+
+// ============================================
+// FINISH (consume or keep the snapshot)
+// ============================================
+void TelemetryBatch::finish(bool delivered) {
+  if (!snapshotActive) {
+    return;
+  }
+  if (delivered) {
+    while (pendingCount > 0) {
+      popOldest();
+      pendingCount--;
+    }
+    dropped -= pendingDropped;
+  }
+  pendingCount = 0;
+  pendingDropped = 0;
+  snapshotActive = false;
+}
+
+// ============================================
+// FLUSH POLICY
+// ============================================
+bool TelemetryBatch::isFlushDue(uint32_t nowMs) {
+  if (count == 0) {
+    return false;
+  }
+  if (used * 100 >= (size_t)TELEMETRY_RING_BYTES * TELEMETRY_FLUSH_FILL_PERCENT) {
+    return true;
+  }
+  uint32_t oldestMs = tailMs;
+  int32_t values[TELEM_TYPE_COUNT][TELEM_MAX_VALUES];
+  memcpy(values, tailValues, sizeof(values));
+  uint8_t type;
+  decode(0, &oldestMs, values, &type);
+  return nowMs - oldestMs >= TELEMETRY_FLUSH_INTERVAL_MS;
+}
+
+uint16_t TelemetryBatch::getCount() {
+  return count;
+}
+
+size_t TelemetryBatch::getBytesUsed() {
+  return used;
+}
+
+uint32_t TelemetryBatch::getDropped() {
+  return dropped;
+}
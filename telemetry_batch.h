@@ -0,0 +1,94 @@
+/*
+ * telemetry_batch.h
+ * 
+ * Batched telemetry events in a delta-encoded ring
+ * 
+ * Sending every event as it happens would wake the radio (RRC setup plus
+ * the inactivity tail, ~10 s) for a few bytes each time. Events are kept
+ * here instead and sent together: piggybacked on the next upload's start
+ * request, or on their own once isFlushDue().
+ * 
+ * Ring record: type byte, time since the previous event in
+ * TELEMETRY_TIME_UNIT_MS units (varint), then one zigzag varint per value
+ * with the change from the previous event of the same type. A typical event
+ * takes 3-6 bytes. When the ring is full the oldest events are dropped and
+ * counted.
+ * 
+ * snapshot() formats the events as compact text in the same delta form:
+ *   {"events":{"unit_ms":100,"age":8600,"dropped":0,"e":"T0,1;S0,18;P31,48000,850"}}
+ * "age" is how long ago (ms) the first event happened. Each ';' record is a
+ * type code, the time since the previous record, and the values. A value is
+ * absolute the first time its type appears in the batch and a delta after
+ * that. Codes: T tap (action), P playback (bytes, tap-to-audio ms),
+ * U upload (bytes on air, ms, chunk retries, ok), S signal (CSQ).
+ * Like LatencyReport, finish(false) keeps the events for the next batch.
+ */
+
+#ifndef TELEMETRY_BATCH_H
+#define TELEMETRY_BATCH_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define TELEM_MAX_VALUES     4
+#define TELEM_MAX_RECORD     (1 + 5 + TELEM_MAX_VALUES * 5)   // Worst-case encoded event
+
+// ============================================
+// EVENT TYPES
+// ============================================
+enum TelemetryEventType {
+  TELEM_TAP = 0,           // Playback/record request (value: ActionType)
+  TELEM_PLAYBACK,          // Playback complete (audio bytes, tap-to-audio ms)
+  TELEM_UPLOAD,            // Upload finished (bytes on air, ms, chunk retries, 1 = ok)
+  TELEM_SIGNAL,            // Signal quality before a transfer (CSQ 0-31, 99 = unknown)
+  TELEM_TYPE_COUNT
+};
+
+// ============================================
+// TELEMETRY BATCH CLASS
+// ============================================
+class TelemetryBatch {
+public:
+  TelemetryBatch();
+  
+  // Add an event; unused values are ignored for types with fewer
+  bool record(uint32_t nowMs, uint8_t type, int32_t v0 = 0, int32_t v1 = 0, int32_t v2 = 0, int32_t v3 = 0);
+  
+  // Format the held events (as many as fit). Returns false if there are none.
+  bool snapshot(char* out, size_t outSize, uint32_t nowMs);
+  
+  // Batch delivered (drop its events) or not (keep them)
+  void finish(bool delivered);
+  
+  // Worth a radio wake-up of its own: ring TELEMETRY_FLUSH_FILL_PERCENT full,
+  // or the oldest event is TELEMETRY_FLUSH_INTERVAL_MS old
+  bool isFlushDue(uint32_t nowMs);
+  
+  uint16_t getCount();
+  size_t getBytesUsed();
+  uint32_t getDropped();       // Events lost to overflow, not yet reported
+
+private:
+  uint8_t ring[TELEMETRY_RING_BYTES];
+  size_t tail;                 // Oldest record
+  size_t used;
+  uint16_t count;
+  uint32_t dropped;
+  
+  // Time and last values at the newest record (encoder) and just before
+  // the oldest one (decoder); values are per type
+  uint32_t headMs;
+  int32_t headValues[TELEM_TYPE_COUNT][TELEM_MAX_VALUES];
+  uint32_t tailMs;
+  int32_t tailValues[TELEM_TYPE_COUNT][TELEM_MAX_VALUES];
+  
+  // Snapshot in flight
+  bool snapshotActive;
+  uint16_t pendingCount;
+  uint32_t pendingDropped;
+  
+  size_t decode(size_t offset, uint32_t* ms, int32_t values[][TELEM_MAX_VALUES], uint8_t* type);
+  void popOldest();
+};
+
+#endif // TELEMETRY_BATCH_H
@@ -0,0 +1,205 @@
+/*
+ * host_bench.cpp
+ * 
+ * Host counterpart of esp32_benchmark.ino.bak for the pure-logic modules
+ * 
+ * Same output format (one "BENCH {json}" line per benchmark), timed with
+ * the host's steady clock. On the host every allocation is counted, so
+ * allocs_per_op is exact (the device sketch can only report net heap
+ * growth). Numbers are for regression gating between commits on one
+ * machine; they say nothing absolute about the ESP32.
+ * 
+ * Usage: host_bench [samples]   (default 4096; ctest runs a short pass)
+ */
+
+#include <Arduino.h>
+#include "config.h"
+#include "logger.h"
+#include "ndef_parser.h"
+#include "gesture_recognizer.h"
+#include "nfc_duty_cycle.h"
+#include "latency_histogram.h"
+#include "telemetry_batch.h"
+#include "adaptive_timeout.h"
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <vector>
+
+#define BENCH_WARMUP  8
+
+static uint64_t allocations = 0;
+
+void* operator new(size_t size) {
+  allocations++;
+  void* p = malloc(size ? size : 1);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+static GestureRecognizer gestures;
+static NfcDutyCycle dutyCycle;
+static LatencyHistogram histogram;
+static TelemetryBatch telemetry;
+static AdaptiveTimeout timeouts;
+
+static uint8_t ndefArea[128];
+static size_t ndefLength = 0;
+static uint32_t fakeClockMs = 0;
+
+// ============================================
+// HARNESS
+// ============================================
+typedef void (*BenchFn)();
+
+static uint64_t nowNs() {
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+static void runBench(const char* name, BenchFn fn, uint32_t n, uint32_t itemsPerOp, const char* unit) {
+  for (int i = 0; i < BENCH_WARMUP; i++) {
+    fn();
+  }
+  
+  std::vector<uint64_t> samples(n);
+  uint64_t allocsBefore = allocations;
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    uint64_t start = nowNs();
+    fn();
+    samples[i] = nowNs() - start;
+    total += samples[i];
+  }
+  uint64_t allocs = allocations - allocsBefore;
+  
+  std::sort(samples.begin(), samples.end());
+  double meanNs = (double)total / n;
+  double throughput = (meanNs > 0) ? itemsPerOp * 1e9 / meanNs : 0;
+  printf("BENCH {\"name\":\"%s\",\"n\":%u,\"p50_ns\":%llu,\"p99_ns\":%llu,\"mean_ns\":%.0f,"
+         "\"throughput\":%.0f,\"unit\":\"%s\",\"allocs_per_op\":%.2f}\n",
+         name, n, (unsigned long long)samples[n / 2], (unsigned long long)samples[(n * 99) / 100],
+         meanNs, throughput, unit, (double)allocs / n);
+}
+
+// ============================================
+// BENCHMARKS
+// ============================================
+static void benchLogFiltered() {
+  Logger::printf(LOG_DEBUG, "Bench", "filtered %d %s", 42, "value");
+}
+
+static void benchNdefFind() {
+  const uint8_t* message;
+  size_t messageLength;
+  NdefParser::findMessage(ndefArea, ndefLength, &message, &messageLength);
+}
+
+static void benchNdefHints() {
+  NdefTagHints hints;
+  NdefParser::parseHints(ndefArea, ndefLength, hints);
+}
+
+static void benchGestureTap() {
+  // One full tap: press, release, tap-gap timeout
+  fakeClockMs += 1000;
+  gestures.onEdge(true, fakeClockMs);
+  gestures.onEdge(false, fakeClockMs + 80);
+  gestures.update(fakeClockMs + 80 + GESTURE_TAP_GAP_MS);
+  gestures.clear();
+}
+
+static void benchDutyCycleUpdate() {
+  fakeClockMs += 50;
+  dutyCycle.update(fakeClockMs, false);
+}
+
+static void benchHistogramRecord() {
+  fakeClockMs += 37;
+  histogram.record(fakeClockMs & 0xFFFF);
+}
+
+static void benchHistogramPercentile() {
+  histogram.getPercentile(99.0f);
+}
+
+static void benchTelemetryRecord() {
+  fakeClockMs += 1700;
+  telemetry.record(fakeClockMs, TELEM_PLAYBACK, 48000 + (fakeClockMs & 0x3FF), 600 + (fakeClockMs & 0xFF));
+}
+
+static void benchTimeoutLookup() {
+  // Lookup plus the answer that follows it, as LTEManager does per command
+  fakeClockMs += 13;
+  timeouts.get("AT+HTTPACTION=0,\"x\"", 60000);
+  timeouts.onResponse("AT+HTTPACTION=0,\"x\"", 900 + (fakeClockMs & 0x1FF));
+}
+
+// ============================================
+// SYNTHETIC INPUT
+// ============================================
+static size_t appendExternalRecord(uint8_t* out, uint8_t header, const char* type, const char* payload) {
+  size_t typeLength = strlen(type);
+  size_t payloadLength = strlen(payload);
+  out[0] = header;
+  out[1] = (uint8_t)typeLength;
+  out[2] = (uint8_t)payloadLength;
+  memcpy(out + 3, type, typeLength);
+  memcpy(out + 3 + typeLength, payload, payloadLength);
+  return 3 + typeLength + payloadLength;
+}
+
+static void buildNdefArea() {
+  // Type 2 tag data area: NULL TLV padding, NDEF TLV with msg ID + version records, terminator
+  uint8_t message[96];
+  size_t messageLength = 0;
+  messageLength += appendExternalRecord(message, 0x94, NDEF_HINT_TYPE_MSG_ID, "greeting-0042");
+  messageLength += appendExternalRecord(message + messageLength, 0x54, NDEF_HINT_TYPE_VERSION, "v7");
+  
+  size_t pos = 0;
+  ndefArea[pos++] = 0x00;  // NULL TLV
+  ndefArea[pos++] = 0x03;  // NDEF message TLV
+  ndefArea[pos++] = (uint8_t)messageLength;
+  memcpy(ndefArea + pos, message, messageLength);
+  pos += messageLength;
+  ndefArea[pos++] = 0xFE;  // Terminator
+  ndefLength = pos;
+}
+
+int main(int argc, char** argv) {
+  uint32_t n = (argc > 1) ? (uint32_t)strtoul(argv[1], nullptr, 10) : 4096;
+  if (n == 0) {
+    n = 1;
+  }
+  
+  printf("BENCH_START {\"host\":true,\"samples\":%u}\n", n);
+  buildNdefArea();
+  gestures.init(GESTURE_TAP_GAP_MS, LONG_PRESS_MS, GESTURE_REPEAT_MS, GESTURE_HOLD_GAP_MS);
+  dutyCycle.configure(NFC_FIELD_ON_MS, NFC_FIELD_OFF_MIN_MS, NFC_FIELD_OFF_MAX_MS, NFC_BACKOFF_WINDOWS);
+  timeouts.clear();
+  
+  Logger::setLogLevel(LOG_INFO);
+  runBench("log_filtered", benchLogFiltered, n, 1, "ops/s");
+  runBench("ndef_find_message", benchNdefFind, n, 1, "ops/s");
+  runBench("ndef_parse_hints", benchNdefHints, n, 1, "ops/s");
+  runBench("gesture_tap", benchGestureTap, n, 1, "gestures/s");
+  runBench("nfc_duty_update", benchDutyCycleUpdate, n, 1, "ops/s");
+  runBench("histogram_record", benchHistogramRecord, n, 1, "ops/s");
+  runBench("histogram_p99", benchHistogramPercentile, n, 1, "ops/s");
+  runBench("telemetry_record", benchTelemetryRecord, n, 1, "events/s");
+  Logger::setLogLevel(LOG_WARN);
+  runBench("rto_lookup_answer", benchTimeoutLookup, n, 1, "ops/s");
+  
+  printf("BENCH_DONE\n");
+  return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * host_test.h
+ * 
+ * Minimal check macros for the host tests (no framework dependency)
+ * 
+ * Each test is its own executable: main() calls each test function through
+ * RUN_TEST, CHECK failures are printed and counted, and HOST_TEST_RESULT()
+ * is the exit code ctest looks at.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <string.h>
+
+static int hostTestFailures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      hostTestFailures++; \
+    } \
+  } while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+    long long a_ = (long long)(actual); \
+    long long e_ = (long long)(expected); \
+    if (a_ != e_) { \
+      printf("FAIL %s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+      hostTestFailures++; \
+    } \
+  } while (0)
+
+#define CHECK_STR(actual, expected) do { \
+    const char* a_ = (actual); \
+    const char* e_ = (expected); \
+    if (strcmp(a_, e_) != 0) { \
+      printf("FAIL %s:%d: %s == \"%s\", expected \"%s\"\n", __FILE__, __LINE__, #actual, a_, e_); \
+      hostTestFailures++; \
+    } \
+  } while (0)
+
+#define RUN_TEST(fn) do { \
+    int before_ = hostTestFailures; \
+    fn(); \
+    printf("%s %s\n", (hostTestFailures == before_) ? "ok  " : "FAIL", #fn); \
+  } while (0)
+
+#define HOST_TEST_RESULT() ((hostTestFailures == 0) ? 0 : 1)
+
+#endif // HOST_TEST_H
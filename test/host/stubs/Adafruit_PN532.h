@@ -0,0 +1,55 @@
+/*
+ * Adafruit_PN532.h (host stub)
+ * 
+ * A simulated PN532 on I2C with its IRQ line on a simulated pin. Commands
+ * take PN532_HOST_CMD_US (I2C write + ACK). InListPassiveTarget answers
+ * PN532_HOST_ANSWER_US after a card is in the field; for a detection armed
+ * with startPassiveTargetIDDetection() the response is signalled by IRQ
+ * going low at that moment, with no I2C traffic while waiting. Any new
+ * command aborts a pending InListPassiveTarget. IRQ goes high again once
+ * the response is read. readPassiveTargetID() with timeout 0 makes one
+ * activation attempt instead of waiting for ever.
+ */
+
+#ifndef HOST_ADAFRUIT_PN532_H
+#define HOST_ADAFRUIT_PN532_H
+
+#include <Arduino.h>
+
+#define PN532_MIFARE_ISO14443A          0x00
+#define PN532_COMMAND_RFCONFIGURATION   0x32
+#define PN532_I2C_ADDRESS               (0x48 >> 1)
+
+#define PN532_HOST_CMD_US     1000   // I2C write + ACK
+#define PN532_HOST_ANSWER_US  4000   // Card in field to InListPassiveTarget response
+#define PN532_HOST_READ_US    600    // Reading a response frame
+#define PN532_HOST_PAGE_US    1500   // NTAG READ via InDataExchange
+#define PN532_HOST_POLL_MS    30     // One activation attempt with no card
+
+class Adafruit_PN532 {
+public:
+  Adafruit_PN532(uint8_t irq, uint8_t reset);
+  
+  void begin();
+  uint32_t getFirmwareVersion();
+  bool SAMConfig();
+  
+  bool readPassiveTargetID(uint8_t cardbaudrate, uint8_t* uid, uint8_t* uidLength, uint16_t timeout = 0);
+  bool startPassiveTargetIDDetection(uint8_t cardbaudrate);
+  bool readDetectedPassiveTargetID(uint8_t* uid, uint8_t* uidLength);
+  uint8_t ntag2xx_ReadPage(uint8_t page, uint8_t* buffer);
+  bool sendCommandCheckAck(uint8_t* cmd, uint8_t cmdlen, uint16_t timeout = 100);
+};
+
+// ============================================
+// SIMULATED CARD (test controls)
+// ============================================
+// Put a card in the field; memory is the NTAG user memory from page 0
+void hostPn532PresentCard(const uint8_t* uid, uint8_t uidLength, const uint8_t* memory, size_t memoryLength);
+void hostPn532RemoveCard();
+
+bool hostPn532FieldOn();
+uint32_t hostPn532Transactions();   // I2C transactions since start
+uint32_t hostPn532PageReads();
+
+#endif // HOST_ADAFRUIT_PN532_H
@@ -0,0 +1,99 @@
+/*
+ * Arduino.h (host stub)
+ * 
+ * Just enough of the Arduino-ESP32 core for the pure-logic modules to build
+ * and run on a PC. Time comes from a clock the test drives by hand, so runs
+ * are deterministic; Serial writes to stdout. Simulated peripherals hang
+ * events on the clock (hostScheduleAt) and drive input pins, which fires
+ * attached interrupt handlers on the matching edge.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/queue.h>
+
+#define IRAM_ATTR
+
+// ============================================
+// TIME (simulated)
+// ============================================
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// Test controls for the simulated clock
+void hostSetMillis(unsigned long ms);
+void hostAdvanceMillis(unsigned long ms);
+
+// Run fn(arg) when the clock reaches atUs (micros() reads atUs inside fn)
+void hostScheduleAt(unsigned long atUs, void (*fn)(void*), void* arg);
+
+// Advance until done(arg) or deadlineUs, whichever comes first (how a
+// blocked task waits); returns done(arg)
+bool hostWaitUntil(unsigned long deadlineUs, bool (*done)(void*), void* arg);
+
+// ============================================
+// GPIO AND INTERRUPTS (simulated pins)
+// ============================================
+#define LOW           0
+#define HIGH          1
+#define INPUT         0x01
+#define OUTPUT        0x03
+#define INPUT_PULLUP  0x05
+#define RISING        0x01
+#define FALLING       0x02
+#define CHANGE        0x03
+
+#define digitalPinToInterrupt(pin)  (pin)
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode);
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+// Drive an input pin from outside (fires an attached handler on its edge)
+void hostSetPin(uint8_t pin, int level);
+
+// ============================================
+// SERIAL
+// ============================================
+class HardwareSerial {
+public:
+  void begin(unsigned long baud);
+  void print(const char* text);
+  void println(const char* text);
+  void println();
+  int printf(const char* format, ...);
+  void flush();
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// ============================================
+// CHIP (cycle counter from the host's steady clock)
+// ============================================
+class EspClass {
+public:
+  uint32_t getCycleCount();
+  uint32_t getFreeHeap();
+};
+
+extern EspClass ESP;
+
+uint32_t getCpuFrequencyMhz();
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,78 @@
+/*
+ * LittleFS.h (host stub)
+ * 
+ * In-memory filesystem with the File/LittleFS calls the firmware uses.
+ * Every write lands at once, as if each were committed; a test can cut
+ * power after a byte budget (later writes come up short, as a torn record
+ * would) and then remount by calling begin() on a fresh object.
+ */
+
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+// ============================================
+// FILE HANDLE
+// ============================================
+class File {
+public:
+  File();
+  
+  operator bool() const;
+  const char* name() const;
+  size_t size() const;
+  
+  size_t read(uint8_t* buffer, size_t length);
+  int read();
+  int available();
+  size_t write(const uint8_t* buffer, size_t length);
+  size_t write(uint8_t b);
+  bool seek(uint32_t pos);
+  size_t position() const;
+  void flush();
+  void close();
+  
+  // Directory handles only
+  File openNextFile();
+
+private:
+  friend class LittleFSHost;
+  
+  bool valid;
+  bool isDir;
+  bool writable;
+  bool append;
+  std::string path;
+  std::string baseName;
+  size_t pos;
+  std::vector<std::string> listing;
+  size_t listPos;
+};
+
+// ============================================
+// FILESYSTEM
+// ============================================
+class LittleFSHost {
+public:
+  bool begin(bool formatOnFail);
+  bool exists(const char* path);
+  bool mkdir(const char* path);
+  File open(const char* path, const char* mode = "r");
+  bool remove(const char* path);
+  bool rename(const char* from, const char* to);
+  
+  // Test controls
+  void hostFormat();                          // Erase everything
+  void hostCutPowerAfter(size_t bytes);       // Writes past this budget are lost
+  void hostRestorePower();
+  bool hostPowerCut();
+  std::vector<uint8_t>* hostData(const char* path);  // Raw contents (nullptr if absent)
+  size_t hostBytesWritten();
+};
+
+extern LittleFSHost LittleFS;
+
+#endif // HOST_LITTLEFS_H
@@ -0,0 +1,34 @@
+/*
+ * Preferences.h (host stub)
+ * 
+ * NVS key/value store kept in memory for the life of the test process
+ */
+
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <Arduino.h>
+#include <string>
+
+class Preferences {
+public:
+  Preferences();
+  
+  bool begin(const char* name, bool readOnly);
+  void end();
+  
+  size_t getBytesLength(const char* key);
+  size_t getBytes(const char* key, void* buffer, size_t length);
+  size_t putBytes(const char* key, const void* value, size_t length);
+  bool remove(const char* key);
+  
+  // Test control: erase every namespace
+  static void hostErase();
+
+private:
+  std::string space;
+  bool opened;
+  bool readOnly;
+};
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,26 @@
+/*
+ * Wire.h (host stub)
+ * 
+ * I2C master. Reads are answered by the simulated device at the address
+ * (only the PN532, see Adafruit_PN532.h).
+ */
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+  bool begin(int sda, int scl);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity);
+  int available();
+  int read();
+
+private:
+  uint8_t pending;
+};
+
+extern TwoWire Wire;
+
+#endif // HOST_WIRE_H
@@ -0,0 +1,238 @@
+/*
+ * arduino_host.cpp
+ * 
+ * Host implementation of the Arduino stub (clock, events, GPIO, Serial, ESP)
+ */
+
+#include <Arduino.h>
+#include <soc/gpio_reg.h>
+#include <stdarg.h>
+#include <chrono>
+#include <vector>
+
+#define HOST_CPU_MHZ    240
+#define HOST_PIN_COUNT  40
+
+static unsigned long hostMicros = 0;
+
+struct HostEvent {
+  unsigned long atUs;
+  void (*fn)(void*);
+  void* arg;
+};
+
+static std::vector<HostEvent> events;
+
+// Move the clock to targetUs, running due events in time order on the way;
+// stops right after an event that makes done() true
+static void advanceTo(unsigned long targetUs, bool (*done)(void*), void* arg) {
+  for (;;) {
+    size_t next = events.size();
+    for (size_t i = 0; i < events.size(); i++) {
+      if (events[i].atUs <= targetUs && (next == events.size() || events[i].atUs < events[next].atUs)) {
+        next = i;
+      }
+    }
+    if (next == events.size()) {
+      break;
+    }
+    HostEvent event = events[next];
+    events.erase(events.begin() + next);
+    if (event.atUs > hostMicros) {
+      hostMicros = event.atUs;
+    }
+    event.fn(event.arg);
+    if (done != nullptr && done(arg)) {
+      return;
+    }
+  }
+  if (targetUs > hostMicros) {
+    hostMicros = targetUs;
+  }
+}
+
+static void advanceTo(unsigned long targetUs) {
+  advanceTo(targetUs, nullptr, nullptr);
+}
+
+// ============================================
+// TIME
+// ============================================
+unsigned long millis() {
+  return hostMicros / 1000;
+}
+
+unsigned long micros() {
+  return hostMicros;
+}
+
+void delay(uint32_t ms) {
+  advanceTo(hostMicros + (unsigned long)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+  advanceTo(hostMicros + us);
+}
+
+void hostSetMillis(unsigned long ms) {
+  if (ms * 1000 >= hostMicros) {
+    advanceTo(ms * 1000);
+  } else {
+    hostMicros = ms * 1000;
+  }
+}
+
+void hostAdvanceMillis(unsigned long ms) {
+  advanceTo(hostMicros + ms * 1000);
+}
+
+bool hostWaitUntil(unsigned long deadlineUs, bool (*done)(void*), void* arg) {
+  if (done(arg)) {
+    return true;
+  }
+  advanceTo(deadlineUs, done, arg);
+  return done(arg);
+}
+
+void hostScheduleAt(unsigned long atUs, void (*fn)(void*), void* arg) {
+  HostEvent event = { atUs, fn, arg };
+  events.push_back(event);
+}
+
+// ============================================
+// GPIO AND INTERRUPTS
+// ============================================
+struct HostPin {
+  int level;
+  int mode;                     // Interrupt edge, 0 = none
+  void (*handler)();
+  void (*handlerArg)(void*);
+  void* arg;
+};
+
+static HostPin pins[HOST_PIN_COUNT];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < HOST_PIN_COUNT && mode == INPUT_PULLUP) {
+    pins[pin].level = HIGH;
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  return (pin < HOST_PIN_COUNT) ? pins[pin].level : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin < HOST_PIN_COUNT) {
+    pins[pin].level = level ? HIGH : LOW;
+  }
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode) {
+  if (pin < HOST_PIN_COUNT) {
+    pins[pin].mode = mode;
+    pins[pin].handler = handler;
+    pins[pin].handlerArg = nullptr;
+  }
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode) {
+  if (pin < HOST_PIN_COUNT) {
+    pins[pin].mode = mode;
+    pins[pin].handler = nullptr;
+    pins[pin].handlerArg = handler;
+    pins[pin].arg = arg;
+  }
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin < HOST_PIN_COUNT) {
+    pins[pin].mode = 0;
+    pins[pin].handler = nullptr;
+    pins[pin].handlerArg = nullptr;
+  }
+}
+
+uint32_t hostGpioInReg(int reg) {
+  uint32_t value = 0;
+  int first = (reg == GPIO_IN_REG) ? 0 : 32;
+  for (int bit = 0; bit < 32 && first + bit < HOST_PIN_COUNT; bit++) {
+    if (pins[first + bit].level == HIGH) {
+      value |= 1UL << bit;
+    }
+  }
+  return value;
+}
+
+void hostSetPin(uint8_t pin, int level) {
+  if (pin >= HOST_PIN_COUNT) {
+    return;
+  }
+  HostPin& p = pins[pin];
+  level = level ? HIGH : LOW;
+  bool rising = p.level == LOW && level == HIGH;
+  bool falling = p.level == HIGH && level == LOW;
+  p.level = level;
+  
+  if ((rising && (p.mode & RISING)) || (falling && (p.mode & FALLING))) {
+    if (p.handler != nullptr) {
+      p.handler();
+    } else if (p.handlerArg != nullptr) {
+      p.handlerArg(p.arg);
+    }
+  }
+}
+
+// ============================================
+// SERIAL
+// ============================================
+HardwareSerial Serial;
+
+void HardwareSerial::begin(unsigned long baud) {
+  (void)baud;
+}
+
+void HardwareSerial::print(const char* text) {
+  fputs(text, stdout);
+}
+
+void HardwareSerial::println(const char* text) {
+  fputs(text, stdout);
+  fputc('\n', stdout);
+}
+
+void HardwareSerial::println() {
+  fputc('\n', stdout);
+}
+
+int HardwareSerial::printf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int n = vprintf(format, args);
+  va_end(args);
+  return n;
+}
+
+void HardwareSerial::flush() {
+  fflush(stdout);
+}
+
+// ============================================
+// CHIP
+// ============================================
+EspClass ESP;
+
+uint32_t EspClass::getCycleCount() {
+  // Real time, not the simulated clock: the profiler measures host code
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+  return (uint32_t)(ns * HOST_CPU_MHZ / 1000);
+}
+
+uint32_t EspClass::getFreeHeap() {
+  return 0;
+}
+
+uint32_t getCpuFrequencyMhz() {
+  return HOST_CPU_MHZ;
+}
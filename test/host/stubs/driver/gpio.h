@@ -0,0 +1,29 @@
+/*
+ * driver/gpio.h (host stub)
+ * 
+ * GPIO wakeup sources for light sleep; nothing sleeps on the host
+ */
+
+#ifndef HOST_DRIVER_GPIO_H
+#define HOST_DRIVER_GPIO_H
+
+#include <esp_err.h>
+
+typedef int gpio_num_t;
+
+typedef enum {
+  GPIO_INTR_DISABLE = 0,
+  GPIO_INTR_POSEDGE = 1,
+  GPIO_INTR_NEGEDGE = 2,
+  GPIO_INTR_ANYEDGE = 3,
+  GPIO_INTR_LOW_LEVEL = 4,
+  GPIO_INTR_HIGH_LEVEL = 5
+} gpio_int_type_t;
+
+inline esp_err_t gpio_wakeup_enable(gpio_num_t pin, gpio_int_type_t type) {
+  (void)pin;
+  (void)type;
+  return ESP_OK;
+}
+
+#endif // HOST_DRIVER_GPIO_H
@@ -0,0 +1,100 @@
+/*
+ * driver/i2s.h (host stub)
+ * 
+ * The legacy ESP-IDF I2S driver API, backed by a simulated SPH0645 on
+ * I2S_NUM_0. Frames arrive at the configured sample rate on the simulated
+ * clock into a DMA ring of dma_buf_count * dma_buf_len frames; a read with
+ * ticks == 0 returns what has arrived, otherwise it waits for the rest.
+ * i2s_zero_dma_buffer() drops what is queued. Left slots carry the current
+ * pattern, right slots stay 0.
+ * A test can switch the mic to stuck-at-0x00000000 or stuck-at-0x00000001
+ * output, optionally clearing on the next driver install (an I2S restart).
+ */
+
+#ifndef HOST_DRIVER_I2S_H
+#define HOST_DRIVER_I2S_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_err.h>
+
+#define ESP_INTR_FLAG_LEVEL1  (1 << 1)
+#define I2S_PIN_NO_CHANGE     (-1)
+
+typedef enum { I2S_NUM_0 = 0, I2S_NUM_1 = 1, I2S_NUM_MAX } i2s_port_t;
+
+typedef enum {
+  I2S_MODE_MASTER = 1,
+  I2S_MODE_SLAVE = 2,
+  I2S_MODE_TX = 4,
+  I2S_MODE_RX = 8
+} i2s_mode_t;
+
+typedef enum {
+  I2S_BITS_PER_SAMPLE_16BIT = 16,
+  I2S_BITS_PER_SAMPLE_24BIT = 24,
+  I2S_BITS_PER_SAMPLE_32BIT = 32
+} i2s_bits_per_sample_t;
+
+typedef enum {
+  I2S_CHANNEL_FMT_RIGHT_LEFT = 0,
+  I2S_CHANNEL_FMT_ONLY_RIGHT = 3,
+  I2S_CHANNEL_FMT_ONLY_LEFT = 4
+} i2s_channel_fmt_t;
+
+typedef enum {
+  I2S_COMM_FORMAT_STAND_I2S = 1,
+  I2S_COMM_FORMAT_STAND_MSB = 3,
+  I2S_COMM_FORMAT_I2S_MSB = 2
+} i2s_comm_format_t;
+
+typedef struct {
+  i2s_mode_t mode;
+  uint32_t sample_rate;
+  i2s_bits_per_sample_t bits_per_sample;
+  i2s_channel_fmt_t channel_format;
+  i2s_comm_format_t communication_format;
+  int intr_alloc_flags;
+  int dma_buf_count;
+  int dma_buf_len;
+  bool use_apll;
+  bool tx_desc_auto_clear;
+  int fixed_mclk;
+} i2s_config_t;
+
+typedef struct {
+  int bck_io_num;
+  int ws_io_num;
+  int data_out_num;
+  int data_in_num;
+} i2s_pin_config_t;
+
+esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t* config, int queueSize, void* queue);
+esp_err_t i2s_driver_uninstall(i2s_port_t port);
+esp_err_t i2s_set_pin(i2s_port_t port, const i2s_pin_config_t* pins);
+esp_err_t i2s_start(i2s_port_t port);
+esp_err_t i2s_zero_dma_buffer(i2s_port_t port);
+esp_err_t i2s_read(i2s_port_t port, void* dest, size_t size, size_t* bytesRead, TickType_t ticks);
+esp_err_t i2s_write(i2s_port_t port, const void* src, size_t size, size_t* bytesWritten, TickType_t ticks);
+
+// ============================================
+// SIMULATED MICROPHONE (test controls)
+// ============================================
+enum HostMicPattern {
+  HOST_MIC_SPEECH,       // Varying 24-bit audio
+  HOST_MIC_STUCK_ZERO,   // Every word 0x00000000
+  HOST_MIC_STUCK_ONE     // Every word 0x00000001
+};
+
+// Set the mic output; with clearOnRestart the next i2s_driver_install()
+// on I2S_NUM_0 brings speech back
+void hostMicSetPattern(HostMicPattern pattern, bool clearOnRestart);
+
+// Frames overwritten in the DMA ring because nobody read them in time
+uint32_t hostMicOverflowFrames();
+
+// Driver installs on a port since the program started
+uint32_t hostI2sInstallCount(i2s_port_t port);
+
+#endif // HOST_DRIVER_I2S_H
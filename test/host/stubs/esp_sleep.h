@@ -0,0 +1,14 @@
+/*
+ * esp_sleep.h (host stub)
+ */
+
+#ifndef HOST_ESP_SLEEP_H
+#define HOST_ESP_SLEEP_H
+
+#include <esp_err.h>
+
+inline esp_err_t esp_sleep_enable_gpio_wakeup() {
+  return ESP_OK;
+}
+
+#endif // HOST_ESP_SLEEP_H
@@ -0,0 +1,32 @@
+/*
+ * freertos/FreeRTOS.h (host stub)
+ * 
+ * Single-threaded stand-in for the FreeRTOS calls the firmware makes.
+ * Tasks are not started: xTaskCreate() records the task and the test runs
+ * one pass of its loop with hostStepTask(), which returns when the task
+ * calls vTaskDelay(). Mutexes never block (nothing else runs), so a take
+ * only fails while the same code already holds it. A queue receive on an
+ * empty queue advances the clock until an event on it posts (a simulated
+ * ISR, see hostScheduleAt) or the wait runs out.
+ */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE            1
+#define pdFALSE           0
+#define pdPASS            1
+#define pdFAIL            0
+#define portMAX_DELAY     0xFFFFFFFFUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portYIELD_FROM_ISR() do {} while (0)
+
+#endif // HOST_FREERTOS_H
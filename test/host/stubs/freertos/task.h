@@ -0,0 +1,31 @@
+/*
+ * freertos/task.h (host stub)
+ */
+
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+
+struct HostTask;
+typedef HostTask* TaskHandle_t;
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* arg,
+                       UBaseType_t priority, TaskHandle_t* handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+TickType_t xTaskGetTickCount();
+
+// Test control: run the task's loop until its next vTaskDelay() (false if
+// the task does not exist or has been deleted)
+bool hostStepTask(TaskHandle_t task);
+
+// Test control: the most recent live task created with this name (nullptr if none)
+TaskHandle_t hostFindTask(const char* name);
+
+#endif // HOST_FREERTOS_TASK_H
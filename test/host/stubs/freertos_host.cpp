@@ -0,0 +1,199 @@
+/*
+ * freertos_host.cpp
+ * 
+ * Single-threaded implementation of the FreeRTOS stubs
+ */
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <deque>
+#include <vector>
+
+struct HostSemaphore {
+  bool mutex;
+  bool taken;      // Mutex held / binary semaphore empty
+};
+
+struct HostTask {
+  const char* name;
+  TaskFunction_t fn;
+  void* arg;
+  bool deleted;
+};
+
+struct HostQueue {
+  size_t length;
+  size_t itemSize;
+  std::deque<std::vector<uint8_t>> items;
+};
+
+// Thrown by vTaskDelay() to end one hostStepTask() pass
+struct HostTaskYield {};
+
+static HostTask* runningTask = nullptr;
+static std::vector<HostTask*> tasks;
+
+// ============================================
+// SEMAPHORES
+// ============================================
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new HostSemaphore{ true, false };
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+  return new HostSemaphore{ false, true };
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+  if (sem == nullptr) {
+    return pdFALSE;
+  }
+  if (sem->taken) {
+    // Nothing else can give it while we wait
+    if (ticks != portMAX_DELAY) {
+      delay(ticks);
+    }
+    return pdFALSE;
+  }
+  sem->taken = true;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  if (sem == nullptr || !sem->taken) {
+    return pdFALSE;
+  }
+  sem->taken = false;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t* woken) {
+  if (woken != nullptr) {
+    *woken = pdFALSE;
+  }
+  return xSemaphoreGive(sem);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+  delete sem;
+}
+
+// ============================================
+// TASKS
+// ============================================
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* arg,
+                       UBaseType_t priority, TaskHandle_t* handle) {
+  (void)stackDepth;
+  (void)priority;
+  HostTask* task = new HostTask{ name, fn, arg, false };
+  tasks.push_back(task);
+  if (handle != nullptr) {
+    *handle = task;
+  }
+  return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+  (void)core;
+  return xTaskCreate(fn, name, stackDepth, arg, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task != nullptr) {
+    task->deleted = true;  // Kept: a stale handle stays safe to step
+  }
+}
+
+void vTaskDelay(TickType_t ticks) {
+  if (runningTask != nullptr) {
+    throw HostTaskYield();
+  }
+  delay(ticks);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return runningTask;
+}
+
+TickType_t xTaskGetTickCount() {
+  return (TickType_t)millis();
+}
+
+bool hostStepTask(TaskHandle_t task) {
+  if (task == nullptr || task->deleted || runningTask != nullptr) {
+    return false;
+  }
+  runningTask = task;
+  try {
+    task->fn(task->arg);
+  } catch (const HostTaskYield&) {
+  }
+  runningTask = nullptr;
+  return true;
+}
+
+TaskHandle_t hostFindTask(const char* name) {
+  for (size_t i = tasks.size(); i > 0; i--) {
+    HostTask* task = tasks[i - 1];
+    if (!task->deleted && strcmp(task->name, name) == 0) {
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+// ============================================
+// QUEUES
+// ============================================
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  return new HostQueue{ length, itemSize, {} };
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+  (void)ticks;
+  if (queue == nullptr || queue->items.size() >= queue->length) {
+    return pdFALSE;
+  }
+  const uint8_t* bytes = (const uint8_t*)item;
+  queue->items.emplace_back(bytes, bytes + queue->itemSize);
+  return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken) {
+  if (woken != nullptr) {
+    *woken = pdFALSE;
+  }
+  return xQueueSend(queue, item, 0);
+}
+
+static bool queueHasItems(void* arg) {
+  return !((QueueHandle_t)arg)->items.empty();
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+  if (queue == nullptr) {
+    return pdFALSE;
+  }
+  if (queue->items.empty()) {
+    // The task sleeps until a (simulated) ISR posts or the wait runs out
+    if (ticks == 0 || ticks == portMAX_DELAY ||
+        !hostWaitUntil(micros() + (unsigned long)ticks * 1000, queueHasItems, queue)) {
+      return pdFALSE;
+    }
+  }
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  return (queue != nullptr) ? (UBaseType_t)queue->items.size() : 0;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+  delete queue;
+}
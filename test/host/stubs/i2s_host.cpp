@@ -0,0 +1,142 @@
+/*
+ * i2s_host.cpp
+ * 
+ * I2S driver stub with a simulated microphone
+ */
+
+#include <Arduino.h>
+#include <driver/i2s.h>
+
+static bool installed[I2S_NUM_MAX];
+static uint32_t installCount[I2S_NUM_MAX];
+static HostMicPattern micPattern = HOST_MIC_SPEECH;
+static bool micClearOnRestart = false;
+static uint32_t micPhase = 0;
+
+// Frames arrive at the configured rate; the DMA ring holds micDmaFrames and
+// anything older is overwritten, as on the chip
+static uint32_t micRate = 16000;
+static uint32_t micDmaFrames = 2048;
+static unsigned long micStartUs = 0;
+static uint64_t micConsumed = 0;
+static uint32_t micOverflowFrames = 0;
+
+static uint64_t micFramesProduced() {
+  return (uint64_t)(micros() - micStartUs) * micRate / 1000000;
+}
+
+esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t* config, int queueSize, void* queue) {
+  (void)queueSize;
+  (void)queue;
+  if (port >= I2S_NUM_MAX || installed[port]) {
+    return ESP_FAIL;
+  }
+  installed[port] = true;
+  installCount[port]++;
+  if (port == I2S_NUM_0) {
+    micRate = config->sample_rate;
+    micDmaFrames = config->dma_buf_count * config->dma_buf_len;
+    micStartUs = micros();
+    micConsumed = 0;
+    if (micClearOnRestart) {
+      micPattern = HOST_MIC_SPEECH;
+      micClearOnRestart = false;
+    }
+  }
+  return ESP_OK;
+}
+
+esp_err_t i2s_driver_uninstall(i2s_port_t port) {
+  if (port >= I2S_NUM_MAX || !installed[port]) {
+    return ESP_FAIL;
+  }
+  installed[port] = false;
+  return ESP_OK;
+}
+
+esp_err_t i2s_set_pin(i2s_port_t port, const i2s_pin_config_t* pins) {
+  (void)pins;
+  return (port < I2S_NUM_MAX && installed[port]) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t i2s_start(i2s_port_t port) {
+  return (port < I2S_NUM_MAX && installed[port]) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t i2s_zero_dma_buffer(i2s_port_t port) {
+  if (port >= I2S_NUM_MAX || !installed[port]) {
+    return ESP_FAIL;
+  }
+  if (port == I2S_NUM_0) {
+    micConsumed = micFramesProduced();
+  }
+  return ESP_OK;
+}
+
+esp_err_t i2s_read(i2s_port_t port, void* dest, size_t size, size_t* bytesRead, TickType_t ticks) {
+  *bytesRead = 0;
+  if (port != I2S_NUM_0 || !installed[port]) {
+    return ESP_FAIL;
+  }
+  
+  // Frames the DMA ring could not hold are lost
+  uint64_t produced = micFramesProduced();
+  if (produced - micConsumed > micDmaFrames) {
+    micOverflowFrames += (uint32_t)(produced - micConsumed - micDmaFrames);
+    micConsumed = produced - micDmaFrames;
+  }
+  
+  // Stereo 32-bit words: mic on the left slot, right slot idle
+  size_t wanted = size / (2 * sizeof(uint32_t));
+  if (ticks > 0 && produced - micConsumed < wanted) {
+    uint64_t missing = wanted - (produced - micConsumed);
+    delayMicroseconds((uint32_t)((missing * 1000000 + micRate - 1) / micRate));
+    produced = micFramesProduced();
+  }
+  size_t frames = (size_t)(produced - micConsumed);
+  if (frames > wanted) {
+    frames = wanted;
+  }
+  
+  uint32_t* words = (uint32_t*)dest;
+  for (size_t i = 0; i < frames; i++) {
+    uint32_t word = 0;
+    if (micPattern == HOST_MIC_STUCK_ONE) {
+      word = 0x00000001;
+    } else if (micPattern == HOST_MIC_SPEECH) {
+      // 500 Hz-ish triangle at 16 kHz, 24-bit left-justified
+      int32_t level = (int32_t)(micPhase % 32) - 16;
+      word = (uint32_t)(level * 200000) << 8;
+      micPhase++;
+    }
+    words[2 * i] = word;
+    words[2 * i + 1] = 0;
+  }
+  micConsumed += frames;
+  *bytesRead = frames * 2 * sizeof(uint32_t);
+  return ESP_OK;
+}
+
+esp_err_t i2s_write(i2s_port_t port, const void* src, size_t size, size_t* bytesWritten, TickType_t ticks) {
+  (void)src;
+  (void)ticks;
+  *bytesWritten = 0;
+  if (port >= I2S_NUM_MAX || !installed[port]) {
+    return ESP_FAIL;
+  }
+  *bytesWritten = size;
+  return ESP_OK;
+}
+
+void hostMicSetPattern(HostMicPattern pattern, bool clearOnRestart) {
+  micPattern = pattern;
+  micClearOnRestart = clearOnRestart;
+}
+
+uint32_t hostMicOverflowFrames() {
+  return micOverflowFrames;
+}
+
+uint32_t hostI2sInstallCount(i2s_port_t port) {
+  return (port < I2S_NUM_MAX) ? installCount[port] : 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * littlefs_host.cpp
+ * 
+ * In-memory implementation of the LittleFS stub
+ */
+
+#include <LittleFS.h>
+#include <map>
+#include <set>
+
+static std::map<std::string, std::vector<uint8_t>> files;
+static std::set<std::string> dirs;
+static bool powerCutArmed = false;
+static size_t powerBudget = 0;
+static size_t bytesWritten = 0;
+
+LittleFSHost LittleFS;
+
+// ============================================
+// FILE HANDLE
+// ============================================
+File::File() : valid(false), isDir(false), writable(false), append(false), pos(0), listPos(0) {}
+
+File::operator bool() const {
+  return valid;
+}
+
+const char* File::name() const {
+  return baseName.c_str();
+}
+
+size_t File::size() const {
+  auto it = files.find(path);
+  return (valid && it != files.end()) ? it->second.size() : 0;
+}
+
+size_t File::read(uint8_t* buffer, size_t length) {
+  auto it = files.find(path);
+  if (!valid || isDir || it == files.end() || pos >= it->second.size()) {
+    return 0;
+  }
+  size_t n = it->second.size() - pos;
+  if (n > length) {
+    n = length;
+  }
+  memcpy(buffer, it->second.data() + pos, n);
+  pos += n;
+  return n;
+}
+
+int File::read() {
+  uint8_t b;
+  return (read(&b, 1) == 1) ? b : -1;
+}
+
+int File::available() {
+  size_t total = size();
+  return (pos < total) ? (int)(total - pos) : 0;
+}
+
+size_t File::write(const uint8_t* buffer, size_t length) {
+  auto it = files.find(path);
+  if (!valid || !writable || it == files.end()) {
+    return 0;
+  }
+  size_t n = length;
+  if (powerCutArmed) {
+    size_t left = (bytesWritten < powerBudget) ? powerBudget - bytesWritten : 0;
+    if (n > left) {
+      n = left;
+    }
+  }
+  std::vector<uint8_t>& data = it->second;
+  if (append) {
+    pos = data.size();
+  }
+  if (pos + n > data.size()) {
+    data.resize(pos + n);
+  }
+  memcpy(data.data() + pos, buffer, n);
+  pos += n;
+  bytesWritten += n;
+  return n;
+}
+
+size_t File::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+bool File::seek(uint32_t position) {
+  if (!valid || position > size()) {
+    return false;
+  }
+  pos = position;
+  return true;
+}
+
+size_t File::position() const {
+  return pos;
+}
+
+void File::flush() {
+}
+
+void File::close() {
+  valid = false;
+}
+
+File File::openNextFile() {
+  File next;
+  if (!valid || !isDir || listPos >= listing.size()) {
+    return next;
+  }
+  return LittleFS.open(listing[listPos++].c_str(), "r");
+}
+
+// ============================================
+// FILESYSTEM
+// ============================================
+bool LittleFSHost::begin(bool formatOnFail) {
+  (void)formatOnFail;
+  dirs.insert("/");
+  return true;
+}
+
+bool LittleFSHost::exists(const char* path) {
+  return files.count(path) > 0 || dirs.count(path) > 0;
+}
+
+bool LittleFSHost::mkdir(const char* path) {
+  dirs.insert(path);
+  return true;
+}
+
+File LittleFSHost::open(const char* path, const char* mode) {
+  File file;
+  std::string p(path);
+  size_t slash = p.rfind('/');
+  file.path = p;
+  file.baseName = (slash == std::string::npos) ? p : p.substr(slash + 1);
+  
+  if (dirs.count(p) > 0) {
+    std::string prefix = (p == "/") ? p : p + "/";
+    for (auto& entry : files) {
+      const std::string& name = entry.first;
+      if (name.compare(0, prefix.size(), prefix) == 0 && name.find('/', prefix.size()) == std::string::npos) {
+        file.listing.push_back(name);
+      }
+    }
+    file.valid = true;
+    file.isDir = true;
+    return file;
+  }
+  
+  if (mode[0] == 'r') {
+    file.valid = files.count(p) > 0;
+    return file;
+  }
+  if (mode[0] == 'w') {
+    files[p].clear();
+  } else if (mode[0] == 'a') {
+    files[p];
+    file.append = true;
+  } else {
+    return file;
+  }
+  file.valid = true;
+  file.writable = true;
+  return file;
+}
+
+bool LittleFSHost::remove(const char* path) {
+  return files.erase(path) > 0;
+}
+
+bool LittleFSHost::rename(const char* from, const char* to) {
+  auto it = files.find(from);
+  if (it == files.end()) {
+    return false;
+  }
+  std::vector<uint8_t> data;
+  data.swap(it->second);
+  files.erase(it);
+  files[to].swap(data);
+  return true;
+}
+
+// ============================================
+// TEST CONTROLS
+// ============================================
+void LittleFSHost::hostFormat() {
+  files.clear();
+  dirs.clear();
+  powerCutArmed = false;
+  bytesWritten = 0;
+}
+
+void LittleFSHost::hostCutPowerAfter(size_t bytes) {
+  powerCutArmed = true;
+  powerBudget = bytesWritten + bytes;
+}
+
+void LittleFSHost::hostRestorePower() {
+  powerCutArmed = false;
+}
+
+bool LittleFSHost::hostPowerCut() {
+  return powerCutArmed && bytesWritten >= powerBudget;
+}
+
+std::vector<uint8_t>* LittleFSHost::hostData(const char* path) {
+  auto it = files.find(path);
+  return (it != files.end()) ? &it->second : nullptr;
+}
+
+size_t LittleFSHost::hostBytesWritten() {
+  return bytesWritten;
+}
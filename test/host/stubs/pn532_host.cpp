@@ -0,0 +1,214 @@
+/*
+ * pn532_host.cpp
+ * 
+ * Simulated PN532 and the I2C bus it sits on
+ */
+
+#include <Adafruit_PN532.h>
+#include <Wire.h>
+#include <stdint.h>
+
+static int irqPin = -1;
+static bool fieldOn = false;
+static bool waiting = false;         // InListPassiveTarget pending, no card yet
+static bool responseReady = false;   // IRQ low until read
+static uint32_t generation = 0;      // Bumped by every command
+static uint32_t transactions = 0;
+static uint32_t pageReads = 0;
+
+static bool cardPresent = false;
+static uint8_t cardUid[10];
+static uint8_t cardUidLength = 0;
+static uint8_t cardMemory[1024];
+static size_t cardMemoryLength = 0;
+
+static void setIrq(int level) {
+  if (irqPin >= 0) {
+    hostSetPin((uint8_t)irqPin, level);
+  }
+}
+
+// A new command aborts whatever the chip was doing
+static void command() {
+  transactions++;
+  generation++;
+  waiting = false;
+  responseReady = false;
+  setIrq(HIGH);
+  delayMicroseconds(PN532_HOST_CMD_US);
+}
+
+static void respond(void* arg) {
+  if ((uint32_t)(uintptr_t)arg != generation) {
+    return;
+  }
+  waiting = false;
+  responseReady = true;
+  setIrq(LOW);
+}
+
+static void scheduleResponse(unsigned long delayUs) {
+  hostScheduleAt(micros() + delayUs, respond, (void*)(uintptr_t)generation);
+}
+
+// ============================================
+// ADAFRUIT_PN532
+// ============================================
+Adafruit_PN532::Adafruit_PN532(uint8_t irq, uint8_t reset) {
+  (void)reset;
+  irqPin = irq;
+}
+
+void Adafruit_PN532::begin() {
+  fieldOn = false;
+  waiting = false;
+  responseReady = false;
+  setIrq(HIGH);
+}
+
+uint32_t Adafruit_PN532::getFirmwareVersion() {
+  command();
+  delayMicroseconds(PN532_HOST_READ_US);
+  return 0x32010607;  // PN532 v1.6
+}
+
+bool Adafruit_PN532::SAMConfig() {
+  command();
+  delayMicroseconds(PN532_HOST_READ_US);
+  return true;
+}
+
+bool Adafruit_PN532::readPassiveTargetID(uint8_t cardbaudrate, uint8_t* uid, uint8_t* uidLength, uint16_t timeout) {
+  (void)cardbaudrate;
+  command();
+  fieldOn = true;
+  if (!cardPresent) {
+    delay(timeout ? timeout : PN532_HOST_POLL_MS);
+    return false;
+  }
+  delayMicroseconds(PN532_HOST_ANSWER_US + PN532_HOST_READ_US);
+  memcpy(uid, cardUid, cardUidLength);
+  *uidLength = cardUidLength;
+  return true;
+}
+
+bool Adafruit_PN532::startPassiveTargetIDDetection(uint8_t cardbaudrate) {
+  (void)cardbaudrate;
+  command();
+  fieldOn = true;
+  waiting = true;
+  if (cardPresent) {
+    scheduleResponse(PN532_HOST_ANSWER_US);
+  }
+  return true;
+}
+
+bool Adafruit_PN532::readDetectedPassiveTargetID(uint8_t* uid, uint8_t* uidLength) {
+  transactions++;
+  if (!responseReady) {
+    return false;
+  }
+  responseReady = false;
+  setIrq(HIGH);
+  delayMicroseconds(PN532_HOST_READ_US);
+  memcpy(uid, cardUid, cardUidLength);
+  *uidLength = cardUidLength;
+  return true;
+}
+
+uint8_t Adafruit_PN532::ntag2xx_ReadPage(uint8_t page, uint8_t* buffer) {
+  command();
+  if (!cardPresent || (size_t)page * 4 + 4 > cardMemoryLength) {
+    return 0;
+  }
+  delayMicroseconds(PN532_HOST_PAGE_US);
+  memcpy(buffer, cardMemory + page * 4, 4);
+  pageReads++;
+  return 1;
+}
+
+bool Adafruit_PN532::sendCommandCheckAck(uint8_t* cmd, uint8_t cmdlen, uint16_t timeout) {
+  (void)timeout;
+  command();
+  if (cmdlen >= 3 && cmd[0] == PN532_COMMAND_RFCONFIGURATION && cmd[1] == 0x01) {
+    fieldOn = (cmd[2] & 0x02) != 0;
+  }
+  scheduleResponse(PN532_HOST_READ_US);
+  return true;
+}
+
+// ============================================
+// I2C (only the PN532 answers)
+// ============================================
+TwoWire Wire;
+
+bool TwoWire::begin(int sda, int scl) {
+  (void)sda;
+  (void)scl;
+  pending = 0;
+  return true;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity) {
+  pending = 0;
+  if (address != PN532_I2C_ADDRESS) {
+    return 0;
+  }
+  transactions++;
+  if (responseReady) {
+    responseReady = false;
+    setIrq(HIGH);
+  }
+  pending = quantity;
+  return quantity;
+}
+
+int TwoWire::available() {
+  return pending;
+}
+
+int TwoWire::read() {
+  if (pending == 0) {
+    return -1;
+  }
+  pending--;
+  return 0;
+}
+
+// ============================================
+// TEST CONTROLS
+// ============================================
+void hostPn532PresentCard(const uint8_t* uid, uint8_t uidLength, const uint8_t* memory, size_t memoryLength) {
+  if (uidLength > sizeof(cardUid)) {
+    uidLength = sizeof(cardUid);
+  }
+  if (memoryLength > sizeof(cardMemory)) {
+    memoryLength = sizeof(cardMemory);
+  }
+  memcpy(cardUid, uid, uidLength);
+  cardUidLength = uidLength;
+  memcpy(cardMemory, memory, memoryLength);
+  cardMemoryLength = memoryLength;
+  cardPresent = true;
+  
+  // An armed InListPassiveTarget sees the card as soon as it is in the field
+  if (waiting && fieldOn) {
+    scheduleResponse(PN532_HOST_ANSWER_US);
+  }
+}
+
+void hostPn532RemoveCard() {
+  cardPresent = false;
+}
+
+bool hostPn532FieldOn() {
+  return fieldOn;
+}
+
+uint32_t hostPn532Transactions() {
+  return transactions;
+}
+
+uint32_t hostPn532PageReads() {
+  return pageReads;
+}
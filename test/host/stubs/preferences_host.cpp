@@ -0,0 +1,55 @@
+/*
+ * preferences_host.cpp
+ * 
+ * In-memory implementation of the Preferences stub
+ */
+
+#include <Preferences.h>
+#include <map>
+#include <vector>
+
+static std::map<std::string, std::vector<uint8_t>> store;  // "namespace/key"
+
+Preferences::Preferences() : opened(false), readOnly(true) {}
+
+bool Preferences::begin(const char* name, bool readOnlyMode) {
+  space = name;
+  opened = true;
+  readOnly = readOnlyMode;
+  return true;
+}
+
+void Preferences::end() {
+  opened = false;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  auto it = store.find(space + "/" + key);
+  return (opened && it != store.end()) ? it->second.size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t length) {
+  auto it = store.find(space + "/" + key);
+  if (!opened || it == store.end() || it->second.size() > length) {
+    return 0;
+  }
+  memcpy(buffer, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+  if (!opened || readOnly) {
+    return 0;
+  }
+  const uint8_t* bytes = (const uint8_t*)value;
+  store[space + "/" + key].assign(bytes, bytes + length);
+  return length;
+}
+
+bool Preferences::remove(const char* key) {
+  return opened && !readOnly && store.erase(space + "/" + key) > 0;
+}
+
+void Preferences::hostErase() {
+  store.clear();
+}
@@ -0,0 +1,12 @@
+/*
+ * soc/dport_access.h (host stub)
+ * 
+ * Peripheral register writes have nothing to act on here
+ */
+
+#ifndef HOST_SOC_DPORT_ACCESS_H
+#define HOST_SOC_DPORT_ACCESS_H
+
+#define DPORT_SET_PERI_REG_MASK(reg, mask) do { (void)(reg); (void)(mask); } while (0)
+
+#endif // HOST_SOC_DPORT_ACCESS_H
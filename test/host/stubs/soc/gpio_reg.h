@@ -0,0 +1,19 @@
+/*
+ * soc/gpio_reg.h (host stub)
+ * 
+ * GPIO input registers, read from the simulated pins
+ */
+
+#ifndef HOST_SOC_GPIO_REG_H
+#define HOST_SOC_GPIO_REG_H
+
+#include <stdint.h>
+
+#define GPIO_IN_REG   0   // GPIO 0-31
+#define GPIO_IN1_REG  1   // GPIO 32-39
+
+uint32_t hostGpioInReg(int reg);
+
+#define REG_READ(reg)  hostGpioInReg(reg)
+
+#endif // HOST_SOC_GPIO_REG_H
@@ -0,0 +1,8 @@
+/*
+ * soc/i2s_reg.h (host stub)
+ */
+
+#ifndef HOST_SOC_I2S_REG_H
+#define HOST_SOC_I2S_REG_H
+
+#endif // HOST_SOC_I2S_REG_H
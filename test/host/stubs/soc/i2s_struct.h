@@ -0,0 +1,8 @@
+/*
+ * soc/i2s_struct.h (host stub)
+ */
+
+#ifndef HOST_SOC_I2S_STRUCT_H
+#define HOST_SOC_I2S_STRUCT_H
+
+#endif // HOST_SOC_I2S_STRUCT_H
@@ -0,0 +1,282 @@
+/*
+ * test_app_fsm.cpp
+ * 
+ * AppFsm driven through a cut-down tap-to-play flow on the simulated clock:
+ * exit/action/entry order, guards, wildcard rows, events posted from
+ * actions, retries as self-transitions, ignored events, queue overflow, and
+ * the trace and dwell metrics the field reports are built from
+ */
+
+#include "host_test.h"
+#include "app_fsm.h"
+#include "logger.h"
+
+enum TestState : uint8_t {
+  ST_IDLE,
+  ST_READING,
+  ST_FETCH,
+  ST_PLAYING,
+  ST_ERROR
+};
+
+enum TestEvent : uint8_t {
+  EV_TAG,
+  EV_READ_OK,
+  EV_FETCH_FAIL,
+  EV_FETCH_OK,
+  EV_DONE,
+  EV_FAULT,
+  EV_RESET
+};
+
+static const char* const eventNames[] = {
+  "TAG", "READ_OK", "FETCH_FAIL", "FETCH_OK", "DONE", "FAULT", "RESET"
+};
+
+// What the actions did, in order ("e:" entry, "x:" exit, "a:" transition action)
+static char callLog[256];
+static uint32_t fetchAttempts = 0;
+static uint32_t readingUpdates = 0;
+static bool postFromEntry = false;
+
+static void note(const char* what) {
+  strncat(callLog, what, sizeof(callLog) - strlen(callLog) - 1);
+  strncat(callLog, " ", sizeof(callLog) - strlen(callLog) - 1);
+}
+
+static void resetLog() {
+  callLog[0] = '\0';
+  fetchAttempts = 0;
+  readingUpdates = 0;
+  postFromEntry = false;
+}
+
+static AppFsm* fsm = nullptr;
+
+static void enterIdle()      { note("e:IDLE"); }
+static void exitIdle()       { note("x:IDLE"); }
+static void enterReading()   { note("e:READING"); if (postFromEntry) { fsm->post(EV_READ_OK); } }
+static void updateReading()  { readingUpdates++; }
+static void exitReading()    { note("x:READING"); }
+static void enterFetch()     { note("e:FETCH"); fetchAttempts++; }
+static void exitFetch()      { note("x:FETCH"); }
+static void enterPlaying()   { note("e:PLAYING"); }
+static void enterError()     { note("e:ERROR"); }
+static void startFetch()     { note("a:startFetch"); }
+static bool canRetry()       { return fetchAttempts < 3; }
+
+static const FsmState states[] = {
+  { ST_IDLE,    "IDLE",    enterIdle,    nullptr,       exitIdle    },
+  { ST_READING, "READING", enterReading, updateReading, exitReading },
+  { ST_FETCH,   "FETCH",   enterFetch,   nullptr,       exitFetch   },
+  { ST_PLAYING, "PLAYING", enterPlaying, nullptr,       nullptr     },
+  { ST_ERROR,   "ERROR",   enterError,   nullptr,       nullptr     }
+};
+
+static const FsmTransition transitions[] = {
+  { ST_IDLE,       EV_TAG,        nullptr,  ST_READING, nullptr    },
+  { ST_READING,    EV_READ_OK,    nullptr,  ST_FETCH,   startFetch },
+  { ST_FETCH,      EV_FETCH_FAIL, canRetry, ST_FETCH,   nullptr    },
+  { ST_FETCH,      EV_FETCH_FAIL, nullptr,  ST_ERROR,   nullptr    },
+  { ST_FETCH,      EV_FETCH_OK,   nullptr,  ST_PLAYING, nullptr    },
+  { ST_PLAYING,    EV_DONE,       nullptr,  ST_IDLE,    nullptr    },
+  { FSM_ANY_STATE, EV_FAULT,      nullptr,  ST_ERROR,   nullptr    },
+  { ST_ERROR,      EV_RESET,      nullptr,  ST_IDLE,    nullptr    }
+};
+
+static void startFsm(AppFsm& machine) {
+  resetLog();
+  fsm = &machine;
+  machine.begin(states, sizeof(states) / sizeof(states[0]),
+                transitions, sizeof(transitions) / sizeof(transitions[0]),
+                ST_IDLE, eventNames);
+}
+
+static void postAndRun(AppFsm& machine, uint8_t event) {
+  machine.post(event);
+  machine.run();
+}
+
+// ============================================
+// TRANSITIONS
+// ============================================
+static void testEntryExitActionOrder() {
+  AppFsm machine;
+  startFsm(machine);
+  CHECK_STR(callLog, "e:IDLE ");
+  CHECK_EQ(machine.getState(), ST_IDLE);
+  
+  postAndRun(machine, EV_TAG);
+  postAndRun(machine, EV_READ_OK);
+  CHECK_STR(callLog, "e:IDLE x:IDLE e:READING x:READING a:startFetch e:FETCH ");
+  CHECK_EQ(machine.getState(), ST_FETCH);
+  CHECK_EQ(machine.getPreviousState(), ST_READING);
+  CHECK_STR(machine.getStateName(machine.getState()), "FETCH");
+  CHECK_STR(machine.getStateName(42), "UNKNOWN");
+}
+
+static void testGuardsPickRetryThenError() {
+  AppFsm machine;
+  startFsm(machine);
+  postAndRun(machine, EV_TAG);
+  postAndRun(machine, EV_READ_OK);
+  
+  // Self-transition re-runs entry while the guard allows, then the next row wins
+  postAndRun(machine, EV_FETCH_FAIL);
+  CHECK_EQ(machine.getState(), ST_FETCH);
+  CHECK_EQ(fetchAttempts, 2);
+  postAndRun(machine, EV_FETCH_FAIL);
+  CHECK_EQ(fetchAttempts, 3);
+  postAndRun(machine, EV_FETCH_FAIL);
+  CHECK_EQ(machine.getState(), ST_ERROR);
+  CHECK_EQ(fetchAttempts, 3);
+}
+
+static void testWildcardAndIgnoredEvents() {
+  AppFsm machine;
+  startFsm(machine);
+  
+  // Not handled in IDLE: no transition, no trace
+  postAndRun(machine, EV_DONE);
+  CHECK_EQ(machine.getState(), ST_IDLE);
+  CHECK_EQ(machine.getTraceCount(), 0);
+  
+  postAndRun(machine, EV_TAG);
+  postAndRun(machine, EV_FAULT);
+  CHECK_EQ(machine.getState(), ST_ERROR);
+  postAndRun(machine, EV_RESET);
+  CHECK_EQ(machine.getState(), ST_IDLE);
+}
+
+static void testPostFromActionSamePass() {
+  AppFsm machine;
+  startFsm(machine);
+  postFromEntry = true;
+  
+  // READING's entry posts READ_OK: both transitions in one run()
+  postAndRun(machine, EV_TAG);
+  CHECK_EQ(machine.getState(), ST_FETCH);
+  CHECK_EQ(machine.getTraceCount(), 2);
+  CHECK_EQ(readingUpdates, 0);
+}
+
+static void testUpdateRunsEveryPass() {
+  AppFsm machine;
+  startFsm(machine);
+  postAndRun(machine, EV_TAG);
+  machine.run();
+  machine.run();
+  CHECK_EQ(readingUpdates, 3);
+}
+
+static void testQueueOverflowDrops() {
+  AppFsm machine;
+  startFsm(machine);
+  for (int i = 0; i < FSM_EVENT_QUEUE; i++) {
+    CHECK(machine.post(EV_DONE));
+  }
+  CHECK(!machine.post(EV_TAG));
+  machine.run();
+  CHECK_EQ(machine.getState(), ST_IDLE);
+}
+
+// ============================================
+// TRACE AND DWELL
+// ============================================
+static void testTraceTimestamps() {
+  AppFsm machine;
+  startFsm(machine);
+  unsigned long start = millis();
+  
+  hostAdvanceMillis(1000);
+  postAndRun(machine, EV_TAG);
+  hostAdvanceMillis(120);
+  postAndRun(machine, EV_READ_OK);
+  hostAdvanceMillis(2500);
+  postAndRun(machine, EV_FETCH_OK);
+  
+  CHECK_EQ(machine.getTraceCount(), 3);
+  FsmTraceEntry e = machine.getTrace(0);
+  CHECK_EQ(e.timeMs, start + 1000);
+  CHECK_EQ(e.from, ST_IDLE);
+  CHECK_EQ(e.to, ST_READING);
+  CHECK_EQ(e.event, EV_TAG);
+  e = machine.getTrace(2);
+  CHECK_EQ(e.timeMs, start + 3620);
+  CHECK_EQ(e.from, ST_FETCH);
+  CHECK_EQ(e.to, ST_PLAYING);
+  CHECK_EQ(machine.getStateEnteredMs(), start + 3620);
+}
+
+static void testTraceKeepsNewest() {
+  AppFsm machine;
+  startFsm(machine);
+  unsigned long start = millis();
+  
+  // FAULT/RESET pairs: two transitions each, well past the ring size
+  const int pairs = FSM_TRACE_SIZE;
+  for (int i = 0; i < pairs; i++) {
+    hostAdvanceMillis(10);
+    postAndRun(machine, EV_FAULT);
+    hostAdvanceMillis(10);
+    postAndRun(machine, EV_RESET);
+  }
+  CHECK_EQ(machine.getTraceCount(), FSM_TRACE_SIZE);
+  FsmTraceEntry oldest = machine.getTrace(0);
+  FsmTraceEntry newest = machine.getTrace(FSM_TRACE_SIZE - 1);
+  CHECK_EQ(newest.timeMs, start + pairs * 20);
+  CHECK_EQ(newest.event, EV_RESET);
+  CHECK_EQ(oldest.timeMs, start + (pairs * 2 - FSM_TRACE_SIZE + 1) * 10);
+  
+  // Oldest first, no gaps
+  for (uint8_t i = 1; i < FSM_TRACE_SIZE; i++) {
+    CHECK_EQ(machine.getTrace(i).timeMs - machine.getTrace(i - 1).timeMs, 10);
+  }
+}
+
+static void testDwellStats() {
+  AppFsm machine;
+  startFsm(machine);
+  
+  // Three visits to READING: 100, 300 and 200 ms
+  const uint32_t visits[] = { 100, 300, 200 };
+  for (int i = 0; i < 3; i++) {
+    hostAdvanceMillis(50);
+    postAndRun(machine, EV_TAG);
+    hostAdvanceMillis(visits[i]);
+    postAndRun(machine, EV_FAULT);
+    postAndRun(machine, EV_RESET);
+  }
+  
+  FsmDwellStats d = machine.getDwellStats(ST_READING);
+  CHECK_EQ(d.entries, 3);
+  CHECK_EQ(d.totalMs, 600);
+  CHECK_EQ(d.maxMs, 300);
+  CHECK_EQ(d.lastMs, 200);
+  
+  // Still in IDLE: only completed visits count
+  CHECK_EQ(machine.getDwellStats(ST_IDLE).entries, 3);
+  CHECK_EQ(machine.getDwellStats(ST_ERROR).totalMs, 0);
+  CHECK_EQ(machine.getDwellStats(FSM_MAX_STATES).entries, 0);
+  
+  LatencyHistogram* hist = machine.getDwellHistogram(ST_READING);
+  CHECK(hist != nullptr);
+  CHECK_EQ(hist->getCount(), 3);
+  CHECK_EQ(hist->getMax(), 300);
+  CHECK(machine.getDwellHistogram(FSM_MAX_STATES) == nullptr);
+}
+
+int main() {
+  Logger::setLogLevel(LOG_ERROR);
+  hostSetMillis(1000);
+  RUN_TEST(testEntryExitActionOrder);
+  RUN_TEST(testGuardsPickRetryThenError);
+  RUN_TEST(testWildcardAndIgnoredEvents);
+  RUN_TEST(testPostFromActionSamePass);
+  RUN_TEST(testUpdateRunsEveryPass);
+  RUN_TEST(testQueueOverflowDrops);
+  RUN_TEST(testTraceTimestamps);
+  RUN_TEST(testTraceKeepsNewest);
+  RUN_TEST(testDwellStats);
+  return HOST_TEST_RESULT();
+}
@@ -0,0 +1,188 @@
+/*
+ * test_button_handler.cpp
+ * 
+ * ButtonHandler fed by scripted edge sequences on a simulated pin: clean and
+ * bouncy presses, glitches, presses while the loop is blocked (as during an
+ * LTE call), long-press timing and edge queue overflow
+ */
+
+#include "host_test.h"
+#include "button_handler.h"
+#include "logger.h"
+#include "config.h"
+
+#define PIN_BUTTON  34
+
+// One scripted level change, in ms from the start of the script
+struct ScriptEdge {
+  uint32_t atMs;
+  bool pressed;
+};
+
+static void setPressed(void* arg) {
+  hostSetPin(PIN_BUTTON, arg != nullptr ? LOW : HIGH);   // Active low
+}
+
+static void playScript(const ScriptEdge* script, size_t count) {
+  unsigned long startUs = micros();
+  for (size_t i = 0; i < count; i++) {
+    hostScheduleAt(startUs + (unsigned long)script[i].atMs * 1000, setPressed,
+                   script[i].pressed ? (void*)1 : nullptr);
+  }
+}
+
+// Loop pass every 10 ms for durationMs
+static void loopFor(ButtonHandler& button, uint32_t durationMs) {
+  unsigned long end = millis() + durationMs;
+  while (millis() < end) {
+    button.update();
+    delay(10);
+  }
+  button.update();
+}
+
+// Released, with no handler from an earlier test still attached
+static void startButton(ButtonHandler& button) {
+  detachInterrupt(PIN_BUTTON);
+  hostSetPin(PIN_BUTTON, HIGH);
+  button.init(PIN_BUTTON, LONG_PRESS_MS, DEBOUNCE_MS);
+}
+
+static void testCleanShortPress() {
+  ButtonHandler button;
+  startButton(button);
+  unsigned long start = millis();
+  const ScriptEdge script[] = { { 100, true }, { 300, false } };
+  playScript(script, 2);
+  loopFor(button, 500);
+  
+  CHECK(button.wasShortPress());
+  CHECK(!button.wasShortPress());
+  CHECK(!button.wasLongPress());
+  CHECK_EQ(button.getLastEventTime(), start + 300);
+  CHECK(button.isIdle());
+}
+
+static void testBouncyPress() {
+  ButtonHandler button;
+  startButton(button);
+  unsigned long start = millis();
+  const ScriptEdge script[] = {
+    { 100, true }, { 101, false }, { 102, true }, { 104, false }, { 105, true },
+    { 400, false }, { 401, true }, { 403, false }, { 404, true }, { 406, false }
+  };
+  playScript(script, sizeof(script) / sizeof(script[0]));
+  loopFor(button, 600);
+  
+  // Contact chatter at both ends: one short press, timed from the last bounce
+  CHECK(button.wasShortPress());
+  CHECK(!button.wasShortPress());
+  CHECK(!button.wasLongPress());
+  CHECK_EQ(button.getLastEventTime(), start + 406);
+}
+
+static void testGlitchIgnored() {
+  ButtonHandler button;
+  startButton(button);
+  const ScriptEdge script[] = { { 100, true }, { 100 + DEBOUNCE_MS / 2, false } };
+  playScript(script, 2);
+  loopFor(button, 300);
+  CHECK(!button.wasShortPress());
+  CHECK(!button.wasLongPress());
+  CHECK(!button.isCurrentlyPressed());
+}
+
+static void testLongPressWhileLooping() {
+  ButtonHandler button;
+  startButton(button);
+  unsigned long start = millis();
+  const ScriptEdge script[] = { { 100, true }, { 100 + LONG_PRESS_MS + 500, false } };
+  playScript(script, 2);
+  
+  // Reported within one loop pass of the threshold, while still held
+  unsigned long reportedMs = 0;
+  unsigned long end = millis() + LONG_PRESS_MS + 1000;
+  while (millis() < end) {
+    button.update();
+    if (reportedMs == 0 && button.wasLongPress()) {
+      reportedMs = millis();
+      CHECK(button.isCurrentlyPressed());
+    }
+    delay(10);
+  }
+  CHECK(reportedMs != 0);
+  CHECK(reportedMs - (start + 100 + LONG_PRESS_MS) <= 10);
+  CHECK_EQ(button.getLastEventTime(), start + 100 + LONG_PRESS_MS);
+  
+  // Releasing afterwards is not a short press
+  loopFor(button, 100);
+  CHECK(!button.wasShortPress());
+  CHECK(!button.wasLongPress());
+}
+
+static void testPressesWhileLoopBlocked() {
+  ButtonHandler button;
+  startButton(button);
+  loopFor(button, 50);
+  unsigned long start = millis();
+  
+  // A whole short press, then a whole long press, during a 5 s modem call
+  const ScriptEdge script[] = {
+    { 200, true }, { 350, false },
+    { 1000, true }, { 1000 + LONG_PRESS_MS + 200, false }
+  };
+  playScript(script, 4);
+  delay(5000);
+  button.update();
+  
+  CHECK(button.wasShortPress());
+  CHECK(button.wasLongPress());
+  CHECK_EQ(button.getLastEventTime(), start + 1000 + LONG_PRESS_MS);
+  
+  // Short release under the threshold, held through the block: classified by edge times
+  ButtonHandler second;
+  startButton(second);
+  start = millis();
+  const ScriptEdge held[] = { { 100, true }, { 100 + LONG_PRESS_MS - 100, false } };
+  playScript(held, 2);
+  delay(3000);
+  second.update();
+  CHECK(second.wasShortPress());
+  CHECK(!second.wasLongPress());
+  CHECK_EQ(second.getLastEventTime(), start + 100 + LONG_PRESS_MS - 100);
+}
+
+static void testQueueOverflowResyncs() {
+  ButtonHandler button;
+  startButton(button);
+  
+  // Chatter that outruns the queue while the loop is blocked, ending held down
+  ScriptEdge script[BUTTON_EDGE_QUEUE_SIZE * 2 + 1];
+  for (size_t i = 0; i < sizeof(script) / sizeof(script[0]); i++) {
+    script[i].atMs = 100 + i * 3;
+    script[i].pressed = (i % 2) == 0;
+  }
+  playScript(script, sizeof(script) / sizeof(script[0]));
+  delay(1000);
+  CHECK(button.getDroppedEdges() > 0);
+  
+  // The pin is trusted: pressed once the debounce passes
+  loopFor(button, DEBOUNCE_MS + 20);
+  CHECK(button.isCurrentlyPressed());
+  hostSetPin(PIN_BUTTON, HIGH);
+  loopFor(button, DEBOUNCE_MS + 20);
+  CHECK(!button.isCurrentlyPressed());
+  CHECK(button.wasShortPress());
+}
+
+int main() {
+  Logger::setLogLevel(LOG_ERROR);
+  hostSetMillis(1000);
+  RUN_TEST(testCleanShortPress);
+  RUN_TEST(testBouncyPress);
+  RUN_TEST(testGlitchIgnored);
+  RUN_TEST(testLongPressWhileLooping);
+  RUN_TEST(testPressesWhileLoopBlocked);
+  RUN_TEST(testQueueOverflowResyncs);
+  return HOST_TEST_RESULT();
+}
@@ -0,0 +1,315 @@
+/*
+ * test_gesture_recognizer.cpp
+ * 
+ * GestureRecognizer fed scripted edge timestamps from a 10 ms loop: every
+ * gesture, the time it is classified against the bound in
+ * gesture_recognizer.h, edges that arrive late because the loop was blocked,
+ * queue overflow, and a bouncy double tap through ButtonHandler on a
+ * simulated pin
+ */
+
+#include "host_test.h"
+#include "gesture_recognizer.h"
+#include "button_handler.h"
+#include "logger.h"
+#include "config.h"
+
+#define PIN_BUTTON  34
+#define LOOP_MS     10    // Loop pass the sketch runs update() at
+#define MAX_EVENTS  16
+
+// One debounced edge, in ms from the start of the script
+struct ScriptEdge {
+  uint32_t atMs;
+  bool pressed;
+};
+
+// A gesture and the loop pass that popped it
+struct Seen {
+  GestureEvent event;
+  uint32_t reportedMs;
+};
+
+static Seen seen[MAX_EVENTS];
+static size_t seenCount = 0;
+
+static void startRecognizer(GestureRecognizer& gestures) {
+  gestures.init(GESTURE_TAP_GAP_MS, LONG_PRESS_MS, GESTURE_REPEAT_MS, GESTURE_HOLD_GAP_MS);
+  seenCount = 0;
+}
+
+static void drain(GestureRecognizer& gestures, uint32_t nowMs) {
+  GestureEvent event;
+  while (gestures.nextGesture(event)) {
+    if (seenCount < MAX_EVENTS) {
+      seen[seenCount].event = event;
+      seen[seenCount].reportedMs = nowMs;
+      seenCount++;
+    }
+  }
+}
+
+// Loop pass every LOOP_MS for durationMs: feed edges that happened, then update
+static void runScript(GestureRecognizer& gestures, const ScriptEdge* script, size_t count,
+                      uint32_t durationMs) {
+  size_t next = 0;
+  for (uint32_t now = 0; now <= durationMs; now += LOOP_MS) {
+    while (next < count && script[next].atMs <= now) {
+      gestures.onEdge(script[next].pressed, script[next].atMs);
+      next++;
+    }
+    gestures.update(now);
+    drain(gestures, now);
+  }
+}
+
+// Gesture i has this type, completion time and start, and was reported within one loop pass
+static void checkSeen(size_t i, GestureType type, uint32_t timeMs, uint32_t startMs) {
+  CHECK(i < seenCount);
+  if (i >= seenCount) {
+    return;
+  }
+  CHECK_STR(GestureRecognizer::getGestureName(seen[i].event.type), GestureRecognizer::getGestureName(type));
+  CHECK_EQ(seen[i].event.timeMs, timeMs);
+  CHECK_EQ(seen[i].event.startMs, startMs);
+  CHECK(seen[i].reportedMs >= timeMs);
+  CHECK(seen[i].reportedMs - timeMs < LOOP_MS);
+}
+
+// ============================================
+// TAPS
+// ============================================
+static void testTap() {
+  GestureRecognizer gestures;
+  startRecognizer(gestures);
+  const ScriptEdge script[] = { { 100, true }, { 180, false } };
+  runScript(gestures, script, 2, 1000);
+  
+  // Only once a second tap is ruled out
+  CHECK_EQ(seenCount, 1);
+  checkSeen(0, GESTURE_TAP, 180 + GESTURE_TAP_GAP_MS, 100);
+  CHECK(gestures.isIdle());
+}
+
+static void testDoubleTap() {
+  GestureRecognizer gestures;
+  startRecognizer(gestures);
+  const ScriptEdge script[] = {
+    { 100, true }, { 180, false },
+    { 180 + GESTURE_TAP_GAP_MS - 10, true }, { 180 + GESTURE_TAP_GAP_MS + 70, false }
+  };
+  runScript(gestures, script, 4, 1500);
+  
+  CHECK_EQ(seenCount, 1);
+  checkSeen(0, GESTURE_DOUBLE_TAP, 180 + GESTURE_TAP_GAP_MS + 70 + GESTURE_TAP_GAP_MS, 100);
+}
+
+static void testTripleTap() {
+  GestureRecognizer gestures;
+  startRecognizer(gestures);
+  const ScriptEdge script[] = {
+    { 100, true }, { 180, false },
+    { 300, true }, { 380, false },
+    { 500, true }, { 580, false }
+  };
+  runScript(gestures, script, 6, 1500);
+  
+  // No gap to wait out after the third release
+  CHECK_EQ(seenCount, 1);
+  checkSeen(0, GESTURE_TRIPLE_TAP, 580, 100);
+  CHECK(gestures.isIdle());
+}
+
+static void testSlowTapsStaySeparate() {
+  GestureRecognizer gestures;
+  startRecognizer(gestures);
+  const ScriptEdge script[] = {
+    { 100, true }, { 180, false },
+    { 180 + GESTURE_TAP_GAP_MS + 20, true }, { 180 + GESTURE_TAP_GAP_MS + 100, false }
+  };
+  runScript(gestures, script, 4, 1500);
+  
+  CHECK_EQ(seenCount, 2);
+  checkSeen(0, GESTURE_TAP, 180 + GESTURE_TAP_GAP_MS, 100);
+  checkSeen(1, GESTURE_TAP, 180 + GESTURE_TAP_GAP_MS + 100 + GESTURE_TAP_GAP_MS, 180 + GESTURE_TAP_GAP_MS + 20);
+}
+
+// ============================================
+// HOLDS
+// ============================================
+static void testHoldWithRepeat() {
+  GestureRecognizer gestures;
+  startRecognizer(gestures);
+  const uint32_t releaseMs = 100 + LONG_PRESS_MS + 2 * GESTURE_REPEAT_MS + 200;
+  const ScriptEdge script[] = { { 100, true }, { releaseMs, false } };
+  runScript(gestures, script, 2, releaseMs + 1000);
+  
+  CHECK_EQ(seenCount, 4);
+  checkSeen(0, GESTURE_HOLD_START, 100 + LONG_PRESS_MS, 100);
+  checkSeen(1, GESTURE_HOLD_REPEAT, 100 + LONG_PRESS_MS + GESTURE_REPEAT_MS, 100);
+  checkSeen(2, GESTURE_HOLD_REPEAT, 100 + LONG_PRESS_MS + 2 * GESTURE_REPEAT_MS, 100);
+  checkSeen(3, GESTURE_HOLD_END, releaseMs, 100);
+  CHECK(gestures.isIdle());
+}
+
+static void testHoldReleaseHold() {
+  GestureRecognizer gestures;
+  startRecognizer(gestures);
+  const uint32_t releaseMs = 100 + LONG_PRESS_MS + 100;
+  const uint32_t repressMs = releaseMs + GESTURE_HOLD_GAP_MS - 50;
+  const ScriptEdge script[] = {
+    { 100, true }, { releaseMs, false },
+    { repressMs, true }, { repressMs + LONG_PRESS_MS + 100, false }
+  };
+  runScript(gestures, script, 4, repressMs + 2000);
+  
+  CHECK_EQ(seenCount, 4);
+  checkSeen(0, GESTURE_HOLD_START, 100 + LONG_PRESS_MS, 100);
+  checkSeen(1, GESTURE_HOLD_END, releaseMs, 100);
+  checkSeen(2, GESTURE_HOLD_RELEASE_HOLD, repressMs + LONG_PRESS_MS, repressMs);
+  checkSeen(3, GESTURE_HOLD_END, repressMs + LONG_PRESS_MS + 100, repressMs);
+}
+
+static void testRepressAfterHoldGap() {
+  GestureRecognizer gestures;
+  startRecognizer(gestures);
+  const uint32_t releaseMs = 100 + LONG_PRESS_MS + 100;
+  const uint32_t repressMs = releaseMs + GESTURE_HOLD_GAP_MS + 50;
+  const ScriptEdge script[] = {
+    { 100, true }, { releaseMs, false },
+    { repressMs, true }, { repressMs + LONG_PRESS_MS + 100, false }
+  };
+  runScript(gestures, script, 4, repressMs + 2000);
+  
+  // Too late for hold-release-hold: a fresh hold
+  CHECK_EQ(seenCount, 4);
+  checkSeen(2, GESTURE_HOLD_START, repressMs + LONG_PRESS_MS, repressMs);
+  checkSeen(3, GESTURE_HOLD_END, repressMs + LONG_PRESS_MS + 100, repressMs);
+}
+
+static void testTapsThenHold() {
+  GestureRecognizer gestures;
+  startRecognizer(gestures);
+  const ScriptEdge script[] = {
+    { 100, true }, { 180, false },
+    { 300, true }, { 300 + LONG_PRESS_MS + 100, false }
+  };
+  runScript(gestures, script, 4, 3000);
+  
+  // The tap is absorbed into the hold
+  CHECK_EQ(seenCount, 2);
+  checkSeen(0, GESTURE_HOLD_START, 300 + LONG_PRESS_MS, 300);
+  checkSeen(1, GESTURE_HOLD_END, 300 + LONG_PRESS_MS + 100, 300);
+}
+
+// ============================================
+// LATE EDGES AND OVERFLOW
+// ============================================
+static void testEdgesAfterBlockedLoop() {
+  GestureRecognizer gestures;
+  startRecognizer(gestures);
+  
+  // A double tap and a hold, all edges handed over after a 4 s modem call
+  const ScriptEdge script[] = {
+    { 100, true }, { 180, false }, { 300, true }, { 380, false },
+    { 1000, true }, { 1000 + LONG_PRESS_MS + 300, false }
+  };
+  for (size_t i = 0; i < 6; i++) {
+    gestures.onEdge(script[i].pressed, script[i].atMs);
+  }
+  gestures.update(4000);
+  drain(gestures, 4000);
+  
+  // Classified by edge times, not by when update() ran
+  CHECK_EQ(seenCount, 3);
+  CHECK(seenCount == 3 && seen[0].event.type == GESTURE_DOUBLE_TAP);
+  CHECK_EQ(seen[0].event.timeMs, 380 + GESTURE_TAP_GAP_MS);
+  CHECK(seenCount == 3 && seen[1].event.type == GESTURE_HOLD_START);
+  CHECK_EQ(seen[1].event.timeMs, 1000 + LONG_PRESS_MS);
+  CHECK(seenCount == 3 && seen[2].event.type == GESTURE_HOLD_END);
+  CHECK(gestures.isIdle());
+}
+
+static void testQueueDropsOldest() {
+  GestureRecognizer gestures;
+  startRecognizer(gestures);
+  
+  // Taps one second apart, nobody popping
+  const uint32_t taps = GESTURE_QUEUE_SIZE + 2;
+  for (uint32_t i = 0; i < taps; i++) {
+    gestures.onEdge(true, 1000 * i);
+    gestures.onEdge(false, 1000 * i + 80);
+  }
+  gestures.update(1000 * taps);
+  drain(gestures, 1000 * taps);
+  
+  CHECK_EQ(seenCount, GESTURE_QUEUE_SIZE);
+  CHECK_EQ(seen[0].event.startMs, 1000 * (taps - GESTURE_QUEUE_SIZE));
+  CHECK_EQ(seen[GESTURE_QUEUE_SIZE - 1].event.startMs, 1000 * (taps - 1));
+}
+
+// ============================================
+// THROUGH BUTTONHANDLER
+// ============================================
+static void setPressed(void* arg) {
+  hostSetPin(PIN_BUTTON, arg != nullptr ? LOW : HIGH);   // Active low
+}
+
+static void testBouncyDoubleTapOnPin() {
+  GestureRecognizer gestures;
+  startRecognizer(gestures);
+  ButtonHandler button;
+  detachInterrupt(PIN_BUTTON);
+  hostSetPin(PIN_BUTTON, HIGH);
+  button.init(PIN_BUTTON, LONG_PRESS_MS, DEBOUNCE_MS);
+  button.setGestureRecognizer(&gestures);
+  
+  // Two presses with contact chatter on every edge
+  const uint32_t levels[][2] = {
+    { 100, 1 }, { 101, 0 }, { 103, 1 }, { 180, 0 }, { 182, 1 }, { 184, 0 },
+    { 300, 1 }, { 302, 0 }, { 303, 1 }, { 380, 0 }, { 381, 1 }, { 383, 0 }
+  };
+  unsigned long startUs = micros();
+  uint32_t startMs = millis();
+  for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+    hostScheduleAt(startUs + (unsigned long)levels[i][0] * 1000, setPressed,
+                   levels[i][1] ? (void*)1 : nullptr);
+  }
+  
+  uint32_t reportedMs = 0;
+  GestureEvent event;
+  event.type = GESTURE_NONE;
+  while (millis() - startMs < 1500) {
+    button.update();
+    if (reportedMs == 0 && gestures.nextGesture(event)) {
+      reportedMs = millis() - startMs;
+    }
+    delay(LOOP_MS);
+  }
+  
+  // One double tap, timed from the last bounce, within debounce plus a loop pass of the bound
+  CHECK(event.type == GESTURE_DOUBLE_TAP);
+  CHECK_EQ(event.startMs, startMs + 103);
+  CHECK_EQ(event.timeMs, startMs + 383 + GESTURE_TAP_GAP_MS);
+  CHECK(reportedMs >= 383 + GESTURE_TAP_GAP_MS);
+  CHECK(reportedMs - (383 + GESTURE_TAP_GAP_MS) <= DEBOUNCE_MS + LOOP_MS);
+  CHECK(!gestures.nextGesture(event));
+  CHECK(button.isIdle());
+}
+
+int main() {
+  Logger::setLogLevel(LOG_ERROR);
+  hostSetMillis(1000);
+  RUN_TEST(testTap);
+  RUN_TEST(testDoubleTap);
+  RUN_TEST(testTripleTap);
+  RUN_TEST(testSlowTapsStaySeparate);
+  RUN_TEST(testHoldWithRepeat);
+  RUN_TEST(testHoldReleaseHold);
+  RUN_TEST(testRepressAfterHoldGap);
+  RUN_TEST(testTapsThenHold);
+  RUN_TEST(testEdgesAfterBlockedLoop);
+  RUN_TEST(testQueueDropsOldest);
+  RUN_TEST(testBouncyDoubleTapOnPin);
+  return HOST_TEST_RESULT();
+}
@@ -0,0 +1,200 @@
+/*
+ * test_latency_histogram.cpp
+ * 
+ * LatencyHistogram bucket layout, percentile accuracy against exact values,
+ * saturation, merge equivalence and the sparse export format
+ */
+
+#include "host_test.h"
+#include "latency_histogram.h"
+#include "logger.h"
+
+static uint32_t rngState = 0x4C415431;
+
+static uint32_t nextRandom() {
+  // xorshift32: same sequence on every host
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+static int compareU32(const void* a, const void* b) {
+  uint32_t x = *(const uint32_t*)a;
+  uint32_t y = *(const uint32_t*)b;
+  return (x > y) - (x < y);
+}
+
+// Same nearest-rank definition as getPercentile()
+static uint32_t exactPercentile(const uint32_t* sorted, uint32_t count, float p) {
+  uint32_t rank = (uint32_t)(p / 100.0f * count + 0.5f);
+  if (rank < 1) {
+    rank = 1;
+  }
+  return sorted[rank - 1];
+}
+
+// ============================================
+// BUCKET LAYOUT
+// ============================================
+static void testBucketsContiguous() {
+  CHECK_EQ(LatencyHistogram::bucketLow(0), 0);
+  for (uint8_t i = 0; i + 1 < LAT_HIST_BUCKETS; i++) {
+    CHECK_EQ(LatencyHistogram::bucketHigh(i) + 1, LatencyHistogram::bucketLow(i + 1));
+  }
+  
+  // Every value up to the last bucket lands in [low, high]
+  uint32_t lastLow = LatencyHistogram::bucketLow(LAT_HIST_BUCKETS - 1);
+  for (uint32_t ms = 0; ms <= LatencyHistogram::bucketHigh(LAT_HIST_BUCKETS - 1); ms++) {
+    uint8_t i = LatencyHistogram::bucketIndex(ms);
+    if (ms < LatencyHistogram::bucketLow(i) || ms > LatencyHistogram::bucketHigh(i)) {
+      CHECK(false);
+      printf("     %lu ms -> bucket %u [%lu, %lu]\n", (unsigned long)ms, i,
+             (unsigned long)LatencyHistogram::bucketLow(i), (unsigned long)LatencyHistogram::bucketHigh(i));
+      return;
+    }
+  }
+  CHECK_EQ(LatencyHistogram::bucketIndex(lastLow), LAT_HIST_BUCKETS - 1);
+  CHECK_EQ(LatencyHistogram::bucketIndex(UINT32_MAX), LAT_HIST_BUCKETS - 1);
+}
+
+static void testBucketWidthBound() {
+  // No bucket is wider than a quarter of its lower edge
+  for (uint8_t i = LAT_HIST_SUB_BUCKETS; i < LAT_HIST_BUCKETS; i++) {
+    uint32_t low = LatencyHistogram::bucketLow(i);
+    uint32_t width = LatencyHistogram::bucketHigh(i) - low + 1;
+    CHECK(width * 4 <= low);
+  }
+}
+
+// ============================================
+// ACCURACY
+// ============================================
+static void testPercentileAccuracy() {
+  // Log-uniform 1 ms .. 60 s, like a mix of NFC reads and LTE uploads
+  const uint32_t n = 20000;
+  static uint32_t samples[n];
+  LatencyHistogram hist;
+  for (uint32_t i = 0; i < n; i++) {
+    samples[i] = (uint32_t)exp(log(60000.0) * (nextRandom() % 100000) / 100000.0);
+    hist.record(samples[i]);
+  }
+  qsort(samples, n, sizeof(samples[0]), compareU32);
+  
+  CHECK_EQ(hist.getCount(), n);
+  CHECK_EQ(hist.getMax(), samples[n - 1]);
+  
+  // Bucket midpoint is within 1/8 of the exact value (+1 ms for integer edges)
+  const float ps[] = { 1, 10, 25, 50, 75, 90, 99, 99.9f, 100 };
+  for (size_t i = 0; i < sizeof(ps) / sizeof(ps[0]); i++) {
+    uint32_t exact = exactPercentile(samples, n, ps[i]);
+    uint32_t estimate = hist.getPercentile(ps[i]);
+    uint32_t error = (estimate > exact) ? estimate - exact : exact - estimate;
+    if (error * 8 > exact + 8) {
+      CHECK(false);
+      printf("     p%.1f: exact %lu, estimate %lu\n", ps[i], (unsigned long)exact, (unsigned long)estimate);
+    }
+  }
+}
+
+static void testSmallValuesExact() {
+  LatencyHistogram hist;
+  for (uint32_t ms = 0; ms < LAT_HIST_SUB_BUCKETS; ms++) {
+    hist.record(ms);
+  }
+  CHECK_EQ(hist.getPercentile(25), 0);
+  CHECK_EQ(hist.getPercentile(100), LAT_HIST_SUB_BUCKETS - 1);
+  
+  LatencyHistogram empty;
+  CHECK_EQ(empty.getPercentile(50), 0);
+  CHECK_EQ(empty.getCount(), 0);
+}
+
+static void testSaturationAndOverflow() {
+  LatencyHistogram hist;
+  for (uint32_t i = 0; i < 70000; i++) {
+    hist.record(5);
+  }
+  hist.record(UINT32_MAX);
+  
+  // Count keeps going; the bucket stops at 65535
+  CHECK_EQ(hist.getCount(), 70001);
+  CHECK_EQ(hist.getMax(), UINT32_MAX);
+  char out[64];
+  CHECK(hist.format(out, sizeof(out)));
+  char expected[64];
+  snprintf(expected, sizeof(expected), "%u:65535,%u:1", LatencyHistogram::bucketIndex(5), LAT_HIST_BUCKETS - 1);
+  CHECK_STR(out, expected);
+}
+
+// ============================================
+// MERGE AND EXPORT
+// ============================================
+static void testMergeEqualsCombined() {
+  LatencyHistogram a;
+  LatencyHistogram b;
+  LatencyHistogram both;
+  for (uint32_t i = 0; i < 5000; i++) {
+    uint32_t ms = nextRandom() % 30000;
+    ((i % 3) ? a : b).record(ms);
+    both.record(ms);
+  }
+  a.merge(b);
+  
+  char merged[1024];
+  char combined[1024];
+  CHECK(a.format(merged, sizeof(merged)));
+  CHECK(both.format(combined, sizeof(combined)));
+  CHECK_STR(merged, combined);
+  CHECK_EQ(a.getCount(), both.getCount());
+  CHECK_EQ(a.getMax(), both.getMax());
+  CHECK_EQ(a.getPercentile(99), both.getPercentile(99));
+  
+  // Merging an empty histogram changes nothing; merging saturates
+  a.merge(LatencyHistogram());
+  CHECK(a.format(merged, sizeof(merged)));
+  CHECK_STR(merged, combined);
+  LatencyHistogram full;
+  for (uint32_t i = 0; i < 40000; i++) {
+    full.record(7);
+  }
+  LatencyHistogram sum = full;
+  sum.merge(full);
+  CHECK_EQ(sum.getCount(), 80000);
+  CHECK(sum.format(merged, sizeof(merged)));
+  snprintf(combined, sizeof(combined), "%u:65535", LatencyHistogram::bucketIndex(7));
+  CHECK_STR(merged, combined);
+}
+
+static void testFormatTruncatesOnEntry() {
+  LatencyHistogram hist;
+  hist.record(1);
+  hist.record(100);
+  hist.record(5000);
+  
+  char out[32];
+  CHECK(hist.format(out, sizeof(out)));
+  CHECK_STR(out, "1:1,22:1,44:1");
+  
+  // Too small: whole entries only, still terminated
+  CHECK(!hist.format(out, 10));
+  CHECK_STR(out, "1:1,22:1");
+  CHECK(!hist.format(out, 1));
+  CHECK_STR(out, "");
+  
+  LatencyHistogram empty;
+  CHECK(empty.format(out, sizeof(out)));
+  CHECK_STR(out, "");
+}
+
+int main() {
+  Logger::setLogLevel(LOG_ERROR);
+  RUN_TEST(testBucketsContiguous);
+  RUN_TEST(testBucketWidthBound);
+  RUN_TEST(testPercentileAccuracy);
+  RUN_TEST(testSmallValuesExact);
+  RUN_TEST(testSaturationAndOverflow);
+  RUN_TEST(testMergeEqualsCombined);
+  RUN_TEST(testFormatTruncatesOnEntry);
+  return HOST_TEST_RESULT();
+}
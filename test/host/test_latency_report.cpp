@@ -0,0 +1,172 @@
+/*
+ * test_latency_report.cpp
+ * 
+ * LatencyReport packing: the exact JSON for grouped series, empty series
+ * left out, snapshot counts restored on a failed upload and dropped on a
+ * delivered one, and series that do not fit carried over once, then dropped
+ */
+
+#include "host_test.h"
+#include "latency_report.h"
+#include "logger.h"
+
+#define REPORT_HEADER  "{\"latency\":{\"scheme\":\"" LAT_HIST_SCHEME "\",\"unit\":\"ms\""
+
+struct TestSeries {
+  LatencyHistogram fetch;
+  LatencyHistogram play;
+  LatencyHistogram idle;
+  LatencyHistogram at;
+  LatencyReport report;
+};
+
+static void addSeries(TestSeries& t) {
+  CHECK(t.report.add("state", "FETCH", &t.fetch));
+  CHECK(t.report.add("state", "PLAY", &t.play));
+  CHECK(t.report.add("state", "IDLE", &t.idle));
+  CHECK(t.report.add("lte", "AT", &t.at));
+}
+
+// FETCH 2x100 ms (bucket 22), PLAY 2 ms (bucket 2), AT 5 s (bucket 44), IDLE empty
+static void recordSamples(TestSeries& t) {
+  t.fetch.record(100);
+  t.fetch.record(100);
+  t.play.record(2);
+  t.at.record(5000);
+}
+
+static const char* fullReport =
+  REPORT_HEADER ",\"state\":{\"FETCH\":\"22:2\",\"PLAY\":\"2:1\"},\"lte\":{\"AT\":\"44:1\"}}}";
+static const char* stateOnlyReport =
+  REPORT_HEADER ",\"state\":{\"FETCH\":\"22:2\",\"PLAY\":\"2:1\"}}}";
+
+// ============================================
+// PACKING
+// ============================================
+static void testPacksGroups() {
+  TestSeries t;
+  addSeries(t);
+  recordSamples(t);
+  
+  char out[256];
+  CHECK(t.report.snapshot(out, sizeof(out)));
+  CHECK_STR(out, fullReport);
+  
+  // Live histograms start over while the snapshot is out
+  CHECK_EQ(t.fetch.getCount(), 0);
+  CHECK_EQ(t.at.getCount(), 0);
+  t.report.finish(true);
+  CHECK_EQ(t.fetch.getCount(), 0);
+}
+
+static void testNothingToReport() {
+  TestSeries t;
+  addSeries(t);
+  char out[256];
+  CHECK(!t.report.snapshot(out, sizeof(out)));
+  
+  // Header alone does not fit: counts stay live
+  recordSamples(t);
+  CHECK(!t.report.snapshot(out, 16));
+  CHECK_EQ(t.fetch.getCount(), 2);
+  CHECK_EQ(t.at.getCount(), 1);
+}
+
+static void testUndeliveredMergedBack() {
+  TestSeries t;
+  addSeries(t);
+  recordSamples(t);
+  
+  char out[256];
+  CHECK(t.report.snapshot(out, sizeof(out)));
+  t.fetch.record(100);
+  t.report.finish(false);
+  CHECK_EQ(t.fetch.getCount(), 3);
+  CHECK_EQ(t.at.getCount(), 1);
+  
+  // An unresolved snapshot is merged back before the next one
+  CHECK(t.report.snapshot(out, sizeof(out)));
+  CHECK(t.report.snapshot(out, sizeof(out)));
+  CHECK_STR(out, REPORT_HEADER ",\"state\":{\"FETCH\":\"22:3\",\"PLAY\":\"2:1\"},\"lte\":{\"AT\":\"44:1\"}}}");
+  t.report.finish(true);
+  CHECK_EQ(t.fetch.getCount(), 0);
+}
+
+static void testExactFitAndCarryOver() {
+  TestSeries t;
+  addSeries(t);
+  recordSamples(t);
+  
+  // Room for the state group exactly: AT waits for the next report
+  char out[256];
+  size_t fit = strlen(stateOnlyReport) + 1;
+  CHECK(t.report.snapshot(out, fit));
+  CHECK_STR(out, stateOnlyReport);
+  CHECK_EQ(t.at.getCount(), 1);
+  t.report.finish(true);
+  CHECK_EQ(t.fetch.getCount(), 0);
+  CHECK_EQ(t.at.getCount(), 1);
+  
+  // AT did not fit twice: dropped rather than blocking every report
+  t.fetch.record(100);
+  t.fetch.record(100);
+  t.play.record(2);
+  CHECK(t.report.snapshot(out, fit));
+  CHECK_STR(out, stateOnlyReport);
+  CHECK_EQ(t.at.getCount(), 0);
+  t.report.finish(true);
+  
+  // One byte less and PLAY is carried as well
+  recordSamples(t);
+  CHECK(t.report.snapshot(out, fit - 1));
+  CHECK_STR(out, REPORT_HEADER ",\"state\":{\"FETCH\":\"22:2\"}}}");
+  CHECK_EQ(t.play.getCount(), 1);
+  CHECK_EQ(t.at.getCount(), 1);
+  t.report.finish(true);
+  
+  // Both go out once there is room
+  CHECK(t.report.snapshot(out, sizeof(out)));
+  CHECK_STR(out, REPORT_HEADER ",\"state\":{\"PLAY\":\"2:1\"},\"lte\":{\"AT\":\"44:1\"}}}");
+  t.report.finish(true);
+}
+
+static void testOversizedSeriesDropped() {
+  TestSeries t;
+  addSeries(t);
+  
+  // One series with every bucket in use does not fit even on its own
+  for (uint32_t ms = 0; ms < 300000; ms += 97) {
+    t.at.record(ms);
+  }
+  char out[128];
+  CHECK(!t.report.snapshot(out, sizeof(out)));
+  CHECK_EQ(t.at.getCount(), 0);
+  
+  // Later samples are reported as usual
+  t.at.record(5000);
+  CHECK(t.report.snapshot(out, sizeof(out)));
+  CHECK_STR(out, REPORT_HEADER ",\"lte\":{\"AT\":\"44:1\"}}}");
+  t.report.finish(true);
+}
+
+static void testSeriesLimit() {
+  LatencyHistogram hist;
+  LatencyReport report;
+  for (int i = 0; i < LATENCY_REPORT_MAX_SERIES; i++) {
+    CHECK(report.add("state", "S", &hist));
+  }
+  CHECK(!report.add("state", "S", &hist));
+  LatencyReport other;
+  CHECK(!other.add("state", "NULL", nullptr));
+}
+
+int main() {
+  Logger::setLogLevel(LOG_ERROR);
+  RUN_TEST(testPacksGroups);
+  RUN_TEST(testNothingToReport);
+  RUN_TEST(testUndeliveredMergedBack);
+  RUN_TEST(testExactFitAndCarryOver);
+  RUN_TEST(testOversizedSeriesDropped);
+  RUN_TEST(testSeriesLimit);
+  return HOST_TEST_RESULT();
+}
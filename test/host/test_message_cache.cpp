@@ -0,0 +1,206 @@
+/*
+ * test_message_cache.cpp
+ * 
+ * MessageCache on the in-memory LittleFS: round trip and remount, LRU
+ * eviction by count and by bytes, a power cut mid-store, and a tap
+ * simulation against an ETag server reporting hit rate, bytes saved and
+ * tap-to-audio latency for cached vs uncached plays
+ */
+
+#include "host_test.h"
+#include "message_cache.h"
+#include "logger.h"
+#include "config.h"
+
+static uint8_t clip[MSG_CACHE_MAX_BYTES + 1];
+static uint8_t loaded[MSG_CACHE_MAX_BYTES];
+
+static void fillClip(size_t length, uint8_t seed) {
+  for (size_t i = 0; i < length; i++) {
+    clip[i] = (uint8_t)(seed + i * 13);
+  }
+}
+
+static bool storeClip(MessageCache& cache, const char* uid, const char* etag, size_t length, uint8_t seed) {
+  fillClip(length, seed);
+  return cache.store(uid, etag, clip, length);
+}
+
+// Load the entry for uid and check it is the clip stored with seed
+static bool loadsClip(MessageCache& cache, const char* uid, size_t length, uint8_t seed) {
+  size_t got = 0;
+  if (!cache.load(uid, loaded, sizeof(loaded), &got) || got != length) {
+    return false;
+  }
+  fillClip(length, seed);
+  return memcmp(loaded, clip, length) == 0;
+}
+
+static void testRoundTripAndRemount() {
+  LittleFS.hostFormat();
+  MessageCache cache;
+  CHECK(cache.begin());
+  
+  char etag[MSG_CACHE_ETAG_LEN];
+  CHECK(!cache.lookup("04A1B2C3", etag, sizeof(etag)));
+  CHECK(storeClip(cache, "04A1B2C3", "\"v1\"", 32000, 1));
+  CHECK(cache.lookup("04A1B2C3", etag, sizeof(etag)));
+  CHECK_STR(etag, "\"v1\"");
+  CHECK(loadsClip(cache, "04A1B2C3", 32000, 1));
+  
+  // No validator: nothing to revalidate against, so not cached
+  CHECK(!storeClip(cache, "04D4E5F6", "", 1000, 2));
+  
+  // Replacing keeps one entry with the new ETag
+  CHECK(storeClip(cache, "04A1B2C3", "\"v2\"", 16000, 3));
+  CHECK(cache.lookup("04A1B2C3", etag, sizeof(etag)));
+  CHECK_STR(etag, "\"v2\"");
+  
+  MessageCache after;
+  CHECK(after.begin());
+  CHECK(after.lookup("04A1B2C3", etag, sizeof(etag)));
+  CHECK_STR(etag, "\"v2\"");
+  CHECK(loadsClip(after, "04A1B2C3", 16000, 3));
+}
+
+static void testLruEvictionByCount() {
+  LittleFS.hostFormat();
+  MessageCache cache;
+  CHECK(cache.begin());
+  
+  char uid[MSG_CACHE_UID_LEN];
+  for (int i = 0; i < MSG_CACHE_MAX_ENTRIES; i++) {
+    snprintf(uid, sizeof(uid), "UID%02d", i);
+    CHECK(storeClip(cache, uid, "\"e\"", 1000, (uint8_t)i));
+  }
+  
+  // Touch the oldest: the second oldest is evicted instead
+  CHECK(loadsClip(cache, "UID00", 1000, 0));
+  CHECK(storeClip(cache, "UIDNEW", "\"e\"", 1000, 99));
+  
+  char etag[MSG_CACHE_ETAG_LEN];
+  CHECK(cache.lookup("UID00", etag, sizeof(etag)));
+  CHECK(!cache.lookup("UID01", etag, sizeof(etag)));
+  CHECK(cache.lookup("UID02", etag, sizeof(etag)));
+  CHECK(cache.lookup("UIDNEW", etag, sizeof(etag)));
+  CHECK(LittleFS.hostData("/cache/UID01.pcm") == nullptr);
+}
+
+static void testLruEvictionByBytes() {
+  LittleFS.hostFormat();
+  MessageCache cache;
+  CHECK(cache.begin());
+  
+  // Three clips of 40% each: the third pushes the first out
+  size_t size = MSG_CACHE_MAX_BYTES * 2 / 5;
+  CHECK(storeClip(cache, "A", "\"a\"", size, 1));
+  CHECK(storeClip(cache, "B", "\"b\"", size, 2));
+  CHECK(storeClip(cache, "C", "\"c\"", size, 3));
+  
+  char etag[MSG_CACHE_ETAG_LEN];
+  CHECK(!cache.lookup("A", etag, sizeof(etag)));
+  CHECK(cache.lookup("B", etag, sizeof(etag)));
+  CHECK(loadsClip(cache, "C", size, 3));
+  
+  // Larger than the whole cache: refused, nothing evicted
+  CHECK(!storeClip(cache, "D", "\"d\"", MSG_CACHE_MAX_BYTES + 1, 4));
+  CHECK(cache.lookup("B", etag, sizeof(etag)));
+}
+
+static void testPowerCutMidStore() {
+  LittleFS.hostFormat();
+  MessageCache cache;
+  CHECK(cache.begin());
+  CHECK(storeClip(cache, "04A1B2C3", "\"v1\"", 20000, 1));
+  
+  // The refresh dies halfway: the old copy stays playable
+  LittleFS.hostCutPowerAfter(10000);
+  CHECK(!storeClip(cache, "04A1B2C3", "\"v2\"", 20000, 2));
+  LittleFS.hostRestorePower();
+  
+  MessageCache after;
+  CHECK(after.begin());
+  char etag[MSG_CACHE_ETAG_LEN];
+  CHECK(after.lookup("04A1B2C3", etag, sizeof(etag)));
+  CHECK_STR(etag, "\"v1\"");
+  CHECK(loadsClip(after, "04A1B2C3", 20000, 1));
+}
+
+// ============================================
+// TAP SIMULATION
+// ============================================
+// Latency model for one tap over LTE: a conditional GET costs a round trip,
+// a full download adds the body at the link rate, a cached play reads flash.
+#define SIM_RTT_MS          300
+#define SIM_LINK_BYTES_MS   20     // ~160 kbit/s
+#define SIM_FLASH_BYTES_MS  2000
+
+struct SimTag {
+  const char* uid;
+  uint32_t version;
+  size_t length;
+};
+
+static void testTapSimulation() {
+  LittleFS.hostFormat();
+  MessageCache cache;
+  CHECK(cache.begin());
+  
+  SimTag tags[] = {
+    { "04A1B2C3", 1, 64000 },
+    { "04D4E5F6", 1, 96000 },
+    { "04112233", 1, 48000 },
+  };
+  const int tagCount = sizeof(tags) / sizeof(tags[0]);
+  
+  // Repeat taps, with the second tag's message re-recorded halfway through
+  int taps = 0;
+  for (int round = 0; round < 10; round++) {
+    if (round == 5) {
+      tags[1].version++;
+    }
+    for (int t = 0; t < tagCount; t++) {
+      SimTag& tag = tags[t];
+      char serverEtag[MSG_CACHE_ETAG_LEN];
+      snprintf(serverEtag, sizeof(serverEtag), "\"%s-%lu\"", tag.uid, (unsigned long)tag.version);
+      
+      char etag[MSG_CACHE_ETAG_LEN];
+      bool hadEntry = cache.lookup(tag.uid, etag, sizeof(etag));
+      size_t got = 0;
+      if (hadEntry && strcmp(etag, serverEtag) == 0 &&
+          cache.load(tag.uid, loaded, sizeof(loaded), &got)) {
+        // 304 Not Modified
+        CHECK_EQ(got, tag.length);
+        cache.recordHit(got, SIM_RTT_MS + got / SIM_FLASH_BYTES_MS);
+      } else {
+        // 200 with the body
+        CHECK(storeClip(cache, tag.uid, serverEtag, tag.length, (uint8_t)tag.version));
+        cache.recordMiss(hadEntry, SIM_RTT_MS + tag.length / SIM_LINK_BYTES_MS);
+      }
+      taps++;
+    }
+  }
+  
+  const MessageCacheStats& stats = cache.getStats();
+  CHECK_EQ(stats.misses, tagCount);
+  CHECK_EQ(stats.refreshes, 1);
+  CHECK_EQ(stats.hits, taps - tagCount - 1);
+  CHECK_EQ(stats.bytesSaved, 9 * 64000 + 8 * 96000 + 9 * 48000);
+  
+  uint32_t hitMs = stats.hitLatencyMs / stats.hits;
+  uint32_t missMs = stats.missLatencyMs / (stats.misses + stats.refreshes);
+  CHECK(hitMs * 5 < missMs);
+  printf("     hit rate %lu/%d, %lu bytes saved, tap-to-audio cached %lu ms, uncached %lu ms\n",
+         (unsigned long)stats.hits, taps, (unsigned long)stats.bytesSaved,
+         (unsigned long)hitMs, (unsigned long)missMs);
+}
+
+int main() {
+  Logger::setLogLevel(LOG_ERROR);
+  RUN_TEST(testRoundTripAndRemount);
+  RUN_TEST(testLruEvictionByCount);
+  RUN_TEST(testLruEvictionByBytes);
+  RUN_TEST(testPowerCutMidStore);
+  RUN_TEST(testTapSimulation);
+  return HOST_TEST_RESULT();
+}
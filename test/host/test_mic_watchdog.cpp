@@ -0,0 +1,157 @@
+/*
+ * test_mic_watchdog.cpp
+ * 
+ * MicWatchdog + AudioManager against the simulated mic: stuck-at-zero and
+ * stuck-at-0x00000001 streams, the per-clip restart budget, and silence
+ * backfill keeping the sample count in step with the clock
+ */
+
+#include "host_test.h"
+#include "audio_manager.h"
+#include "mic_watchdog.h"
+#include "logger.h"
+#include "config.h"
+
+#define BLOCK_BYTES  512   // Up to 256 mono samples per read
+#define BLOCK_MS     8   // Loop period
+
+static AudioManager audio;
+static MicWatchdog watchdog;
+static TaskHandle_t watchdogTask = nullptr;
+static unsigned long nextCheck = 0;
+
+// Drain the mic every BLOCK_MS and run the watchdog every
+// MIC_WATCHDOG_PERIOD_MS, as the loop and the monitor task would.
+// Returns mono samples delivered.
+static uint32_t recordFor(uint32_t durationMs) {
+  uint8_t block[BLOCK_BYTES];
+  uint32_t samples = 0;
+  unsigned long end = millis() + durationMs;
+  while (millis() < end) {
+    size_t got;
+    while ((got = audio.readRecordedData(block, sizeof(block))) > 0) {
+      samples += got / sizeof(int16_t);
+    }
+    if (millis() >= nextCheck) {
+      hostStepTask(watchdogTask);
+      nextCheck = millis() + MIC_WATCHDOG_PERIOD_MS;
+    }
+    hostAdvanceMillis(BLOCK_MS);
+  }
+  return samples;
+}
+
+static void startClip() {
+  hostMicSetPattern(HOST_MIC_SPEECH, false);
+  CHECK(audio.startRecording(SAMPLE_RATE));
+}
+
+static void testStuckZeroRecovers() {
+  startClip();
+  uint32_t restartsBefore = watchdog.getTotalRestarts();
+  uint32_t installsBefore = hostI2sInstallCount(I2S_NUM_0);
+  recordFor(1000);
+  CHECK_EQ(watchdog.getTotalRestarts(), restartsBefore);
+  
+  // Mic goes quiet; one I2S restart brings it back
+  hostMicSetPattern(HOST_MIC_STUCK_ZERO, true);
+  uint32_t overflowBefore = hostMicOverflowFrames();
+  unsigned long start = millis();
+  uint32_t samples = recordFor(3000);
+  uint32_t elapsed = millis() - start;
+  
+  CHECK_EQ(watchdog.getTotalRestarts(), restartsBefore + 1);
+  CHECK_EQ(watchdog.getRestartCount(), 1);
+  CHECK_EQ(hostI2sInstallCount(I2S_NUM_0), installsBefore + 1);
+  CHECK_EQ(audio.getStuckBlockRun(), 0);
+  
+  // Silence covers the restart: delivered audio matches the time that passed
+  uint32_t expected = elapsed * (SAMPLE_RATE / 1000);
+  CHECK(samples + 256 >= expected && samples <= expected + 256);
+  CHECK_EQ(hostMicOverflowFrames(), overflowBefore);
+  audio.stopRecording();
+}
+
+static void testStuckOneRecovers() {
+  startClip();
+  uint32_t restartsBefore = watchdog.getTotalRestarts();
+  recordFor(500);
+  
+  hostMicSetPattern(HOST_MIC_STUCK_ONE, true);
+  recordFor(3000);
+  CHECK_EQ(watchdog.getTotalRestarts(), restartsBefore + 1);
+  CHECK_EQ(audio.getStuckBlockRun(), 0);
+  CHECK(audio.getMsSinceLastGoodBlock() < MIC_WATCHDOG_STALL_MS);
+  audio.stopRecording();
+}
+
+static void testDetectionLatency() {
+  startClip();
+  recordFor(500);
+  uint32_t restartsBefore = watchdog.getTotalRestarts();
+  
+  // Stuck blocks must add up to MIC_WATCHDOG_STUCK_BLOCKS, then one check period
+  hostMicSetPattern(HOST_MIC_STUCK_ZERO, true);
+  unsigned long start = millis();
+  while (watchdog.getTotalRestarts() == restartsBefore && millis() - start < 5000) {
+    recordFor(BLOCK_MS);
+  }
+  uint32_t detectMs = millis() - start;
+  uint32_t boundMs = MIC_WATCHDOG_STUCK_BLOCKS * BLOCK_MS + MIC_WATCHDOG_PERIOD_MS + 400;  // + restart time
+  CHECK(watchdog.getTotalRestarts() == restartsBefore + 1);
+  CHECK(detectMs <= boundMs);
+  printf("     detection + restart: %lu ms (bound %lu ms)\n", (unsigned long)detectMs, (unsigned long)boundMs);
+  audio.stopRecording();
+}
+
+static void testBudgetPerClip() {
+  startClip();
+  uint32_t restartsBefore = watchdog.getTotalRestarts();
+  
+  // Dead mic: restarts stop at the budget, spaced by the hold-off
+  hostMicSetPattern(HOST_MIC_STUCK_ZERO, false);
+  recordFor(10000);
+  CHECK_EQ(watchdog.getRestartCount(), MIC_WATCHDOG_MAX_RESTARTS);
+  CHECK(watchdog.isBudgetExhausted());
+  CHECK_EQ(watchdog.getTotalRestarts(), restartsBefore + MIC_WATCHDOG_MAX_RESTARTS);
+  audio.stopRecording();
+  
+  // The next clip gets a fresh budget
+  CHECK(audio.startRecording(SAMPLE_RATE));
+  recordFor(10000);
+  CHECK_EQ(watchdog.getRestartCount(), MIC_WATCHDOG_MAX_RESTARTS);
+  CHECK_EQ(watchdog.getTotalRestarts(), restartsBefore + 2 * MIC_WATCHDOG_MAX_RESTARTS);
+  audio.stopRecording();
+}
+
+static void testNoBackfillAcrossClips() {
+  startClip();
+  recordFor(500);
+  hostMicSetPattern(HOST_MIC_STUCK_ZERO, true);
+  recordFor(800);  // Restart done, silence still owed
+  
+  // A new clip starts on live audio, not on the last clip's silence
+  audio.stopRecording();
+  startClip();
+  uint8_t block[BLOCK_BYTES];
+  size_t got = audio.readRecordedData(block, sizeof(block));
+  CHECK_EQ(got, BLOCK_BYTES / 2);
+  CHECK(audio.getCaptureStats().silentSamples < got / sizeof(int16_t));
+  audio.stopRecording();
+}
+
+int main() {
+  Logger::setLogLevel(LOG_ERROR);
+  hostSetMillis(1000);
+  CHECK(audio.init(26, 25, 33, 14, 12, 27));
+  CHECK(watchdog.begin(&audio));
+  watchdogTask = hostFindTask("mic_wdt");
+  CHECK(watchdogTask != nullptr);
+  
+  RUN_TEST(testStuckZeroRecovers);
+  RUN_TEST(testStuckOneRecovers);
+  RUN_TEST(testDetectionLatency);
+  RUN_TEST(testBudgetPerClip);
+  RUN_TEST(testNoBackfillAcrossClips);
+  return HOST_TEST_RESULT();
+}
@@ -0,0 +1,282 @@
+/*
+ * test_ndef_fuzz.cpp
+ * 
+ * Fuzz target for the NDEF parser. Seed tag areas are mutated with a fixed
+ * seed (bit flips, interesting bytes, inserts, deletes, truncation, random
+ * tails) and every input is checked for:
+ *   - findMessage() and the record iterator staying inside the buffer
+ *   - the iterator ending within one record per byte
+ *   - hints being terminated, printable ASCII and free of '"'
+ *   - page-by-page reading agreeing with reading the whole area at once
+ * Each input sits in an exact-size heap block so an AddressSanitizer build
+ * (-DHOST_SANITIZE=ON) catches any read past the end.
+ * 
+ *   test_ndef_fuzz [iterations] [seed]
+ */
+
+#include "host_test.h"
+#include "ndef_parser.h"
+#include <stdlib.h>
+#include <vector>
+
+#define FUZZ_MAX_INPUT  600   // NTAG216 user memory is 888; NTAG215 504
+
+typedef std::vector<uint8_t> Bytes;
+
+static uint32_t rngState = 1;
+
+static uint32_t nextRandom() {
+  // xorshift32: same sequence on every host
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+static uint32_t randomBelow(uint32_t n) {
+  return (n == 0) ? 0 : nextRandom() % n;
+}
+
+// ============================================
+// SEED CORPUS
+// ============================================
+static void appendRecord(Bytes& out, uint8_t flags, const char* type, const uint8_t* payload, size_t payloadLength) {
+  size_t typeLength = strlen(type);
+  out.push_back(flags);
+  out.push_back((uint8_t)typeLength);
+  if (flags & 0x10) {
+    out.push_back((uint8_t)payloadLength);
+  } else {
+    out.push_back((uint8_t)(payloadLength >> 24));
+    out.push_back((uint8_t)(payloadLength >> 16));
+    out.push_back((uint8_t)(payloadLength >> 8));
+    out.push_back((uint8_t)payloadLength);
+  }
+  out.insert(out.end(), type, type + typeLength);
+  out.insert(out.end(), payload, payload + payloadLength);
+}
+
+static void appendNdefTlv(Bytes& out, const Bytes& message) {
+  out.push_back(0x03);
+  if (message.size() < 0xFF) {
+    out.push_back((uint8_t)message.size());
+  } else {
+    out.push_back(0xFF);
+    out.push_back((uint8_t)(message.size() >> 8));
+    out.push_back((uint8_t)message.size());
+  }
+  out.insert(out.end(), message.begin(), message.end());
+  out.push_back(0xFE);
+}
+
+static std::vector<Bytes> buildSeeds() {
+  std::vector<Bytes> seeds;
+  const uint8_t msgId[] = "MSG-0042";
+  const uint8_t version[] = "5f3a-2";
+  const uint8_t uri[] = "\x04" "example.com/clips/42.wav";
+  
+  // Factory NTAG213 lock control TLV, then all three hints
+  Bytes message;
+  appendRecord(message, 0x94, NDEF_HINT_TYPE_MSG_ID, msgId, sizeof(msgId) - 1);
+  appendRecord(message, 0x14, NDEF_HINT_TYPE_VERSION, version, sizeof(version) - 1);
+  appendRecord(message, 0x51, "U", uri, sizeof(uri) - 1);
+  Bytes tag = { 0x01, 0x03, 0xA0, 0x0C, 0x34 };
+  appendNdefTlv(tag, message);
+  seeds.push_back(tag);
+  
+  // Long record form and the three-byte TLV length
+  Bytes longPayload(300, 'a');
+  Bytes longMessage;
+  appendRecord(longMessage, 0xC4, "esp32voice:pad", longPayload.data(), longPayload.size());
+  Bytes longTag;
+  appendNdefTlv(longTag, longMessage);
+  seeds.push_back(longTag);
+  
+  // NULL padding and an empty record
+  Bytes empty = { 0x00, 0x00 };
+  Bytes emptyMessage = { 0xD0, 0x00, 0x00 };
+  appendNdefTlv(empty, emptyMessage);
+  seeds.push_back(empty);
+  return seeds;
+}
+
+// ============================================
+// MUTATOR
+// ============================================
+static const uint8_t interesting[] = { 0x00, 0x01, 0x03, 0x10, 0x14, 0x7F, 0x80, 0xC0, 0xD1, 0xFE, 0xFF };
+
+static void mutate(Bytes& data) {
+  uint32_t ops = 1 + randomBelow(4);
+  for (uint32_t i = 0; i < ops; i++) {
+    size_t pos = randomBelow((uint32_t)data.size() + 1);
+    switch (randomBelow(8)) {
+      case 0:
+        if (pos < data.size()) data[pos] ^= (uint8_t)(1 << randomBelow(8));
+        break;
+      case 1:
+        if (pos < data.size()) data[pos] = (uint8_t)nextRandom();
+        break;
+      case 2:
+        if (pos < data.size()) data[pos] = interesting[randomBelow(sizeof(interesting))];
+        break;
+      case 3:
+        data.insert(data.begin() + pos, (uint8_t)nextRandom());
+        break;
+      case 4:
+        if (pos < data.size()) data.erase(data.begin() + pos);
+        break;
+      case 5:
+        data.resize(pos);
+        break;
+      case 6:
+        for (uint32_t n = randomBelow(32); n > 0; n--) {
+          data.push_back((uint8_t)nextRandom());
+        }
+        break;
+      default:
+        // Length fields: bump the byte after a TLV or record header
+        if (pos + 1 < data.size()) data[pos + 1] = (uint8_t)(data[pos + 1] + 1 + randomBelow(3));
+        break;
+    }
+  }
+  if (data.size() > FUZZ_MAX_INPUT) {
+    data.resize(FUZZ_MAX_INPUT);
+  }
+}
+
+// ============================================
+// PROPERTIES
+// ============================================
+static bool inside(const uint8_t* p, size_t n, const uint8_t* begin, const uint8_t* end) {
+  return p >= begin && p <= end && n <= (size_t)(end - p);
+}
+
+static bool isHintString(const char* s, size_t size) {
+  size_t len = strnlen(s, size);
+  if (len == size) {
+    return false;
+  }
+  for (size_t i = 0; i < len; i++) {
+    if (s[i] < 0x20 || s[i] > 0x7E || s[i] == '"') {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void checkInput(const Bytes& input) {
+  size_t length = input.size();
+  uint8_t* data = (uint8_t*)malloc(length ? length : 1);
+  if (length) {
+    memcpy(data, input.data(), length);
+  }
+  const uint8_t* dataEnd = data + length;
+  
+  const uint8_t* message = nullptr;
+  size_t messageLength = 0;
+  NdefStatus status = NdefParser::findMessage(data, length, &message, &messageLength);
+  if (status == NDEF_OK) {
+    CHECK(inside(message, messageLength, data, dataEnd));
+    
+    NdefParser parser(message, messageLength);
+    NdefRecord record;
+    size_t records = 0;
+    while (parser.next(record) && records <= messageLength) {
+      records++;
+      const uint8_t* messageEnd = message + messageLength;
+      CHECK(inside(record.type, record.typeLength, message, messageEnd));
+      CHECK(inside(record.id, record.idLength, message, messageEnd));
+      CHECK(inside(record.payload, record.payloadLength, message, messageEnd));
+    }
+    CHECK(records <= messageLength);
+  }
+  
+  // Page by page, as NFCManager::readNdef() reads, must end the same way
+  NdefStatus paged = NDEF_INCOMPLETE;
+  const uint8_t* pagedMessage = nullptr;
+  size_t pagedLength = 0;
+  for (size_t have = 4; paged == NDEF_INCOMPLETE && have < length + 4; have += 4) {
+    size_t n = (have < length) ? have : length;
+    paged = NdefParser::findMessage(data, n, &pagedMessage, &pagedLength);
+  }
+  if (length > 0) {
+    CHECK(paged == status);
+  }
+  if (status == NDEF_OK && paged == NDEF_OK) {
+    CHECK(pagedMessage == message && pagedLength == messageLength);
+  }
+  
+  NdefTagHints hints;
+  memset(&hints, 0x55, sizeof(hints));
+  bool found = NdefParser::parseHints(data, length, hints);
+  CHECK(isHintString(hints.messageId, sizeof(hints.messageId)));
+  CHECK(isHintString(hints.cacheVersion, sizeof(hints.cacheVersion)));
+  CHECK(isHintString(hints.audioUrl, sizeof(hints.audioUrl)));
+  CHECK(!found || hints.messageId[0] || hints.cacheVersion[0] || hints.audioUrl[0]);
+  CHECK(found || status != NDEF_OK || (!hints.messageId[0] && !hints.cacheVersion[0] && !hints.audioUrl[0]));
+  
+  free(data);
+}
+
+static void testSeedsParse() {
+  std::vector<Bytes> seeds = buildSeeds();
+  NdefTagHints hints;
+  CHECK(NdefParser::parseHints(seeds[0].data(), seeds[0].size(), hints));
+  CHECK_STR(hints.messageId, "MSG-0042");
+  CHECK_STR(hints.cacheVersion, "5f3a-2");
+  CHECK_STR(hints.audioUrl, "https://example.com/clips/42.wav");
+  
+  const uint8_t* message;
+  size_t messageLength;
+  CHECK(NdefParser::findMessage(seeds[1].data(), seeds[1].size(), &message, &messageLength) == NDEF_OK);
+  CHECK_EQ(messageLength, 2 + 4 + 14 + 300);
+  CHECK(!NdefParser::parseHints(seeds[2].data(), seeds[2].size(), hints));
+  
+  for (size_t i = 0; i < seeds.size(); i++) {
+    checkInput(seeds[i]);
+  }
+}
+
+static uint32_t fuzzIterations = 200000;
+
+static void testFuzz() {
+  std::vector<Bytes> seeds = buildSeeds();
+  Bytes input;
+  for (uint32_t i = 0; i < fuzzIterations; i++) {
+    // Mostly mutated seeds, some pure noise
+    if (randomBelow(16) == 0) {
+      input.resize(randomBelow(FUZZ_MAX_INPUT));
+      for (size_t j = 0; j < input.size(); j++) {
+        input[j] = (uint8_t)nextRandom();
+      }
+    } else {
+      input = seeds[randomBelow((uint32_t)seeds.size())];
+      mutate(input);
+    }
+    
+    int failuresBefore = hostTestFailures;
+    checkInput(input);
+    if (hostTestFailures != failuresBefore) {
+      printf("     iteration %lu, %u bytes:", (unsigned long)i, (unsigned)input.size());
+      for (size_t j = 0; j < input.size() && j < 64; j++) {
+        printf(" %02X", input[j]);
+      }
+      printf("\n");
+      return;
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) {
+    fuzzIterations = (uint32_t)strtoul(argv[1], nullptr, 10);
+  }
+  rngState = (argc > 2) ? (uint32_t)strtoul(argv[2], nullptr, 10) : 0x4E444546;
+  if (rngState == 0) {
+    rngState = 1;
+  }
+  
+  RUN_TEST(testSeedsParse);
+  RUN_TEST(testFuzz);
+  return HOST_TEST_RESULT();
+}
@@ -0,0 +1,203 @@
+/*
+ * test_nfc_irq.cpp
+ * 
+ * NFCManager against the simulated PN532: IRQ detection latency against
+ * the 500 ms polling it replaced, no I2C traffic while armed, cancellation
+ * by a synchronous read, the duty-cycled field and early NDEF stop
+ */
+
+#include "host_test.h"
+#include "nfc_manager.h"
+#include "logger.h"
+#include "config.h"
+
+#define PIN_IRQ  4
+#define PIN_RST  5
+
+static NFCManager nfc;
+static const uint8_t cardUid[7] = { 0x04, 0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0x80 };
+static uint8_t cardMemory[540];
+
+static volatile uint32_t irqCount = 0;
+static volatile unsigned long irqUs = 0;
+
+static void onIrq() {
+  irqCount++;
+  irqUs = micros();
+}
+
+static void presentCard() {
+  hostPn532PresentCard(cardUid, sizeof(cardUid), cardMemory, sizeof(cardMemory));
+}
+
+// Step the clock 1 ms at a time until the IRQ fires or limitMs passes
+static bool waitForIrq(uint32_t before, uint32_t limitMs) {
+  for (uint32_t i = 0; i < limitMs && irqCount == before; i++) {
+    hostAdvanceMillis(1);
+  }
+  return irqCount != before;
+}
+
+static void testIrqLatencyVersusPolling() {
+  hostPn532RemoveCard();
+  CHECK(nfc.startDetection());
+  CHECK(nfc.isDetectionArmed());
+  
+  // Nothing on the bus while waiting for a card
+  uint32_t busBefore = hostPn532Transactions();
+  uint32_t before = irqCount;
+  hostAdvanceMillis(2000);
+  CHECK_EQ(hostPn532Transactions(), busBefore);
+  CHECK_EQ(irqCount, before);
+  CHECK(!nfc.isCardDetected());
+  
+  unsigned long presentUs = micros();
+  presentCard();
+  CHECK(waitForIrq(before, 50));
+  uint32_t irqLatencyUs = irqUs - presentUs;
+  CHECK(nfc.isCardDetected());
+  CHECK(irqLatencyUs <= 10000);
+  
+  uint8_t uid[10];
+  uint8_t length = 0;
+  CHECK(nfc.readDetectedUID(uid, &length));
+  CHECK_EQ(length, sizeof(cardUid));
+  CHECK(memcmp(uid, cardUid, sizeof(cardUid)) == 0);
+  CHECK(!nfc.isDetectionArmed());
+  CHECK_EQ(digitalRead(PIN_IRQ), HIGH);
+  
+  // The loop this replaced: readUID() every 500 ms, card arriving anywhere in between
+  uint32_t worstPollUs = 0;
+  for (uint32_t offsetMs = 10; offsetMs < 500; offsetMs += 70) {
+    hostPn532RemoveCard();
+    CHECK(!nfc.readUID(uid, &length, 0));
+    unsigned long pollUs = micros();
+    hostAdvanceMillis(offsetMs);
+    presentUs = micros();
+    presentCard();
+    
+    unsigned long nextPollUs = pollUs + 500000;
+    hostAdvanceMillis((nextPollUs - micros()) / 1000);
+    CHECK(nfc.readUID(uid, &length, 0));
+    uint32_t latencyUs = micros() - presentUs;
+    if (latencyUs > worstPollUs) {
+      worstPollUs = latencyUs;
+    }
+  }
+  CHECK(worstPollUs > 400000);
+  printf("     card to IRQ %lu us, polled every 500 ms up to %lu us\n",
+         (unsigned long)irqLatencyUs, (unsigned long)worstPollUs);
+}
+
+static void testCardAlreadyInField() {
+  presentCard();
+  uint32_t before = irqCount;
+  unsigned long armUs = micros();
+  CHECK(nfc.startDetection());
+  CHECK(waitForIrq(before, 50));
+  CHECK(irqUs - armUs <= PN532_HOST_CMD_US + PN532_HOST_ANSWER_US);
+  
+  uint8_t uid[10];
+  uint8_t length = 0;
+  CHECK(nfc.readDetectedUID(uid, &length));
+  CHECK_EQ(length, sizeof(cardUid));
+}
+
+static void testSyncReadCancelsDetection() {
+  hostPn532RemoveCard();
+  CHECK(nfc.startDetection());
+  presentCard();
+  
+  // readUID() aborts the armed InListPassiveTarget before its answer arrives
+  uint32_t before = irqCount;
+  uint8_t uid[10];
+  uint8_t length = 0;
+  CHECK(nfc.readUID(uid, &length, 0));
+  CHECK(!nfc.isDetectionArmed());
+  CHECK(!nfc.isCardDetected());
+  hostAdvanceMillis(50);
+  CHECK_EQ(irqCount, before);
+  CHECK(!nfc.readDetectedUID(uid, &length));
+}
+
+static void testDutyCycledField() {
+  hostPn532RemoveCard();
+  nfc.setDutyCycle(NFC_FIELD_ON_MS, NFC_FIELD_OFF_MIN_MS, NFC_FIELD_OFF_MAX_MS, NFC_BACKOFF_WINDOWS);
+  
+  // Idle loop: pollLowPower() when its delay runs out or the IRQ fires
+  uint8_t uid[10];
+  uint8_t length = 0;
+  uint32_t fieldOnMs = 0;
+  uint32_t seenIrq = irqCount;
+  unsigned long nextPoll = millis();
+  unsigned long presentMs = 0;
+  unsigned long foundMs = 0;
+  unsigned long end = millis() + 30000;
+  while (millis() < end && foundMs == 0) {
+    if (presentMs == 0 && millis() >= end - 15000) {
+      presentMs = millis();
+      presentCard();
+    }
+    if (irqCount != seenIrq || millis() >= nextPoll) {
+      seenIrq = irqCount;
+      if (nfc.pollLowPower(uid, &length)) {
+        foundMs = millis();
+      }
+      nextPoll = millis() + nfc.getLowPowerPollDelay();
+    }
+    if (presentMs == 0 && hostPn532FieldOn()) {
+      fieldOnMs++;
+    }
+    hostAdvanceMillis(1);
+  }
+  
+  // Field mostly off with no card; the card is seen by the next window
+  CHECK(fieldOnMs * 4 < 15000);
+  CHECK(foundMs != 0);
+  CHECK(foundMs - presentMs <= NFC_FIELD_OFF_MAX_MS + 20);
+  CHECK_EQ(length, sizeof(cardUid));
+  CHECK(!hostPn532FieldOn());
+  printf("     field on %lu of 15000 ms idle, card found after %lu ms\n",
+         (unsigned long)fieldOnMs, (unsigned long)(foundMs - presentMs));
+}
+
+static void testNdefStopsAtMessageEnd() {
+  presentCard();
+  uint8_t uid[10];
+  uint8_t length = 0;
+  CHECK(nfc.readUID(uid, &length, 0));
+  
+  uint8_t buffer[NFC_NDEF_MAX_BYTES];
+  size_t got = 0;
+  uint32_t pagesBefore = hostPn532PageReads();
+  CHECK(nfc.readNdef(buffer, sizeof(buffer), &got));
+  CHECK(memcmp(buffer, cardMemory + 16, got) == 0);
+  
+  // CC page plus the five pages holding the 20-byte message, not the whole data area
+  CHECK_EQ(hostPn532PageReads() - pagesBefore, 1 + 5);
+}
+
+int main() {
+  Logger::setLogLevel(LOG_ERROR);
+  hostSetMillis(1000);
+  
+  // NTAG215: CC on page 3, then an NDEF TLV holding one URI record
+  static const uint8_t cc[4] = { 0xE1, 0x10, 0x3E, 0x00 };
+  static const uint8_t tlv[] = {
+    0x03, 0x12, 0xD1, 0x01, 0x0E, 'U', 0x04,
+    'e', 'x', 'a', 'm', 'p', 'l', 'e', '.', 'c', 'o', 'm', '/', 'a',
+    0xFE
+  };
+  memcpy(cardMemory + 12, cc, sizeof(cc));
+  memcpy(cardMemory + 16, tlv, sizeof(tlv));
+  
+  CHECK(nfc.init(21, 22, PIN_IRQ, PIN_RST));
+  nfc.setIrqHook(onIrq);
+  
+  RUN_TEST(testIrqLatencyVersusPolling);
+  RUN_TEST(testCardAlreadyInField);
+  RUN_TEST(testSyncReadCancelsDetection);
+  RUN_TEST(testDutyCycledField);
+  RUN_TEST(testNdefStopsAtMessageEnd);
+  return HOST_TEST_RESULT();
+}
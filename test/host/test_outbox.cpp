@@ -0,0 +1,161 @@
+/*
+ * test_outbox.cpp
+ * 
+ * Outbox on the in-memory LittleFS: round trip, remount, the size limit,
+ * corrupt segments and power cut mid-append
+ */
+
+#include "host_test.h"
+#include "outbox.h"
+#include "logger.h"
+#include "config.h"
+
+static uint8_t clip[200000];
+static uint8_t drain[200000];
+
+static void fillClip(size_t length, uint8_t seed) {
+  for (size_t i = 0; i < length; i++) {
+    clip[i] = (uint8_t)(seed + i * 7);
+  }
+}
+
+static bool appendClip(Outbox& outbox, size_t length, uint8_t seed) {
+  OutboxMeta meta;
+  memset(&meta, 0, sizeof(meta));
+  snprintf(meta.uid, sizeof(meta.uid), "UID%02X", seed);
+  meta.sampleRate = 16000;
+  fillClip(length, seed);
+  return outbox.append(meta, clip, length);
+}
+
+// Peek the oldest clip and check it is the one appended with seed
+static bool drainClip(Outbox& outbox, size_t length, uint8_t seed) {
+  OutboxMeta meta;
+  size_t got = 0;
+  if (!outbox.peek(meta, drain, sizeof(drain), &got) || got != length) {
+    return false;
+  }
+  fillClip(length, seed);
+  return memcmp(drain, clip, length) == 0 && outbox.pop();
+}
+
+static size_t storedOnFlash() {
+  size_t total = 0;
+  char path[32];
+  for (uint32_t seg = 1; seg < 1000; seg++) {
+    snprintf(path, sizeof(path), "/outbox/%08lu.seg", (unsigned long)seg);
+    std::vector<uint8_t>* data = LittleFS.hostData(path);
+    total += (data != nullptr) ? data->size() : 0;
+  }
+  return total;
+}
+
+static void testRoundTripAndRemount() {
+  LittleFS.hostFormat();
+  Outbox outbox;
+  CHECK(outbox.begin());
+  CHECK(outbox.isEmpty());
+  
+  for (uint8_t i = 0; i < 5; i++) {
+    CHECK(appendClip(outbox, 30000, i));
+  }
+  CHECK_EQ(outbox.getPendingCount(), 5);
+  CHECK(drainClip(outbox, 30000, 0));
+  CHECK(drainClip(outbox, 30000, 1));
+  
+  // Reboot: the cursor and the remaining clips survive
+  Outbox after;
+  CHECK(after.begin());
+  CHECK_EQ(after.getPendingCount(), 3);
+  for (uint8_t i = 2; i < 5; i++) {
+    CHECK(drainClip(after, 30000, i));
+  }
+  CHECK(after.isEmpty());
+  CHECK_EQ(storedOnFlash(), 0);
+}
+
+static void testSizeLimitHolds() {
+  LittleFS.hostFormat();
+  Outbox outbox;
+  CHECK(outbox.begin());
+  
+  // Clips larger than a segment get one segment each; the oldest go first
+  for (uint8_t i = 0; i < 20; i++) {
+    CHECK(appendClip(outbox, 150000, i));
+    CHECK(storedOnFlash() <= OUTBOX_MAX_BYTES);
+  }
+  uint32_t kept = outbox.getPendingCount();
+  CHECK(kept > 0 && kept < 20);
+  CHECK(drainClip(outbox, 150000, (uint8_t)(20 - kept)));
+}
+
+static void testOversizedClipRejected() {
+  LittleFS.hostFormat();
+  Outbox outbox;
+  CHECK(outbox.begin());
+  CHECK(appendClip(outbox, 1000, 1));
+  
+  // Cannot fit even with everything else gone: refused, nothing dropped
+  OutboxMeta meta;
+  memset(&meta, 0, sizeof(meta));
+  static uint8_t huge[OUTBOX_MAX_BYTES];
+  CHECK(!outbox.append(meta, huge, sizeof(huge)));
+  CHECK_EQ(outbox.getPendingCount(), 1);
+  CHECK(storedOnFlash() <= OUTBOX_MAX_BYTES);
+  CHECK(drainClip(outbox, 1000, 1));
+}
+
+static void testCorruptSegmentRecount() {
+  LittleFS.hostFormat();
+  Outbox outbox;
+  CHECK(outbox.begin());
+  
+  // Segment 1 holds clips 0-2, segment 2 holds clip 3
+  for (uint8_t i = 0; i < 4; i++) {
+    CHECK(appendClip(outbox, 20000, i));
+  }
+  CHECK_EQ(outbox.getPendingCount(), 4);
+  CHECK(drainClip(outbox, 20000, 0));
+  
+  // Flip a byte in clip 1: it and clip 2 behind it are lost with the segment
+  std::vector<uint8_t>* seg = LittleFS.hostData("/outbox/00000001.seg");
+  CHECK(seg != nullptr);
+  if (seg != nullptr) {
+    (*seg)[seg->size() / 2] ^= 0xFF;
+  }
+  CHECK(drainClip(outbox, 20000, 3));
+  CHECK_EQ(outbox.getPendingCount(), 0);
+  CHECK(outbox.isEmpty());
+}
+
+static void testPowerCutMidAppend() {
+  LittleFS.hostFormat();
+  Outbox outbox;
+  CHECK(outbox.begin());
+  CHECK(appendClip(outbox, 10000, 1));
+  CHECK(appendClip(outbox, 10000, 2));
+  
+  // Power fails halfway through the third record
+  LittleFS.hostCutPowerAfter(5000);
+  CHECK(!appendClip(outbox, 10000, 3));
+  LittleFS.hostRestorePower();
+  
+  Outbox after;
+  CHECK(after.begin());
+  CHECK_EQ(after.getPendingCount(), 2);
+  CHECK(appendClip(after, 10000, 4));
+  CHECK(drainClip(after, 10000, 1));
+  CHECK(drainClip(after, 10000, 2));
+  CHECK(drainClip(after, 10000, 4));
+  CHECK(after.isEmpty());
+}
+
+int main() {
+  Logger::setLogLevel(LOG_ERROR);
+  RUN_TEST(testRoundTripAndRemount);
+  RUN_TEST(testSizeLimitHolds);
+  RUN_TEST(testOversizedClipRejected);
+  RUN_TEST(testCorruptSegmentRecount);
+  RUN_TEST(testPowerCutMidAppend);
+  return HOST_TEST_RESULT();
+}
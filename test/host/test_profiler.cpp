@@ -0,0 +1,129 @@
+/*
+ * test_profiler.cpp
+ * 
+ * Profiler zone table and ProfileScope timing against the host's steady
+ * clock (the cycle counter stub), the cost of an empty zone, and
+ * PROFILE_ZONE compiling to nothing with ENABLE_PROFILING 0
+ */
+
+#include "host_test.h"
+#include "profiler.h"
+#include "logger.h"
+#include <chrono>
+
+// Spin on the real clock (delay() only moves the simulated one)
+static void busyWaitUs(uint32_t us) {
+  auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+static void timedWork(uint32_t us) {
+  ProfileScope zone(PROF_NFC_READ);
+  busyWaitUs(us);
+}
+
+static void macroZone() {
+  PROFILE_ZONE(PROF_MIC_READ);
+  busyWaitUs(100);
+}
+
+// ============================================
+// ZONE TABLE
+// ============================================
+static void testRecordAggregates() {
+  Profiler::reset();
+  Profiler::record(PROF_AT_COMMAND, 100);
+  Profiler::record(PROF_AT_COMMAND, 300);
+  Profiler::record(PROF_AT_COMMAND, 200);
+  
+  ProfileZoneStats z = Profiler::getStats(PROF_AT_COMMAND);
+  CHECK_EQ(z.calls, 3);
+  CHECK_EQ(z.totalCycles, 600);
+  CHECK_EQ(z.maxCycles, 300);
+  CHECK_EQ(Profiler::getStats(PROF_LOG).calls, 0);
+  
+  // 64-bit total: ~17 s of cycles per call does not wrap after a few calls
+  Profiler::record(PROF_SPK_WRITE, UINT32_MAX);
+  Profiler::record(PROF_SPK_WRITE, UINT32_MAX);
+  CHECK(Profiler::getStats(PROF_SPK_WRITE).totalCycles == 2ULL * UINT32_MAX);
+  
+  Profiler::reset();
+  CHECK_EQ(Profiler::getStats(PROF_AT_COMMAND).calls, 0);
+  CHECK_EQ(Profiler::getStats(PROF_AT_COMMAND).maxCycles, 0);
+}
+
+static void testOutOfRangeAndNames() {
+  CHECK_EQ(Profiler::getStats(PROF_ZONE_COUNT).calls, 0);
+  CHECK_STR(Profiler::getZoneName(PROF_MIC_READ), "MIC_READ");
+  CHECK_STR(Profiler::getZoneName(PROF_LOG), "LOG");
+  CHECK_STR(Profiler::getZoneName(PROF_ZONE_COUNT), "UNKNOWN");
+}
+
+// ============================================
+// SCOPES ON THE HOST CLOCK
+// ============================================
+static void testScopeMeasuresSteadyClock() {
+  Profiler::reset();
+  timedWork(2000);
+  timedWork(500);
+  
+  // At least the time spun; the upper bound only guards against garbage
+  const uint32_t cyclesPerUs = getCpuFrequencyMhz();
+  ProfileZoneStats z = Profiler::getStats(PROF_NFC_READ);
+  CHECK_EQ(z.calls, 2);
+  CHECK(z.maxCycles >= 2000 * cyclesPerUs);
+  CHECK(z.totalCycles >= 2500ULL * cyclesPerUs);
+  CHECK(z.maxCycles < 1000000 * cyclesPerUs);
+}
+
+static void testNestedScopes() {
+  Profiler::reset();
+  {
+    ProfileScope outer(PROF_AT_COMMAND);
+    busyWaitUs(200);
+    timedWork(300);
+  }
+  ProfileZoneStats outer = Profiler::getStats(PROF_AT_COMMAND);
+  ProfileZoneStats inner = Profiler::getStats(PROF_NFC_READ);
+  CHECK_EQ(outer.calls, 1);
+  CHECK_EQ(inner.calls, 1);
+  CHECK(outer.totalCycles >= inner.totalCycles + 200ULL * getCpuFrequencyMhz());
+}
+
+static void testEmptyZoneCost() {
+  Profiler::reset();
+  const uint32_t n = 100000;
+  for (uint32_t i = 0; i < n; i++) {
+    ProfileScope zone(PROF_LOG);
+  }
+  
+  // Two clock reads apart; on the host that is a steady_clock call, not CCOUNT
+  ProfileZoneStats z = Profiler::getStats(PROF_LOG);
+  CHECK_EQ(z.calls, n);
+  uint32_t avgCycles = (uint32_t)(z.totalCycles / n);
+  CHECK(avgCycles < 10 * getCpuFrequencyMhz());
+  printf("     empty zone: %lu host cycles avg (%lu ns)\n", (unsigned long)avgCycles,
+         (unsigned long)(avgCycles * 1000 / getCpuFrequencyMhz()));
+}
+
+static void testMacroDisabled() {
+  Profiler::reset();
+  macroZone();
+#if ENABLE_PROFILING
+  CHECK_EQ(Profiler::getStats(PROF_MIC_READ).calls, 1);
+#else
+  CHECK_EQ(Profiler::getStats(PROF_MIC_READ).calls, 0);
+#endif
+}
+
+int main() {
+  Logger::setLogLevel(LOG_ERROR);
+  RUN_TEST(testRecordAggregates);
+  RUN_TEST(testOutOfRangeAndNames);
+  RUN_TEST(testScopeMeasuresSteadyClock);
+  RUN_TEST(testNestedScopes);
+  RUN_TEST(testEmptyZoneCost);
+  RUN_TEST(testMacroDisabled);
+  return HOST_TEST_RESULT();
+}
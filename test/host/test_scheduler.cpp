@@ -0,0 +1,204 @@
+/*
+ * test_scheduler.cpp
+ * 
+ * Scheduler on the simulated clock: timer cadence, one-shot re-arming,
+ * skipped periods, queue overflow, and an idle minute with button ISRs
+ * measuring wakeups per second and dispatch latency against the old
+ * delay(10) loop
+ */
+
+#include "host_test.h"
+#include "scheduler.h"
+#include "logger.h"
+#include "config.h"
+
+static uint32_t fired[4];
+static uint32_t buttonEvents = 0;
+
+static void onTimer(void* arg) {
+  fired[(uintptr_t)arg]++;
+}
+
+static void onButton(const SchedEvent& event) {
+  (void)event;
+  buttonEvents++;
+}
+
+static void resetCounters() {
+  memset(fired, 0, sizeof(fired));
+  buttonEvents = 0;
+}
+
+// ============================================
+// SIMULATED BUTTON ISR
+// ============================================
+static Scheduler* isrTarget = nullptr;
+static volatile bool buttonFlag = false;   // What the delay(10) loop polled
+static volatile unsigned long buttonPressUs = 0;
+
+static void buttonIsr(void* arg) {
+  (void)arg;
+  buttonFlag = true;
+  buttonPressUs = micros();
+  if (isrTarget != nullptr) {
+    isrTarget->postEventFromISR(SCHED_EVENT_BUTTON);
+  }
+}
+
+// Presses spread over [startUs, startUs + spanUs), fixed pseudo-random offsets
+static uint32_t schedulePresses(unsigned long startUs, unsigned long spanUs, uint32_t count) {
+  uint32_t seed = 12345;
+  for (uint32_t i = 0; i < count; i++) {
+    seed = seed * 1103515245 + 12345;
+    unsigned long atUs = startUs + (unsigned long)(((uint64_t)spanUs * i + (seed >> 16) % (spanUs / count)) / count);
+    hostScheduleAt(atUs, buttonIsr, nullptr);
+  }
+  return count;
+}
+
+static void testPeriodicCadence() {
+  resetCounters();
+  static Scheduler scheduler;   // Lives as long as the program, as on the device (its queue is never deleted)
+  CHECK(scheduler.begin());
+  scheduler.addTimer("fast", 100, true, onTimer, (void*)0);
+  scheduler.addTimer("slow", 1000, true, onTimer, (void*)1);
+  
+  unsigned long end = millis() + 10000;
+  while (millis() < end) {
+    scheduler.run(SCHEDULER_IDLE_MAX_WAIT_MS);
+  }
+  CHECK_EQ(fired[0], 100);
+  CHECK_EQ(fired[1], 10);
+  
+  // Only deadlines wake the loop: one wakeup per 100 ms slot
+  SchedStats stats = scheduler.getStats();
+  CHECK_EQ(stats.wakeups, 100);
+  CHECK_EQ(stats.timersFired, 110);
+}
+
+static void testOneShotRearmAndCancel() {
+  resetCounters();
+  static Scheduler scheduler;
+  CHECK(scheduler.begin());
+  int8_t id = scheduler.addTimer("once", 50, false, onTimer, (void*)0);
+  CHECK(id != SCHED_INVALID_TIMER);
+  
+  hostAdvanceMillis(49);
+  scheduler.run(0);
+  CHECK_EQ(fired[0], 0);
+  CHECK_EQ(scheduler.getMsUntilNextTimer(), 1);
+  scheduler.run(SCHEDULER_IDLE_MAX_WAIT_MS);
+  CHECK_EQ(fired[0], 1);
+  CHECK_EQ(scheduler.getMsUntilNextTimer(), UINT32_MAX);
+  
+  scheduler.setTimer(id, 200);
+  CHECK_EQ(scheduler.getMsUntilNextTimer(), 200);
+  scheduler.cancelTimer(id);
+  unsigned long start = millis();
+  scheduler.run(SCHEDULER_IDLE_MAX_WAIT_MS);
+  CHECK_EQ(fired[0], 1);
+  CHECK_EQ(millis() - start, SCHEDULER_IDLE_MAX_WAIT_MS);
+}
+
+static void testMissedPeriodsSkipped() {
+  resetCounters();
+  static Scheduler scheduler;
+  CHECK(scheduler.begin());
+  scheduler.addTimer("tick", 100, true, onTimer, (void*)0);
+  scheduler.run(SCHEDULER_IDLE_MAX_WAIT_MS);
+  CHECK_EQ(fired[0], 1);
+  
+  // The loop is busy elsewhere for ten periods: one late fire, no burst
+  delay(1050);
+  scheduler.run(0);
+  scheduler.run(0);
+  CHECK_EQ(fired[0], 2);
+  CHECK(scheduler.getMsUntilNextTimer() <= 100);
+  
+  // Then back on a 100 ms cadence
+  unsigned long end = millis() + 1000;
+  while (millis() < end) {
+    scheduler.run(SCHEDULER_IDLE_MAX_WAIT_MS);
+  }
+  CHECK_EQ(fired[0], 12);
+}
+
+static void testQueueOverflowCounted() {
+  resetCounters();
+  static Scheduler scheduler;
+  CHECK(scheduler.begin());
+  scheduler.onEvent(SCHED_EVENT_BUTTON, onButton);
+  
+  for (int i = 0; i < SCHED_QUEUE_LENGTH + 4; i++) {
+    scheduler.postEventFromISR(SCHED_EVENT_BUTTON);
+  }
+  scheduler.run(0);
+  CHECK_EQ(buttonEvents, SCHED_QUEUE_LENGTH);
+  SchedStats stats = scheduler.getStats();
+  CHECK_EQ(stats.eventsDropped, 4);
+  CHECK_EQ(stats.eventsDispatched, SCHED_QUEUE_LENGTH);
+}
+
+static void testIdleWakeupsAndLatency() {
+  resetCounters();
+  const uint32_t minuteMs = 60000;
+  const uint32_t presses = 30;
+  
+  // The sketch's idle timers plus button ISRs at scattered times
+  static Scheduler scheduler;
+  CHECK(scheduler.begin());
+  scheduler.addTimer("nfc", PREFETCH_POLL_MS, true, onTimer, (void*)0);
+  scheduler.addTimer("outbox", OUTBOX_DRAIN_INTERVAL_MS, true, onTimer, (void*)1);
+  scheduler.addTimer("telemetry", TELEMETRY_CHECK_INTERVAL_MS, true, onTimer, (void*)2);
+  scheduler.onEvent(SCHED_EVENT_BUTTON, onButton);
+  isrTarget = &scheduler;
+  
+  unsigned long start = millis();
+  schedulePresses(micros() + 1000, (unsigned long)minuteMs * 1000 - 2000, presses);
+  while (millis() - start < minuteMs) {
+    scheduler.run(SCHEDULER_IDLE_MAX_WAIT_MS);
+  }
+  isrTarget = nullptr;
+  
+  SchedStats stats = scheduler.getStats();
+  uint32_t timerFires = fired[0] + fired[1] + fired[2];
+  CHECK_EQ(buttonEvents, presses);
+  CHECK_EQ(stats.eventsDropped, 0);
+  CHECK(stats.wakeups <= timerFires + presses);
+  CHECK(stats.maxDispatchUs < 1000);   // Wake-up itself costs nothing on the simulated clock
+  float schedWakeups = stats.wakeups * 1000.0f / minuteMs;
+  
+  // The loop it replaced: poll everything, then delay(10)
+  buttonFlag = false;
+  schedulePresses(micros() + 1000, (unsigned long)minuteMs * 1000 - 2000, presses);
+  uint32_t loopWakeups = 0;
+  uint32_t worstPollUs = 0;
+  start = millis();
+  while (millis() - start < minuteMs) {
+    if (buttonFlag) {
+      buttonFlag = false;
+      uint32_t latency = micros() - buttonPressUs;
+      if (latency > worstPollUs) {
+        worstPollUs = latency;
+      }
+    }
+    delay(10);
+    loopWakeups++;
+  }
+  float loopRate = loopWakeups * 1000.0f / minuteMs;
+  CHECK(schedWakeups * 20 < loopRate);
+  
+  printf("     scheduler %.1f wakeups/s, dispatch max %lu us; delay(10) loop %.1f wakeups/s, up to %lu us\n",
+         schedWakeups, (unsigned long)stats.maxDispatchUs, loopRate, (unsigned long)worstPollUs);
+}
+
+int main() {
+  Logger::setLogLevel(LOG_ERROR);
+  hostSetMillis(1000);
+  RUN_TEST(testPeriodicCadence);
+  RUN_TEST(testOneShotRearmAndCancel);
+  RUN_TEST(testMissedPeriodsSkipped);
+  RUN_TEST(testQueueOverflowCounted);
+  RUN_TEST(testIdleWakeupsAndLatency);
+  return HOST_TEST_RESULT();
+}